@@ -0,0 +1,251 @@
+#include "InputGenerators.hpp"
+
+#include "unicode.hpp"
+
+namespace Benchmarks
+{
+//==============================================================================
+namespace
+{
+  using std::string;
+  using std::to_string;
+
+  const char* words[] =
+  {
+    "lorem", "ipsum", "dolor", "sit", "amet", "consectetur", "adipiscing", "elit",
+    "sed", "do", "eiusmod", "tempor", "incididunt", "ut", "labore", "et",
+  };
+  const int wordCount = sizeof(words) / sizeof(words[0]);
+
+  // sentence of `count` words picked by `seed`
+  string GetSentence(int seed, int count)
+  {
+    string sentence;
+    for (int i = 0; i < count; i++)
+    {
+      sentence += (i > 0 ? " " : "");
+      sentence += words[(seed * 7 + i * 5) % wordCount];
+    }
+    return sentence;
+  }
+
+  // units are appended until source is `size` bytes or more
+  string Repeat(size_t size, string (*unit)(int))
+  {
+    string source;
+    for (int n = 0; source.size() < size; n++)
+    {
+      source += unit(n);
+    }
+    return source;
+  }
+
+  //==============================================================================
+  const int nestingDepth = 64;
+  const char nestedOperators[] = "+-*&|";
+
+  // parser takes `(a + 1) * b` but not `a * (b + 1)`, so expressions nest
+  // through left operands, call arguments and subscripts
+  string GetNestedExpressions(int n)
+  {
+    string name = "nested" + to_string(n);
+    string left = "a";
+    string calls = "a";
+    string subscripts = "a";
+    for (int i = 0; i < nestingDepth; i++)
+    {
+      string op = string(" ") + nestedOperators[(n + i) % 5] + " ";
+      string operand = i % 2 == 0 ? to_string(i) : "b";
+      left = "(" + left + op + operand + ")";
+      calls = name + "(" + calls + op + operand + ", b)";
+      subscripts = "table[(" + subscripts + op + operand + ") & 15]";
+    }
+    return string(n == 0 ? "int table[16];\n" : "")
+           + "int " + name + "(int a, int b)\n"
+           "{\n"
+           "  int r;\n"
+           "  r = " + left + ";\n"
+           "  r = " + calls + ";\n"
+           "  r = " + subscripts + ";\n"
+           "  return r;\n"
+           "}\n";
+  }
+
+  //==============================================================================
+  string GetFunction(int n)
+  {
+    string call = n > 0 ? "f" + to_string(n - 1) + "(i, b)" : "i";
+    return "int f" + to_string(n) + "(int a, int b)\n"
+           "{\n"
+           "  int i;\n"
+           "  int s;\n"
+           "  s = 0;\n"
+           "  for (i = 0; i < a; i++)\n"
+           "  {\n"
+           "    if (i % 3 == " + to_string(n % 3) + ")\n"
+           "      s += i * b;\n"
+           "    else\n"
+           "      s -= " + call + ";\n"
+           "  }\n"
+           "  return s;\n"
+           "}\n";
+  }
+
+  //==============================================================================
+  const int structFieldCount = 200;
+
+  // code generator takes no floats, so float fields are declared only
+  string GetLargeStruct(int n)
+  {
+    string name = "Large" + to_string(n);
+    string variable = "large" + to_string(n);
+    string source = "struct " + name + "\n{\n";
+    for (int i = 0; i < structFieldCount; i++)
+    {
+      string field = "f" + to_string(i);
+      switch (i % 5)
+      {
+      case 0: source += "  int " + field + ";\n"; break;
+      case 1: source += "  float " + field + ";\n"; break;
+      case 2: source += "  char " + field + "[" + to_string(4 + i % 13) + "];\n"; break;
+      case 3: source += "  int* " + field + ";\n"; break;
+      case 4: source += "  struct " + name + "* " + field + ";\n"; break;
+      }
+    }
+    source += "};\n"
+              "struct " + name + " " + variable + ";\n"
+              "int use" + name + "(int a)\n"
+              "{\n"
+              "  struct " + name + " s;\n"
+              "  s.f0 = a;\n"
+              "  " + variable + ".f195 = s.f0 + 1;\n"
+              "  " + variable + ".f197[1] = 3;\n"
+              "  return s.f0 + " + variable + ".f195 + " + variable + ".f197[1];\n"
+              "}\n";
+    return source;
+  }
+
+  //==============================================================================
+  const int stringLineCount = 64;
+
+  // adjacent literals of about 64 characters each are joined by tokenizer
+  string GetLongString(int n)
+  {
+    string source = "char* text" + to_string(n) + " =\n";
+    for (int i = 0; i < stringLineCount; i++)
+    {
+      source += "  \"" + GetSentence(n + i, 6) + (i % 4 == 0 ? " \\\"quoted\\\"\\t" : "")
+                + (i % 8 == 0 ? " \\\\ \\x41\\101" : "") + "\\n\"\n";
+    }
+    source += "  ;\n";
+    return source;
+  }
+
+  //==============================================================================
+  string GetCommentedFunction(int n)
+  {
+    string source = "/*\n";
+    for (int i = 0; i < 12; i++)
+    {
+      source += " * " + GetSentence(n + i, 10) + "\n";
+    }
+    source += " */\n";
+    for (int i = 0; i < 6; i++)
+    {
+      source += "// " + GetSentence(n * 3 + i, 8) + "\n";
+    }
+    source += "int commented" + to_string(n) + "(int a) // " + GetSentence(n, 4) + "\n"
+              "{\n"
+              "  /* " + GetSentence(n + 1, 6) + " */ int b; // " + GetSentence(n + 2, 5) + "\n"
+              "  b = a /* " + GetSentence(n + 3, 3) + " */ + " + to_string(n) + ";\n"
+              "  return b; // " + GetSentence(n + 4, 7) + "\n"
+              "}\n";
+    return source;
+  }
+
+  //==============================================================================
+  // first letters of Latin-1, Cyrillic, Greek, CJK blocks and emoji,
+  // one, two, three and four bytes in UTF-8
+  const int scripts[] = {0xC0, 0x410, 0x391, 0x4E00, 0x1F600};
+  const int scriptCount = sizeof(scripts) / sizeof(scripts[0]);
+
+  // word of `length` letters of script picked by `seed`
+  string GetUnicodeWord(int seed, int length)
+  {
+    string word;
+    int first = scripts[seed % scriptCount];
+    for (int i = 0; i < length; i++)
+    {
+      char bytes[4];
+      word.append(bytes, UTF8Encode(first + (seed * 3 + i * 7) % 24, bytes));
+    }
+    return word;
+  }
+
+  string GetUnicodeText(int seed, int wordCount)
+  {
+    string text;
+    for (int i = 0; i < wordCount; i++)
+    {
+      text += (i > 0 ? " " : "") + GetUnicodeWord(seed + i, 3 + (seed + i) % 6);
+    }
+    return text;
+  }
+
+  // compiler's identifiers are ASCII only, so Unicode goes to comments and
+  // string literals
+  string GetUnicodeUnit(int n)
+  {
+    string source;
+    for (int i = 0; i < 4; i++)
+    {
+      source += "// " + GetUnicodeText(n + i, 8) + "\n";
+    }
+    source += "/* " + GetUnicodeText(n * 5, 16) + " */\n"
+              "char* greeting" + to_string(n) + " = \"" + GetUnicodeText(n * 7, 10) + "\";\n"
+              "int greet" + to_string(n) + "(int a) /* " + GetUnicodeText(n, 3) + " */\n"
+              "{\n"
+              "  return greeting" + to_string(n) + "[a % 8]; // " + GetUnicodeText(n + 1, 4) + "\n"
+              "}\n";
+    return source;
+  }
+
+  //==============================================================================
+  // every brace, bracket, `|` and `~` spelled as trigraph, `?\?/` splices
+  // comment lines, `?\?=`, `?\?'` and `?\?!` fill comments
+  string GetTrigraphFunction(int n)
+  {
+    return "int t" + to_string(n) + "(int a)\n"
+           "?\?<\n"
+           "  int b?\?(4?\?);\n"
+           "  // ?\?= ?\?' ?\?! spliced ?\?/\n"
+           "  comment line\n"
+           "  b?\?(0?\?) = a ?\?! " + to_string(n) + ";\n"
+           "  b?\?(1?\?) = ?\?-b?\?(0?\?) ?\?!?\?! a;\n"
+           "  if (b?\?(1?\?) ?\?! b?\?(0?\?))\n"
+           "  ?\?<\n"
+           "    b?\?(2?\?) = b?\?(0?\?) & ?\?-a;\n"
+           "  ?\?>\n"
+           "  return b?\?(2?\?);\n"
+           "?\?>\n";
+  }
+
+} // namespace
+
+//==============================================================================
+const std::vector<InputGenerator>& GetInputGenerators()
+{
+  static const std::vector<InputGenerator> generators =
+  {
+    {"nested-expressions", [](size_t size) { return Repeat(size, GetNestedExpressions); }},
+    {"many-functions", [](size_t size) { return Repeat(size, GetFunction); }},
+    {"large-structs", [](size_t size) { return Repeat(size, GetLargeStruct); }},
+    {"long-strings", [](size_t size) { return Repeat(size, GetLongString); }},
+    {"comments", [](size_t size) { return Repeat(size, GetCommentedFunction); }},
+    {"unicode", [](size_t size) { return Repeat(size, GetUnicodeUnit); }},
+    {"trigraphs", [](size_t size) { return Repeat(size, GetTrigraphFunction); }},
+  };
+  return generators;
+}
+
+} // namespace Benchmarks
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace Benchmarks
+{
+// synthetic source of about `size` bytes, the same every time, and in the
+// subset of C compiler takes, so each stage up to code generation runs
+// over all of it
+struct InputGenerator
+{
+  const char* name;
+  std::string (*generate)(size_t size);
+};
+
+// deeply nested expressions, thousands of functions, large structs, long
+// string literals, heavy comments, Unicode text and trigraphs
+const std::vector<InputGenerator>& GetInputGenerators();
+
+} // namespace Benchmarks
@@ -0,0 +1,71 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += thread
+
+QMAKE_CXXFLAGS += -std=c++11
+
+DESTDIR = ../bin
+
+INCLUDEPATH += ../src
+
+CONFIG(debug, debug|release) {
+    DEFINES += \
+        _DEBUG
+    OBJECTS_DIR = temp/debug/obj
+    TARGET = benchmarks-debug
+} else {
+    OBJECTS_DIR = temp/release/obj
+    TARGET = benchmarks-release
+}
+
+DEFINES += BOOST_ALL_NO_LIB
+
+LIBS += \
+    -lboost_system-mgw48-mt-1_55 \
+    -lboost_coroutine-mgw48-mt-1_55 \
+    -lboost_context-mgw48-mt-1_55 \
+
+SOURCES += main.cpp \
+    InputGenerators.cpp \
+    ../src/utils.cpp \
+    ../src/unicode.cpp \
+    ../src/PreTokenizer.cpp \
+    ../src/Tokenizer.cpp \
+    ../src/Token.cpp \
+    ../src/Parser.cpp \
+    ../src/ASTNode.cpp \
+    ../src/SymbolTable.cpp \
+    ../src/prettyPrinting.cpp \
+    ../src/OutputSink.cpp \
+    ../src/Statement.cpp \
+    ../src/codegen.cpp \
+    ../src/AsmInstruction.cpp \
+    ../src/PeepholeOptimizer.cpp \
+    ../src/ThreadPool.cpp \
+    ../src/TimeReport.cpp \
+    ../src/Trace.cpp
+
+HEADERS += InputGenerators.hpp \
+    ../src/utils.hpp \
+    ../src/unicode.hpp \
+    ../src/PreTokenizer.hpp \
+    ../src/Tokenizer.hpp \
+    ../src/IPreTokenStream.hpp \
+    ../src/ITokenStream.hpp \
+    ../src/constants.hpp \
+    ../src/Token.hpp \
+    ../src/Parser.hpp \
+    ../src/ASTNode.hpp \
+    ../src/SymbolTable.hpp \
+    ../src/prettyPrinting.hpp \
+    ../src/OutputSink.hpp \
+    ../src/Statement.hpp \
+    ../src/Visitor.hpp \
+    ../src/codegen.hpp \
+    ../src/AsmInstruction.hpp \
+    ../src/PeepholeOptimizer.hpp \
+    ../src/ThreadPool.hpp \
+    ../src/TimeReport.hpp \
+    ../src/Trace.hpp
@@ -0,0 +1,13 @@
+int fib(int n)
+{
+  if (n < 2)
+    return n;
+  return fib(n - 1) + fib(n - 2);
+}
+
+int main()
+{
+  int result = fib(32);
+  print(result);
+  return 0;
+}
@@ -0,0 +1,33 @@
+int a[3600];
+int b[3600];
+int c[3600];
+
+int main()
+{
+  int n = 60;
+  int i;
+  int j;
+  int k;
+  int round;
+  int checksum = 0;
+  for (i = 0; i < n * n; i++)
+  {
+    a[i] = i % 7 - 3;
+    b[i] = i % 5 - 2;
+  }
+  for (round = 0; round < 30; round++)
+  {
+    for (i = 0; i < n; i++)
+      for (j = 0; j < n; j++)
+      {
+        int sum = 0;
+        for (k = 0; k < n; k++)
+          sum += a[i * n + k] * b[k * n + j];
+        c[i * n + j] = sum;
+      }
+  }
+  for (i = 0; i < n * n; i++)
+    checksum = checksum * 31 + c[i];
+  print(checksum);
+  return 0;
+}
@@ -0,0 +1,25 @@
+char composite[100000];
+
+int main()
+{
+  int round;
+  int count = 0;
+  for (round = 0; round < 50; round++)
+  {
+    int i;
+    int j;
+    count = 0;
+    for (i = 0; i < 100000; i++)
+      composite[i] = 0;
+    for (i = 2; i < 100000; i++)
+    {
+      if (composite[i])
+        continue;
+      count++;
+      for (j = i + i; j < 100000; j += i)
+        composite[j] = 1;
+    }
+  }
+  print(count);
+  return 0;
+}
@@ -0,0 +1,30 @@
+char text[4096];
+
+int length(char* s)
+{
+  int n = 0;
+  while (*s++)
+    n++;
+  return n;
+}
+
+int hash(char* s)
+{
+  int h = 5381;
+  while (*s)
+    h = h * 33 + *s++;
+  return h;
+}
+
+int main()
+{
+  int i;
+  int total = 0;
+  for (i = 0; i < 4095; i++)
+    text[i] = 'a' + i % 26;
+  text[4095] = 0;
+  for (i = 0; i < 3000; i++)
+    total += length(&text[0]) + hash(&text[i % 16]);
+  print(total);
+  return 0;
+}
@@ -0,0 +1,327 @@
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <chrono>
+#include <stdexcept>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Parser.hpp"
+#include "codegen.hpp"
+#include "InputGenerators.hpp"
+
+namespace
+{
+using namespace Compiler;
+using namespace Benchmarks;
+
+// pretokens are dropped
+class NullPreTokenStream : public IPreTokenStream
+{
+public:
+  virtual void EmitWhitespaceSequence(const int) {}
+  virtual void EmitNewLine() {}
+  virtual void EmitIdentifier(const int*, size_t) {}
+  virtual void EmitPpNumber(const std::string&) {}
+  virtual void EmitCharacterLiteral(const std::string&) {}
+  virtual void EmitStringLiteral(const std::string&) {}
+  virtual void EmitPunctuation(const std::string&) {}
+  virtual void EmitNonWhitespaceChar(const std::string&) {}
+  virtual void EmitEof() {}
+  virtual void Flush() {}
+};
+
+// tokens are counted and dropped
+class CountingTokenStream : public ITokenStream
+{
+public:
+  size_t count{0};
+
+  virtual void EmitInvalid(const string&, const int, const int) { count++; }
+  virtual void EmitKeyword(const string&, ETokenType, const int, const int) { count++; }
+  virtual void EmitPunctuation(const string&, ETokenType, const int, const int) { count++; }
+  virtual void EmitIdentifier(const string&, const int, const int) { count++; }
+  virtual void EmitLiteral(const string&, EFundamentalType, const void*, size_t,
+                           const int, const int) { count++; }
+  virtual void EmitLiteralArray(const string&, size_t, EFundamentalType, const void*, size_t,
+                                const int, const int) { count++; }
+  virtual void EmitEof(const int, const int) { count++; }
+};
+
+// symbol tables are not printed
+class SilentParser : public Parser
+{
+public:
+  SilentParser()
+    : Parser(std::cout)
+  {
+
+  }
+
+  virtual void Flush() const
+  {
+
+  }
+};
+
+// assembly is formatted as usual, then dropped
+class NullBuffer : public std::streambuf
+{
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    return traits_type::not_eof(c);
+  }
+
+  virtual std::streamsize xsputn(const char*, std::streamsize count)
+  {
+    return count;
+  }
+};
+
+// stages stream into each other, so each one runs the ones before it too
+struct Stage
+{
+  const char* name;
+  std::function<void(const std::vector<char>&)> run;
+};
+
+const std::vector<Stage> stages =
+{
+  {"pretokenize", [](const std::vector<char>& input)
+    {
+      NullPreTokenStream pretokens;
+      PreTokenizer pretokenizer(input, pretokens);
+    }},
+  {"tokenize", [](const std::vector<char>& input)
+    {
+      CountingTokenStream tokens;
+      Tokenizer tokenizer(tokens);
+      PreTokenizer pretokenizer(input, tokenizer);
+    }},
+  {"parse", [](const std::vector<char>& input)
+    {
+      SilentParser parser;
+      Tokenizer tokenizer(parser);
+      PreTokenizer pretokenizer(input, tokenizer);
+    }},
+  {"codegen", [](const std::vector<char>& input)
+    {
+      NullBuffer buffer;
+      std::ostream out(&buffer);
+      CodeGenerator codeGenerator(out);
+      Tokenizer tokenizer(codeGenerator);
+      PreTokenizer pretokenizer(input, tokenizer);
+    }},
+};
+
+struct Result
+{
+  std::string input;
+  std::string stage;
+  size_t bytes;
+  size_t tokens;
+  std::vector<double> seconds;
+};
+
+double GetMedian(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+double GetMbPerSecond(const Result& result)
+{
+  return result.bytes / GetMedian(result.seconds) / (1 << 20);
+}
+
+double GetTokensPerSecond(const Result& result)
+{
+  return result.tokens / GetMedian(result.seconds);
+}
+
+void PrintTable(const std::vector<Result>& results, std::ostream& out)
+{
+  using namespace std;
+
+  out << left << setw(20) << "input" << setw(13) << "stage" << right
+      << setw(10) << "MB/s" << setw(14) << "Mtokens/s" << setw(12) << "median ms" << endl;
+  for (auto& result : results)
+  {
+    out << fixed << setprecision(2) << left << setw(20) << result.input << setw(13) << result.stage
+        << right << setw(10) << GetMbPerSecond(result)
+        << setw(14) << GetTokensPerSecond(result) * 1e-6
+        << setw(12) << GetMedian(result.seconds) * 1e3 << endl;
+  }
+}
+
+// every sample is kept, so runs can be compared by distribution later
+void WriteJson(const std::vector<Result>& results, size_t sizeKb, int runCount,
+               const std::string& path)
+{
+  using namespace std;
+
+  ostringstream text;
+  text << setprecision(9) << "{\n  \"size_kb\": " << sizeKb << ",\n  \"runs\": " << runCount
+       << ",\n  \"results\": [";
+  for (size_t i = 0; i < results.size(); i++)
+  {
+    const Result& result = results[i];
+    text << (i > 0 ? "," : "") << "\n    {\"input\": \"" << result.input
+         << "\", \"stage\": \"" << result.stage
+         << "\", \"bytes\": " << result.bytes << ", \"tokens\": " << result.tokens
+         << ", \"mb_per_s\": " << GetMbPerSecond(result)
+         << ", \"tokens_per_s\": " << GetTokensPerSecond(result) << ", \"seconds\": [";
+    for (size_t j = 0; j < result.seconds.size(); j++)
+    {
+      text << (j > 0 ? ", " : "") << result.seconds[j];
+    }
+    text << "]}";
+  }
+  text << "\n  ]\n}\n";
+
+  ofstream file(path, ios::binary);
+  file << text.str();
+  if (!file)
+  {
+    throw runtime_error("can't write " + path);
+  }
+}
+
+void ShowHelp()
+{
+  std::cout <<
+               R"(Front end and code generator throughput on synthetic sources.
+               Usage: benchmarks [OPTION]...
+
+               --size KB                 size of each generated source,
+                                         512 by default
+               --runs N                  timed runs of each stage, median
+                                         is reported, 5 by default; one
+                                         more runs first and is not timed
+               --filter TEXT             run only inputs and stages which
+                                         INPUT/STAGE contains TEXT
+               --json FILE               write every timed run to FILE,
+                                         scripts/compare_benchmarks.pl
+                                         tells regressions between two
+               --dump DIR                write generated sources to DIR
+                                         as INPUT.c and exit
+               -h, --help                display this help and exit
+              )";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  using namespace std;
+
+  size_t sizeKb = 512;
+  int runCount = 5;
+  string filter;
+  string jsonPath;
+  string dumpDirectory;
+  for (int i = 1; i < argc; i++)
+  {
+    string option = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (option == "--size" && hasValue && atoi(argv[i + 1]) > 0)
+    {
+      sizeKb = atoi(argv[++i]);
+    }
+    else if (option == "--runs" && hasValue && atoi(argv[i + 1]) > 0)
+    {
+      runCount = atoi(argv[++i]);
+    }
+    else if (option == "--filter" && hasValue)
+    {
+      filter = argv[++i];
+    }
+    else if (option == "--json" && hasValue)
+    {
+      jsonPath = argv[++i];
+    }
+    else if (option == "--dump" && hasValue)
+    {
+      dumpDirectory = argv[++i];
+    }
+    else
+    {
+      ShowHelp();
+      return option == "-h" || option == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  vector<Result> results;
+  // input or benchmark which failed
+  string current;
+  try
+  {
+    for (auto& generator : GetInputGenerators())
+    {
+      current = generator.name;
+      string text = generator.generate(sizeKb << 10);
+      vector<char> input(text.begin(), text.end());
+      if (!dumpDirectory.empty())
+      {
+        ofstream file(dumpDirectory + "/" + generator.name + ".c", ios::binary);
+        file << text;
+        if (!file)
+        {
+          throw runtime_error("can't write to " + dumpDirectory);
+        }
+        continue;
+      }
+
+      CountingTokenStream tokens;
+      {
+        Tokenizer tokenizer(tokens);
+        PreTokenizer pretokenizer(input, tokenizer);
+      }
+
+      for (auto& stage : stages)
+      {
+        string name = string(generator.name) + "/" + stage.name;
+        if (name.find(filter) == string::npos)
+        {
+          continue;
+        }
+
+        current = name;
+        Result result{generator.name, stage.name, input.size(), tokens.count, {}};
+        stage.run(input);
+        for (int run = 0; run < runCount; run++)
+        {
+          auto start = chrono::steady_clock::now();
+          stage.run(input);
+          result.seconds.push_back(
+                chrono::duration<double>(chrono::steady_clock::now() - start).count());
+        }
+        results.push_back(result);
+      }
+    }
+
+    if (!dumpDirectory.empty())
+    {
+      return EXIT_SUCCESS;
+    }
+    PrintTable(results, cout);
+    if (!jsonPath.empty())
+    {
+      WriteJson(results, sizeKb, runCount, jsonPath);
+    }
+  }
+  catch (exception& e)
+  {
+    cerr << "ERROR: " << current << ": " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
@@ -2,6 +2,7 @@ TEMPLATE = app
 CONFIG += console
 CONFIG -= app_bundle
 CONFIG -= qt
+CONFIG += thread
 
 QMAKE_CXXFLAGS += -std=c++11
 
@@ -17,12 +18,52 @@ CONFIG(debug, debug|release) {
     TARGET = compiler-release
 }
 
+DEFINES += BOOST_ALL_NO_LIB
+
+LIBS += \
+    -lboost_system-mgw48-mt-1_55 \
+    -lboost_coroutine-mgw48-mt-1_55 \
+    -lboost_context-mgw48-mt-1_55 \
+
+# names of allocation sites for --alloc-stats
+unix {
+    QMAKE_LFLAGS += -rdynamic
+    LIBS += -ldl
+}
+
 SOURCES += src/main.cpp \
     src/utils.cpp \
     src/PreTokenizer.cpp \
     src/unicode.cpp \
     src/Tokenizer.cpp \
-    src/SimpleExpressionParser.cpp
+    src/SimpleExpressionParser.cpp \
+    src/ExpressionParser.cpp \
+    src/Token.cpp \
+    src/Parser.cpp \
+    src/ASTNode.cpp \
+    src/SymbolTable.cpp \
+    src/prettyPrinting.cpp \
+    src/OutputSink.cpp \
+    src/Statement.cpp \
+    src/codegen.cpp \
+    src/AsmInstruction.cpp \
+    src/PeepholeOptimizer.cpp \
+    src/Bytecode.cpp \
+    src/BytecodeCompiler.cpp \
+    src/Interpreter.cpp \
+    src/Jit.cpp \
+    src/ThreadPool.cpp \
+    src/TokenPipeline.cpp \
+    src/Driver.cpp \
+    src/CompileServer.cpp \
+    src/CompileCache.cpp \
+    src/PrecompiledDeclarations.cpp \
+    src/MappedFile.cpp \
+    src/AstFile.cpp \
+    src/TimeReport.cpp \
+    src/Trace.cpp \
+    src/AllocationTracker.cpp \
+    src/IncrementalParser.cpp
 
 HEADERS += \
     src/utils.hpp \
@@ -34,5 +75,34 @@ HEADERS += \
     src/DebugPreTokenStream.hpp \
     src/DebugTokenOutputStream.hpp \
     src/SimpleExpressionParser.hpp \
-    src/ITokenStream.hpp
+    src/ITokenStream.hpp \
+    src/ExpressionParser.hpp \
+    src/Token.hpp \
+    src/Parser.hpp \
+    src/ASTNode.hpp \
+    src/SymbolTable.hpp \
+    src/prettyPrinting.hpp \
+    src/OutputSink.hpp \
+    src/Statement.hpp \
+    src/Visitor.hpp \
+    src/codegen.hpp \
+    src/AsmInstruction.hpp \
+    src/PeepholeOptimizer.hpp \
+    src/Bytecode.hpp \
+    src/BytecodeCompiler.hpp \
+    src/Interpreter.hpp \
+    src/Jit.hpp \
+    src/ThreadPool.hpp \
+    src/SpscQueue.hpp \
+    src/TokenPipeline.hpp \
+    src/Driver.hpp \
+    src/CompileServer.hpp \
+    src/CompileCache.hpp \
+    src/PrecompiledDeclarations.hpp \
+    src/MappedFile.hpp \
+    src/AstFile.hpp \
+    src/TimeReport.hpp \
+    src/Trace.hpp \
+    src/AllocationTracker.hpp \
+    src/IncrementalParser.hpp
 
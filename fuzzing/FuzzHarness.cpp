@@ -0,0 +1,145 @@
+#include "FuzzHarness.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <streambuf>
+#include <chrono>
+#include <stdexcept>
+#include <algorithm>
+#include <cmath>
+
+#include <boost/coroutine/all.hpp>
+
+namespace Fuzzing
+{
+//==============================================================================
+namespace
+{
+  // inputs which run shorter are not checked, so most runs cost one call
+  const double minCheckedSeconds = 0.001;
+  // checked input is repeated until a run takes this long, shorter ones are
+  // mostly noise
+  const double minComparedSeconds = 0.05;
+  // time which doesn't reach it by this size doesn't grow with input,
+  // stage likely stops at the first error
+  const size_t maxRepeatedSize = 1 << 24;
+  // median of this many runs is compared, single slow runs don't count
+  const int comparedRunCount = 5;
+  // doubling input about doubles time of linear stage, quadruples it for
+  // quadratic one
+  const double maxGrowth = 3.0;
+
+  class NullBuffer : public std::streambuf
+  {
+  protected:
+    virtual int_type overflow(int_type c)
+    {
+      return traits_type::not_eof(c);
+    }
+
+    virtual std::streamsize xsputn(const char*, std::streamsize count)
+    {
+      return count;
+    }
+  };
+
+  double GetSeconds(void (*stage)(const std::vector<char>&), const std::vector<char>& input)
+  {
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+      stage(input);
+    }
+    catch (std::exception&)
+    {
+
+    }
+    catch (boost::coroutines::detail::forced_unwind&)
+    {
+      throw;
+    }
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  }
+
+  double GetMedianSeconds(void (*stage)(const std::vector<char>&), const std::vector<char>& input)
+  {
+    std::vector<double> seconds;
+    for (int i = 0; i < comparedRunCount; i++)
+    {
+      seconds.push_back(GetSeconds(stage, input));
+    }
+    std::nth_element(seconds.begin(), seconds.begin() + comparedRunCount / 2, seconds.end());
+    return seconds[comparedRunCount / 2];
+  }
+
+  // copies are put on lines of their own, so columns stay as they are
+  std::vector<char> Repeat(const std::vector<char>& input, size_t count)
+  {
+    std::vector<char> repeated;
+    repeated.reserve((input.size() + 1) * count);
+    for (size_t i = 0; i < count; i++)
+    {
+      repeated.insert(repeated.end(), input.begin(), input.end());
+      repeated.push_back('\n');
+    }
+    return repeated;
+  }
+
+  // whether median time of input repeated twice as many times as `count`
+  // is more than `maxGrowth` times the median of `count` times
+  bool GrowsFasterThanInput(void (*stage)(const std::vector<char>&),
+                            const std::vector<char>& input, size_t count,
+                            double& seconds, double& doubledSeconds)
+  {
+    seconds = GetMedianSeconds(stage, Repeat(input, count));
+    doubledSeconds = GetMedianSeconds(stage, Repeat(input, 2 * count));
+    return doubledSeconds > maxGrowth * seconds;
+  }
+
+} // namespace
+
+//==============================================================================
+void RunStage(const uint8_t* data, size_t size, void (*stage)(const std::vector<char>& input))
+{
+  static NullBuffer nullBuffer;
+  std::cout.rdbuf(&nullBuffer);
+  std::cerr.rdbuf(&nullBuffer);
+
+  std::vector<char> input(data, data + size);
+  double seconds = GetSeconds(stage, input);
+  if (seconds < minCheckedSeconds)
+  {
+    return;
+  }
+
+  // the first run pays for cold caches
+  seconds = std::min(seconds, GetSeconds(stage, input));
+  if (seconds < minCheckedSeconds)
+  {
+    return;
+  }
+
+  size_t count = static_cast<size_t>(std::ceil(minComparedSeconds / seconds));
+  while (GetMedianSeconds(stage, Repeat(input, count)) < minComparedSeconds)
+  {
+    if ((size + 1) * count * 2 > maxRepeatedSize)
+    {
+      return;
+    }
+    count *= 2;
+  }
+
+  double doubledSeconds = 0.0;
+  // the machine may be busy with something else for a while, so growth
+  // must show up twice
+  if (GrowsFasterThanInput(stage, input, count, seconds, doubledSeconds)
+      && GrowsFasterThanInput(stage, input, count, seconds, doubledSeconds))
+  {
+    std::fprintf(stderr, "super-linear time: %zu bytes took %.3f ms, twice them %.3f ms\n",
+                 (size + 1) * count, seconds * 1e3, doubledSeconds * 1e3);
+    std::abort();
+  }
+}
+
+} // namespace Fuzzing
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Fuzzing
+{
+// runs `stage` over `data` with standard output dropped; errors compiler
+// reports on malformed input are expected, crashes, failed assertions and
+// sanitizer reports are what fuzzer looks for, and so is time which grows
+// faster than input: input that took a millisecond or more is repeated
+// until a run takes about 50 ms, then twice as many times, and harness
+// aborts if median of five runs of the latter is more than three times
+// as long, twice in a row
+void RunStage(const uint8_t* data, size_t size, void (*stage)(const std::vector<char>& input));
+
+} // namespace Fuzzing
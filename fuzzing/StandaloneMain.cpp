@@ -0,0 +1,74 @@
+#include <cstdlib>
+#include <cstdint>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include <dirent.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace
+{
+// files of `path` if it is a directory, `path` itself otherwise
+std::vector<std::string> ListInputs(const std::string& path)
+{
+  std::vector<std::string> inputs;
+  DIR* handle = opendir(path.c_str());
+  if (handle == NULL)
+  {
+    inputs.push_back(path);
+    return inputs;
+  }
+  while (dirent* item = readdir(handle))
+  {
+    if (item->d_name[0] != '.')
+    {
+      inputs.push_back(path + "/" + item->d_name);
+    }
+  }
+  closedir(handle);
+  std::sort(inputs.begin(), inputs.end());
+  return inputs;
+}
+
+} // namespace
+
+// without libFuzzer harness runs once over each input given, so corpus
+// and crash inputs are replayed by any compiler
+int main(int argc, char** argv)
+{
+  using namespace std;
+
+  if (argc < 2)
+  {
+    cout << "Usage: " << argv[0] << " FILE_OR_DIR..." << endl;
+    return EXIT_FAILURE;
+  }
+
+  size_t count = 0;
+  for (int i = 1; i < argc; i++)
+  {
+    for (auto& path : ListInputs(argv[i]))
+    {
+      ifstream file(path, ios::binary);
+      if (!file)
+      {
+        cerr << "ERROR: can't open " << path << endl;
+        return EXIT_FAILURE;
+      }
+      ostringstream text;
+      text << file.rdbuf();
+      string data = text.str();
+      // named first, so the input which crashes is known
+      clog << path << endl;
+      LLVMFuzzerTestOneInput(reinterpret_cast<const uint8_t*>(data.data()), data.size());
+      count++;
+    }
+  }
+  clog << count << " inputs run" << endl;
+  return EXIT_SUCCESS;
+}
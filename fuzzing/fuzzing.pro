@@ -0,0 +1,84 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += thread
+
+QMAKE_CXXFLAGS += -std=c++11 -g
+
+DESTDIR = ../bin
+
+INCLUDEPATH += ../src
+
+# one harness a build: qmake HARNESS=pretokenizer, tokenizer or parser;
+# scripts/make_fuzz_corpus.pl HARNESS DIR seeds DIR with test inputs, then
+# `fuzz-HARNESS-release -dict=c.dict DIR` fuzzes from there
+isEmpty(HARNESS): HARNESS = parser
+
+# parser runs on boost coroutine stacks, which address sanitizer can't
+# follow unless boost is built with BOOST_USE_ASAN, so build it with
+# SANITIZERS=undefined otherwise
+isEmpty(SANITIZERS): SANITIZERS = address,undefined
+
+# CONFIG+=libfuzzer needs clang, without it harness is built with
+# StandaloneMain.cpp and replays corpus and crash inputs given to it
+CONFIG(libfuzzer) {
+    QMAKE_CXXFLAGS += -fsanitize=fuzzer,$${SANITIZERS}
+    QMAKE_LFLAGS += -fsanitize=fuzzer,$${SANITIZERS}
+} else {
+    SOURCES += StandaloneMain.cpp
+}
+
+CONFIG(debug, debug|release) {
+    DEFINES += \
+        _DEBUG
+    OBJECTS_DIR = temp/$${HARNESS}/debug/obj
+    TARGET = fuzz-$${HARNESS}-debug
+} else {
+    OBJECTS_DIR = temp/$${HARNESS}/release/obj
+    TARGET = fuzz-$${HARNESS}-release
+}
+
+DEFINES += BOOST_ALL_NO_LIB
+
+LIBS += \
+    -lboost_system-mgw48-mt-1_55 \
+    -lboost_coroutine-mgw48-mt-1_55 \
+    -lboost_context-mgw48-mt-1_55 \
+
+SOURCES += $${HARNESS}.cpp \
+    FuzzHarness.cpp \
+    ../src/utils.cpp \
+    ../src/unicode.cpp \
+    ../src/PreTokenizer.cpp \
+    ../src/Tokenizer.cpp \
+    ../src/Token.cpp \
+    ../src/Parser.cpp \
+    ../src/ASTNode.cpp \
+    ../src/SymbolTable.cpp \
+    ../src/prettyPrinting.cpp \
+    ../src/OutputSink.cpp \
+    ../src/Statement.cpp \
+    ../src/TimeReport.cpp \
+    ../src/Trace.cpp
+
+HEADERS += FuzzHarness.hpp \
+    ../src/utils.hpp \
+    ../src/unicode.hpp \
+    ../src/PreTokenizer.hpp \
+    ../src/Tokenizer.hpp \
+    ../src/IPreTokenStream.hpp \
+    ../src/ITokenStream.hpp \
+    ../src/DebugPreTokenStream.hpp \
+    ../src/DebugTokenOutputStream.hpp \
+    ../src/constants.hpp \
+    ../src/Token.hpp \
+    ../src/Parser.hpp \
+    ../src/ASTNode.hpp \
+    ../src/SymbolTable.hpp \
+    ../src/prettyPrinting.hpp \
+    ../src/OutputSink.hpp \
+    ../src/Statement.hpp \
+    ../src/Visitor.hpp \
+    ../src/TimeReport.hpp \
+    ../src/Trace.hpp
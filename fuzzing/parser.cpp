@@ -0,0 +1,20 @@
+#include "FuzzHarness.hpp"
+
+#include <iostream>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Parser.hpp"
+
+// raw bytes into declarations, statements and symbol tables, which are
+// printed as the parser tests print them
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  Fuzzing::RunStage(data, size, [](const std::vector<char>& input)
+  {
+    Compiler::Parser parser(std::cout);
+    Compiler::Tokenizer tokenizer(parser);
+    Compiler::PreTokenizer pretokenizer(input, tokenizer);
+  });
+  return 0;
+}
@@ -0,0 +1,15 @@
+#include "FuzzHarness.hpp"
+
+#include "PreTokenizer.hpp"
+#include "DebugPreTokenStream.hpp"
+
+// raw bytes into UTF-8 decoding, trigraphs, line splicing and pretokens
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  Fuzzing::RunStage(data, size, [](const std::vector<char>& input)
+  {
+    Compiler::DebugPreTokenStream output;
+    Compiler::PreTokenizer pretokenizer(input, output);
+  });
+  return 0;
+}
@@ -0,0 +1,20 @@
+#include "FuzzHarness.hpp"
+
+#include <iostream>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "DebugTokenOutputStream.hpp"
+
+// raw bytes into tokens and their literal values, printed as the
+// tokenizer tests print them
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+  Fuzzing::RunStage(data, size, [](const std::vector<char>& input)
+  {
+    Compiler::DebugTokenOutputStream output(std::cout);
+    Compiler::Tokenizer tokenizer(output);
+    Compiler::PreTokenizer pretokenizer(input, tokenizer);
+  });
+  return 0;
+}
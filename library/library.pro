@@ -0,0 +1,92 @@
+TEMPLATE = lib
+CONFIG -= qt
+CONFIG += thread
+# static library by default, `qmake CONFIG+=compiler_shared` builds
+# shared one, whose users define COMPILER_SHARED too
+CONFIG += staticlib
+compiler_shared {
+    CONFIG -= staticlib
+    CONFIG += shared
+    DEFINES += COMPILER_SHARED COMPILER_BUILD_LIBRARY
+    unix {
+        QMAKE_CXXFLAGS += -fvisibility=hidden
+    }
+}
+
+QMAKE_CXXFLAGS += -std=c++11
+
+DESTDIR = ../lib
+
+INCLUDEPATH += ../src
+
+CONFIG(debug, debug|release) {
+    DEFINES += \
+        _DEBUG
+    OBJECTS_DIR = temp/debug/obj
+    TARGET = compiler-debug
+} else {
+    OBJECTS_DIR = temp/release/obj
+    TARGET = compiler
+}
+
+DEFINES += BOOST_ALL_NO_LIB
+
+LIBS += \
+    -lboost_system-mgw48-mt-1_55 \
+    -lboost_coroutine-mgw48-mt-1_55 \
+    -lboost_context-mgw48-mt-1_55 \
+
+# src/CompilerLibrary.hpp is the interface, only what Compile reaches is
+# linked; allocation tracker is left out as it replaces operator new of
+# whole program
+SOURCES += \
+    ../src/utils.cpp \
+    ../src/PreTokenizer.cpp \
+    ../src/unicode.cpp \
+    ../src/Tokenizer.cpp \
+    ../src/Token.cpp \
+    ../src/Parser.cpp \
+    ../src/ASTNode.cpp \
+    ../src/SymbolTable.cpp \
+    ../src/prettyPrinting.cpp \
+    ../src/OutputSink.cpp \
+    ../src/Statement.cpp \
+    ../src/codegen.cpp \
+    ../src/AsmInstruction.cpp \
+    ../src/PeepholeOptimizer.cpp \
+    ../src/Bytecode.cpp \
+    ../src/BytecodeCompiler.cpp \
+    ../src/ThreadPool.cpp \
+    ../src/TokenPipeline.cpp \
+    ../src/TimeReport.cpp \
+    ../src/Trace.cpp \
+    ../src/CompilerLibrary.cpp
+
+HEADERS += \
+    ../src/utils.hpp \
+    ../src/constants.hpp \
+    ../src/PreTokenizer.hpp \
+    ../src/Tokenizer.hpp \
+    ../src/unicode.hpp \
+    ../src/IPreTokenStream.hpp \
+    ../src/DebugTokenOutputStream.hpp \
+    ../src/ITokenStream.hpp \
+    ../src/Token.hpp \
+    ../src/Parser.hpp \
+    ../src/ASTNode.hpp \
+    ../src/SymbolTable.hpp \
+    ../src/prettyPrinting.hpp \
+    ../src/OutputSink.hpp \
+    ../src/Statement.hpp \
+    ../src/Visitor.hpp \
+    ../src/codegen.hpp \
+    ../src/AsmInstruction.hpp \
+    ../src/PeepholeOptimizer.hpp \
+    ../src/Bytecode.hpp \
+    ../src/BytecodeCompiler.hpp \
+    ../src/ThreadPool.hpp \
+    ../src/SpscQueue.hpp \
+    ../src/TokenPipeline.hpp \
+    ../src/TimeReport.hpp \
+    ../src/Trace.hpp \
+    ../src/CompilerLibrary.hpp
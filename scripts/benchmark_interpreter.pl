@@ -0,0 +1,78 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+use Time::HiRes qw(time);
+
+if (scalar(@ARGV) < 1 or scalar(@ARGV) > 2)
+{
+	die "Usage: benchmark_interpreter.pl <app> [runs]";
+}
+
+my $app = $ARGV[0];
+my $runs = scalar(@ARGV) == 2 ? $ARGV[1] : 5;
+
+# native code needs MASM toolchain, see sandbox/do.bat
+my $native = (system("which ml > /dev/null 2>&1") == 0
+	and system("which link > /dev/null 2>&1") == 0);
+
+sub best_time
+{
+	my ($command, $expected) = @_;
+	my $best;
+
+	for (my $i = 0; $i < $runs; $i++)
+	{
+		my $start = time();
+		my $output = `$command`;
+		my $elapsed = time() - $start;
+
+		chomp($output);
+		if ($output ne $expected)
+		{
+			return undef;
+		}
+
+		$best = $elapsed if (!defined($best) or $elapsed < $best);
+	}
+
+	return $best;
+}
+
+my @benchmarks = split(/\s+/, `find benchmarks/interpreter -name '*.c'`);
+
+printf("%-12s %12s %12s %12s %12s %8s\n", "benchmark", "interpret", "tiered", "run", "native", "ratio");
+
+for my $benchmark (sort @benchmarks)
+{
+	my $base = $benchmark;
+	$base =~ s/\.c$//;
+	my $name = $base;
+	$name =~ s/.*\///;
+
+	my $expected = `cat $base.ref`;
+	chomp($expected);
+
+	my $interpreted = best_time("./$app --interpret $benchmark", $expected);
+	my $tiered = best_time("./$app --tiered $benchmark", $expected);
+	my $jit = best_time("./$app --run $benchmark", $expected);
+	my $compiled;
+
+	if ($native)
+	{
+		system("./$app -S $benchmark > $base.asm") == 0 or die "$benchmark: compilation failed";
+		system("ml /nologo /c /Cp /coff /Fo$base.obj $base.asm > /dev/null") == 0 or die "$benchmark: ml failed";
+		system("link /nologo $base.obj /DEFAULTLIB:libcmt /SUBSYSTEM:console /out:$base.exe /entry:mainCRTStartup > /dev/null") == 0
+			or die "$benchmark: link failed";
+		$compiled = best_time("$base.exe", $expected);
+		unlink("$base.asm", "$base.obj", "$base.exe");
+	}
+
+	printf("%-12s %12s %12s %12s %12s %8s\n", $name,
+		defined($interpreted) ? sprintf("%.3fs", $interpreted) : "WRONG",
+		defined($tiered) ? sprintf("%.3fs", $tiered) : "WRONG",
+		defined($jit) ? sprintf("%.3fs", $jit) : "WRONG",
+		defined($compiled) ? sprintf("%.3fs", $compiled) : ($native ? "WRONG" : "n/a"),
+		(defined($interpreted) and defined($compiled) and $compiled > 0)
+			? sprintf("%.1fx", $interpreted / $compiled) : "-");
+}
@@ -0,0 +1,186 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use JSON::PP;
+
+# fails when a benchmark of <new> is slower than the same one of <base> by
+# more than threshold percent of median time and Mann-Whitney U test over
+# their runs says it is not by chance; results are what
+# `benchmarks --json FILE` writes, both made with the same --size
+if (scalar(@ARGV) < 2 or scalar(@ARGV) > 4)
+{
+	die "Usage: compare_benchmarks.pl <base.json> <new.json> [threshold_percent] [significance]";
+}
+
+my $base_path = $ARGV[0];
+my $new_path = $ARGV[1];
+my $threshold = scalar(@ARGV) >= 3 ? $ARGV[2] / 100 : 0.05;
+my $significance = scalar(@ARGV) == 4 ? $ARGV[3] : 0.05;
+
+sub ReadResults
+{
+	my ($path) = @_;
+	open(my $file, '<', $path) or die "can't open $path";
+	local $/;
+	my $json = decode_json(<$file>);
+	close($file);
+
+	my %results;
+	for my $result (@{$json->{results}})
+	{
+		$results{"$result->{input}/$result->{stage}"} = $result;
+	}
+	return %results;
+}
+
+sub Median
+{
+	my @sorted = sort { $a <=> $b } @_;
+	my $middle = int(scalar(@sorted) / 2);
+	return scalar(@sorted) % 2 ? $sorted[$middle] : ($sorted[$middle - 1] + $sorted[$middle]) / 2;
+}
+
+# U of second sample: pairs in which its value is greater, ties count half
+sub MannWhitneyU
+{
+	my ($first, $second) = @_;
+	my $u = 0;
+	for my $y (@$second)
+	{
+		for my $x (@$first)
+		{
+			$u += $y > $x ? 1 : ($y == $x ? 0.5 : 0);
+		}
+	}
+	return $u;
+}
+
+# probability of U this large or larger if both samples come from the same
+# distribution; exact count of rank orders for small samples, normal
+# approximation otherwise
+sub PValue
+{
+	my ($u, $n1, $n2) = @_;
+
+	if ($n1 * $n2 > 2500)
+	{
+		my $mean = $n1 * $n2 / 2;
+		my $deviation = sqrt($n1 * $n2 * ($n1 + $n2 + 1) / 12);
+		my $z = ($u - 0.5 - $mean) / $deviation;
+		# upper tail of standard normal, Abramowitz and Stegun 26.2.17
+		my $t = 1 / (1 + 0.2316419 * abs($z));
+		my $tail = exp(-$z * $z / 2) / sqrt(2 * 3.14159265358979)
+			* $t * (0.319381530 + $t * (-0.356563782 + $t * (1.781477937
+				+ $t * (-1.821255978 + $t * 1.330274429))));
+		return $z >= 0 ? $tail : 1 - $tail;
+	}
+
+	# $counts[$i][$j][$u]: orders of $i and $j values which give U of $u
+	my @counts;
+	for my $i (0 .. $n1)
+	{
+		for my $j (0 .. $n2)
+		{
+			if ($i == 0 or $j == 0)
+			{
+				$counts[$i][$j] = [1];
+				next;
+			}
+			my @ways;
+			my $previous_first = $counts[$i - 1][$j];
+			my $previous_second = $counts[$i][$j - 1];
+			# largest value is from second sample and greater than all $i of first
+			for my $k (0 .. $#$previous_second)
+			{
+				$ways[$k + $i] += $previous_second->[$k];
+			}
+			for my $k (0 .. $#$previous_first)
+			{
+				$ways[$k] += $previous_first->[$k];
+			}
+			$counts[$i][$j] = [map { defined($_) ? $_ : 0 } @ways];
+		}
+	}
+
+	my $distribution = $counts[$n1][$n2];
+	my ($total, $tail) = (0, 0);
+	for my $k (0 .. $#$distribution)
+	{
+		$total += $distribution->[$k];
+		$tail += $distribution->[$k] if ($k >= $u - 1e-9);
+	}
+	return $tail / $total;
+}
+
+my %base = ReadResults($base_path);
+my %new = ReadResults($new_path);
+
+printf("%-32s %10s %10s %8s %8s  %s\n", "benchmark", "base ms", "new ms", "change", "p", "verdict");
+
+my $regressions = 0;
+for my $name (sort keys %base)
+{
+	my $base_result = $base{$name};
+	my $new_result = $new{$name};
+	if (!defined($new_result))
+	{
+		printf("%-32s %s\n", $name, "not in $new_path");
+		next;
+	}
+	if ($base_result->{bytes} != $new_result->{bytes})
+	{
+		die "$name: inputs differ, compare runs of the same --size";
+	}
+
+	my @base_seconds = @{$base_result->{seconds}};
+	my @new_seconds = @{$new_result->{seconds}};
+	my $base_median = Median(@base_seconds);
+	my $new_median = Median(@new_seconds);
+	my $change = $new_median / $base_median - 1;
+	my $p = PValue(MannWhitneyU(\@base_seconds, \@new_seconds),
+		scalar(@base_seconds), scalar(@new_seconds));
+
+	my $verdict = "ok";
+	if ($change > $threshold and $p < $significance)
+	{
+		$verdict = "REGRESSION";
+		$regressions++;
+	}
+	elsif ($change > $threshold)
+	{
+		$verdict = "slower, not significant";
+	}
+	elsif (-$change > $threshold
+		and PValue(MannWhitneyU(\@new_seconds, \@base_seconds),
+			scalar(@new_seconds), scalar(@base_seconds)) < $significance)
+	{
+		$verdict = "faster";
+	}
+
+	printf("%-32s %10.3f %10.3f %+7.1f%% %8.4f  %s\n", $name,
+		$base_median * 1e3, $new_median * 1e3, $change * 100, $p, $verdict);
+}
+
+# with few runs no outcome is unlikely enough
+my ($n1, $n2) = (0, 0);
+for my $name (keys %base)
+{
+	next if (!defined($new{$name}));
+	$n1 = scalar(@{$base{$name}->{seconds}});
+	$n2 = scalar(@{$new{$name}->{seconds}});
+	last;
+}
+if ($n1 > 0 and PValue($n1 * $n2, $n1, $n2) >= $significance)
+{
+	print "\nWARNING: $n1 and $n2 runs can't show significance $significance, use more --runs\n";
+}
+
+if ($regressions > 0)
+{
+	print "\n$regressions REGRESSIONS\n";
+	exit(1);
+}
+
+print "\nNO REGRESSIONS\n";
@@ -0,0 +1,44 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use File::Copy;
+use File::Path qw(make_path);
+
+# seeds fuzzing corpus of harness with golden test inputs: every suite
+# for pretokenizer and tokenizer, translation units for parser
+if (scalar(@ARGV) != 2)
+{
+	die "Usage: make_fuzz_corpus.pl <pretokenizer|tokenizer|parser> <corpus_dir>";
+}
+
+my $harness = $ARGV[0];
+my $corpus = $ARGV[1];
+
+my %suites =
+(
+	pretokenizer => [qw(tokenizer simple-expression-parser expression-parser parser type-check codegen bytecode)],
+	tokenizer => [qw(tokenizer simple-expression-parser expression-parser parser type-check codegen bytecode)],
+	parser => [qw(parser type-check codegen bytecode)],
+);
+
+if (!defined($suites{$harness}))
+{
+	die "unknown harness $harness";
+}
+
+make_path($corpus);
+
+my $count = 0;
+for my $suite (@{$suites{$harness}})
+{
+	for my $test (sort glob("tests/$suite/*.t"))
+	{
+		my ($name) = $test =~ m/([^\/]+)\.t$/;
+		copy($test, "$corpus/$suite-$name") or die "can't copy $test to $corpus";
+		$count++;
+	}
+}
+
+print "$count seeds in $corpus\n";
@@ -0,0 +1,84 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+use IO::Socket::UNIX;
+use Time::HiRes qw(time sleep);
+
+if (scalar(@ARGV) < 2 or scalar(@ARGV) > 3)
+{
+	die "Usage: server_latency.pl <app> <file> [runs]";
+}
+
+my $app = $ARGV[0];
+my $file = $ARGV[1];
+my $runs = scalar(@ARGV) == 3 ? $ARGV[2] : 100;
+my $socket = "/tmp/compiler-latency-$$.sock";
+
+sub Report
+{
+	my ($name, @times) = @_;
+	my @sorted = sort { $a <=> $b } @times;
+	printf("%-16s %10dus %10dus %10dus\n", $name,
+		$sorted[int($#sorted / 2)] * 1e6,
+		$sorted[int($#sorted * 0.9)] * 1e6,
+		$sorted[-1] * 1e6);
+}
+
+# same framing as CompileServer: big endian lengths, arguments, source
+sub Request
+{
+	my ($source) = @_;
+	my $connection = IO::Socket::UNIX->new(Peer => $socket, Type => SOCK_STREAM)
+		or die "can't connect to $socket";
+	my @arguments = ("-S", $file);
+	my $request = pack("N", scalar(@arguments));
+	$request .= pack("N/a*", $_) for @arguments;
+	$request .= pack("N/a*", $source);
+	print $connection $request;
+
+	local $/;
+	my $response = <$connection>;
+	my ($status, $output, $errors) = unpack("N N/a* N/a*", $response);
+	die "request failed: $errors" if $status != 0;
+}
+
+open(my $input, "<", $file) or die "can't open $file";
+binmode($input);
+my $source = do { local $/; <$input> };
+close($input);
+
+my $server = fork();
+if ($server == 0)
+{
+	exec("./$app", "--server", $socket) or die "can't start server";
+}
+for (my $i = 0; $i < 100 and not -S $socket; $i++)
+{
+	sleep(0.05);
+}
+
+my (@cold, @client, @request);
+for (1..$runs)
+{
+	my $start = time();
+	system("./$app -S $file >/dev/null") == 0 or die "compilation failed";
+	push(@cold, time() - $start);
+
+	$start = time();
+	system("./$app --connect $socket -S $file >/dev/null") == 0 or die "client failed";
+	push(@client, time() - $start);
+
+	$start = time();
+	Request($source);
+	push(@request, time() - $start);
+}
+
+printf("%-16s %12s %12s %12s\n", "$runs runs", "median", "90%", "max");
+Report("cold process", @cold);
+Report("client process", @client);
+Report("request only", @request);
+
+system("./$app --connect $socket --shutdown");
+waitpid($server, 0);
@@ -0,0 +1,38 @@
+#!/usr/bin/perl
+
+use strict;
+use warnings;
+
+if (scalar(@ARGV) < 1 or scalar(@ARGV) > 2)
+{
+	die "Usage: time_to_first_instruction.pl <app> [test_dir]";
+}
+
+my $app = $ARGV[0];
+my $dir = scalar(@ARGV) == 2 ? $ARGV[1] : "tests/codegen";
+
+my @tests = split(/\s+/, `find $dir -name '*.t' -o -name '*.c'`);
+my @totals;
+
+printf("%-28s %10s %10s %10s %8s\n", "test", "total", "front end", "codegen", "bytes");
+
+for my $test (sort @tests)
+{
+	my $stats = `./$app --run --jit-stats $test 2>&1 >/dev/null`;
+
+	if ($stats !~ m/time to first instruction: (\d+) us.*front end: (\d+) us.*machine code: (\d+) us, \d+ functions, (\d+) bytes/s)
+	{
+		printf("%-28s %10s\n", $test, "FAIL");
+		next;
+	}
+
+	push(@totals, $1);
+	printf("%-28s %8dus %8dus %8dus %8d\n", $test, $1, $2, $3, $4);
+}
+
+if (@totals)
+{
+	my @sorted = sort { $a <=> $b } @totals;
+	printf("\nmedian %dus, max %dus over %d tests\n",
+		$sorted[int($#sorted / 2)], $sorted[-1], scalar(@sorted));
+}
@@ -5,11 +5,10 @@
 
 #include "SymbolTable.hpp"
 #include "Parser.hpp"
+#include "TimeReport.hpp"
 
 namespace Compiler
 {
-// not sure if really need it
-extern Parser* theParser;
 ////////////////////////////////////////////////////////////////////////////////
 ASTNode::~ASTNode()
 {
@@ -43,6 +42,12 @@ shared_ptr<SymbolType> ASTNode::GetTypeSym() const
         return typeSym_;
 }
 
+//==============================================================================
+bool ASTNode::HasTypeSym() const
+{
+        return typeSym_ != NULL;
+}
+
 //==============================================================================
 bool ASTNode::IsConstExpr() const
 {
@@ -74,7 +79,7 @@ int ASTNode::EvalToInt() const
 ASTNode::ASTNode(const Token &token)
         : token(token)
 {
-
+        TimeReport::Count(TimeReport::ECounter::AST_NODES);
 }
 
 //==============================================================================
@@ -83,6 +88,7 @@ ASTNode::ASTNode(const Token& token, shared_ptr<SymbolType> type)
         , typeSym_(type)
 {
         assert(type != NULL);
+        TimeReport::Count(TimeReport::ECounter::AST_NODES);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -205,10 +211,9 @@ ASTNodeBinaryOperator::ASTNodeBinaryOperator(const Token& token, shared_ptr<ASTN
             case OP_LE:
             case OP_GT:
             case OP_LT:
-                break;
-
             case OP_EQ:
             case OP_NE:
+                SetTypeSym(make_shared<SymbolInt>());
                 break;
 
             case OP_AMP:
@@ -343,8 +348,9 @@ ASTNodeUnaryOperator::ASTNodeUnaryOperator(const Token& token)
 }
 
 //==============================================================================
-ASTNodeUnaryOperator::ASTNodeUnaryOperator(const Token& token, shared_ptr<ASTNode> node)
+ASTNodeUnaryOperator::ASTNodeUnaryOperator(const Token& token, shared_ptr<ASTNode> node, bool postfix)
         : ASTNode(token)
+        , postfix_(postfix)
 {
         assert(node != NULL);
         children_.push_back(node);
@@ -390,6 +396,12 @@ int ASTNodeUnaryOperator::EvalToInt() const
         }
 }
 
+//==============================================================================
+bool ASTNodeUnaryOperator::IsPostfix() const
+{
+        return postfix_;
+}
+
 //==============================================================================
 void ASTNodeUnaryOperator::CheckTypes_()
 {
@@ -455,7 +467,7 @@ void ASTNodeUnaryOperator::CheckTypes_()
 
             case KW_SIZEOF:
                 // TODO: complete checks
-                SetTypeSym(theParser->LookupType("int"));
+                SetTypeSym(make_shared<SymbolInt>());
                 break;
 
             default:
@@ -477,7 +489,17 @@ ASTNodeConditionalOperator::ASTNodeConditionalOperator(const Token& token,
         children_.push_back(thenExpression);
         children_.push_back(elseExpression);
 
-        // TODO: check for constraints, apply type, see 6.5.15
+        // TODO: check for constraints, see 6.5.15
+        shared_ptr<SymbolType> thenType = thenExpression->GetTypeSym();
+        shared_ptr<SymbolType> elseType = elseExpression->GetTypeSym();
+        if (IfArithmetic(thenType) && IfArithmetic(elseType))
+        {
+            SetTypeSym(CalcCommonArithmeticType(thenType, elseType));
+        }
+        else
+        {
+            SetTypeSym(thenType);
+        }
 }
 
 //==============================================================================
@@ -701,6 +723,12 @@ bool ASTNodeTypeName::IsConstExpr() const
         return false;
 }
 
+//==============================================================================
+shared_ptr<SymbolType> ASTNodeTypeName::GetTypeNameSymbol() const
+{
+        return typeSymbol_;
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 ASTNodeCast::ASTNodeCast(shared_ptr<ASTNodeTypeName> left, shared_ptr<ASTNode> right)
         : ASTNode(Token(TT_CAST, "cast"))
@@ -708,7 +736,7 @@ ASTNodeCast::ASTNodeCast(shared_ptr<ASTNodeTypeName> left, shared_ptr<ASTNode> r
         assert(left != NULL && right != NULL);
         children_.push_back(left);
         children_.push_back(right);
-        SetTypeSym(left->GetTypeSym());
+        SetTypeSym(left->GetTypeNameSymbol());
 }
 
 //==============================================================================
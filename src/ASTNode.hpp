@@ -25,6 +25,8 @@ public:
   shared_ptr<ASTNode> GetChild(const int index);
   void SetTypeSym(shared_ptr<SymbolType> type);
   shared_ptr<SymbolType> GetTypeSym() const;
+  // statements have no type
+  bool HasTypeSym() const;
   virtual bool IsConstExpr() const;
   virtual int EvalToInt() const;
 
@@ -67,16 +69,20 @@ class ASTNodeUnaryOperator
 
   public:
     ASTNodeUnaryOperator(const Token& token);
-  ASTNodeUnaryOperator(const Token& token, shared_ptr<ASTNode> node);
+  ASTNodeUnaryOperator(const Token& token, shared_ptr<ASTNode> node, bool postfix = false);
 
   void SetOperand(shared_ptr<ASTNode> node);
   shared_ptr<ASTNode> GetOperand();
   virtual bool IsConstExpr() const;
   virtual int EvalToInt() const;
+  // `a++` and `a--` as opposed to `++a` and `--a`
+  bool IsPostfix() const;
 
 private:
   void CheckTypes_();
 
+  bool postfix_{false};
+
 };
 
 ////////////////////////////////////////////////////////////////////////////////
@@ -142,6 +148,7 @@ class ASTNodeTypeName
   public:
     ASTNodeTypeName(shared_ptr<SymbolType> typeNameSymbol);
   virtual bool IsConstExpr() const;
+  shared_ptr<SymbolType> GetTypeNameSymbol() const;
 
 private:
   shared_ptr<SymbolType> typeSymbol_{NULL};
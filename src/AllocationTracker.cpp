@@ -0,0 +1,332 @@
+#include "AllocationTracker.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <algorithm>
+
+#include <malloc.h>
+
+#ifndef _WIN32
+#include <execinfo.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#define ALLOCATION_SITES
+#endif
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  // containers of tracker allocate too, their allocations are not counted
+  thread_local bool insideTracker = false;
+
+  // frames of operator new and Allocate_, then callers kept to tell site
+  const int skippedFrames = 2;
+  const int siteDepth = 8;
+
+  size_t GetBlockSize(void* memory)
+  {
+#ifdef _WIN32
+    return _msize(memory);
+#else
+    return malloc_usable_size(memory);
+#endif
+  }
+
+  double GetMegabytes(uint64_t bytes)
+  {
+    return bytes / double(1 << 20);
+  }
+
+#ifdef ALLOCATION_SITES
+  // std::string temporaries and make_shared are allocated inside library
+  // code inlined into compiler, site is the first caller of it
+  bool IsLibraryFunction(const std::string& name)
+  {
+    return name.empty()
+        || name.find("std::") != std::string::npos
+        || name.find("__gnu_cxx::") != std::string::npos
+        || name.find("operator new") != std::string::npos
+        || name.find("AllocationTracker::") != std::string::npos;
+  }
+
+  std::string GetDemangledName(const char* name)
+  {
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name, NULL, NULL, &status);
+    std::string result = status == 0 ? demangled : name;
+    std::free(demangled);
+    return result;
+  }
+
+  // name without parameters, so overloads are one site
+  std::string GetFunctionName(const std::string& name)
+  {
+    size_t end = name.rfind(')');
+    int depth = 0;
+    for (size_t i = end; end != std::string::npos && i > 0; i--)
+    {
+      depth += name[i] == ')' ? 1 : (name[i] == '(' ? -1 : 0);
+      if (depth == 0)
+      {
+        return name.substr(0, i);
+      }
+    }
+    return name;
+  }
+
+  // first frame in compiler itself which is not library code, or module
+  // and offset of the first one in it if none is named
+  std::string GetSiteName(void* const* frames)
+  {
+    Dl_info self;
+    dladdr(reinterpret_cast<void*>(&GetBlockSize), &self);
+    std::string fallback;
+    for (int i = 0; i < siteDepth && frames[i] != NULL; i++)
+    {
+      Dl_info info;
+      if (dladdr(frames[i], &info) == 0 || info.dli_fbase != self.dli_fbase)
+      {
+        continue;
+      }
+      std::string name;
+      if (info.dli_sname != NULL)
+      {
+        name = GetFunctionName(GetDemangledName(info.dli_sname));
+        if (!IsLibraryFunction(name))
+        {
+          return name;
+        }
+      }
+      else
+      {
+        std::ostringstream text;
+        const char* module = std::strrchr(info.dli_fname, '/');
+        text << (module != NULL ? module + 1 : info.dli_fname) << "+0x" << std::hex
+             << static_cast<const char*>(frames[i]) - static_cast<const char*>(info.dli_fbase);
+        name = text.str();
+      }
+      if (fallback.empty())
+      {
+        fallback = name;
+      }
+    }
+    return fallback.empty() ? "unknown" : fallback;
+  }
+#endif
+
+} // namespace
+
+//==============================================================================
+// callers of operator new, hashed by frame addresses, and sizes of live
+// blocks allocated while tracker is active
+struct AllocationTracker::Sites
+{
+  struct Stack
+  {
+    void* frames[siteDepth];
+
+    bool operator==(const Stack& other) const
+    {
+      return std::equal(frames, frames + siteDepth, other.frames);
+    }
+  };
+
+  struct StackHash
+  {
+    size_t operator()(const Stack& stack) const
+    {
+      size_t hash = 0;
+      for (void* frame : stack.frames)
+      {
+        hash = hash * 31 + std::hash<void*>()(frame);
+      }
+      return hash;
+    }
+  };
+
+  std::unordered_map<Stack, Totals, StackHash> stacks;
+  std::unordered_map<void*, size_t> blocks;
+};
+
+std::atomic<AllocationTracker*> AllocationTracker::active_{NULL};
+std::mutex AllocationTracker::mutex_;
+
+//==============================================================================
+AllocationTracker::AllocationTracker()
+  : sites_(new Sites)
+{
+  AllocationTracker* expected = NULL;
+  if (!active_.compare_exchange_strong(expected, this))
+  {
+    throw std::logic_error("allocation tracker is already active");
+  }
+}
+
+//==============================================================================
+AllocationTracker::~AllocationTracker()
+{
+  // threads which saw tracker active find it gone once they lock
+  std::lock_guard<std::mutex> lock(mutex_);
+  active_ = NULL;
+}
+
+//==============================================================================
+void AllocationTracker::Allocate_(void* memory, size_t size)
+{
+  if (insideTracker)
+  {
+    return;
+  }
+  insideTracker = true;
+
+  Sites::Stack stack = {};
+#ifdef ALLOCATION_SITES
+  void* frames[skippedFrames + siteDepth];
+  int depth = backtrace(frames, skippedFrames + siteDepth);
+  for (int i = skippedFrames; i < depth; i++)
+  {
+    stack.frames[i - skippedFrames] = frames[i];
+  }
+#endif
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AllocationTracker* tracker = active_.load();
+    if (tracker != NULL)
+    {
+      TimeReport::EPhase phase = TimeReport::GetPhase();
+      for (Totals* totals : {&tracker->total_, &tracker->phases_[static_cast<int>(phase)],
+                             &tracker->sites_->stacks[stack]})
+      {
+        totals->calls++;
+        totals->bytes += size;
+      }
+      size_t blockSize = GetBlockSize(memory);
+      tracker->sites_->blocks[memory] = blockSize;
+      tracker->live_ += blockSize;
+      tracker->peakLive_ = std::max(tracker->peakLive_, tracker->live_);
+    }
+  }
+
+  insideTracker = false;
+}
+
+//==============================================================================
+void AllocationTracker::Free_(void* memory)
+{
+  if (insideTracker)
+  {
+    return;
+  }
+  insideTracker = true;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    AllocationTracker* tracker = active_.load();
+    if (tracker != NULL)
+    {
+      auto block = tracker->sites_->blocks.find(memory);
+      if (block != tracker->sites_->blocks.end())
+      {
+        tracker->live_ -= block->second;
+        tracker->sites_->blocks.erase(block);
+      }
+    }
+  }
+
+  insideTracker = false;
+}
+
+//==============================================================================
+void AllocationTracker::Print(std::ostream& out, size_t siteCount) const
+{
+  using namespace std;
+
+  // report itself is not counted, nor are frees of its temporaries
+  insideTracker = true;
+  {
+    lock_guard<mutex> lock(mutex_);
+
+    // sites of stacks which differ deeper than the first own frame are merged
+    vector<pair<string, Totals>> sites;
+    {
+      map<string, Totals> named;
+      for (auto& stack : sites_->stacks)
+      {
+#ifdef ALLOCATION_SITES
+        Totals& totals = named[GetSiteName(stack.first.frames)];
+#else
+        Totals& totals = named["unknown"];
+#endif
+        totals.calls += stack.second.calls;
+        totals.bytes += stack.second.bytes;
+      }
+      sites.assign(named.begin(), named.end());
+    }
+    sort(sites.begin(), sites.end(), [](const pair<string, Totals>& a, const pair<string, Totals>& b)
+    {
+      return a.second.bytes > b.second.bytes;
+    });
+
+    ostringstream text;
+    text << fixed << setprecision(3) << "allocations:" << endl;
+    auto row = [&](const string& name, const Totals& totals)
+    {
+      text << "  " << left << setw(16) << name << right
+           << setw(12) << totals.calls << " calls"
+           << setw(12) << GetMegabytes(totals.bytes) << " MB" << endl;
+    };
+    for (int i = 0; i < static_cast<int>(TimeReport::EPhase::COUNT); i++)
+    {
+      row(TimeReport::GetPhaseName(static_cast<TimeReport::EPhase>(i)), phases_[i]);
+    }
+    row("other", phases_[static_cast<int>(TimeReport::EPhase::COUNT)]);
+    row("total", total_);
+    text << "  " << left << setw(16) << "peak live" << right
+         << setw(30) << GetMegabytes(peakLive_) << " MB" << endl;
+
+    text << "top sites by bytes:" << endl;
+    for (size_t i = 0; i < sites.size() && i < siteCount; i++)
+    {
+      text << setw(12) << sites[i].second.calls << " calls"
+           << setw(12) << GetMegabytes(sites[i].second.bytes) << " MB  "
+           << sites[i].first << endl;
+    }
+    out << text.str();
+  }
+  insideTracker = false;
+}
+
+} // namespace Compiler
+
+//==============================================================================
+// the rest of the program allocates through these
+void* operator new(std::size_t size)
+{
+  Compiler::TimeReport::Count(Compiler::TimeReport::ECounter::ALLOCATIONS);
+  void* memory = std::malloc(size == 0 ? 1 : size);
+  if (memory == NULL)
+  {
+    throw std::bad_alloc();
+  }
+  Compiler::AllocationTracker::OnAllocate(memory, size);
+  return memory;
+}
+
+//==============================================================================
+void operator delete(void* memory) noexcept
+{
+  Compiler::AllocationTracker::OnFree(memory);
+  std::free(memory);
+}
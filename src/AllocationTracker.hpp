@@ -0,0 +1,76 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <mutex>
+
+#include "TimeReport.hpp"
+
+namespace Compiler
+{
+// counts every operator new and delete of every thread while tracker is
+// active: calls, bytes, live and peak live bytes, per time report phase
+// and per allocation site; operator new of this file checks a single
+// pointer when no tracker is, phases are known only while a time report
+// is active
+class AllocationTracker
+{
+public:
+  // only one tracker may be active at a time, throws otherwise
+  AllocationTracker();
+  ~AllocationTracker();
+
+  AllocationTracker(const AllocationTracker&) = delete;
+  AllocationTracker& operator=(const AllocationTracker&) = delete;
+
+  // called by operator new and delete
+  static void OnAllocate(void* memory, size_t size)
+  {
+    if (active_.load(std::memory_order_relaxed) != NULL)
+    {
+      Allocate_(memory, size);
+    }
+  }
+
+  static void OnFree(void* memory)
+  {
+    if (active_.load(std::memory_order_relaxed) != NULL && memory != NULL)
+    {
+      Free_(memory);
+    }
+  }
+
+  // totals, phases, and `siteCount` sites which allocated the most bytes;
+  // sites are named where platform can walk the stack
+  void Print(std::ostream& out, size_t siteCount = 20) const;
+
+private:
+  struct Totals
+  {
+    uint64_t calls{0};
+    uint64_t bytes{0};
+  };
+
+  struct Sites;
+
+  static std::atomic<AllocationTracker*> active_;
+  // guards active tracker, which is detached under it before teardown
+  static std::mutex mutex_;
+
+  Totals total_;
+  // the last one is for allocations outside of any phase
+  Totals phases_[static_cast<int>(TimeReport::EPhase::COUNT) + 1];
+  // in bytes malloc reserved, which free gives back; blocks allocated
+  // before tracker started are not counted when freed
+  uint64_t live_{0};
+  uint64_t peakLive_{0};
+  std::unique_ptr<Sites> sites_;
+
+  static void Allocate_(void* memory, size_t size);
+  static void Free_(void* memory);
+};
+
+} // namespace Compiler
@@ -0,0 +1,318 @@
+#include "AsmInstruction.hpp"
+
+#include <cassert>
+
+namespace Compiler
+{
+//==============================================================================
+AsmArgument::AsmArgument()
+{
+
+}
+
+//==============================================================================
+AsmArgument::AsmArgument(EAsmRegister reg)
+  : type(EAsmArgumentType::REGISTER)
+  , reg(reg)
+{
+
+}
+
+//==============================================================================
+AsmArgument::AsmArgument(int immediate)
+  : type(EAsmArgumentType::IMMEDIATE)
+  , value(immediate)
+{
+
+}
+
+//==============================================================================
+AsmArgument AsmArgument::Memory(EAsmRegister base, int displacement, int size)
+{
+  AsmArgument argument;
+  argument.type = EAsmArgumentType::MEMORY;
+  argument.reg = base;
+  argument.value = displacement;
+  argument.size = size;
+  return argument;
+}
+
+//==============================================================================
+AsmArgument AsmArgument::Memory(const std::string& symbol, int size)
+{
+  AsmArgument argument;
+  argument.type = EAsmArgumentType::MEMORY;
+  argument.symbol = symbol;
+  argument.size = size;
+  return argument;
+}
+
+//==============================================================================
+AsmArgument AsmArgument::Symbol(const std::string& name)
+{
+  AsmArgument argument;
+  argument.type = EAsmArgumentType::SYMBOL;
+  argument.symbol = name;
+  return argument;
+}
+
+//==============================================================================
+AsmArgument AsmArgument::Offset(const std::string& name)
+{
+  AsmArgument argument;
+  argument.type = EAsmArgumentType::OFFSET;
+  argument.symbol = name;
+  return argument;
+}
+
+//==============================================================================
+bool AsmArgument::IsRegister() const
+{
+  return type == EAsmArgumentType::REGISTER;
+}
+
+//==============================================================================
+bool AsmArgument::IsRegister(EAsmRegister reg) const
+{
+  return type == EAsmArgumentType::REGISTER
+      && this->reg == reg;
+}
+
+//==============================================================================
+bool AsmArgument::IsImmediate() const
+{
+  return type == EAsmArgumentType::IMMEDIATE;
+}
+
+//==============================================================================
+bool AsmArgument::IsImmediate(int immediate) const
+{
+  return type == EAsmArgumentType::IMMEDIATE
+      && value == immediate;
+}
+
+//==============================================================================
+bool AsmArgument::IsMemory() const
+{
+  return type == EAsmArgumentType::MEMORY;
+}
+
+//==============================================================================
+bool AsmArgument::UsesRegister(EAsmRegister reg) const
+{
+  // 8-bit registers alias low bytes of 32-bit ones
+  auto widen = [](EAsmRegister r)
+  {
+    switch (r)
+    {
+    case EAsmRegister::AL:
+      return EAsmRegister::EAX;
+    case EAsmRegister::CL:
+      return EAsmRegister::ECX;
+    case EAsmRegister::DL:
+      return EAsmRegister::EDX;
+    default:
+      return r;
+    }
+  };
+
+  switch (type)
+  {
+  case EAsmArgumentType::REGISTER:
+    return widen(this->reg) == widen(reg);
+
+  case EAsmArgumentType::MEMORY:
+    return symbol.empty()
+        && widen(this->reg) == widen(reg);
+
+  default:
+    return false;
+  }
+}
+
+//==============================================================================
+bool AsmArgument::operator ==(const AsmArgument& argument) const
+{
+  if (type != argument.type)
+  {
+    return false;
+  }
+
+  switch (type)
+  {
+  case EAsmArgumentType::NONE:
+    return true;
+
+  case EAsmArgumentType::REGISTER:
+    return reg == argument.reg;
+
+  case EAsmArgumentType::IMMEDIATE:
+    return value == argument.value;
+
+  case EAsmArgumentType::MEMORY:
+    return size == argument.size
+        && symbol == argument.symbol
+        && (!symbol.empty()
+            || (reg == argument.reg
+                && value == argument.value));
+
+  case EAsmArgumentType::SYMBOL:
+  case EAsmArgumentType::OFFSET:
+    return symbol == argument.symbol;
+  }
+
+  return false;
+}
+
+//==============================================================================
+bool AsmArgument::operator !=(const AsmArgument& argument) const
+{
+  return !(*this == argument);
+}
+
+//==============================================================================
+std::string AsmArgument::ToString() const
+{
+  switch (type)
+  {
+  case EAsmArgumentType::NONE:
+    return "";
+
+  case EAsmArgumentType::REGISTER:
+    return asmRegisterToString.at(reg);
+
+  case EAsmArgumentType::IMMEDIATE:
+    return std::to_string(value);
+
+  case EAsmArgumentType::MEMORY:
+  {
+    std::string sizeName = size == 1 ? "BYTE PTR " : "DWORD PTR ";
+    if (!symbol.empty())
+    {
+      return sizeName + symbol;
+    }
+
+    std::string displacement;
+    if (value > 0)
+    {
+      displacement = "+" + std::to_string(value);
+    }
+    else if (value < 0)
+    {
+      displacement = std::to_string(value);
+    }
+    return sizeName + "[" + asmRegisterToString.at(reg) + displacement + "]";
+  }
+
+  case EAsmArgumentType::SYMBOL:
+    return symbol;
+
+  case EAsmArgumentType::OFFSET:
+    return "OFFSET " + symbol;
+  }
+
+  return "";
+}
+
+//==============================================================================
+AsmInstruction::AsmInstruction(EAsmMnemonic mnemonic)
+  : mnemonic(mnemonic)
+{
+
+}
+
+//==============================================================================
+AsmInstruction::AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first)
+  : mnemonic(mnemonic)
+  , arguments({first})
+{
+
+}
+
+//==============================================================================
+AsmInstruction::AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first,
+                               const AsmArgument& second)
+  : mnemonic(mnemonic)
+  , arguments({first, second})
+{
+
+}
+
+//==============================================================================
+AsmInstruction::AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first,
+                               const AsmArgument& second, const AsmArgument& third)
+  : mnemonic(mnemonic)
+  , arguments({first, second, third})
+{
+
+}
+
+//==============================================================================
+AsmInstruction AsmInstruction::Label(const std::string& name)
+{
+  return AsmInstruction(EAsmMnemonic::LABEL, AsmArgument::Symbol(name));
+}
+
+//==============================================================================
+bool AsmInstruction::Is(EAsmMnemonic mnemonic) const
+{
+  return this->mnemonic == mnemonic;
+}
+
+//==============================================================================
+bool AsmInstruction::IsLabel() const
+{
+  return mnemonic == EAsmMnemonic::LABEL;
+}
+
+//==============================================================================
+bool AsmInstruction::IsLabel(const std::string& name) const
+{
+  return mnemonic == EAsmMnemonic::LABEL
+      && arguments[0].symbol == name;
+}
+
+//==============================================================================
+bool AsmInstruction::IsJump() const
+{
+  switch (mnemonic)
+  {
+  case EAsmMnemonic::JMP:
+  case EAsmMnemonic::JE:
+  case EAsmMnemonic::JNE:
+  case EAsmMnemonic::JL:
+  case EAsmMnemonic::JLE:
+  case EAsmMnemonic::JG:
+  case EAsmMnemonic::JGE:
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+//==============================================================================
+bool AsmInstruction::IsUnconditionalTransfer() const
+{
+  return mnemonic == EAsmMnemonic::JMP
+      || mnemonic == EAsmMnemonic::RET;
+}
+
+//==============================================================================
+std::string AsmInstruction::ToString() const
+{
+  if (IsLabel())
+  {
+    return arguments[0].symbol + ":";
+  }
+
+  assert(asmMnemonicToString.find(mnemonic) != asmMnemonicToString.end());
+  std::string result = "\t" + asmMnemonicToString.at(mnemonic);
+  for (size_t i = 0; i < arguments.size(); i++)
+  {
+    result += (i == 0 ? "\t" : ", ") + arguments[i].ToString();
+  }
+  return result;
+}
+
+} // namespace Compiler
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+
+namespace Compiler
+{
+enum class EAsmMnemonic
+{
+  MOV,
+  MOVSX,
+  MOVZX,
+  LEA,
+  PUSH,
+  POP,
+  RET,
+  CALL,
+  JMP,
+  JE,
+  JNE,
+  JL,
+  JLE,
+  JG,
+  JGE,
+  ADD,
+  SUB,
+  IMUL,
+  IDIV,
+  CDQ,
+  NEG,
+  NOT,
+  AND,
+  OR,
+  XOR,
+  SHL,
+  SAR,
+  CMP,
+  TEST,
+  SETE,
+  SETNE,
+  SETL,
+  SETLE,
+  SETG,
+  SETGE,
+  NOP,
+  // pseudo instruction, argument is the label name
+  LABEL,
+};
+
+enum class EAsmRegister
+{
+  EAX,
+  EBX,
+  ECX,
+  EDX,
+  ESI,
+  EDI,
+  ESP,
+  EBP,
+  AL,
+  CL,
+  DL,
+};
+
+enum class EAsmArgumentType
+{
+  NONE,
+  REGISTER,
+  IMMEDIATE,
+  // `DWORD PTR [ebp-4]` or `DWORD PTR _name` if symbol is not empty
+  MEMORY,
+  // label or procedure name: `$LN1`, `_main`
+  SYMBOL,
+  // `OFFSET _name`
+  OFFSET,
+};
+
+const std::map<EAsmMnemonic, std::string> asmMnemonicToString =
+{
+  {EAsmMnemonic::MOV, "mov"},
+  {EAsmMnemonic::MOVSX, "movsx"},
+  {EAsmMnemonic::MOVZX, "movzx"},
+  {EAsmMnemonic::LEA, "lea"},
+  {EAsmMnemonic::PUSH, "push"},
+  {EAsmMnemonic::POP, "pop"},
+  {EAsmMnemonic::RET, "ret"},
+  {EAsmMnemonic::CALL, "call"},
+  {EAsmMnemonic::JMP, "jmp"},
+  {EAsmMnemonic::JE, "je"},
+  {EAsmMnemonic::JNE, "jne"},
+  {EAsmMnemonic::JL, "jl"},
+  {EAsmMnemonic::JLE, "jle"},
+  {EAsmMnemonic::JG, "jg"},
+  {EAsmMnemonic::JGE, "jge"},
+  {EAsmMnemonic::ADD, "add"},
+  {EAsmMnemonic::SUB, "sub"},
+  {EAsmMnemonic::IMUL, "imul"},
+  {EAsmMnemonic::IDIV, "idiv"},
+  {EAsmMnemonic::CDQ, "cdq"},
+  {EAsmMnemonic::NEG, "neg"},
+  {EAsmMnemonic::NOT, "not"},
+  {EAsmMnemonic::AND, "and"},
+  {EAsmMnemonic::OR, "or"},
+  {EAsmMnemonic::XOR, "xor"},
+  {EAsmMnemonic::SHL, "shl"},
+  {EAsmMnemonic::SAR, "sar"},
+  {EAsmMnemonic::CMP, "cmp"},
+  {EAsmMnemonic::TEST, "test"},
+  {EAsmMnemonic::SETE, "sete"},
+  {EAsmMnemonic::SETNE, "setne"},
+  {EAsmMnemonic::SETL, "setl"},
+  {EAsmMnemonic::SETLE, "setle"},
+  {EAsmMnemonic::SETG, "setg"},
+  {EAsmMnemonic::SETGE, "setge"},
+  {EAsmMnemonic::NOP, "nop"},
+};
+
+const std::map<EAsmRegister, std::string> asmRegisterToString =
+{
+  {EAsmRegister::EAX, "eax"},
+  {EAsmRegister::EBX, "ebx"},
+  {EAsmRegister::ECX, "ecx"},
+  {EAsmRegister::EDX, "edx"},
+  {EAsmRegister::ESI, "esi"},
+  {EAsmRegister::EDI, "edi"},
+  {EAsmRegister::ESP, "esp"},
+  {EAsmRegister::EBP, "ebp"},
+  {EAsmRegister::AL, "al"},
+  {EAsmRegister::CL, "cl"},
+  {EAsmRegister::DL, "dl"},
+};
+
+class AsmArgument
+{
+public:
+  EAsmArgumentType type{EAsmArgumentType::NONE};
+  EAsmRegister reg{EAsmRegister::EAX};
+  // immediate value or memory displacement
+  int value{0};
+  // memory operand size in bytes
+  int size{4};
+  std::string symbol{""};
+
+  AsmArgument();
+  AsmArgument(EAsmRegister reg);
+  AsmArgument(int immediate);
+
+  static AsmArgument Memory(EAsmRegister base, int displacement = 0, int size = 4);
+  static AsmArgument Memory(const std::string& symbol, int size = 4);
+  static AsmArgument Symbol(const std::string& name);
+  static AsmArgument Offset(const std::string& name);
+
+  bool IsRegister() const;
+  bool IsRegister(EAsmRegister reg) const;
+  bool IsImmediate() const;
+  bool IsImmediate(int immediate) const;
+  bool IsMemory() const;
+  // register is either the argument itself or memory operand base
+  bool UsesRegister(EAsmRegister reg) const;
+
+  bool operator ==(const AsmArgument& argument) const;
+  bool operator !=(const AsmArgument& argument) const;
+
+  std::string ToString() const;
+};
+
+class AsmInstruction
+{
+public:
+  EAsmMnemonic mnemonic{EAsmMnemonic::NOP};
+  std::vector<AsmArgument> arguments;
+
+  AsmInstruction(EAsmMnemonic mnemonic);
+  AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first);
+  AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first, const AsmArgument& second);
+  AsmInstruction(EAsmMnemonic mnemonic, const AsmArgument& first, const AsmArgument& second, const AsmArgument& third);
+
+  static AsmInstruction Label(const std::string& name);
+
+  bool Is(EAsmMnemonic mnemonic) const;
+  bool IsLabel() const;
+  bool IsLabel(const std::string& name) const;
+  bool IsJump() const;
+  // control never reaches the next instruction
+  bool IsUnconditionalTransfer() const;
+
+  std::string ToString() const;
+};
+
+typedef std::vector<AsmInstruction> AsmCode;
+
+} // namespace Compiler
@@ -0,0 +1,1059 @@
+#include "AstFile.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <typeinfo>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Parser.hpp"
+#include "Statement.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const char magic[] = "CAST";
+  // bumped when records change
+  const uint32_t version = 1;
+
+  // header fields by offset, blocks are given by offset from file start and
+  // record count or size in bytes
+  enum HeaderOffset
+  {
+    HO_MAGIC = 0,
+    HO_VERSION = 4,
+    HO_SYMBOLS = 8,
+    HO_TABLES = 16,
+    HO_ENTRIES = 24,
+    HO_NODES = 32,
+    HO_LISTS = 40,
+    HO_STRINGS = 48,
+    HO_NODE_COUNT = 56,
+    HO_INTERNAL_TABLE = 60,
+    HO_GLOBAL_TABLE = 64,
+    HEADER_SIZE = 68,
+  };
+
+  // symbol: type, flags, name, referenced symbol, array element count or
+  // variable offset or table of fields or parameters, function body or list
+  // of variable initializers
+  enum SymbolRecord
+  {
+    SR_TYPE = 0,
+    SR_FLAGS = 4,
+    SR_NAME = 8,
+    SR_REF = 12,
+    SR_EXTRA = 16,
+    SR_NODES = 20,
+    SYMBOL_RECORD_SIZE = 24,
+  };
+
+  // table: scope, first entry, then variable, type and function entry counts,
+  // entries of each follow each other
+  enum TableRecord
+  {
+    TR_SCOPE = 0,
+    TR_FIRST = 4,
+    TR_COUNTS = 8,
+    TABLE_RECORD_SIZE = 20,
+  };
+
+  // entry: name symbol is found by, symbol
+  enum EntryRecord
+  {
+    ER_KEY = 0,
+    ER_SYMBOL = 4,
+    ENTRY_RECORD_SIZE = 8,
+  };
+
+  // node: what it is, its token, type, kind specific word, declarations
+  // list, child count and child offsets, children come before parents
+  enum NodeRecord
+  {
+    NR_KIND = 0,
+    NR_TOKEN_TYPE = 4,
+    NR_LINE = 8,
+    NR_COLUMN = 12,
+    NR_TEXT = 16,
+    NR_VALUE = 20,
+    NR_SIZE = 24,
+    NR_TYPE = 28,
+    // postfix flag, named type, symbol table or loop
+    NR_EXTRA = 32,
+    NR_DECLARATIONS = 36,
+    NR_CHILD_COUNT = 40,
+    NR_CHILDREN = 44,
+  };
+
+  // no symbol, table, node or list
+  const uint32_t none = 0xFFFFFFFF;
+
+  const uint32_t SF_COMPLETE = 1;
+
+  void ThrowMalformed()
+  {
+    throw std::runtime_error("malformed AST file");
+  }
+
+  // node classes are leaves of hierarchy, so exact type tells kind, and
+  // type comparison is cheaper than dynamic_cast through the hierarchy
+  AstFile::ENodeKind GetNodeKind(const ASTNode& node)
+  {
+    typedef AstFile::ENodeKind K;
+    static const std::pair<const std::type_info*, K> kinds[] =
+    {
+      {&typeid(ASTNode), K::PRIMARY},
+      {&typeid(ASTNodeBinaryOperator), K::BINARY_OPERATOR},
+      {&typeid(ASTNodeAssignment), K::ASSIGNMENT},
+      {&typeid(ASTNodeUnaryOperator), K::UNARY_OPERATOR},
+      {&typeid(ASTNodeConditionalOperator), K::CONDITIONAL_OPERATOR},
+      {&typeid(ASTNodeArraySubscript), K::ARRAY_SUBSCRIPT},
+      {&typeid(ASTNodeFunctionCall), K::FUNCTION_CALL},
+      {&typeid(ASTNodeStructureAccess), K::STRUCTURE_ACCESS},
+      {&typeid(ASTNodeTypeName), K::TYPE_NAME},
+      {&typeid(ASTNodeCast), K::CAST},
+      {&typeid(ASTNodeCommaOperator), K::COMMA_OPERATOR},
+      {&typeid(CompoundStatement), K::COMPOUND_STATEMENT},
+      {&typeid(ExpressionStatement), K::EXPRESSION_STATEMENT},
+      {&typeid(SelectionStatement), K::SELECTION_STATEMENT},
+      {&typeid(ForStatement), K::FOR_STATEMENT},
+      {&typeid(DoStatement), K::DO_STATEMENT},
+      {&typeid(WhileStatement), K::WHILE_STATEMENT},
+      {&typeid(JumpStatement), K::JUMP_STATEMENT},
+    };
+
+    const std::type_info& type = typeid(node);
+    for (auto& kind : kinds)
+    {
+      if (*kind.first == type)
+      {
+        return kind.second;
+      }
+    }
+    throw std::logic_error(std::string("no AST file node kind for ") + type.name());
+  }
+
+  //==============================================================================
+  // keeps whole translation unit
+  class TreeRecorder : public Parser
+  {
+  public:
+    // prints nothing, Flush is empty
+    TreeRecorder()
+      : Parser(std::cout)
+    {
+
+    }
+
+    shared_ptr<SymbolTable> GetInternalSymbols() const
+    {
+      return GetInternalSymbolTable();
+    }
+
+    shared_ptr<SymbolTable> GetGlobalSymbols() const
+    {
+      return GetGlobalSymbolTable();
+    }
+
+    virtual void Flush() const
+    {
+
+    }
+  };
+
+  //==============================================================================
+  // numbers symbols and tables in order they are reached from the tables it
+  // starts with, nodes are written as they are reached
+  class TreeWriter
+  {
+  public:
+    TreeWriter(shared_ptr<SymbolTable> internal, shared_ptr<SymbolTable> global)
+    {
+      AddTable_(internal);
+      AddTable_(global);
+      while (written_ < symbols_.size() || writtenTables_ < tables_.size())
+      {
+        while (written_ < symbols_.size())
+        {
+          WriteSymbol_(*symbols_[written_++]);
+        }
+        while (writtenTables_ < tables_.size())
+        {
+          WriteTable_(*tables_[writtenTables_++]);
+        }
+      }
+
+      // loops come after jump statements in them
+      for (auto& jump : jumps_)
+      {
+        uint32_t loop = loopOffsets_.at(jump.second);
+        for (int i = 0; i < 4; i++)
+        {
+          nodes_[jump.first + i] = static_cast<char>((loop >> (8 * i)) & 0xFF);
+        }
+      }
+    }
+
+    void Serialize(std::string& out) const
+    {
+      uint32_t offset = HEADER_SIZE;
+      auto putBlock = [&](size_t size, uint32_t countOrSize)
+      {
+        Put32(out, offset);
+        Put32(out, countOrSize);
+        offset += size;
+      };
+      putBlock(symbolRecords_.size(), symbols_.size());
+      putBlock(tableRecords_.size(), tables_.size());
+      putBlock(entries_.size(), entries_.size() / ENTRY_RECORD_SIZE);
+      putBlock(nodes_.size(), nodes_.size());
+      putBlock(lists_.size(), lists_.size());
+      putBlock(strings_.size(), strings_.size());
+      Put32(out, nodeCount_);
+      // tables tree starts with
+      Put32(out, 0);
+      Put32(out, 1);
+      out += symbolRecords_;
+      out += tableRecords_;
+      out += entries_;
+      out += nodes_;
+      out += lists_;
+      out += strings_;
+    }
+
+  private:
+    std::unordered_map<const Symbol*, uint32_t> symbolIndices_;
+    std::unordered_map<const SymbolTable*, uint32_t> tableIndices_;
+    // only loops are looked up, by jump statements in them
+    std::unordered_map<const ASTNode*, uint32_t> loopOffsets_;
+    std::unordered_map<std::string, uint32_t> stringOffsets_;
+    std::vector<Symbol*> symbols_;
+    std::vector<SymbolTable*> tables_;
+    size_t written_{0};
+    size_t writtenTables_{0};
+    uint32_t nodeCount_{0};
+    // where loop offset of jump statement goes, and the loop
+    std::vector<std::pair<size_t, const ASTNode*>> jumps_;
+    std::string symbolRecords_;
+    std::string tableRecords_;
+    std::string entries_;
+    std::string nodes_;
+    std::string lists_;
+    std::string strings_;
+
+    uint32_t Add_(const shared_ptr<Symbol>& symbol)
+    {
+      if (symbol == NULL)
+      {
+        return none;
+      }
+      auto found = symbolIndices_.find(symbol.get());
+      if (found != symbolIndices_.end())
+      {
+        return found->second;
+      }
+      uint32_t index = symbols_.size();
+      symbolIndices_[symbol.get()] = index;
+      symbols_.push_back(symbol.get());
+      return index;
+    }
+
+    uint32_t AddTable_(const shared_ptr<SymbolTable>& table)
+    {
+      if (table == NULL)
+      {
+        return none;
+      }
+      auto found = tableIndices_.find(table.get());
+      if (found != tableIndices_.end())
+      {
+        return found->second;
+      }
+      uint32_t index = tables_.size();
+      tableIndices_[table.get()] = index;
+      tables_.push_back(table.get());
+      return index;
+    }
+
+    uint32_t GetString_(const std::string& text)
+    {
+      auto found = stringOffsets_.find(text);
+      if (found != stringOffsets_.end())
+      {
+        return found->second;
+      }
+      uint32_t offset = strings_.size();
+      strings_ += text;
+      strings_ += '\0';
+      stringOffsets_[text] = offset;
+      return offset;
+    }
+
+    uint32_t AddList_(const std::vector<uint32_t>& words)
+    {
+      uint32_t offset = lists_.size();
+      Put32(lists_, words.size());
+      for (uint32_t word : words)
+      {
+        Put32(lists_, word);
+      }
+      return offset;
+    }
+
+    uint32_t AddDeclarations_(const std::vector<DeclarationPoint>& declarations)
+    {
+      std::vector<uint32_t> words;
+      for (auto& declaration : declarations)
+      {
+        words.push_back(declaration.position);
+        words.push_back(Add_(declaration.variable));
+      }
+      return AddList_(words);
+    }
+
+    // children first, so their offsets are known
+    uint32_t WriteNode_(const shared_ptr<ASTNode>& node)
+    {
+      std::vector<uint32_t> children;
+      for (int i = 0; i < node->GetChildCount(); i++)
+      {
+        children.push_back(WriteNode_(node->GetChild(i)));
+      }
+
+      AstFile::ENodeKind kind = GetNodeKind(*node);
+      const Token& token = node->token;
+      uint32_t value = static_cast<uint32_t>(token.intValue);
+      if (token.type == TT_LITERAL_CHAR_ARRAY)
+      {
+        // bytes may hold zeros, so they go unshared
+        value = strings_.size();
+        strings_.append(token.charValue, token.size);
+      }
+      uint32_t extra = none;
+      uint32_t declarations = none;
+      const ASTNode* loop = NULL;
+      switch (kind)
+      {
+      case AstFile::ENodeKind::UNARY_OPERATOR:
+        extra = static_cast<ASTNodeUnaryOperator&>(*node).IsPostfix();
+        break;
+
+      case AstFile::ENodeKind::TYPE_NAME:
+        extra = Add_(static_cast<ASTNodeTypeName&>(*node).GetTypeNameSymbol());
+        break;
+
+      case AstFile::ENodeKind::COMPOUND_STATEMENT:
+      {
+        CompoundStatement& compound = static_cast<CompoundStatement&>(*node);
+        extra = AddTable_(compound.GetSymbolTable());
+        declarations = AddDeclarations_(compound.GetDeclarations());
+        break;
+      }
+
+      case AstFile::ENodeKind::FOR_STATEMENT:
+      {
+        ForStatement& forStatement = static_cast<ForStatement&>(*node);
+        extra = AddTable_(forStatement.GetSymbolTable());
+        declarations = AddDeclarations_(forStatement.GetDeclarations());
+        break;
+      }
+
+      case AstFile::ENodeKind::JUMP_STATEMENT:
+        loop = static_cast<JumpStatement&>(*node).GetRefLoopStatement().get();
+        break;
+
+      default:
+        break;
+      }
+
+      uint32_t offset = nodes_.size();
+      Put32(nodes_, static_cast<uint32_t>(kind));
+      Put32(nodes_, token.type);
+      Put32(nodes_, token.line);
+      Put32(nodes_, token.column);
+      Put32(nodes_, GetString_(token.text));
+      Put32(nodes_, value);
+      Put32(nodes_, token.size);
+      Put32(nodes_, node->HasTypeSym() ? Add_(node->GetTypeSym()) : none);
+      if (loop != NULL)
+      {
+        jumps_.push_back({nodes_.size(), loop});
+      }
+      Put32(nodes_, extra);
+      Put32(nodes_, declarations);
+      Put32(nodes_, children.size());
+      for (uint32_t child : children)
+      {
+        Put32(nodes_, child);
+      }
+      if (kind == AstFile::ENodeKind::FOR_STATEMENT
+          || kind == AstFile::ENodeKind::DO_STATEMENT
+          || kind == AstFile::ENodeKind::WHILE_STATEMENT)
+      {
+        loopOffsets_[node.get()] = offset;
+      }
+      nodeCount_++;
+      return offset;
+    }
+
+    // symbols are written in order they are numbered
+    void WriteSymbol_(Symbol& symbol)
+    {
+      ESymbolType type = symbol.GetType();
+      uint32_t flags = 0;
+      uint32_t ref = none;
+      uint32_t extra = none;
+      uint32_t nodes = none;
+      SymbolTypeRef* symRef = dynamic_cast<SymbolTypeRef*>(&symbol);
+      if (symRef != NULL && symRef->HasRefSymbol())
+      {
+        ref = Add_(symRef->GetRefSymbol());
+      }
+
+      switch (type)
+      {
+      case ESymbolType::VARIABLE:
+      {
+        SymbolVariable& symVar = static_cast<SymbolVariable&>(symbol);
+        extra = static_cast<uint32_t>(symVar.offset);
+        if (!symVar.GetInitializers().empty())
+        {
+          std::vector<uint32_t> initializers;
+          for (auto& initializer : symVar.GetInitializers())
+          {
+            initializers.push_back(WriteNode_(initializer));
+          }
+          nodes = AddList_(initializers);
+        }
+        break;
+      }
+
+      case ESymbolType::TYPE_FUNCTION:
+      {
+        SymbolFunctionType& symFunc = static_cast<SymbolFunctionType&>(symbol);
+        extra = AddTable_(symFunc.GetSymbolTable());
+        if (symFunc.GetBody() != NULL)
+        {
+          nodes = WriteNode_(symFunc.GetBody());
+        }
+        break;
+      }
+
+      case ESymbolType::TYPE_STRUCT:
+      {
+        SymbolStruct& symStruct = static_cast<SymbolStruct&>(symbol);
+        if (symStruct.complete)
+        {
+          flags |= SF_COMPLETE;
+          extra = AddTable_(symStruct.GetSymbolTable());
+        }
+        break;
+      }
+
+      case ESymbolType::TYPE_ARRAY:
+        extra = static_cast<SymbolArray&>(symbol).GetElementCount();
+        break;
+
+      default:
+        break;
+      }
+
+      Put32(symbolRecords_, static_cast<uint32_t>(type));
+      Put32(symbolRecords_, flags);
+      Put32(symbolRecords_, GetString_(symbol.name));
+      Put32(symbolRecords_, ref);
+      Put32(symbolRecords_, extra);
+      Put32(symbolRecords_, nodes);
+    }
+
+    void WriteTable_(const SymbolTable& table)
+    {
+      Put32(tableRecords_, static_cast<uint32_t>(table.GetScopeType()));
+      Put32(tableRecords_, entries_.size() / ENTRY_RECORD_SIZE);
+      if (table.GetScopeType() == EScopeType::PARAMETERS
+          || table.GetScopeType() == EScopeType::STRUCTURE)
+      {
+        auto& variables = static_cast<const SymbolTableWithOrder&>(table).orderedVariables;
+        for (auto& variable : variables)
+        {
+          WriteEntry_(variable->name, variable);
+        }
+        Put32(tableRecords_, variables.size());
+      }
+      else
+      {
+        for (auto& variable : table.variables)
+        {
+          WriteEntry_(variable.first, variable.second);
+        }
+        Put32(tableRecords_, table.variables.size());
+      }
+      for (auto& type : table.types)
+      {
+        WriteEntry_(type.first, type.second);
+      }
+      Put32(tableRecords_, table.types.size());
+      for (auto& function : table.functions)
+      {
+        WriteEntry_(function.first, function.second);
+      }
+      Put32(tableRecords_, table.functions.size());
+    }
+
+    void WriteEntry_(const std::string& key, shared_ptr<Symbol> symbol)
+    {
+      Put32(entries_, GetString_(key));
+      Put32(entries_, Add_(symbol));
+    }
+  };
+
+} // namespace
+
+//==============================================================================
+AstFile::Symbol::Symbol(const AstFile& file, uint32_t index)
+  : file_(&file)
+  , index_(index)
+{
+  if (index >= file.GetSymbolCount())
+  {
+    ThrowMalformed();
+  }
+}
+
+//==============================================================================
+uint32_t AstFile::Symbol::Get_(size_t field) const
+{
+  return file_->GetRecord_(HO_SYMBOLS, index_, SYMBOL_RECORD_SIZE, field);
+}
+
+//==============================================================================
+ESymbolType AstFile::Symbol::GetType() const
+{
+  uint32_t type = Get_(SR_TYPE);
+  if (type > static_cast<uint32_t>(ESymbolType::VARIABLE))
+  {
+    ThrowMalformed();
+  }
+  return static_cast<ESymbolType>(type);
+}
+
+//==============================================================================
+const char* AstFile::Symbol::GetName() const
+{
+  return file_->GetString_(Get_(SR_NAME));
+}
+
+//==============================================================================
+bool AstFile::Symbol::HasRefSymbol() const
+{
+  return Get_(SR_REF) != none;
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Symbol::GetRefSymbol() const
+{
+  return Symbol(*file_, Get_(SR_REF));
+}
+
+//==============================================================================
+unsigned AstFile::Symbol::GetElementCount() const
+{
+  return GetType() == ESymbolType::TYPE_ARRAY ? Get_(SR_EXTRA) : 0;
+}
+
+//==============================================================================
+int AstFile::Symbol::GetOffset() const
+{
+  return GetType() == ESymbolType::VARIABLE ? static_cast<int>(Get_(SR_EXTRA)) : -1;
+}
+
+//==============================================================================
+bool AstFile::Symbol::IsComplete() const
+{
+  return (Get_(SR_FLAGS) & SF_COMPLETE) != 0;
+}
+
+//==============================================================================
+AstFile::Table AstFile::Symbol::GetSymbolTable() const
+{
+  ESymbolType type = GetType();
+  if (type != ESymbolType::TYPE_FUNCTION && type != ESymbolType::TYPE_STRUCT)
+  {
+    throw std::logic_error(std::string(GetName()) + " has no symbol table");
+  }
+  return Table(*file_, Get_(SR_EXTRA));
+}
+
+//==============================================================================
+bool AstFile::Symbol::HasBody() const
+{
+  return GetType() == ESymbolType::TYPE_FUNCTION && Get_(SR_NODES) != none;
+}
+
+//==============================================================================
+AstFile::Node AstFile::Symbol::GetBody() const
+{
+  if (!HasBody())
+  {
+    throw std::logic_error("function type has no body");
+  }
+  return Node(*file_, Get_(SR_NODES));
+}
+
+//==============================================================================
+int AstFile::Symbol::GetInitializerCount() const
+{
+  if (GetType() != ESymbolType::VARIABLE || Get_(SR_NODES) == none)
+  {
+    return 0;
+  }
+  return file_->GetListSize_(Get_(SR_NODES));
+}
+
+//==============================================================================
+AstFile::Node AstFile::Symbol::GetInitializer(int index) const
+{
+  return Node(*file_, file_->GetListWord_(Get_(SR_NODES), index));
+}
+
+//==============================================================================
+AstFile::Table::Table(const AstFile& file, uint32_t index)
+  : file_(&file)
+  , index_(index)
+{
+  if (index >= file.file_.Get32(HO_TABLES + 4))
+  {
+    ThrowMalformed();
+  }
+}
+
+//==============================================================================
+uint32_t AstFile::Table::Get_(size_t field) const
+{
+  return file_->GetRecord_(HO_TABLES, index_, TABLE_RECORD_SIZE, field);
+}
+
+//==============================================================================
+uint32_t AstFile::Table::GetEntry_(size_t section, int index, size_t field) const
+{
+  uint32_t first = Get_(TR_FIRST);
+  for (size_t i = 0; i < section; i++)
+  {
+    first += Get_(TR_COUNTS + 4 * i);
+  }
+  if (index < 0 || static_cast<uint32_t>(index) >= Get_(TR_COUNTS + 4 * section))
+  {
+    throw std::out_of_range("no such symbol table entry");
+  }
+  return file_->GetRecord_(HO_ENTRIES, first + index, ENTRY_RECORD_SIZE, field);
+}
+
+//==============================================================================
+EScopeType AstFile::Table::GetScopeType() const
+{
+  uint32_t scope = Get_(TR_SCOPE);
+  if (scope > static_cast<uint32_t>(EScopeType::LOOP))
+  {
+    ThrowMalformed();
+  }
+  return static_cast<EScopeType>(scope);
+}
+
+//==============================================================================
+int AstFile::Table::GetVariableCount() const
+{
+  return Get_(TR_COUNTS);
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Table::GetVariable(int index) const
+{
+  return Symbol(*file_, GetEntry_(0, index, ER_SYMBOL));
+}
+
+//==============================================================================
+int AstFile::Table::GetTypeCount() const
+{
+  return Get_(TR_COUNTS + 4);
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Table::GetType(int index) const
+{
+  return Symbol(*file_, GetEntry_(1, index, ER_SYMBOL));
+}
+
+//==============================================================================
+const char* AstFile::Table::GetTypeKey(int index) const
+{
+  return file_->GetString_(GetEntry_(1, index, ER_KEY));
+}
+
+//==============================================================================
+int AstFile::Table::GetFunctionCount() const
+{
+  return Get_(TR_COUNTS + 8);
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Table::GetFunction(int index) const
+{
+  return Symbol(*file_, GetEntry_(2, index, ER_SYMBOL));
+}
+
+//==============================================================================
+AstFile::Node::Node(const AstFile& file, uint32_t offset)
+  : file_(&file)
+  , offset_(offset)
+{
+  // whole record, children included, is inside node block
+  uint32_t size = file.file_.Get32(HO_NODES + 4);
+  if (offset % 4 != 0 || offset > size || size - offset < NR_CHILDREN
+      || (size - offset - NR_CHILDREN) / 4 < Get_(NR_CHILD_COUNT))
+  {
+    ThrowMalformed();
+  }
+}
+
+//==============================================================================
+uint32_t AstFile::Node::Get_(size_t field) const
+{
+  return file_->file_.Get32(file_->file_.Get32(HO_NODES) + offset_ + field);
+}
+
+//==============================================================================
+AstFile::ENodeKind AstFile::Node::GetKind() const
+{
+  uint32_t kind = Get_(NR_KIND);
+  if (kind > static_cast<uint32_t>(ENodeKind::JUMP_STATEMENT))
+  {
+    ThrowMalformed();
+  }
+  return static_cast<ENodeKind>(kind);
+}
+
+//==============================================================================
+ETokenType AstFile::Node::GetTokenType() const
+{
+  return static_cast<ETokenType>(Get_(NR_TOKEN_TYPE));
+}
+
+//==============================================================================
+const char* AstFile::Node::GetText() const
+{
+  return file_->GetString_(Get_(NR_TEXT));
+}
+
+//==============================================================================
+unsigned AstFile::Node::GetLine() const
+{
+  return Get_(NR_LINE);
+}
+
+//==============================================================================
+unsigned AstFile::Node::GetColumn() const
+{
+  return Get_(NR_COLUMN);
+}
+
+//==============================================================================
+int AstFile::Node::GetIntValue() const
+{
+  return static_cast<int>(Get_(NR_VALUE));
+}
+
+//==============================================================================
+float AstFile::Node::GetFloatValue() const
+{
+  uint32_t bits = Get_(NR_VALUE);
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+//==============================================================================
+const char* AstFile::Node::GetCharArray() const
+{
+  uint32_t offset = Get_(NR_VALUE);
+  uint32_t size = Get_(NR_SIZE);
+  uint32_t stringsSize = file_->file_.Get32(HO_STRINGS + 4);
+  if (GetTokenType() != TT_LITERAL_CHAR_ARRAY
+      || offset > stringsSize || stringsSize - offset < size)
+  {
+    ThrowMalformed();
+  }
+  return reinterpret_cast<const char*>(file_->file_.GetData())
+      + file_->file_.Get32(HO_STRINGS) + offset;
+}
+
+//==============================================================================
+unsigned AstFile::Node::GetCharArraySize() const
+{
+  return Get_(NR_SIZE);
+}
+
+//==============================================================================
+bool AstFile::Node::HasTypeSymbol() const
+{
+  return Get_(NR_TYPE) != none;
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Node::GetTypeSymbol() const
+{
+  return Symbol(*file_, Get_(NR_TYPE));
+}
+
+//==============================================================================
+int AstFile::Node::GetChildCount() const
+{
+  return Get_(NR_CHILD_COUNT);
+}
+
+//==============================================================================
+AstFile::Node AstFile::Node::GetChild(int index) const
+{
+  if (index < 0 || index >= GetChildCount())
+  {
+    throw std::out_of_range("no such child node");
+  }
+  return Node(*file_, Get_(NR_CHILDREN + 4 * index));
+}
+
+//==============================================================================
+bool AstFile::Node::IsPostfix() const
+{
+  return GetKind() == ENodeKind::UNARY_OPERATOR && Get_(NR_EXTRA) != 0;
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Node::GetTypeNameSymbol() const
+{
+  if (GetKind() != ENodeKind::TYPE_NAME)
+  {
+    throw std::logic_error("node is not a type name");
+  }
+  return Symbol(*file_, Get_(NR_EXTRA));
+}
+
+//==============================================================================
+bool AstFile::Node::HasSymbolTable() const
+{
+  ENodeKind kind = GetKind();
+  return (kind == ENodeKind::COMPOUND_STATEMENT || kind == ENodeKind::FOR_STATEMENT)
+      && Get_(NR_EXTRA) != none;
+}
+
+//==============================================================================
+AstFile::Table AstFile::Node::GetSymbolTable() const
+{
+  if (!HasSymbolTable())
+  {
+    throw std::logic_error("node has no symbol table");
+  }
+  return Table(*file_, Get_(NR_EXTRA));
+}
+
+//==============================================================================
+int AstFile::Node::GetDeclarationCount() const
+{
+  if (Get_(NR_DECLARATIONS) == none)
+  {
+    return 0;
+  }
+  return file_->GetListSize_(Get_(NR_DECLARATIONS)) / 2;
+}
+
+//==============================================================================
+int AstFile::Node::GetDeclarationPosition(int index) const
+{
+  return file_->GetListWord_(Get_(NR_DECLARATIONS), 2 * index);
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::Node::GetDeclaration(int index) const
+{
+  return Symbol(*file_, file_->GetListWord_(Get_(NR_DECLARATIONS), 2 * index + 1));
+}
+
+//==============================================================================
+bool AstFile::Node::HasRefLoopStatement() const
+{
+  return GetKind() == ENodeKind::JUMP_STATEMENT && Get_(NR_EXTRA) != none;
+}
+
+//==============================================================================
+AstFile::Node AstFile::Node::GetRefLoopStatement() const
+{
+  if (!HasRefLoopStatement())
+  {
+    throw std::logic_error("node has no loop");
+  }
+  return Node(*file_, Get_(NR_EXTRA));
+}
+
+//==============================================================================
+AstFile::AstFile(const std::string& path)
+  : file_(path)
+{
+  Validate_();
+}
+
+//==============================================================================
+double AstFile::Write(const std::vector<char>& source, const std::string& path)
+{
+  using namespace std;
+
+  auto start = chrono::steady_clock::now();
+  TreeRecorder recorder;
+  {
+    Tokenizer tokenizer(recorder);
+    PreTokenizer pretokenizer(source, tokenizer);
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  TreeWriter tree(recorder.GetInternalSymbols(), recorder.GetGlobalSymbols());
+  string out(magic, 4);
+  Put32(out, version);
+  tree.Serialize(out);
+
+  ofstream file(path, ios::binary);
+  file.write(out.data(), out.size());
+  if (!file)
+  {
+    throw runtime_error("can't write " + path);
+  }
+  return seconds;
+}
+
+//==============================================================================
+AstFile::Table AstFile::GetInternalTable() const
+{
+  return Table(*this, file_.Get32(HO_INTERNAL_TABLE));
+}
+
+//==============================================================================
+AstFile::Table AstFile::GetGlobalTable() const
+{
+  return Table(*this, file_.Get32(HO_GLOBAL_TABLE));
+}
+
+//==============================================================================
+size_t AstFile::GetSymbolCount() const
+{
+  return file_.Get32(HO_SYMBOLS + 4);
+}
+
+//==============================================================================
+AstFile::Symbol AstFile::GetSymbol(size_t index) const
+{
+  if (index >= GetSymbolCount())
+  {
+    throw std::out_of_range("no such symbol");
+  }
+  return Symbol(*this, index);
+}
+
+//==============================================================================
+size_t AstFile::GetNodeCount() const
+{
+  return file_.Get32(HO_NODE_COUNT);
+}
+
+//==============================================================================
+size_t AstFile::GetSize() const
+{
+  return file_.GetSize();
+}
+
+//==============================================================================
+uint32_t AstFile::GetRecord_(size_t block, uint32_t index, size_t recordSize, size_t field) const
+{
+  if (index >= file_.Get32(block + 4))
+  {
+    ThrowMalformed();
+  }
+  return file_.Get32(file_.Get32(block) + index * recordSize + field);
+}
+
+//==============================================================================
+const char* AstFile::GetString_(uint32_t offset) const
+{
+  // block ends with zero byte, so every string in it does
+  if (offset >= file_.Get32(HO_STRINGS + 4))
+  {
+    ThrowMalformed();
+  }
+  return reinterpret_cast<const char*>(file_.GetData()) + file_.Get32(HO_STRINGS) + offset;
+}
+
+//==============================================================================
+uint32_t AstFile::GetListSize_(uint32_t offset) const
+{
+  uint32_t size = file_.Get32(HO_LISTS + 4);
+  if (offset % 4 != 0 || offset > size || size - offset < 4)
+  {
+    ThrowMalformed();
+  }
+  uint32_t count = file_.Get32(file_.Get32(HO_LISTS) + offset);
+  if ((size - offset - 4) / 4 < count)
+  {
+    ThrowMalformed();
+  }
+  return count;
+}
+
+//==============================================================================
+uint32_t AstFile::GetListWord_(uint32_t offset, uint32_t index) const
+{
+  if (index >= GetListSize_(offset))
+  {
+    throw std::out_of_range("no such list element");
+  }
+  return file_.Get32(file_.Get32(HO_LISTS) + offset + 4 + 4 * index);
+}
+
+//==============================================================================
+void AstFile::Validate_() const
+{
+  const unsigned char* data = file_.GetData();
+  size_t size = file_.GetSize();
+  if (size < HEADER_SIZE
+      || std::string(reinterpret_cast<const char*>(data), 4) != std::string(magic, 4))
+  {
+    throw std::runtime_error("not an AST file");
+  }
+  if (file_.Get32(HO_VERSION) != version)
+  {
+    throw std::runtime_error("AST file of other compiler version");
+  }
+
+  // blocks with record count rather than size
+  const size_t recordSizes[] =
+  {
+    SYMBOL_RECORD_SIZE, TABLE_RECORD_SIZE, ENTRY_RECORD_SIZE, 1, 1, 1,
+  };
+  uint64_t expected = HEADER_SIZE;
+  for (size_t i = 0; i < 6; i++)
+  {
+    size_t block = HO_SYMBOLS + 8 * i;
+    if (file_.Get32(block) != expected)
+    {
+      ThrowMalformed();
+    }
+    expected += static_cast<uint64_t>(file_.Get32(block + 4)) * recordSizes[i];
+  }
+  if (expected != size
+      || (file_.Get32(HO_STRINGS + 4) > 0 && data[size - 1] != '\0'))
+  {
+    ThrowMalformed();
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "constants.hpp"
+#include "SymbolTable.hpp"
+#include "MappedFile.hpp"
+
+namespace Compiler
+{
+// typed syntax tree of a translation unit with all its symbol tables, saved
+// so tools walk it without parsing the source again
+// file is little-endian 32-bit words: header, fixed size records of symbols,
+// symbol tables and their entries, then nodes, lists and strings; records
+// refer to each other by index or by offset into their block, never by
+// pointer, so the file is mapped and read in place, nothing is copied
+// but names
+class AstFile
+{
+public:
+  // class of ASTNode node was
+  enum class ENodeKind
+  {
+    // identifier, literal or stub of omitted for clause
+    PRIMARY,
+    BINARY_OPERATOR,
+    ASSIGNMENT,
+    UNARY_OPERATOR,
+    CONDITIONAL_OPERATOR,
+    ARRAY_SUBSCRIPT,
+    FUNCTION_CALL,
+    STRUCTURE_ACCESS,
+    TYPE_NAME,
+    CAST,
+    COMMA_OPERATOR,
+    COMPOUND_STATEMENT,
+    EXPRESSION_STATEMENT,
+    SELECTION_STATEMENT,
+    FOR_STATEMENT,
+    DO_STATEMENT,
+    WHILE_STATEMENT,
+    JUMP_STATEMENT,
+  };
+
+  class Node;
+  class Table;
+
+  //==============================================================================
+  // views below are a file and a place in it, valid while file is,
+  // they throw if file is malformed
+  class Symbol
+  {
+  public:
+    ESymbolType GetType() const;
+    const char* GetName() const;
+    // type of variable, pointer, array, const, typedef or function result
+    bool HasRefSymbol() const;
+    Symbol GetRefSymbol() const;
+    // of array, 0 if not known
+    unsigned GetElementCount() const;
+    // of variable in frame or structure, -1 if not laid out
+    int GetOffset() const;
+    bool IsComplete() const;
+    // fields of complete struct or parameters of function type
+    Table GetSymbolTable() const;
+    // of function type, false for declarations
+    bool HasBody() const;
+    Node GetBody() const;
+    // of variable
+    int GetInitializerCount() const;
+    Node GetInitializer(int index) const;
+
+  private:
+    friend class AstFile;
+    Symbol(const AstFile& file, uint32_t index);
+    uint32_t Get_(size_t field) const;
+
+    const AstFile* file_;
+    uint32_t index_;
+  };
+
+  //==============================================================================
+  class Table
+  {
+  public:
+    EScopeType GetScopeType() const;
+    // variables of parameters and structure tables are in declaration order
+    int GetVariableCount() const;
+    Symbol GetVariable(int index) const;
+    int GetTypeCount() const;
+    Symbol GetType(int index) const;
+    // name type is found by in table, struct types have "struct " prefix
+    const char* GetTypeKey(int index) const;
+    int GetFunctionCount() const;
+    Symbol GetFunction(int index) const;
+
+  private:
+    friend class AstFile;
+    Table(const AstFile& file, uint32_t index);
+    uint32_t Get_(size_t field) const;
+    // word `field` of entry `index` of variables, types or functions
+    uint32_t GetEntry_(size_t section, int index, size_t field) const;
+
+    const AstFile* file_;
+    uint32_t index_;
+  };
+
+  //==============================================================================
+  class Node
+  {
+  public:
+    ENodeKind GetKind() const;
+    // token node was made of
+    ETokenType GetTokenType() const;
+    const char* GetText() const;
+    unsigned GetLine() const;
+    unsigned GetColumn() const;
+    // of integer, character and float literals
+    int GetIntValue() const;
+    float GetFloatValue() const;
+    // of string literals, not zero-terminated
+    const char* GetCharArray() const;
+    unsigned GetCharArraySize() const;
+    // type of expression
+    bool HasTypeSymbol() const;
+    Symbol GetTypeSymbol() const;
+    int GetChildCount() const;
+    Node GetChild(int index) const;
+    // `a++` and `a--` as opposed to `++a` and `--a`
+    bool IsPostfix() const;
+    // type type name stands for
+    Symbol GetTypeNameSymbol() const;
+    // of compound and for statements
+    bool HasSymbolTable() const;
+    Table GetSymbolTable() const;
+    // local variables declared right before child with their position,
+    // of compound and for statements
+    int GetDeclarationCount() const;
+    int GetDeclarationPosition(int index) const;
+    Symbol GetDeclaration(int index) const;
+    // loop break and continue jump out of
+    bool HasRefLoopStatement() const;
+    Node GetRefLoopStatement() const;
+
+  private:
+    friend class AstFile;
+    Node(const AstFile& file, uint32_t offset);
+    uint32_t Get_(size_t field) const;
+
+    const AstFile* file_;
+    uint32_t offset_;
+  };
+
+  //==============================================================================
+  // maps file at `path`, throws if it can't be read or its blocks don't fit
+  explicit AstFile(const std::string& path);
+
+  // parses `source` and writes its tree and symbols to `path`, returns time
+  // parse took
+  static double Write(const std::vector<char>& source, const std::string& path);
+
+  // builtin types and functions
+  Table GetInternalTable() const;
+  Table GetGlobalTable() const;
+
+  size_t GetSymbolCount() const;
+  Symbol GetSymbol(size_t index) const;
+  size_t GetNodeCount() const;
+  size_t GetSize() const;
+
+private:
+  MappedFile file_;
+
+  // word `field` of record `index` of block which header offset and record
+  // count are at `block`, throws if there is no such record
+  uint32_t GetRecord_(size_t block, uint32_t index, size_t recordSize, size_t field) const;
+  const char* GetString_(uint32_t offset) const;
+  // lists are word count followed by words
+  uint32_t GetListSize_(uint32_t offset) const;
+  uint32_t GetListWord_(uint32_t offset, uint32_t index) const;
+  // throws if blocks don't follow header one after another up to the end
+  void Validate_() const;
+};
+
+} // namespace Compiler
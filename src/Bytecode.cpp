@@ -0,0 +1,205 @@
+#include "Bytecode.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace Compiler
+{
+//==============================================================================
+const std::map<EOpcode, OpcodeInfo> opcodeInfo =
+{
+  {EOpcode::MOV, {"mov", "rr"}},
+  {EOpcode::MOVI, {"movi", "ri"}},
+  {EOpcode::ADD, {"add", "rrr"}},
+  {EOpcode::SUB, {"sub", "rrr"}},
+  {EOpcode::MUL, {"mul", "rrr"}},
+  {EOpcode::DIV, {"div", "rrr"}},
+  {EOpcode::MOD, {"mod", "rrr"}},
+  {EOpcode::AND, {"and", "rrr"}},
+  {EOpcode::OR, {"or", "rrr"}},
+  {EOpcode::XOR, {"xor", "rrr"}},
+  {EOpcode::SHL, {"shl", "rrr"}},
+  {EOpcode::SAR, {"sar", "rrr"}},
+  {EOpcode::ADDI, {"addi", "rri"}},
+  {EOpcode::MULI, {"muli", "rri"}},
+  {EOpcode::ANDI, {"andi", "rri"}},
+  {EOpcode::SHLI, {"shli", "rri"}},
+  {EOpcode::SARI, {"sari", "rri"}},
+  {EOpcode::NEG, {"neg", "rr"}},
+  {EOpcode::NOT, {"not", "rr"}},
+  {EOpcode::LNOT, {"lnot", "rr"}},
+  {EOpcode::SEXT8, {"sext8", "rr"}},
+  {EOpcode::EQ, {"eq", "rrr"}},
+  {EOpcode::NE, {"ne", "rrr"}},
+  {EOpcode::LT, {"lt", "rrr"}},
+  {EOpcode::LE, {"le", "rrr"}},
+  {EOpcode::GT, {"gt", "rrr"}},
+  {EOpcode::GE, {"ge", "rrr"}},
+  {EOpcode::JMP, {"jmp", "t"}},
+  {EOpcode::JZ, {"jz", "rt"}},
+  {EOpcode::JNZ, {"jnz", "rt"}},
+  {EOpcode::JEQ, {"jeq", "rrt"}},
+  {EOpcode::JNE, {"jne", "rrt"}},
+  {EOpcode::JLT, {"jlt", "rrt"}},
+  {EOpcode::JLE, {"jle", "rrt"}},
+  {EOpcode::JGT, {"jgt", "rrt"}},
+  {EOpcode::JGE, {"jge", "rrt"}},
+  {EOpcode::JEQI, {"jeqi", "rit"}},
+  {EOpcode::JNEI, {"jnei", "rit"}},
+  {EOpcode::JLTI, {"jlti", "rit"}},
+  {EOpcode::JLEI, {"jlei", "rit"}},
+  {EOpcode::JGTI, {"jgti", "rit"}},
+  {EOpcode::JGEI, {"jgei", "rit"}},
+  {EOpcode::LEAL, {"leal", "ri"}},
+  {EOpcode::LOAD8, {"load8", "rri"}},
+  {EOpcode::LOAD32, {"load32", "rri"}},
+  {EOpcode::STORE8, {"store8", "rir"}},
+  {EOpcode::STORE32, {"store32", "rir"}},
+  {EOpcode::LOADL8, {"loadl8", "ri"}},
+  {EOpcode::LOADL32, {"loadl32", "ri"}},
+  {EOpcode::STOREL8, {"storel8", "ir"}},
+  {EOpcode::STOREL32, {"storel32", "ir"}},
+  {EOpcode::LOADG8, {"loadg8", "ri"}},
+  {EOpcode::LOADG32, {"loadg32", "ri"}},
+  {EOpcode::STOREG8, {"storeg8", "ir"}},
+  {EOpcode::STOREG32, {"storeg32", "ir"}},
+  {EOpcode::CALL, {"call", "rfr"}},
+  {EOpcode::CALLR, {"callr", "rrr"}},
+  {EOpcode::TCALL, {"tcall", "fr"}},
+  {EOpcode::RET, {"ret", ""}},
+  {EOpcode::RETV, {"retv", "r"}},
+  {EOpcode::PRINT, {"print", "pri"}},
+};
+
+//==============================================================================
+int BytecodeModule::GetFunctionIndex(const std::string& name)
+{
+  auto it = functionIndices.find(name);
+  if (it != functionIndices.end())
+  {
+    return it->second;
+  }
+
+  BytecodeFunction function;
+  function.name = name;
+  functions.push_back(function);
+  functionIndices[name] = functions.size() - 1;
+  return functions.size() - 1;
+}
+
+//==============================================================================
+void BytecodeModule::PrintListing(std::ostream& out) const
+{
+  using namespace std;
+
+  out << "data: " << data.size() << " bytes" << endl;
+  for (size_t i = 0; i < printFormats.size(); i++)
+  {
+    out << "format " << i << ": " << printFormats[i] << endl;
+  }
+
+  for (auto& function : functions)
+  {
+    if (!function.defined)
+    {
+      continue;
+    }
+
+    out << endl << function.name << ": parameters " << function.parameterCount
+        << ", registers " << function.registerCount
+        << ", frame " << function.frameSize << endl;
+
+    for (size_t i = 0; i < function.code.size(); i++)
+    {
+      const BytecodeInstruction& instruction = function.code[i];
+      const OpcodeInfo& info = opcodeInfo.at(instruction.opcode);
+      out << setw(6) << i << "  " << info.name;
+      if (!info.operands.empty())
+      {
+        out << string(max<int>(1, 9 - info.name.size()), ' ');
+      }
+
+      const int operands[] = {instruction.a, instruction.b, instruction.c};
+      assert(info.operands.size() <= 3);
+      for (size_t j = 0; j < info.operands.size(); j++)
+      {
+        out << (j == 0 ? "" : ", ");
+        int value = operands[j];
+        switch (info.operands[j])
+        {
+        case 'r':
+          out << "r" << value;
+          break;
+
+        case 't':
+          out << "@" << value;
+          break;
+
+        case 'f':
+          out << functions[value].name;
+          break;
+
+        case 'p':
+          out << "format " << value;
+          break;
+
+        default:
+          out << value;
+        }
+      }
+      out << endl;
+    }
+  }
+}
+
+//==============================================================================
+unsigned CheckMemoryAccess(const std::vector<unsigned char>& memory, int address, int size)
+{
+  // null page is the first 4 bytes of data
+  unsigned location = static_cast<unsigned>(address);
+  if (location < 4 || location > memory.size() - size)
+  {
+    throw std::runtime_error("invalid memory access at address " + std::to_string(address));
+  }
+  return location;
+}
+
+//==============================================================================
+void PrintValues(std::ostream& out, const std::vector<unsigned char>& memory,
+                 const std::string& kinds, const int* arguments, int count)
+{
+  for (int i = 0; i < count; i++)
+  {
+    if (i != 0)
+    {
+      out << ' ';
+    }
+
+    switch (kinds[i])
+    {
+    case 'c':
+      out << static_cast<char>(arguments[i]);
+      break;
+
+    case 's':
+    {
+      unsigned address = CheckMemoryAccess(memory, arguments[i], 1);
+      while (memory[address] != 0)
+      {
+        out << static_cast<char>(memory[address]);
+        address = CheckMemoryAccess(memory, address + 1, 1);
+      }
+      break;
+    }
+
+    default:
+      out << arguments[i];
+    }
+  }
+  out << '\n';
+}
+
+} // namespace Compiler
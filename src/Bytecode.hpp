@@ -0,0 +1,140 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <iosfwd>
+
+namespace Compiler
+{
+// register machine: every function has its own window of 32-bit registers,
+// parameters arrive in the first registers of the window
+// r - register, i - immediate, t - jump target, f - function index,
+// p - print format index
+enum class EOpcode
+{
+  MOV,      // r r     a = b
+  MOVI,     // r i     a = imm
+  ADD,      // r r r   a = b + c
+  SUB,
+  MUL,
+  DIV,
+  MOD,
+  AND,
+  OR,
+  XOR,
+  SHL,
+  SAR,
+  ADDI,     // r r i   a = b + imm
+  MULI,
+  ANDI,
+  SHLI,
+  SARI,
+  NEG,      // r r     a = -b
+  NOT,
+  LNOT,
+  SEXT8,    // r r     a = (char)b
+  EQ,       // r r r   a = b == c
+  NE,
+  LT,
+  LE,
+  GT,
+  GE,
+  JMP,      // t
+  JZ,       // r t     jump if a == 0
+  JNZ,
+  JEQ,      // r r t   jump if a == b
+  JNE,
+  JLT,
+  JLE,
+  JGT,
+  JGE,
+  JEQI,     // r i t   jump if a == imm
+  JNEI,
+  JLTI,
+  JLEI,
+  JGTI,
+  JGEI,
+  LEAL,     // r i     a = fp + imm
+  LOAD8,    // r r i   a = [b + imm]
+  LOAD32,
+  STORE8,   // r i r   [a + imm] = c
+  STORE32,
+  LOADL8,   // r i     a = [fp + imm]
+  LOADL32,
+  STOREL8,  // i r     [fp + imm] = b
+  STOREL32,
+  LOADG8,   // r i     a = [imm]
+  LOADG32,
+  STOREG8,  // i r     [imm] = b
+  STOREG32,
+  CALL,     // r f r   a = call function b, arguments start at register c
+  CALLR,    // r r r   a = call function address b, arguments start at c
+  TCALL,    // f r     tail call function a, arguments start at register b,
+            //         only emitted in functions without memory frame
+  RET,      //         return 0
+  RETV,     // r       return a
+  PRINT,    // p r i   print c values starting at register b
+  COUNT,
+};
+
+struct OpcodeInfo
+{
+  std::string name;
+  // operand kinds, see EOpcode
+  std::string operands;
+};
+
+extern const std::map<EOpcode, OpcodeInfo> opcodeInfo;
+
+struct BytecodeInstruction
+{
+  EOpcode opcode;
+  int a;
+  int b;
+  int c;
+};
+
+struct BytecodeFunction
+{
+  std::string name;
+  std::vector<BytecodeInstruction> code;
+  int parameterCount{0};
+  int registerCount{0};
+  // bytes of locals which live in memory: arrays, structures
+  // and variables whose address is taken
+  int frameSize{0};
+  // false for declared only functions, calling them is a runtime error
+  bool defined{false};
+  // sorted first instructions of `for` and `while` bodies, where
+  // running function may be switched to native code
+  std::vector<int> loopHeaders;
+};
+
+// function pointers are tagged indices into BytecodeModule::functions,
+// data addresses are offsets into interpreter memory and stay below it
+const int functionAddressTag = 0x40000000;
+
+struct BytecodeModule
+{
+  std::vector<BytecodeFunction> functions;
+  std::unordered_map<std::string, int> functionIndices;
+  // initial memory image: string literals and globals, address 0 is null
+  std::vector<char> data{0, 0, 0, 0};
+  // `print` argument kinds: 'd', 'c' or 's' per argument
+  std::vector<std::string> printFormats;
+
+  // index of function `name`, placeholder is added if it is not known yet
+  int GetFunctionIndex(const std::string& name);
+  void PrintListing(std::ostream& out) const;
+};
+
+// runtime support shared by interpreter and native code
+// throws if [address, address + size) is null page or lies outside memory
+unsigned CheckMemoryAccess(const std::vector<unsigned char>& memory, int address, int size);
+// `print` output: values separated by space, newline at the end
+void PrintValues(std::ostream& out, const std::vector<unsigned char>& memory,
+                 const std::string& kinds, const int* arguments, int count);
+
+} // namespace Compiler
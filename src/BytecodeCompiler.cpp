@@ -0,0 +1,1532 @@
+#include "BytecodeCompiler.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <map>
+#include <stdexcept>
+#include <cstring>
+
+#include "codegen.hpp"
+#include "TimeReport.hpp"
+#include "Trace.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const std::unordered_map<int, EOpcode> arithmeticOpcodes =
+  {
+    {OP_PLUS, EOpcode::ADD},
+    {OP_PLUSASS, EOpcode::ADD},
+    {OP_MINUS, EOpcode::SUB},
+    {OP_MINUSASS, EOpcode::SUB},
+    {OP_STAR, EOpcode::MUL},
+    {OP_STARASS, EOpcode::MUL},
+    {OP_DIV, EOpcode::DIV},
+    {OP_DIVASS, EOpcode::DIV},
+    {OP_MOD, EOpcode::MOD},
+    {OP_MODASS, EOpcode::MOD},
+    {OP_AMP, EOpcode::AND},
+    {OP_BANDASS, EOpcode::AND},
+    {OP_BOR, EOpcode::OR},
+    {OP_BORASS, EOpcode::OR},
+    {OP_XOR, EOpcode::XOR},
+    {OP_XORASS, EOpcode::XOR},
+    {OP_LSHIFT, EOpcode::SHL},
+    {OP_LSHIFTASS, EOpcode::SHL},
+    {OP_RSHIFT, EOpcode::SAR},
+    {OP_RSHIFTASS, EOpcode::SAR},
+    {OP_EQ, EOpcode::EQ},
+    {OP_NE, EOpcode::NE},
+    {OP_LT, EOpcode::LT},
+    {OP_LE, EOpcode::LE},
+    {OP_GT, EOpcode::GT},
+    {OP_GE, EOpcode::GE},
+  };
+
+  // jump if comparison holds, jump if it does not
+  const std::unordered_map<int, std::pair<EOpcode, EOpcode>> comparisonJumps =
+  {
+    {OP_EQ, {EOpcode::JEQ, EOpcode::JNE}},
+    {OP_NE, {EOpcode::JNE, EOpcode::JEQ}},
+    {OP_LT, {EOpcode::JLT, EOpcode::JGE}},
+    {OP_LE, {EOpcode::JLE, EOpcode::JGT}},
+    {OP_GT, {EOpcode::JGT, EOpcode::JLE}},
+    {OP_GE, {EOpcode::JGE, EOpcode::JLT}},
+  };
+
+  const std::map<EOpcode, EOpcode> jumpToImmediateJump =
+  {
+    {EOpcode::JEQ, EOpcode::JEQI},
+    {EOpcode::JNE, EOpcode::JNEI},
+    {EOpcode::JLT, EOpcode::JLTI},
+    {EOpcode::JLE, EOpcode::JLEI},
+    {EOpcode::JGT, EOpcode::JGTI},
+    {EOpcode::JGE, EOpcode::JGEI},
+  };
+
+  // integer literal, possibly negated
+  bool IsConstant(ASTNode* node, int& value)
+  {
+    if (node->token == TT_LITERAL_INT
+        || node->token == TT_LITERAL_CHAR)
+    {
+      value = node->token.intValue;
+      return true;
+    }
+    if ((node->token == OP_MINUS || node->token == OP_PLUS)
+        && node->GetChildCount() == 1
+        && IsConstant(node->GetChild(0).get(), value))
+    {
+      value = node->token == OP_MINUS ? -value : value;
+      return true;
+    }
+    return false;
+  }
+
+  bool IsComparison(const Token& token)
+  {
+    return comparisonJumps.find(token.type) != comparisonJumps.end();
+  }
+
+} // namespace
+
+//==============================================================================
+FunctionBytecodeCompiler::FunctionBytecodeCompiler(shared_ptr<SymbolVariable> symFun,
+                                                   shared_ptr<SymbolTable> globalSymbols,
+                                                   shared_ptr<SymbolTable> internalSymbols,
+                                                   BytecodeContext& context)
+  : symFun_(symFun)
+  , context_(context)
+{
+  scopes_.push_back(internalSymbols.get());
+  scopes_.push_back(globalSymbols.get());
+}
+
+//==============================================================================
+BytecodeFunction FunctionBytecodeCompiler::Compile()
+{
+  shared_ptr<SymbolFunctionType> symType = static_pointer_cast<SymbolFunctionType>(symFun_->GetRefSymbol());
+  shared_ptr<SymbolTableWithOrder> parameters = symType->GetSymbolTable();
+  scopes_.push_back(parameters.get());
+  CollectAddressTaken_(symType->GetBody().get());
+
+  // arguments arrive in the first registers of the window
+  int parameterCount = parameters->orderedVariables.size();
+  variableTop_ = parameterCount;
+  for (int i = 0; i < parameterCount; i++)
+  {
+    shared_ptr<SymbolVariable> parameter = parameters->orderedVariables[i];
+    if (IfOfType(parameter, ESymbolType::TYPE_STRUCT))
+    {
+      throw std::logic_error(parameter->GetQualifiedName() + ": structure parameters are not supported by bytecode compiler");
+    }
+    CheckSupportedType_(Token(TT_IDENTIFIER, parameter->name), parameter->GetRefSymbol());
+
+    if (IsPromotable_(parameter))
+    {
+      variableRegisters_[parameter.get()] = i;
+    }
+    else
+    {
+      parameter->offset = frameSize_;
+      frameSize_ += 4;
+      Emit_(IfOfType(parameter, ESymbolType::TYPE_CHAR) ? EOpcode::STOREL8 : EOpcode::STOREL32,
+            parameter->offset, i);
+    }
+  }
+  maxFrameSize_ = frameSize_;
+  registerCount_ = variableTop_;
+  ResetTemporaries_();
+
+  CompileCompoundStatement_(symType->GetBody().get());
+  Emit_(EOpcode::RET);
+  ResolveLabels_();
+  if (maxFrameSize_ == 0)
+  {
+    // no locals may be referenced by callee, so frame can be reused
+    for (size_t i = 0; i + 1 < code_.size(); i++)
+    {
+      if (code_[i].opcode == EOpcode::CALL
+          && code_[i + 1].opcode == EOpcode::RETV
+          && code_[i + 1].a == code_[i].a)
+      {
+        code_[i] = {EOpcode::TCALL, code_[i].b, code_[i].c, 0};
+      }
+    }
+  }
+
+  scopes_.pop_back();
+
+  BytecodeFunction function;
+  function.name = symFun_->name;
+  function.code = code_;
+  function.parameterCount = parameterCount;
+  function.registerCount = registerCount_;
+  function.frameSize = maxFrameSize_;
+  function.defined = true;
+  for (int label : loopHeaderLabels_)
+  {
+    function.loopHeaders.push_back(labels_[label]);
+  }
+  std::sort(function.loopHeaders.begin(), function.loopHeaders.end());
+  function.loopHeaders.erase(std::unique(function.loopHeaders.begin(), function.loopHeaders.end()),
+                             function.loopHeaders.end());
+  return function;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::Emit_(EOpcode opcode, int a, int b, int c)
+{
+  code_.push_back({opcode, a, b, c});
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::NewLabel_()
+{
+  labels_.push_back(-1);
+  return labels_.size() - 1;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::BindLabel_(int label)
+{
+  labels_[label] = code_.size();
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::ResolveLabels_()
+{
+  for (auto& instruction : code_)
+  {
+    const std::string& operands = opcodeInfo.at(instruction.opcode).operands;
+    int* arguments[] = {&instruction.a, &instruction.b, &instruction.c};
+    for (size_t i = 0; i < operands.size(); i++)
+    {
+      if (operands[i] == 't')
+      {
+        assert(labels_[*arguments[i]] >= 0);
+        *arguments[i] = labels_[*arguments[i]];
+      }
+    }
+  }
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::NewTemporary_()
+{
+  registerCount_ = std::max(registerCount_, temporaryTop_ + 1);
+  return temporaryTop_++;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::ResetTemporaries_()
+{
+  temporaryTop_ = variableTop_;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::Result_(int target)
+{
+  return target >= 0 ? target : NewTemporary_();
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::MoveTo_(int reg, int target)
+{
+  if (target < 0 || target == reg)
+  {
+    return reg;
+  }
+  Emit_(EOpcode::MOV, target, reg);
+  return target;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CollectAddressTaken_(ASTNode* node)
+{
+  if (node->token == OP_AMP
+      && node->GetChildCount() == 1
+      && node->GetChild(0)->token == TT_IDENTIFIER)
+  {
+    addressTaken_.insert(node->GetChild(0)->token.text);
+  }
+
+  // initializers are kept aside of statement children
+  const std::vector<DeclarationPoint>* declarations = NULL;
+  if (CompoundStatement* compound = dynamic_cast<CompoundStatement*>(node))
+  {
+    declarations = &compound->GetDeclarations();
+  }
+  else if (ForStatement* forStatement = dynamic_cast<ForStatement*>(node))
+  {
+    declarations = &forStatement->GetDeclarations();
+  }
+  if (declarations != NULL)
+  {
+    for (auto& declaration : *declarations)
+    {
+      for (auto& initializer : declaration.variable->GetInitializers())
+      {
+        CollectAddressTaken_(initializer.get());
+      }
+    }
+  }
+
+  for (int i = 0; i < node->GetChildCount(); i++)
+  {
+    CollectAddressTaken_(node->GetChild(i).get());
+  }
+}
+
+//==============================================================================
+SymbolTable* FunctionBytecodeCompiler::LookupScope_(const std::string& name) const
+{
+  for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it)
+  {
+    if ((*it)->LookupVariable(name) != NULL
+        || (*it)->LookupFunction(name) != NULL)
+    {
+      return *it;
+    }
+  }
+  return NULL;
+}
+
+//==============================================================================
+bool FunctionBytecodeCompiler::IsPromotable_(shared_ptr<SymbolVariable> variable) const
+{
+  shared_ptr<SymbolType> type = GetActualType(variable);
+  return (type->GetType() == ESymbolType::TYPE_INT
+          || type->GetType() == ESymbolType::TYPE_CHAR
+          || type->GetType() == ESymbolType::TYPE_POINTER)
+      && addressTaken_.find(variable->name) == addressTaken_.end();
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::AllocateLocals_(const std::vector<DeclarationPoint>& declarations)
+{
+  for (auto& declaration : declarations)
+  {
+    shared_ptr<SymbolVariable> variable = declaration.variable;
+    if (IsPromotable_(variable))
+    {
+      variableRegisters_[variable.get()] = variableTop_++;
+    }
+    else
+    {
+      variable->offset = frameSize_;
+      frameSize_ += RoundUpTo4(GetActualType(variable)->GetSize());
+    }
+  }
+  registerCount_ = std::max(registerCount_, variableTop_);
+  maxFrameSize_ = std::max(maxFrameSize_, frameSize_);
+  ResetTemporaries_();
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileInitializer_(shared_ptr<SymbolVariable> variable)
+{
+  const std::vector<shared_ptr<ASTNode>>& initializers = variable->GetInitializers();
+  if (initializers.empty())
+  {
+    return;
+  }
+
+  std::vector<std::pair<int, shared_ptr<SymbolType>>> slots;
+  CollectInitializerSlots(variable->GetRefSymbol(), 0, slots);
+  assert(slots.size() >= initializers.size());
+
+  auto it = variableRegisters_.find(variable.get());
+  for (unsigned i = 0; i < initializers.size(); i++)
+  {
+    ResetTemporaries_();
+    CheckSupportedType_(initializers[i]->token, slots[i].second);
+    bool byte = IfOfType(slots[i].second, ESymbolType::TYPE_CHAR);
+    if (it != variableRegisters_.end())
+    {
+      int value = CompileValue_(initializers[i].get(), byte ? -1 : it->second);
+      CompileStore_({ELocation::REGISTER, it->second, 0, byte}, value);
+    }
+    else
+    {
+      int value = CompileValue_(initializers[i].get());
+      CompileStore_({ELocation::FRAME, 0, variable->offset + slots[i].first, byte}, value);
+    }
+  }
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::GlobalAddress_(shared_ptr<SymbolVariable> variable)
+{
+  auto it = context_.globalAddresses.find(variable.get());
+  if (it != context_.globalAddresses.end())
+  {
+    return it->second;
+  }
+
+  // globals are laid out in order of first use
+  std::vector<char>& data = context_.module.data;
+  data.resize(RoundUpTo4(data.size()), 0);
+  int address = data.size();
+  data.resize(address + RoundUpTo4(GetActualType(variable)->GetSize()), 0);
+  context_.globalAddresses[variable.get()] = address;
+
+  const std::vector<shared_ptr<ASTNode>>& initializers = variable->GetInitializers();
+  std::vector<std::pair<int, shared_ptr<SymbolType>>> slots;
+  CollectInitializerSlots(variable->GetRefSymbol(), 0, slots);
+  assert(slots.size() >= initializers.size());
+
+  for (unsigned i = 0; i < initializers.size(); i++)
+  {
+    ASTNode* initializer = initializers[i].get();
+    CheckSupportedType_(initializer->token, slots[i].second);
+
+    int value = 0;
+    if (initializer->IsConstExpr())
+    {
+      value = initializer->EvalToInt();
+    }
+    else if (initializer->token == TT_LITERAL_CHAR_ARRAY)
+    {
+      value = StringAddress_(initializer);
+    }
+    else if (initializer->token == OP_AMP
+             && initializer->GetChildCount() == 1
+             && initializer->GetChild(0)->token == TT_IDENTIFIER
+             && LookupScope_(initializer->GetChild(0)->token.text) == scopes_[1])
+    {
+      const std::string& name = initializer->GetChild(0)->token.text;
+      shared_ptr<SymbolVariable> target = scopes_[1]->LookupVariable(name);
+      value = target != NULL
+          ? GlobalAddress_(target)
+          : functionAddressTag | context_.module.GetFunctionIndex(name);
+    }
+    else
+    {
+      ThrowInvalidTokenError(initializer->token, "initializer element is not constant");
+    }
+
+    // data may have been reallocated by nested allocations
+    char* slot = &context_.module.data[address + slots[i].first];
+    if (IfOfType(slots[i].second, ESymbolType::TYPE_CHAR))
+    {
+      *slot = static_cast<char>(value);
+    }
+    else
+    {
+      memcpy(slot, &value, 4);
+    }
+  }
+
+  return address;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::StringAddress_(ASTNode* node)
+{
+  auto it = context_.stringAddresses.find(node);
+  if (it != context_.stringAddresses.end())
+  {
+    return it->second;
+  }
+
+  std::vector<char>& data = context_.module.data;
+  data.resize(RoundUpTo4(data.size()), 0);
+  int address = data.size();
+  data.insert(data.end(), node->token.charValue, node->token.charValue + node->token.size);
+  context_.stringAddresses[node] = address;
+  return address;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileStatement_(Statement* statement)
+{
+  switch (statement->GetStatementType())
+  {
+  case EStatementType::COMPOUND:
+    CompileCompoundStatement_(static_cast<CompoundStatement*>(statement));
+    break;
+
+  case EStatementType::SELECTION:
+    CompileSelectionStatement_(static_cast<SelectionStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_FOR:
+    CompileForStatement_(static_cast<ForStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_WHILE:
+    CompileWhileStatement_(static_cast<WhileStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_DO:
+    CompileDoStatement_(static_cast<DoStatement*>(statement));
+    break;
+
+  case EStatementType::JUMP:
+    CompileJumpStatement_(static_cast<JumpStatement*>(statement));
+    break;
+
+  case EStatementType::EXPRESSION:
+  {
+    shared_ptr<ASTNode> expression = static_cast<ExpressionStatement*>(statement)->GetExpression();
+    if (expression != NULL)
+    {
+      ResetTemporaries_();
+      CompileEffect_(expression.get());
+    }
+    break;
+  }
+  }
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileCompoundStatement_(CompoundStatement* statement)
+{
+  scopes_.push_back(statement->GetSymbolTable().get());
+  // sibling blocks share registers and stack space
+  int frameSize = frameSize_;
+  int variableTop = variableTop_;
+
+  const std::vector<DeclarationPoint>& declarations = statement->GetDeclarations();
+  AllocateLocals_(declarations);
+
+  unsigned d = 0;
+  for (int i = 0; i < statement->GetChildCount(); i++)
+  {
+    while (d < declarations.size() && declarations[d].position == i)
+    {
+      CompileInitializer_(declarations[d++].variable);
+    }
+    CompileStatement_(static_cast<Statement*>(statement->GetChild(i).get()));
+  }
+  while (d < declarations.size())
+  {
+    CompileInitializer_(declarations[d++].variable);
+  }
+
+  frameSize_ = frameSize;
+  variableTop_ = variableTop;
+  scopes_.pop_back();
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileSelectionStatement_(SelectionStatement* statement)
+{
+  int elseLabel = NewLabel_();
+  ResetTemporaries_();
+  CompileBranch_(statement->GetChild(0).get(), false, elseLabel);
+  CompileStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+
+  if (statement->GetChildCount() > 2)
+  {
+    int endLabel = NewLabel_();
+    Emit_(EOpcode::JMP, endLabel);
+    BindLabel_(elseLabel);
+    CompileStatement_(static_cast<Statement*>(statement->GetChild(2).get()));
+    BindLabel_(endLabel);
+  }
+  else
+  {
+    BindLabel_(elseLabel);
+  }
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileForStatement_(ForStatement* statement)
+{
+  scopes_.push_back(statement->GetSymbolTable().get());
+  int frameSize = frameSize_;
+  int variableTop = variableTop_;
+
+  AllocateLocals_(statement->GetDeclarations());
+  for (auto& declaration : statement->GetDeclarations())
+  {
+    CompileInitializer_(declaration.variable);
+  }
+
+  // stub nodes stand for omitted expressions
+  auto present = [](shared_ptr<ASTNode> node)
+  {
+    return node->token != TT_INVALID;
+  };
+
+  shared_ptr<ASTNode> initializing = statement->GetChild(0);
+  shared_ptr<ASTNode> controlling = statement->GetChild(1);
+  shared_ptr<ASTNode> iteration = statement->GetChild(2);
+
+  if (present(initializing))
+  {
+    ResetTemporaries_();
+    CompileEffect_(initializing.get());
+  }
+
+  // condition is tested at the bottom, one jump per iteration
+  LoopLabels labels{NewLabel_(), NewLabel_()};
+  loopLabels_[statement] = labels;
+  int topLabel = NewLabel_();
+  int conditionLabel = NewLabel_();
+  loopHeaderLabels_.push_back(topLabel);
+
+  if (present(controlling))
+  {
+    Emit_(EOpcode::JMP, conditionLabel);
+  }
+  BindLabel_(topLabel);
+  CompileStatement_(static_cast<Statement*>(statement->GetChild(3).get()));
+  BindLabel_(labels.continueLabel);
+  if (present(iteration))
+  {
+    ResetTemporaries_();
+    CompileEffect_(iteration.get());
+  }
+  BindLabel_(conditionLabel);
+  if (present(controlling))
+  {
+    ResetTemporaries_();
+    CompileBranch_(controlling.get(), true, topLabel);
+  }
+  else
+  {
+    Emit_(EOpcode::JMP, topLabel);
+  }
+  BindLabel_(labels.breakLabel);
+
+  frameSize_ = frameSize;
+  variableTop_ = variableTop;
+  scopes_.pop_back();
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileWhileStatement_(WhileStatement* statement)
+{
+  LoopLabels labels{NewLabel_(), NewLabel_()};
+  loopLabels_[statement] = labels;
+  int topLabel = NewLabel_();
+  loopHeaderLabels_.push_back(topLabel);
+
+  Emit_(EOpcode::JMP, labels.continueLabel);
+  BindLabel_(topLabel);
+  CompileStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+  BindLabel_(labels.continueLabel);
+  ResetTemporaries_();
+  CompileBranch_(statement->GetChild(0).get(), true, topLabel);
+  BindLabel_(labels.breakLabel);
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileDoStatement_(DoStatement* statement)
+{
+  LoopLabels labels{NewLabel_(), NewLabel_()};
+  loopLabels_[statement] = labels;
+  int topLabel = NewLabel_();
+
+  BindLabel_(topLabel);
+  CompileStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+  BindLabel_(labels.continueLabel);
+  ResetTemporaries_();
+  CompileBranch_(statement->GetChild(0).get(), true, topLabel);
+  BindLabel_(labels.breakLabel);
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileJumpStatement_(JumpStatement* statement)
+{
+  switch (statement->token.type)
+  {
+  case KW_RETURN:
+  {
+    shared_ptr<ASTNode> expression = statement->GetReturnExpression();
+    if (expression != NULL)
+    {
+      ResetTemporaries_();
+      CheckSupportedType_(expression->token, expression->GetTypeSym());
+      Emit_(EOpcode::RETV, CompileValue_(expression.get()));
+    }
+    else
+    {
+      Emit_(EOpcode::RET);
+    }
+    break;
+  }
+
+  case KW_BREAK:
+    Emit_(EOpcode::JMP, loopLabels_.at(statement->GetRefLoopStatement().get()).breakLabel);
+    break;
+
+  case KW_CONTINUE:
+    Emit_(EOpcode::JMP, loopLabels_.at(statement->GetRefLoopStatement().get()).continueLabel);
+    break;
+
+  default:
+    assert(false);
+  }
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileBranch_(ASTNode* node, bool jumpIf, int label)
+{
+  CheckSupportedType_(node->token, node->GetTypeSym());
+  const Token& token = node->token;
+  int value = 0;
+
+  if (token == OP_LNOT && node->GetChildCount() == 1)
+  {
+    CompileBranch_(node->GetChild(0).get(), !jumpIf, label);
+  }
+  else if (token == OP_LAND || token == OP_LOR)
+  {
+    // `a && b` jumps on true only if both are true, `a || b` on false
+    // only if both are false, otherwise first operand decides alone
+    bool shortValue = token == OP_LOR;
+    if (jumpIf == shortValue)
+    {
+      CompileBranch_(node->GetChild(0).get(), jumpIf, label);
+      CompileBranch_(node->GetChild(1).get(), jumpIf, label);
+    }
+    else
+    {
+      int skipLabel = NewLabel_();
+      CompileBranch_(node->GetChild(0).get(), shortValue, skipLabel);
+      CompileBranch_(node->GetChild(1).get(), jumpIf, label);
+      BindLabel_(skipLabel);
+    }
+  }
+  else if (IsComparison(token) && node->GetChildCount() == 2)
+  {
+    const std::pair<EOpcode, EOpcode>& jumps = comparisonJumps.at(token.type);
+    EOpcode opcode = jumpIf ? jumps.first : jumps.second;
+    int left = CompileValue_(node->GetChild(0).get());
+    if (IsConstant(node->GetChild(1).get(), value))
+    {
+      Emit_(jumpToImmediateJump.at(opcode), left, value, label);
+    }
+    else
+    {
+      Emit_(opcode, left, CompileValue_(node->GetChild(1).get()), label);
+    }
+  }
+  else if (IsConstant(node, value))
+  {
+    if ((value != 0) == jumpIf)
+    {
+      Emit_(EOpcode::JMP, label);
+    }
+  }
+  else
+  {
+    Emit_(jumpIf ? EOpcode::JNZ : EOpcode::JZ, CompileValue_(node), label);
+  }
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileEffect_(ASTNode* node)
+{
+  if (IsAssignmentOperator(node->token.type))
+  {
+    CompileAssignment_(node, -1, true);
+  }
+  else if ((node->token == OP_INC || node->token == OP_DEC)
+           && dynamic_cast<ASTNodeUnaryOperator*>(node) != NULL)
+  {
+    CompileIncDec_(static_cast<ASTNodeUnaryOperator*>(node), -1, true);
+  }
+  else if (node->token == OP_COMMA)
+  {
+    for (int i = 0; i < node->GetChildCount(); i++)
+    {
+      CompileEffect_(node->GetChild(i).get());
+    }
+  }
+  else
+  {
+    CompileValue_(node);
+  }
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileValue_(ASTNode* node, int target)
+{
+  if (dynamic_cast<ASTNodeFunctionCall*>(node) != NULL)
+  {
+    return CompileFunctionCall_(node, target);
+  }
+
+  Token& token = node->token;
+  CheckSupportedType_(token, node->GetTypeSym());
+
+  switch (token.type)
+  {
+  case TT_IDENTIFIER:
+    if (IfOfType(node->GetTypeSym(), ESymbolType::TYPE_FUNCTION))
+    {
+      if (LookupScope_(token.text) == scopes_[0])
+      {
+        ThrowInvalidTokenError(token, "internal function can only be called");
+      }
+      int result = Result_(target);
+      Emit_(EOpcode::MOVI, result, functionAddressTag | context_.module.GetFunctionIndex(token.text));
+      return result;
+    }
+    return CompileLoad_(CompileLocation_(node), node->GetTypeSym(), target);
+
+  case TT_LITERAL_INT:
+  case TT_LITERAL_CHAR:
+  {
+    int result = Result_(target);
+    Emit_(EOpcode::MOVI, result, token.intValue);
+    return result;
+  }
+
+  case TT_LITERAL_CHAR_ARRAY:
+  {
+    int result = Result_(target);
+    Emit_(EOpcode::MOVI, result, StringAddress_(node));
+    return result;
+  }
+
+  case OP_LAND:
+  case OP_LOR:
+    return CompileLogicalOperator_(node, target);
+
+  case OP_QMARK:
+    return CompileConditional_(node, target);
+
+  case OP_COMMA:
+    for (int i = 0; i < node->GetChildCount() - 1; i++)
+    {
+      CompileEffect_(node->GetChild(i).get());
+    }
+    return CompileValue_(node->GetChild(node->GetChildCount() - 1).get(), target);
+
+  case OP_LSQUARE:
+  case OP_DOT:
+  case OP_ARROW:
+    return CompileLoad_(CompileLocation_(node), node->GetTypeSym(), target);
+
+  case TT_CAST:
+  {
+    shared_ptr<SymbolType> targetType = static_cast<ASTNodeTypeName*>(node->GetChild(0).get())->GetTypeNameSymbol();
+    ASTNode* expression = node->GetChild(1).get();
+    CheckSupportedType_(token, targetType);
+    CheckSupportedType_(expression->token, expression->GetTypeSym());
+    int value = CompileValue_(expression, target);
+    if (IfOfType(targetType, ESymbolType::TYPE_CHAR))
+    {
+      int result = Result_(target);
+      Emit_(EOpcode::SEXT8, result, value);
+      return result;
+    }
+    return value;
+  }
+
+  default:
+    if (IsAssignmentOperator(token.type))
+    {
+      return CompileAssignment_(node, target, false);
+    }
+    else if (dynamic_cast<ASTNodeUnaryOperator*>(node) != NULL)
+    {
+      return CompileUnaryOperator_(node, target);
+    }
+    else if (dynamic_cast<ASTNodeBinaryOperator*>(node) != NULL)
+    {
+      return CompileBinaryOperator_(node, target);
+    }
+    ThrowInvalidTokenError(token, "expression is not supported by bytecode compiler");
+  }
+  return -1;
+}
+
+//==============================================================================
+FunctionBytecodeCompiler::Location FunctionBytecodeCompiler::CompileLocation_(ASTNode* node)
+{
+  bool byte = IfOfType(node->GetTypeSym(), ESymbolType::TYPE_CHAR);
+
+  switch (node->token.type)
+  {
+  case TT_IDENTIFIER:
+  {
+    SymbolTable* scope = LookupScope_(node->token.text);
+    assert(scope != NULL);
+    shared_ptr<SymbolVariable> variable = scope->LookupVariable(node->token.text);
+    if (variable == NULL || scope == scopes_[0])
+    {
+      ThrowInvalidTokenError(node->token, "lvalue expected");
+    }
+    if (scope->GetScopeType() == EScopeType::GLOBAL)
+    {
+      return {ELocation::GLOBAL, 0, GlobalAddress_(variable), byte};
+    }
+    auto it = variableRegisters_.find(variable.get());
+    if (it != variableRegisters_.end())
+    {
+      return {ELocation::REGISTER, it->second, 0, byte};
+    }
+    return {ELocation::FRAME, 0, variable->offset, byte};
+  }
+
+  case TT_LITERAL_CHAR_ARRAY:
+    return {ELocation::GLOBAL, 0, StringAddress_(node), false};
+
+  case OP_LSQUARE:
+  {
+    ASTNode* base = node->GetChild(0).get();
+    ASTNode* index = node->GetChild(1).get();
+    int size = GetActualType(node->GetTypeSym())->GetSize();
+    int value = 0;
+
+    // array elements are addressed from the array location itself
+    Location location;
+    if (IfOfType(base->GetTypeSym(), ESymbolType::TYPE_ARRAY))
+    {
+      location = CompileLocation_(base);
+    }
+    else
+    {
+      location = {ELocation::INDIRECT, CompileValue_(base), 0, false};
+    }
+    location.byte = byte;
+
+    if (IsConstant(index, value))
+    {
+      location.offset += value * size;
+      return location;
+    }
+
+    int address = CompileLocationAddress_(location, -1);
+    int scaled = CompileScale_(CompileValue_(index), size);
+    int result = NewTemporary_();
+    Emit_(EOpcode::ADD, result, address, scaled);
+    return {ELocation::INDIRECT, result, 0, byte};
+  }
+
+  case OP_DOT:
+  {
+    ASTNode* lhs = node->GetChild(0).get();
+    Location location = CompileLocation_(lhs);
+    location.offset += FieldOffset(lhs->GetTypeSym(), node->GetChild(1)->token.text);
+    location.byte = byte;
+    return location;
+  }
+
+  case OP_ARROW:
+  {
+    ASTNode* lhs = node->GetChild(0).get();
+    shared_ptr<SymbolType> structType = GetRefSymbol(GetActualType(lhs->GetTypeSym()));
+    int base = CompileValue_(lhs);
+    return {ELocation::INDIRECT, base, FieldOffset(structType, node->GetChild(1)->token.text), byte};
+  }
+
+  case OP_STAR:
+    if (node->GetChildCount() == 1)
+    {
+      return {ELocation::INDIRECT, CompileValue_(node->GetChild(0).get()), 0, byte};
+    }
+    // fallthrough
+
+  default:
+    ThrowInvalidTokenError(node->token, "lvalue expected");
+  }
+  return {ELocation::REGISTER, -1, 0, false};
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileLoad_(const Location& location, shared_ptr<SymbolType> type, int target)
+{
+  switch (GetActualType(type)->GetType())
+  {
+  case ESymbolType::TYPE_ARRAY:
+  case ESymbolType::TYPE_STRUCT:
+  case ESymbolType::TYPE_FUNCTION:
+    // value is the address itself
+    return CompileLocationAddress_(location, target);
+
+  default:
+    break;
+  }
+
+  if (location.kind == ELocation::REGISTER)
+  {
+    return MoveTo_(location.reg, target);
+  }
+
+  int result = Result_(target);
+  switch (location.kind)
+  {
+  case ELocation::FRAME:
+    Emit_(location.byte ? EOpcode::LOADL8 : EOpcode::LOADL32, result, location.offset);
+    break;
+
+  case ELocation::GLOBAL:
+    Emit_(location.byte ? EOpcode::LOADG8 : EOpcode::LOADG32, result, location.offset);
+    break;
+
+  case ELocation::INDIRECT:
+    Emit_(location.byte ? EOpcode::LOAD8 : EOpcode::LOAD32, result, location.reg, location.offset);
+    break;
+
+  default:
+    assert(false);
+  }
+  return result;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileLocationAddress_(const Location& location, int target)
+{
+  switch (location.kind)
+  {
+  case ELocation::FRAME:
+  {
+    int result = Result_(target);
+    Emit_(EOpcode::LEAL, result, location.offset);
+    return result;
+  }
+
+  case ELocation::GLOBAL:
+  {
+    int result = Result_(target);
+    Emit_(EOpcode::MOVI, result, location.offset);
+    return result;
+  }
+
+  case ELocation::INDIRECT:
+  {
+    if (location.offset == 0)
+    {
+      return MoveTo_(location.reg, target);
+    }
+    int result = Result_(target);
+    Emit_(EOpcode::ADDI, result, location.reg, location.offset);
+    return result;
+  }
+
+  default:
+    // variables whose address is taken never get a register
+    assert(false);
+  }
+  return -1;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompileStore_(const Location& location, int value)
+{
+  switch (location.kind)
+  {
+  case ELocation::REGISTER:
+    if (location.byte)
+    {
+      Emit_(EOpcode::SEXT8, location.reg, value);
+    }
+    else
+    {
+      MoveTo_(value, location.reg);
+    }
+    break;
+
+  case ELocation::FRAME:
+    Emit_(location.byte ? EOpcode::STOREL8 : EOpcode::STOREL32, location.offset, value);
+    break;
+
+  case ELocation::GLOBAL:
+    Emit_(location.byte ? EOpcode::STOREG8 : EOpcode::STOREG32, location.offset, value);
+    break;
+
+  case ELocation::INDIRECT:
+    Emit_(location.byte ? EOpcode::STORE8 : EOpcode::STORE32, location.reg, location.offset, value);
+    break;
+  }
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileBinaryOperator_(ASTNode* node, int target)
+{
+  ASTNode* left = node->GetChild(0).get();
+  ASTNode* right = node->GetChild(1).get();
+  shared_ptr<SymbolType> leftType = left->GetTypeSym();
+  shared_ptr<SymbolType> rightType = right->GetTypeSym();
+  CheckSupportedType_(left->token, leftType);
+  CheckSupportedType_(right->token, rightType);
+
+  const Token& token = node->token;
+  bool leftPointer = IfPointerLike(leftType);
+  bool rightPointer = IfPointerLike(rightType);
+  // integer added to or subtracted from pointer is scaled by element size
+  bool scaleRight = (token == OP_PLUS || token == OP_MINUS) && leftPointer && !rightPointer;
+
+  int leftValue = CompileValue_(left);
+  int value = 0;
+  if (!rightPointer && IsConstant(right, value))
+  {
+    int result = Result_(target);
+    if (EmitArithmeticImmediate_(token, result, leftValue, scaleRight ? value * ElementSize(leftType) : value))
+    {
+      return result;
+    }
+    // result may be the left operand register, constant goes elsewhere
+    int constant = NewTemporary_();
+    Emit_(EOpcode::MOVI, constant, scaleRight ? value * ElementSize(leftType) : value);
+    EmitArithmetic_(token, result, leftValue, constant);
+    return result;
+  }
+
+  int rightValue = CompileValue_(right);
+  if (scaleRight)
+  {
+    rightValue = CompileScale_(rightValue, ElementSize(leftType));
+  }
+  else if (token == OP_PLUS && rightPointer && !leftPointer)
+  {
+    leftValue = CompileScale_(leftValue, ElementSize(rightType));
+  }
+
+  int result = Result_(target);
+  EmitArithmetic_(token, result, leftValue, rightValue);
+
+  if (token == OP_MINUS && leftPointer && rightPointer)
+  {
+    // pointer difference is measured in elements
+    int size = ElementSize(leftType);
+    if (size != 1)
+    {
+      int divisor = NewTemporary_();
+      Emit_(EOpcode::MOVI, divisor, size);
+      Emit_(EOpcode::DIV, result, result, divisor);
+    }
+  }
+  return result;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileLogicalOperator_(ASTNode* node, int target)
+{
+  int shortLabel = NewLabel_();
+  int endLabel = NewLabel_();
+  // && short-circuits to 0, || short-circuits to 1
+  bool shortValue = node->token == OP_LOR;
+  int result = Result_(target);
+
+  CompileBranch_(node->GetChild(0).get(), shortValue, shortLabel);
+  CompileBranch_(node->GetChild(1).get(), shortValue, shortLabel);
+  Emit_(EOpcode::MOVI, result, !shortValue);
+  Emit_(EOpcode::JMP, endLabel);
+  BindLabel_(shortLabel);
+  Emit_(EOpcode::MOVI, result, shortValue);
+  BindLabel_(endLabel);
+  return result;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileUnaryOperator_(ASTNode* node, int target)
+{
+  ASTNode* operand = node->GetChild(0).get();
+
+  switch (node->token.type)
+  {
+  case OP_INC:
+  case OP_DEC:
+    return CompileIncDec_(static_cast<ASTNodeUnaryOperator*>(node), target, false);
+
+  case OP_AMP:
+    if (operand->token == TT_IDENTIFIER
+        && IfOfType(operand->GetTypeSym(), ESymbolType::TYPE_FUNCTION))
+    {
+      return CompileValue_(operand, target);
+    }
+    return CompileLocationAddress_(CompileLocation_(operand), target);
+
+  case OP_STAR:
+    return CompileLoad_(CompileLocation_(node), node->GetTypeSym(), target);
+
+  case KW_SIZEOF:
+  {
+    shared_ptr<SymbolType> type = operand->token == TT_TYPE_NAME
+        ? static_cast<ASTNodeTypeName*>(operand)->GetTypeNameSymbol()
+        : operand->GetTypeSym();
+    int result = Result_(target);
+    Emit_(EOpcode::MOVI, result, GetActualType(type)->GetSize());
+    return result;
+  }
+
+  case OP_PLUS:
+  case OP_MINUS:
+  case OP_COMPL:
+  case OP_LNOT:
+  {
+    CheckSupportedType_(operand->token, operand->GetTypeSym());
+    int value = 0;
+    if (IsConstant(node, value))
+    {
+      int result = Result_(target);
+      Emit_(EOpcode::MOVI, result, value);
+      return result;
+    }
+    if (node->token == OP_PLUS)
+    {
+      return CompileValue_(operand, target);
+    }
+    int operandValue = CompileValue_(operand);
+    int result = Result_(target);
+    Emit_(node->token == OP_MINUS ? EOpcode::NEG
+          : node->token == OP_COMPL ? EOpcode::NOT
+          : EOpcode::LNOT, result, operandValue);
+    return result;
+  }
+
+  default:
+    ThrowInvalidTokenError(node->token, "operator is not supported by bytecode compiler");
+  }
+  return -1;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileIncDec_(ASTNodeUnaryOperator* node, int target, bool discard)
+{
+  shared_ptr<SymbolType> type = node->GetTypeSym();
+  CheckSupportedType_(node->token, type);
+  int step = IfPointerLike(type) ? ElementSize(type) : 1;
+  int delta = node->token == OP_INC ? step : -step;
+
+  Location location = CompileLocation_(node->GetOperand().get());
+  if (location.kind == ELocation::REGISTER)
+  {
+    int reg = location.reg;
+    int old = -1;
+    if (node->IsPostfix() && !discard)
+    {
+      old = Result_(target);
+      Emit_(EOpcode::MOV, old, reg);
+    }
+    Emit_(EOpcode::ADDI, reg, reg, delta);
+    if (location.byte)
+    {
+      Emit_(EOpcode::SEXT8, reg, reg);
+    }
+    return old >= 0 ? old : MoveTo_(reg, target);
+  }
+
+  int value = CompileLoad_(location, type, -1);
+  int updated = NewTemporary_();
+  Emit_(EOpcode::ADDI, updated, value, delta);
+  CompileStore_(location, updated);
+  if (discard)
+  {
+    return updated;
+  }
+  if (node->IsPostfix())
+  {
+    return MoveTo_(value, target);
+  }
+  if (location.byte)
+  {
+    Emit_(EOpcode::SEXT8, updated, updated);
+  }
+  return MoveTo_(updated, target);
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileAssignment_(ASTNode* node, int target, bool discard)
+{
+  ASTNode* left = node->GetChild(0).get();
+  ASTNode* right = node->GetChild(1).get();
+  shared_ptr<SymbolType> type = left->GetTypeSym();
+
+  if (IfOfType(type, ESymbolType::TYPE_STRUCT))
+  {
+    ThrowInvalidTokenError(node->token, "structure assignment is not supported by bytecode compiler");
+  }
+  CheckSupportedType_(left->token, type);
+  CheckSupportedType_(right->token, right->GetTypeSym());
+
+  Location location = CompileLocation_(left);
+  int result = -1;
+
+  if (node->token == OP_ASS)
+  {
+    if (location.kind == ELocation::REGISTER)
+    {
+      // value is computed right into variable register
+      int value = CompileValue_(right, location.byte ? -1 : location.reg);
+      CompileStore_(location, value);
+      return MoveTo_(location.reg, target);
+    }
+    result = CompileValue_(right);
+  }
+  else
+  {
+    // for register variables this is the variable register itself
+    result = CompileLoad_(location, type, -1);
+    int value = 0;
+    bool pointer = IfPointerLike(type)
+        && (node->token == OP_PLUSASS || node->token == OP_MINUSASS);
+    int scale = pointer ? ElementSize(type) : 1;
+    if (!IsConstant(right, value)
+        || !EmitArithmeticImmediate_(node->token, result, result, value * scale))
+    {
+      int rightValue = CompileValue_(right);
+      if (pointer)
+      {
+        rightValue = CompileScale_(rightValue, scale);
+      }
+      EmitArithmetic_(node->token, result, result, rightValue);
+    }
+    if (location.kind == ELocation::REGISTER)
+    {
+      if (location.byte)
+      {
+        Emit_(EOpcode::SEXT8, result, result);
+      }
+      return MoveTo_(result, target);
+    }
+  }
+
+  CompileStore_(location, result);
+  if (location.byte && !discard)
+  {
+    int extended = Result_(target);
+    Emit_(EOpcode::SEXT8, extended, result);
+    return extended;
+  }
+  return MoveTo_(result, target);
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileFunctionCall_(ASTNode* node, int target)
+{
+  ASTNode* callee = node->GetChild(0).get();
+  if (callee->token == TT_IDENTIFIER
+      && callee->token.text == "print"
+      && LookupScope_("print") == scopes_[0])
+  {
+    CompilePrint_(node);
+    return Result_(target);
+  }
+
+  int argumentCount = node->GetChildCount() - 1;
+  for (int i = 1; i <= argumentCount; i++)
+  {
+    ASTNode* argument = node->GetChild(i).get();
+    if (IfOfType(argument->GetTypeSym(), ESymbolType::TYPE_STRUCT))
+    {
+      ThrowInvalidTokenError(argument->token, "structure arguments are not supported by bytecode compiler");
+    }
+    CheckSupportedType_(argument->token, argument->GetTypeSym());
+  }
+
+  shared_ptr<SymbolType> returnType = GetRefSymbol(GetActualType(callee->GetTypeSym()));
+  if (IfOfType(returnType, ESymbolType::TYPE_STRUCT))
+  {
+    ThrowInvalidTokenError(node->token, "structure return values are not supported by bytecode compiler");
+  }
+
+  bool direct = callee->token == TT_IDENTIFIER
+      && IfOfType(callee->GetTypeSym(), ESymbolType::TYPE_FUNCTION);
+  int address = direct ? -1 : CompileValue_(callee);
+  int result = Result_(target);
+
+  // arguments become first registers of callee window, registers above
+  // them hold only temporaries which are dead by the time of call
+  int argumentBase = temporaryTop_;
+  temporaryTop_ += argumentCount;
+  registerCount_ = std::max(registerCount_, temporaryTop_);
+  for (int i = 0; i < argumentCount; i++)
+  {
+    CompileValue_(node->GetChild(i + 1).get(), argumentBase + i);
+    temporaryTop_ = argumentBase + argumentCount;
+  }
+
+  if (direct)
+  {
+    Emit_(EOpcode::CALL, result, context_.module.GetFunctionIndex(callee->token.text), argumentBase);
+  }
+  else
+  {
+    Emit_(EOpcode::CALLR, result, address, argumentBase);
+  }
+  temporaryTop_ = argumentBase;
+  return result;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CompilePrint_(ASTNode* node)
+{
+  std::string format;
+  int argumentCount = node->GetChildCount() - 1;
+  for (int i = 1; i <= argumentCount; i++)
+  {
+    ASTNode* argument = node->GetChild(i).get();
+    shared_ptr<SymbolType> type = argument->GetTypeSym();
+    CheckSupportedType_(argument->token, type);
+
+    char specifier = 'd';
+    if (IfOfType(type, ESymbolType::TYPE_CHAR))
+    {
+      specifier = 'c';
+    }
+    else if (IfPointerLike(type)
+             && IfOfType(GetRefSymbol(GetActualType(type)), ESymbolType::TYPE_CHAR))
+    {
+      specifier = 's';
+    }
+    else if (!IfInteger(type) && !IfPointerLike(type))
+    {
+      ThrowInvalidTokenError(argument->token, "print argument of type "
+                             + type->GetQualifiedName() + " is not supported by bytecode compiler");
+    }
+    format += specifier;
+  }
+
+  std::vector<std::string>& formats = context_.module.printFormats;
+  int formatIndex = std::find(formats.begin(), formats.end(), format) - formats.begin();
+  if (formatIndex == static_cast<int>(formats.size()))
+  {
+    formats.push_back(format);
+  }
+
+  int argumentBase = temporaryTop_;
+  temporaryTop_ += argumentCount;
+  registerCount_ = std::max(registerCount_, temporaryTop_);
+  for (int i = 0; i < argumentCount; i++)
+  {
+    CompileValue_(node->GetChild(i + 1).get(), argumentBase + i);
+    temporaryTop_ = argumentBase + argumentCount;
+  }
+  Emit_(EOpcode::PRINT, formatIndex, argumentBase, argumentCount);
+  temporaryTop_ = argumentBase;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileConditional_(ASTNode* node, int target)
+{
+  int elseLabel = NewLabel_();
+  int endLabel = NewLabel_();
+  int result = Result_(target);
+
+  CompileBranch_(node->GetChild(0).get(), false, elseLabel);
+  CompileValue_(node->GetChild(1).get(), result);
+  Emit_(EOpcode::JMP, endLabel);
+  BindLabel_(elseLabel);
+  CompileValue_(node->GetChild(2).get(), result);
+  BindLabel_(endLabel);
+  return result;
+}
+
+//==============================================================================
+int FunctionBytecodeCompiler::CompileScale_(int reg, int size)
+{
+  if (size == 1)
+  {
+    return reg;
+  }
+  int result = NewTemporary_();
+  Emit_(EOpcode::MULI, result, reg, size);
+  return result;
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::EmitArithmetic_(const Token& token, int result, int left, int right)
+{
+  auto it = arithmeticOpcodes.find(token.type);
+  if (it == arithmeticOpcodes.end())
+  {
+    ThrowInvalidTokenError(token, "operator is not supported by bytecode compiler");
+  }
+  Emit_(it->second, result, left, right);
+}
+
+//==============================================================================
+bool FunctionBytecodeCompiler::EmitArithmeticImmediate_(const Token& token, int result, int left, int value)
+{
+  auto it = arithmeticOpcodes.find(token.type);
+  if (it == arithmeticOpcodes.end())
+  {
+    return false;
+  }
+
+  switch (it->second)
+  {
+  case EOpcode::ADD:
+    Emit_(EOpcode::ADDI, result, left, value);
+    return true;
+
+  case EOpcode::SUB:
+    Emit_(EOpcode::ADDI, result, left, -value);
+    return true;
+
+  case EOpcode::MUL:
+    Emit_(EOpcode::MULI, result, left, value);
+    return true;
+
+  case EOpcode::AND:
+    Emit_(EOpcode::ANDI, result, left, value);
+    return true;
+
+  case EOpcode::SHL:
+    Emit_(EOpcode::SHLI, result, left, value & 31);
+    return true;
+
+  case EOpcode::SAR:
+    Emit_(EOpcode::SARI, result, left, value & 31);
+    return true;
+
+  default:
+    return false;
+  }
+}
+
+//==============================================================================
+void FunctionBytecodeCompiler::CheckSupportedType_(const Token& token, shared_ptr<SymbolType> type) const
+{
+  if (type != NULL
+      && IfOfType(type, ESymbolType::TYPE_FLOAT))
+  {
+    ThrowInvalidTokenError(token, "floating point values are not supported by bytecode compiler");
+  }
+}
+
+//==============================================================================
+BytecodeGenerator::BytecodeGenerator(bool listing, std::ostream& out)
+  : Parser(out)
+  , listing_(listing)
+  , out_(out)
+{
+
+}
+
+//==============================================================================
+BytecodeGenerator::~BytecodeGenerator()
+{
+
+}
+
+//==============================================================================
+void BytecodeGenerator::Flush() const
+{
+  TimeReport::Scope scope(TimeReport::EPhase::OUTPUT);
+  Trace::Scope span("output");
+  if (listing_)
+  {
+    context_.module.PrintListing(out_);
+  }
+}
+
+//==============================================================================
+const BytecodeModule& BytecodeGenerator::GetModule() const
+{
+  return context_.module;
+}
+
+//==============================================================================
+void BytecodeGenerator::OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun)
+{
+  TimeReport::Scope scope(TimeReport::EPhase::CODEGEN);
+  Trace::Scope span("codegen", symFun->name);
+  FunctionBytecodeCompiler compiler(symFun, GetGlobalSymbolTable(), GetInternalSymbolTable(), context_);
+  BytecodeFunction function = compiler.Compile();
+  context_.module.functions[context_.module.GetFunctionIndex(symFun->name)] = function;
+}
+
+} // namespace Compiler
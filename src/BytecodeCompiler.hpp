@@ -0,0 +1,161 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <iostream>
+
+#include "ASTNode.hpp"
+#include "Statement.hpp"
+#include "Parser.hpp"
+#include "Bytecode.hpp"
+
+namespace Compiler
+{
+// shared between compiled functions of one translation unit
+struct BytecodeContext
+{
+  BytecodeModule module;
+  // string literal node -> address in module data
+  std::unordered_map<const ASTNode*, int> stringAddresses;
+  // global variable -> address in module data
+  std::unordered_map<const SymbolVariable*, int> globalAddresses;
+};
+
+// lowers single function definition to bytecode
+// scalar variables whose address is never taken live in registers,
+// everything else is addressed relative to frame pointer
+class FunctionBytecodeCompiler
+{
+public:
+  FunctionBytecodeCompiler(shared_ptr<SymbolVariable> symFun,
+                           shared_ptr<SymbolTable> globalSymbols,
+                           shared_ptr<SymbolTable> internalSymbols,
+                           BytecodeContext& context);
+
+  BytecodeFunction Compile();
+
+private:
+  enum class ELocation
+  {
+    REGISTER,
+    // frame pointer relative
+    FRAME,
+    // absolute address in module data
+    GLOBAL,
+    // register holds base address
+    INDIRECT,
+  };
+
+  // where lvalue lives
+  struct Location
+  {
+    ELocation kind;
+    int reg;
+    int offset;
+    bool byte;
+  };
+
+  struct LoopLabels
+  {
+    int continueLabel;
+    int breakLabel;
+  };
+
+  shared_ptr<SymbolVariable> symFun_;
+  BytecodeContext& context_;
+  std::vector<BytecodeInstruction> code_;
+  std::vector<SymbolTable*> scopes_;
+  std::unordered_map<const Statement*, LoopLabels> loopLabels_;
+  // label -> instruction index, -1 until label is bound
+  std::vector<int> labels_;
+  std::vector<int> loopHeaderLabels_;
+  std::unordered_map<const SymbolVariable*, int> variableRegisters_;
+  // names used as operand of unary `&`, such variables are kept in memory
+  std::unordered_set<std::string> addressTaken_;
+  int variableTop_{0};
+  int temporaryTop_{0};
+  int registerCount_{0};
+  int frameSize_{0};
+  int maxFrameSize_{0};
+
+  void Emit_(EOpcode opcode, int a = 0, int b = 0, int c = 0);
+  int NewLabel_();
+  void BindLabel_(int label);
+  void ResolveLabels_();
+  int NewTemporary_();
+  // temporaries do not outlive expression of a statement
+  void ResetTemporaries_();
+  // `target` if it is given, new temporary otherwise
+  int Result_(int target);
+  // copies reg to target, if it is given
+  int MoveTo_(int reg, int target);
+
+  void CollectAddressTaken_(ASTNode* node);
+  SymbolTable* LookupScope_(const std::string& name) const;
+  bool IsPromotable_(shared_ptr<SymbolVariable> variable) const;
+  void AllocateLocals_(const std::vector<DeclarationPoint>& declarations);
+  void CompileInitializer_(shared_ptr<SymbolVariable> variable);
+  int GlobalAddress_(shared_ptr<SymbolVariable> variable);
+  int StringAddress_(ASTNode* node);
+
+  void CompileStatement_(Statement* statement);
+  void CompileCompoundStatement_(CompoundStatement* statement);
+  void CompileSelectionStatement_(SelectionStatement* statement);
+  void CompileForStatement_(ForStatement* statement);
+  void CompileWhileStatement_(WhileStatement* statement);
+  void CompileDoStatement_(DoStatement* statement);
+  void CompileJumpStatement_(JumpStatement* statement);
+  // jumps to label if truth value of node equals `jumpIf`
+  void CompileBranch_(ASTNode* node, bool jumpIf, int label);
+
+  // expression evaluated for side effects only
+  void CompileEffect_(ASTNode* node);
+  // returns register holding the value, which is `target` if it is given
+  // returned register may be a variable one and must not be written to
+  int CompileValue_(ASTNode* node, int target = -1);
+  Location CompileLocation_(ASTNode* node);
+  int CompileLoad_(const Location& location, shared_ptr<SymbolType> type, int target);
+  int CompileLocationAddress_(const Location& location, int target);
+  void CompileStore_(const Location& location, int value);
+  int CompileBinaryOperator_(ASTNode* node, int target);
+  int CompileLogicalOperator_(ASTNode* node, int target);
+  int CompileUnaryOperator_(ASTNode* node, int target);
+  int CompileIncDec_(ASTNodeUnaryOperator* node, int target, bool discard);
+  int CompileAssignment_(ASTNode* node, int target, bool discard);
+  int CompileFunctionCall_(ASTNode* node, int target);
+  void CompilePrint_(ASTNode* node);
+  int CompileConditional_(ASTNode* node, int target);
+  // reg * size, pointer arithmetic
+  int CompileScale_(int reg, int size);
+
+  // result = left `operation` right, operation is binary or compound assignment
+  void EmitArithmetic_(const Token& token, int result, int left, int right);
+  // same with immediate right operand, false if there is no such instruction
+  bool EmitArithmeticImmediate_(const Token& token, int result, int left, int value);
+
+  void CheckSupportedType_(const Token& token, shared_ptr<SymbolType> type) const;
+};
+
+class BytecodeGenerator : public Parser
+{
+public:
+  // listing of compiled module is printed to `out` by Flush if `listing` is set
+  BytecodeGenerator(bool listing, std::ostream& out);
+  ~BytecodeGenerator();
+
+  virtual void Flush() const;
+
+  const BytecodeModule& GetModule() const;
+
+protected:
+  virtual void OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun);
+
+private:
+  BytecodeContext context_;
+  bool listing_;
+  std::ostream& out_;
+};
+
+} // namespace Compiler
@@ -0,0 +1,480 @@
+#include "CompileCache.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <functional>
+#include <mutex>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <cstdlib>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <utime.h>
+#ifdef _WIN32
+#include <direct.h>
+#include <io.h>
+#include <process.h>
+#include <sys/locking.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "utils.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const uint64_t prime1 = 11400714785074694791ULL;
+  const uint64_t prime2 = 14029467366897019727ULL;
+  const uint64_t prime3 = 1609587929392839161ULL;
+  const uint64_t prime4 = 9650029242287828579ULL;
+  const uint64_t prime5 = 2870177450012600261ULL;
+
+  // bumped when entry format changes, compiler changes are told apart by
+  // build id
+  const char* const entryHeader = "compile-cache 1";
+  const char* const statisticsFile = "statistics";
+  const char* const digits = "0123456789abcdef";
+#ifdef _WIN32
+  const int binaryFlag = O_BINARY;
+#else
+  const int binaryFlag = 0;
+#endif
+
+  uint64_t RotateLeft(uint64_t value, int bits)
+  {
+    return (value << bits) | (value >> (64 - bits));
+  }
+
+  uint64_t Read64(const unsigned char* data)
+  {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--)
+    {
+      value = (value << 8) | data[i];
+    }
+    return value;
+  }
+
+  uint64_t Read32(const unsigned char* data)
+  {
+    return static_cast<uint64_t>(data[0]) | (static_cast<uint64_t>(data[1]) << 8)
+        | (static_cast<uint64_t>(data[2]) << 16) | (static_cast<uint64_t>(data[3]) << 24);
+  }
+
+  uint64_t Round(uint64_t accumulator, uint64_t input)
+  {
+    accumulator += input * prime2;
+    accumulator = RotateLeft(accumulator, 31);
+    return accumulator * prime1;
+  }
+
+  uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+  {
+    accumulator ^= Round(0, value);
+    return accumulator * prime1 + prime4;
+  }
+
+  void MakeDirectory(const std::string& path)
+  {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0777);
+#endif
+  }
+
+  struct FileInfo
+  {
+    std::string path;
+    uint64_t size;
+    time_t modified;
+  };
+
+  // regular files of `directory` except unfinished writes
+  std::vector<FileInfo> ListEntries(const std::string& directory)
+  {
+    std::vector<FileInfo> files;
+    DIR* handle = opendir(directory.c_str());
+    if (handle == NULL)
+    {
+      return files;
+    }
+
+    while (dirent* item = readdir(handle))
+    {
+      std::string name = item->d_name;
+      if (name.empty() || name[0] == '.')
+      {
+        continue;
+      }
+
+      struct stat info;
+      std::string path = directory + "/" + name;
+      if (stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode))
+      {
+        files.push_back({path, static_cast<uint64_t>(info.st_size), info.st_mtime});
+      }
+    }
+    closedir(handle);
+    return files;
+  }
+
+  // path, file number, size and modification time of running executable,
+  // so that rebuilt compiler doesn't reuse output of the previous one, and
+  // hashing all of it doesn't cost more than compiling; 0 if it can't be
+  // found, nothing is cached then
+  uint64_t GetBuildId()
+  {
+    static const uint64_t buildId = []
+    {
+#ifdef _WIN32
+      const char* executable = _pgmptr;
+#else
+      const char* executable = "/proc/self/exe";
+#endif
+      struct stat info;
+      if (executable == NULL || stat(executable, &info) != 0)
+      {
+        return uint64_t(0);
+      }
+      std::ostringstream id;
+      id << executable << '\0' << info.st_ino << '\0' << info.st_size << '\0' << info.st_mtime;
+      std::string text = id.str();
+      // never 0, which stands for unknown build
+      return CompileCache::Hash(text.data(), text.size()) | 1;
+    }();
+    return buildId;
+  }
+
+  // counters at the start of statistics file, zeros if it's shorter
+  void ReadCounters(int file, uint64_t* counts, size_t size)
+  {
+#ifdef _WIN32
+    bool read = _lseek(file, 0, SEEK_SET) == 0
+        && _read(file, counts, size) == static_cast<int>(size);
+#else
+    bool read = pread(file, counts, size, 0) == static_cast<ssize_t>(size);
+#endif
+    if (!read)
+    {
+      std::fill(counts, counts + size / sizeof(uint64_t), 0);
+    }
+  }
+
+  // empties the file if counters don't fit, so they restart from zero
+  // rather than read back torn
+  void WriteCounters(int file, const uint64_t* counts, size_t size)
+  {
+#ifdef _WIN32
+    if (_lseek(file, 0, SEEK_SET) != 0
+        || _write(file, counts, size) != static_cast<int>(size))
+    {
+      _chsize(file, 0);
+    }
+#else
+    if (pwrite(file, counts, size, 0) != static_cast<ssize_t>(size))
+    {
+      // nothing more to do if this fails too
+      int truncated = ftruncate(file, 0);
+      UNUSED(truncated);
+    }
+#endif
+  }
+
+  // waits until other processes release the counters
+  bool LockCounters(int file, size_t size)
+  {
+#ifdef _WIN32
+    // retries for 10 seconds, then gives up
+    return _lseek(file, 0, SEEK_SET) == 0 && _locking(file, _LK_LOCK, size) == 0;
+#else
+    struct flock lock;
+    memset(&lock, 0, sizeof(lock));
+    lock.l_type = F_WRLCK;
+    lock.l_whence = SEEK_SET;
+    lock.l_len = size;
+    return fcntl(file, F_SETLKW, &lock) == 0;
+#endif
+  }
+
+  void UnlockCounters(int file, size_t size)
+  {
+#ifdef _WIN32
+    // Windows doesn't release locks of closed file at once
+    _lseek(file, 0, SEEK_SET);
+    _locking(file, _LK_UNLCK, size);
+#else
+    // closing the file releases them
+    UNUSED(file);
+    UNUSED(size);
+#endif
+  }
+
+  // file locks exclude other processes only
+  std::mutex statisticsMutex;
+
+} // namespace
+
+//==============================================================================
+CompileCache::CompileCache(const std::string& directory, uint64_t sizeLimit)
+  : directory_(directory)
+  , sizeLimit_(sizeLimit)
+{
+
+}
+
+//==============================================================================
+std::string CompileCache::GetKey(const std::string& options, const std::vector<char>& source)
+{
+  uint64_t buildId = GetBuildId();
+  if (buildId == 0)
+  {
+    return std::string();
+  }
+  std::string salted = std::string(entryHeader) + '\0' + options;
+  uint64_t hash = Hash(salted.data(), salted.size(), buildId);
+  hash = Hash(source.data(), source.size(), hash);
+
+  std::string key(16, '0');
+  for (int i = 15; i >= 0; i--, hash >>= 4)
+  {
+    key[i] = digits[hash & 15];
+  }
+  return key;
+}
+
+//==============================================================================
+uint64_t CompileCache::Hash(const void* data, size_t size, uint64_t seed)
+{
+  const unsigned char* p = static_cast<const unsigned char*>(data);
+  const unsigned char* end = p + size;
+  uint64_t hash = 0;
+
+  if (size >= 32)
+  {
+    uint64_t v1 = seed + prime1 + prime2;
+    uint64_t v2 = seed + prime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - prime1;
+    for (; p + 32 <= end; p += 32)
+    {
+      v1 = Round(v1, Read64(p));
+      v2 = Round(v2, Read64(p + 8));
+      v3 = Round(v3, Read64(p + 16));
+      v4 = Round(v4, Read64(p + 24));
+    }
+    hash = RotateLeft(v1, 1) + RotateLeft(v2, 7) + RotateLeft(v3, 12) + RotateLeft(v4, 18);
+    hash = MergeRound(hash, v1);
+    hash = MergeRound(hash, v2);
+    hash = MergeRound(hash, v3);
+    hash = MergeRound(hash, v4);
+  }
+  else
+  {
+    hash = seed + prime5;
+  }
+
+  hash += size;
+  for (; p + 8 <= end; p += 8)
+  {
+    hash ^= Round(0, Read64(p));
+    hash = RotateLeft(hash, 27) * prime1 + prime4;
+  }
+  if (p + 4 <= end)
+  {
+    hash ^= Read32(p) * prime1;
+    hash = RotateLeft(hash, 23) * prime2 + prime3;
+    p += 4;
+  }
+  for (; p < end; p++)
+  {
+    hash ^= *p * prime5;
+    hash = RotateLeft(hash, 11) * prime1;
+  }
+
+  hash ^= hash >> 33;
+  hash *= prime2;
+  hash ^= hash >> 29;
+  hash *= prime3;
+  hash ^= hash >> 32;
+  return hash;
+}
+
+//==============================================================================
+bool CompileCache::Load(const std::string& key, Entry& entry)
+{
+  std::string path = GetPath_(key);
+  std::ifstream file(path, std::ios::binary);
+  std::string header;
+  size_t outputSize = 0;
+  size_t errorsSize = 0;
+  bool loaded = std::getline(file, header) && header == entryHeader
+      && file >> entry.status >> outputSize >> errorsSize
+      && file.get() == '\n';
+  if (loaded)
+  {
+    entry.output.resize(outputSize);
+    entry.errors.resize(errorsSize);
+    file.read(&entry.output[0], outputSize);
+    file.read(&entry.errors[0], errorsSize);
+    loaded = file && file.peek() == std::char_traits<char>::eof();
+  }
+
+  if (loaded)
+  {
+    utime(path.c_str(), NULL);
+  }
+  Count_(loaded ? hitCounter : missCounter);
+  return loaded;
+}
+
+//==============================================================================
+void CompileCache::Store(const std::string& key, const Entry& entry)
+{
+  static std::atomic<unsigned> writeCounter(0);
+
+  std::string subdirectory = directory_ + "/" + key.substr(0, 1);
+  MakeDirectory(directory_);
+  MakeDirectory(subdirectory);
+
+  // unique among threads and processes sharing the directory
+  std::ostringstream temporary;
+  temporary << subdirectory << "/.tmp-" << getpid() << "-"
+            << std::hash<std::thread::id>()(std::this_thread::get_id()) << "-" << writeCounter++;
+  std::string temporaryPath = temporary.str();
+
+  {
+    std::ofstream file(temporaryPath, std::ios::binary);
+    file << entryHeader << '\n'
+         << entry.status << ' ' << entry.output.size() << ' ' << entry.errors.size() << '\n'
+         << entry.output << entry.errors;
+    if (!file.flush())
+    {
+      file.close();
+      std::remove(temporaryPath.c_str());
+      return;
+    }
+  }
+
+  // fails on some systems if entry is already there, it has the same contents then
+  if (std::rename(temporaryPath.c_str(), GetPath_(key).c_str()) != 0)
+  {
+    std::remove(temporaryPath.c_str());
+  }
+
+  Evict_(subdirectory, GetPath_(key));
+}
+
+//==============================================================================
+void CompileCache::PrintStatistics(std::ostream& out) const
+{
+  uint64_t counts[counterCount] = {};
+  int file = open((directory_ + "/" + statisticsFile).c_str(), O_RDONLY | binaryFlag);
+  if (file >= 0)
+  {
+    ReadCounters(file, counts, sizeof(counts));
+    close(file);
+  }
+  uint64_t hits = counts[hitCounter];
+  uint64_t misses = counts[missCounter];
+  uint64_t entries = 0;
+  uint64_t size = 0;
+  for (int i = 0; i < 16; i++)
+  {
+    for (auto& file : ListEntries(directory_ + "/" + digits[i]))
+    {
+      entries++;
+      size += file.size;
+    }
+  }
+
+  std::ostringstream line;
+  line << "cache: " << hits << " hits, " << misses << " misses";
+  if (hits + misses > 0)
+  {
+    line << " (" << std::fixed << std::setprecision(1)
+         << 100.0 * hits / (hits + misses) << "% hit rate)";
+  }
+  line << ", " << entries << " entries, " << size << " of " << sizeLimit_ << " bytes";
+  out << line.str() << std::endl;
+}
+
+//==============================================================================
+std::string CompileCache::GetPath_(const std::string& key) const
+{
+  return directory_ + "/" + key.substr(0, 1) + "/" + key;
+}
+
+//==============================================================================
+void CompileCache::Count_(Counter counter) const
+{
+  MakeDirectory(directory_);
+  int file = open((directory_ + "/" + statisticsFile).c_str(), O_RDWR | O_CREAT | binaryFlag, 0666);
+  if (file < 0)
+  {
+    return;
+  }
+
+  // read, increment and write back under lock, so concurrent compilers
+  // don't lose counts
+  std::lock_guard<std::mutex> guard(statisticsMutex);
+  uint64_t counts[counterCount] = {};
+  if (LockCounters(file, sizeof(counts)))
+  {
+    ReadCounters(file, counts, sizeof(counts));
+    counts[counter]++;
+    WriteCounters(file, counts, sizeof(counts));
+    UnlockCounters(file, sizeof(counts));
+  }
+  close(file);
+}
+
+//==============================================================================
+void CompileCache::Evict_(const std::string& subdirectory, const std::string& kept) const
+{
+  std::vector<FileInfo> files = ListEntries(subdirectory);
+  uint64_t size = 0;
+  for (auto& file : files)
+  {
+    size += file.size;
+  }
+
+  uint64_t limit = sizeLimit_ / 16;
+  if (size <= limit)
+  {
+    return;
+  }
+
+  std::sort(files.begin(), files.end(), [](const FileInfo& a, const FileInfo& b)
+  {
+    return a.modified < b.modified;
+  });
+  for (auto& file : files)
+  {
+    if (size <= limit)
+    {
+      break;
+    }
+    if (file.path == kept)
+    {
+      continue;
+    }
+    // may be gone already if another compiler trims the same directory
+    std::remove(file.path.c_str());
+    size -= file.size;
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <cstdint>
+
+namespace Compiler
+{
+// on-disk cache of compilation results keyed by hash of source and options,
+// safe to share between concurrently running compilers
+// entries live in 16 subdirectories by first key digit, each holds up to
+// 1/16 of size limit and drops least recently used entries beyond it,
+// except the newest one
+class CompileCache
+{
+public:
+  struct Entry
+  {
+    int status{0};
+    std::string output;
+    std::string errors;
+  };
+
+  CompileCache(const std::string& directory, uint64_t sizeLimit);
+
+  // `options` must name everything output depends on besides compiler build,
+  // which key includes; empty if the build can't be told, output mustn't
+  // be cached then
+  static std::string GetKey(const std::string& options, const std::vector<char>& source);
+  // XXH64
+  static uint64_t Hash(const void* data, size_t size, uint64_t seed = 0);
+
+  // false on miss, hit makes entry most recently used
+  bool Load(const std::string& key, Entry& entry);
+  // entry appears at once or not at all, then its subdirectory is trimmed
+  void Store(const std::string& key, const Entry& entry);
+
+  // totals over every compiler which used the directory
+  void PrintStatistics(std::ostream& out) const;
+
+private:
+  enum Counter
+  {
+    hitCounter,
+    missCounter,
+    counterCount,
+  };
+
+  std::string directory_;
+  uint64_t sizeLimit_;
+
+  std::string GetPath_(const std::string& key) const;
+  // counters are 64-bit numbers at fixed offsets of statistics file,
+  // updated in place
+  void Count_(Counter counter) const;
+  // `kept` stays even if it alone is over the limit
+  void Evict_(const std::string& subdirectory, const std::string& kept) const;
+};
+
+} // namespace Compiler
@@ -0,0 +1,415 @@
+#include "CompileServer.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <chrono>
+#include <cstring>
+#include <cstdlib>
+#include <cerrno>
+#include <cstdint>
+#include <csignal>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <poll.h>
+#include <arpa/inet.h>
+#endif
+
+#include "Driver.hpp"
+#include "ThreadPool.hpp"
+
+namespace Compiler
+{
+#ifndef _WIN32
+//==============================================================================
+namespace
+{
+  // requests bigger than this are rejected rather than allocated, connection
+  // is closed without reply
+  const uint32_t maxSourceSize = 1 << 24;
+  const uint32_t maxArgumentCount = 256;
+  const uint32_t maxArgumentSize = 4096;
+  // output may be larger than source, server is trusted by its clients
+  const uint32_t maxReplySize = 1 << 30;
+  // whole request must arrive and reply be taken within this, so idle or
+  // stuck clients don't hold workers
+  const int requestTimeoutMilliseconds = 5000;
+
+  typedef std::chrono::steady_clock::time_point Deadline;
+
+  void WriteAll(int socket, const char* data, size_t size)
+  {
+    while (size > 0)
+    {
+      ssize_t written = ::write(socket, data, size);
+      if (written < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (written <= 0)
+      {
+        throw std::runtime_error("compile server connection is broken");
+      }
+      data += written;
+      size -= written;
+    }
+  }
+
+  // without deadline waits as long as it takes
+  void ReadAll(int socket, char* data, size_t size, const Deadline* deadline = NULL)
+  {
+    while (size > 0)
+    {
+      if (deadline != NULL)
+      {
+        auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                      *deadline - std::chrono::steady_clock::now()).count();
+        pollfd request = {socket, POLLIN, 0};
+        int ready = left > 0 ? poll(&request, 1, static_cast<int>(left)) : 0;
+        if (ready < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if (ready <= 0)
+        {
+          throw std::runtime_error("compile server request timed out");
+        }
+      }
+      ssize_t read = ::read(socket, data, size);
+      if (read < 0 && errno == EINTR)
+      {
+        continue;
+      }
+      if (read <= 0)
+      {
+        throw std::runtime_error("compile server connection is broken");
+      }
+      data += read;
+      size -= read;
+    }
+  }
+
+  void WriteNumber(int socket, uint32_t value)
+  {
+    value = htonl(value);
+    WriteAll(socket, reinterpret_cast<const char*>(&value), sizeof(value));
+  }
+
+  uint32_t ReadNumber(int socket, const Deadline* deadline = NULL)
+  {
+    uint32_t value = 0;
+    ReadAll(socket, reinterpret_cast<char*>(&value), sizeof(value), deadline);
+    return ntohl(value);
+  }
+
+  void WriteString(int socket, const std::string& value)
+  {
+    WriteNumber(socket, value.size());
+    WriteAll(socket, value.data(), value.size());
+  }
+
+  std::string ReadString(int socket, uint32_t maxSize, const Deadline* deadline = NULL)
+  {
+    uint32_t size = ReadNumber(socket, deadline);
+    if (size > maxSize)
+    {
+      throw std::runtime_error("compile server request is too big");
+    }
+    std::string value(size, '\0');
+    ReadAll(socket, &value[0], size, deadline);
+    return value;
+  }
+
+  sockaddr_un GetAddress(const std::string& path)
+  {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+    {
+      throw std::runtime_error("socket path is too long: " + path);
+    }
+    strcpy(address.sun_path, path.c_str());
+    return address;
+  }
+
+  bool IsAbsolutePath(const std::string& path)
+  {
+    return path.empty() || path[0] == '/';
+  }
+
+  int Connect(const std::string& path)
+  {
+    sockaddr_un address = GetAddress(path);
+    int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (connection < 0
+        || connect(connection, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0)
+    {
+      if (connection >= 0)
+      {
+        close(connection);
+      }
+      throw std::runtime_error("can't connect to compile server at " + path);
+    }
+    return connection;
+  }
+
+} // namespace
+
+//==============================================================================
+CompileServer::CompileServer(const std::string& socketPath, unsigned threadCount)
+  : socketPath_(socketPath)
+  , threadCount_(threadCount)
+{
+  sockaddr_un address = GetAddress(socketPath_);
+  // left by server which didn't exit cleanly
+  unlink(socketPath_.c_str());
+
+  listener_ = socket(AF_UNIX, SOCK_STREAM, 0);
+  // only the user who started server may connect, shut it down among others;
+  // no other threads run yet to be affected by umask
+  mode_t oldMask = umask(0077);
+  bool bound = listener_ >= 0
+      && bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+  umask(oldMask);
+  if (!bound || listen(listener_, SOMAXCONN) != 0)
+  {
+    std::string error = strerror(errno);
+    if (listener_ >= 0)
+    {
+      close(listener_);
+    }
+    throw std::runtime_error("can't listen on " + socketPath_ + ": " + error);
+  }
+}
+
+//==============================================================================
+CompileServer::~CompileServer()
+{
+  close(listener_);
+  unlink(socketPath_.c_str());
+}
+
+//==============================================================================
+void CompileServer::Run(std::ostream& log)
+{
+  // client going away must not kill the server
+  signal(SIGPIPE, SIG_IGN);
+
+  {
+    ThreadPool pool(threadCount_);
+    while (!stopping_)
+    {
+      int connection = accept(listener_, NULL, NULL);
+      if (connection < 0)
+      {
+        if (errno == EINTR)
+        {
+          continue;
+        }
+        throw std::runtime_error(std::string("compile server accept failed: ") + strerror(errno));
+      }
+
+      if (stopping_)
+      {
+        close(connection);
+        break;
+      }
+      // reply to client which doesn't read it fails rather than blocks
+      timeval timeout = {requestTimeoutMilliseconds / 1000, 0};
+      setsockopt(connection, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      pool.Submit([this, connection] { Serve_(connection); });
+    }
+    pool.Wait();
+  }
+
+  log << "served " << requestCount_ << " requests";
+  if (requestCount_ > 0)
+  {
+    log << ", " << static_cast<long>(requestSeconds_ / requestCount_ * 1e6) << " us per request";
+  }
+  log << std::endl;
+}
+
+//==============================================================================
+void CompileServer::Serve_(int connection)
+{
+  using namespace std;
+
+  try
+  {
+#ifdef SO_PEERCRED
+    // socket permissions aren't honoured everywhere
+    ucred peer;
+    socklen_t peerSize = sizeof(peer);
+    if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &peer, &peerSize) != 0
+        || peer.uid != getuid())
+    {
+      throw runtime_error("compile server client is another user");
+    }
+#endif
+    Deadline deadline = chrono::steady_clock::now()
+        + chrono::milliseconds(requestTimeoutMilliseconds);
+    uint32_t argumentCount = ReadNumber(connection, &deadline);
+    if (argumentCount > maxArgumentCount)
+    {
+      throw runtime_error("compile server request has too many arguments");
+    }
+    vector<string> arguments(argumentCount);
+    for (auto& argument : arguments)
+    {
+      argument = ReadString(connection, maxArgumentSize, &deadline);
+    }
+    string source = ReadString(connection, maxSourceSize, &deadline);
+
+    auto start = chrono::steady_clock::now();
+    ostringstream out;
+    ostringstream err;
+    int status = EXIT_SUCCESS;
+    DriverOptions options;
+    if (arguments.size() == 1 && arguments[0] == "--shutdown")
+    {
+      stopping_ = true;
+      // wakes accept up
+      close(Connect(socketPath_));
+    }
+    else if (!ParseDriverOptions(arguments, options)
+             || !options.IsSingleSourceMode()
+             || options.files.size() != 1
+             || !options.connectSocket.empty())
+    {
+      err << "ERROR: compile server runs single file -S and --bytecode compilations only"
+          << endl;
+      status = EXIT_FAILURE;
+    }
+    // programs would run inside server shared by all clients
+    else if (options.interpret || options.run || options.tiered)
+    {
+      err << "ERROR: compile server doesn't run programs, --interpret, --run and --tiered "
+             "are local only" << endl;
+      status = EXIT_FAILURE;
+    }
+    // profiles are one per process, server compiles for many clients at once
+    else if (options.timeReport || !options.traceFile.empty() || options.allocStats)
+    {
+      err << "ERROR: compile server doesn't profile, -ftime-report, --trace and "
+             "--alloc-stats are local only" << endl;
+      status = EXIT_FAILURE;
+    }
+    // server's working directory isn't client's
+    else if (!IsAbsolutePath(options.pchFile) || !IsAbsolutePath(options.cacheDirectory))
+    {
+      err << "ERROR: compile server needs absolute --pch and --cache paths" << endl;
+      status = EXIT_FAILURE;
+    }
+    else
+    {
+      status = CompileCachedSource(options, vector<char>(source.begin(), source.end()), out, err);
+    }
+
+    WriteNumber(connection, status);
+    WriteString(connection, out.str());
+    WriteString(connection, err.str());
+
+    lock_guard<mutex> lock(statisticsMutex_);
+    requestCount_++;
+    requestSeconds_ += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  }
+  catch (exception&)
+  {
+    // client has gone, nobody to report to
+  }
+  close(connection);
+}
+
+//==============================================================================
+int RunCompileClient(const std::string& socketPath, const std::vector<std::string>& arguments,
+                     const std::vector<char>& source, std::ostream& out, std::ostream& err)
+{
+  int connection = Connect(socketPath);
+  try
+  {
+    WriteNumber(connection, arguments.size());
+    for (auto& argument : arguments)
+    {
+      WriteString(connection, argument);
+    }
+    WriteString(connection, std::string(source.begin(), source.end()));
+
+    int status = static_cast<int>(ReadNumber(connection));
+    out << ReadString(connection, maxReplySize);
+    err << ReadString(connection, maxReplySize);
+    close(connection);
+    return status;
+  }
+  catch (...)
+  {
+    close(connection);
+    throw;
+  }
+}
+
+//==============================================================================
+std::string GetAbsolutePath(const std::string& path)
+{
+  if (IsAbsolutePath(path))
+  {
+    return path;
+  }
+  char* directory = getcwd(NULL, 0);
+  if (directory == NULL)
+  {
+    throw std::runtime_error(std::string("can't get working directory: ") + strerror(errno));
+  }
+  std::string absolutePath = std::string(directory) + "/" + path;
+  free(directory);
+  return absolutePath;
+}
+
+#else
+//==============================================================================
+CompileServer::CompileServer(const std::string& socketPath, unsigned threadCount)
+  : socketPath_(socketPath)
+  , threadCount_(threadCount)
+{
+  throw std::runtime_error("compile server needs unix domain sockets");
+}
+
+//==============================================================================
+CompileServer::~CompileServer()
+{
+
+}
+
+//==============================================================================
+void CompileServer::Run(std::ostream& log)
+{
+
+}
+
+//==============================================================================
+void CompileServer::Serve_(int connection)
+{
+
+}
+
+//==============================================================================
+int RunCompileClient(const std::string& socketPath, const std::vector<std::string>& arguments,
+                     const std::vector<char>& source, std::ostream& out, std::ostream& err)
+{
+  throw std::runtime_error("compile server needs unix domain sockets");
+}
+
+//==============================================================================
+std::string GetAbsolutePath(const std::string& path)
+{
+  return path;
+}
+#endif
+
+} // namespace Compiler
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+#include <atomic>
+#include <mutex>
+
+namespace Compiler
+{
+// long running compiler answering `compiler --connect` clients on unix
+// domain socket, process start and static tables are paid for once
+// only the user who started it may connect, request must arrive within
+// 5 seconds and source be at most 16 MB, otherwise connection is closed
+// without reply
+// request:  argument count, arguments, source
+// response: exit status, output, errors
+// numbers are 32-bit big endian, strings are prefixed with their length
+class CompileServer
+{
+public:
+  // up to `threadCount` requests are served at once,
+  // zero means one per hardware thread
+  CompileServer(const std::string& socketPath, unsigned threadCount);
+  ~CompileServer();
+  CompileServer(const CompileServer&) = delete;
+  CompileServer& operator=(const CompileServer&) = delete;
+
+  // serves until `--shutdown` request, then prints statistics to `log`
+  void Run(std::ostream& log);
+
+private:
+  std::string socketPath_;
+  unsigned threadCount_;
+  int listener_{-1};
+  std::atomic<bool> stopping_{false};
+
+  std::mutex statisticsMutex_;
+  unsigned requestCount_{0};
+  double requestSeconds_{0.0};
+
+  void Serve_(int connection);
+};
+
+// sends compiler command line `arguments` and `source` of the file named
+// in them to server, writes what server returns to `out` and `err`
+// and returns exit status of the compilation
+int RunCompileClient(const std::string& socketPath, const std::vector<std::string>& arguments,
+                     const std::vector<char>& source, std::ostream& out, std::ostream& err);
+
+// server doesn't share client's working directory, so client passes it paths
+// made absolute by this
+std::string GetAbsolutePath(const std::string& path);
+
+} // namespace Compiler
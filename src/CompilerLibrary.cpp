@@ -0,0 +1,114 @@
+#include "CompilerLibrary.hpp"
+
+#include <sstream>
+#include <stdexcept>
+#include <algorithm>
+
+#include "Token.hpp"
+#include "TokenPipeline.hpp"
+#include "DebugTokenOutputStream.hpp"
+#include "Parser.hpp"
+#include "codegen.hpp"
+#include "BytecodeCompiler.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  Diagnostic MakeDiagnostic(const CompileError& error)
+  {
+    Diagnostic diagnostic;
+    diagnostic.line = error.GetLine();
+    diagnostic.column = error.GetColumn();
+    diagnostic.endColumn = error.GetEndColumn();
+    diagnostic.message = error.what();
+    return diagnostic;
+  }
+
+  // errors parser recovers from are thrown together with the one which
+  // ends it
+  void Parse(const std::vector<char>& input, Parser& parser, const CompileOptions& options)
+  {
+    parser.SetErrorRecovery(options.recoverErrors);
+    try
+    {
+      Tokenize(input, parser, options.pipeline);
+    }
+    catch (...)
+    {
+      parser.RethrowWithRecoveredErrors();
+    }
+  }
+
+} // namespace
+
+//==============================================================================
+CompileResult Compile(const char* source, size_t size, const CompileOptions& options)
+{
+  using namespace std;
+
+  CompileResult result;
+  ostringstream out;
+  vector<char> input(source, source + size);
+  try
+  {
+    switch (options.output)
+    {
+    case ECompileOutput::ASSEMBLY:
+    {
+      CodeGenerator codeGenerator(out, max(1u, options.threadCount));
+      Parse(input, codeGenerator, options);
+      break;
+    }
+    case ECompileOutput::BYTECODE:
+    {
+      BytecodeGenerator bytecodeGenerator(true, out);
+      Parse(input, bytecodeGenerator, options);
+      break;
+    }
+    case ECompileOutput::TOKENS:
+    {
+      DebugTokenOutputStream tokens(out);
+      Tokenize(input, tokens, options.pipeline);
+      break;
+    }
+    case ECompileOutput::SYMBOL_TABLES:
+    {
+      Parser parser(out);
+      Parse(input, parser, options);
+      break;
+    }
+    }
+    result.succeeded = true;
+  }
+  catch (CompileErrorList& e)
+  {
+    for (auto& error : e.GetErrors())
+    {
+      result.diagnostics.push_back(MakeDiagnostic(error));
+    }
+  }
+  catch (CompileError& e)
+  {
+    result.diagnostics.push_back(MakeDiagnostic(e));
+  }
+  catch (exception& e)
+  {
+    result.diagnostics.push_back(MakeDiagnostic(CompileError(e.what(), 0, 0)));
+  }
+  catch (...)
+  {
+    result.diagnostics.push_back(MakeDiagnostic(CompileError("unknown exception", 0, 0)));
+  }
+  result.output = out.str();
+  return result;
+}
+
+//==============================================================================
+CompileResult Compile(const std::string& source, const CompileOptions& options)
+{
+  return Compile(source.data(), source.size(), options);
+}
+
+} // namespace Compiler
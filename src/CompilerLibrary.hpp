@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// raised when CompileOptions, Diagnostic or CompileResult change in a way
+// callers built against an older version would notice
+#define COMPILER_API_VERSION 3
+
+// shared library build defines COMPILER_SHARED for itself and its users,
+// COMPILER_BUILD_LIBRARY for itself only
+#if defined(_WIN32) && defined(COMPILER_SHARED)
+#ifdef COMPILER_BUILD_LIBRARY
+#define COMPILER_API __declspec(dllexport)
+#else
+#define COMPILER_API __declspec(dllimport)
+#endif
+#elif defined(COMPILER_SHARED)
+#define COMPILER_API __attribute__((visibility("default")))
+#else
+#define COMPILER_API
+#endif
+
+namespace Compiler
+{
+// what Compile puts to CompileResult::output, the same as output of
+// compiler's -S, --bytecode, tokenizer and parser modes
+enum class ECompileOutput
+{
+  ASSEMBLY,
+  BYTECODE,
+  TOKENS,
+  SYMBOL_TABLES,
+};
+
+struct CompileOptions
+{
+  ECompileOutput output{ECompileOutput::ASSEMBLY};
+  // functions are compiled to assembly on this many threads
+  unsigned threadCount{1};
+  // pretokenizer and tokenizer run on their own thread
+  bool pipeline{false};
+  // parse goes on past syntax and type errors, skipping to the next
+  // statement or declaration, so every one of them is reported;
+  // no output is made then
+  bool recoverErrors{true};
+};
+
+struct Diagnostic
+{
+  // 0 when error is not tied to position of source
+  unsigned line{0};
+  unsigned column{0};
+  // range of source error is about ends here on `line`, past its last
+  // character; tokens don't span lines
+  unsigned endColumn{0};
+  std::string message;
+};
+
+struct CompileResult
+{
+  bool succeeded{false};
+  // on failure holds what was written before the error
+  std::string output;
+  std::vector<Diagnostic> diagnostics;
+};
+
+// compiles one translation unit, neither standard output nor standard
+// error is written; everything compilation touches is owned by the call,
+// so sources may be compiled on several threads at once
+COMPILER_API CompileResult Compile(const char* source, size_t size,
+                                   const CompileOptions& options = CompileOptions());
+COMPILER_API CompileResult Compile(const std::string& source,
+                                   const CompileOptions& options = CompileOptions());
+
+} // namespace Compiler
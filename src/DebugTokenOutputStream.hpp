@@ -2,59 +2,64 @@
 
 #include <iostream>
 #include <exception>
-#include <cassert>
 #include <sstream>
 
 #include "ITokenStream.hpp"
 #include "constants.hpp"
 #include "utils.hpp"
+#include "OutputSink.hpp"
 
 namespace Compiler
 {
-using std::cout;
 using std::endl;
 using std::logic_error;
 using std::stringstream;
 
 struct DebugTokenOutputStream : public ITokenStream
 {
+  // output is buffered until Flush or destruction
+  explicit DebugTokenOutputStream(std::ostream& out)
+    : sink_(out)
+  {
+
+  }
+
   // output: <line>-<column>: invalid <source>
   void EmitInvalid(const string& source, const int line, const int column)
   {
-    stringstream ss;
-    ss << "invalid token at " << FormatPos_(line, column) << source;
-    //            throw logic_error(ss.str());
-    cout << FormatPos_(line, column) << "invalid " << source << endl;
+    //            throw logic_error("invalid token at " + position + source);
+    WritePos_(line, column) << "invalid " << source << '\n';
   }
 
   // output: <line>-<column>: keyword <token_type> <source>
   void EmitKeyword(const string& source, ETokenType token_type,
                    const int line, const int column)
   {
-    cout << FormatPos_(line, column) << "keyword "
-         << keywordTypeToStringMap.at(token_type) << " " << source << endl;
+    WritePos_(line, column) << "keyword "
+         << keywordTypeToStringMap.at(token_type) << " " << source << '\n';
   }
 
   // output: <line>-<column>: punctuation <token_type> <source>
   void EmitPunctuation(const string& source, ETokenType token_type,
                        const int line, const int column)
   {
-    cout << FormatPos_(line, column) << "punctuation "
-         << punctuationTypeToStringMap.at(token_type) << " " << source <<  endl;
+    WritePos_(line, column) << "punctuation "
+         << punctuationTypeToStringMap.at(token_type) << " " << source << '\n';
   }
 
   // output: <line>-<column>: identifier <source>
   void EmitIdentifier(const string& source, const int line, const int column)
   {
-    cout << FormatPos_(line, column) << "identifier " << " " << source << endl;
+    WritePos_(line, column) << "identifier " << " " << source << '\n';
   }
 
   // output: <line>-<column>: literal <type> <source> <hexdump(data,nbytes)>
   void EmitLiteral(const string& source, EFundamentalType type, const void* data,
                    size_t nbytes, const int line, const int column)
   {
-    cout << FormatPos_(line, column) << "literal " << fundamentalTypeToStringMap.at(type)
-         << " " << source << " " << HexDump(data, nbytes) << endl;
+    WritePos_(line, column) << "literal " << fundamentalTypeToStringMap.at(type)
+         << " " << source << " ";
+    sink_.WriteHexDump(data, nbytes) << '\n';
   }
 
   // output: <line>-<column>: literal <source> array of <num_elements> <type> <hexdump(data,nbytes)>
@@ -62,30 +67,44 @@ struct DebugTokenOutputStream : public ITokenStream
                         EFundamentalType type, const void* data, size_t nbytes,
                         const int line, const int column)
   {
-    cout << FormatPos_(line, column) << "literal " << source << " array of "
-         << num_elements << " " << fundamentalTypeToStringMap.at(type)
-         << " " << HexDump(data, nbytes) << endl;
+    WritePos_(line, column) << "literal " << source << " array of "
+         << num_elements << " " << fundamentalTypeToStringMap.at(type) << " ";
+    sink_.WriteHexDump(data, nbytes) << '\n';
   }
 
   // output : eof
   void EmitEof(const int /*line*/, const int /*column*/)
   {
-    cout << "eof" << endl;
+    sink_ << "eof" << '\n';
+    sink_.Flush();
+  }
+
+  // called before error is reported, so it comes after tokens read so far
+  void Flush() const
+  {
+    sink_.Flush();
   }
 
 private:
-  inline std::string FormatPos_(const int line, const int column)
+  mutable StreamOutputSink sink_;
+
+  static size_t GetDigitCount_(int value)
+  {
+    size_t count = 1;
+    for (; value >= 10; value /= 10)
+    {
+      count++;
+    }
+    return count;
+  }
+
+  // padded to 4 and 3 digits, longer numbers are written as they are
+  inline OutputSink& WritePos_(const int line, const int column)
   {
-    std::string lineString = std::to_string(line);
-    std::string columnString = std::to_string(column);
-    assert(lineString.size() <= 4);
-    assert(columnString.size() <= 3);
-    return std::string(4 - lineString.size(), '.')
-        + lineString
-        + '-'
-        + std::string(3 - columnString.size(), '.')
-        + columnString
-        + ": ";
+    size_t lineDigits = GetDigitCount_(line);
+    size_t columnDigits = GetDigitCount_(column);
+    sink_.Fill('.', lineDigits < 4 ? 4 - lineDigits : 0) << line << '-';
+    return sink_.Fill('.', columnDigits < 3 ? 3 - columnDigits : 0) << column << ": ";
   }
 };
 
@@ -0,0 +1,744 @@
+#include "Driver.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <algorithm>
+#include <memory>
+#include <thread>
+#include <chrono>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Token.hpp"
+#include "SimpleExpressionParser.hpp"
+#include "codegen.hpp"
+#include "BytecodeCompiler.hpp"
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "ThreadPool.hpp"
+#include "TokenPipeline.hpp"
+#include "CompileCache.hpp"
+#include "PrecompiledDeclarations.hpp"
+#include "AstFile.hpp"
+#include "TimeReport.hpp"
+#include "AllocationTracker.hpp"
+#include "Trace.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  // time report, trace and allocation statistics
+  bool IsProfiled(const DriverOptions& options)
+  {
+    return options.timeReport || !options.traceFile.empty() || options.allocStats;
+  }
+
+  // listings depend on source and options only, programs which run may read
+  // input and their output is not kept, nor are statistics of pch file
+  // and profiles
+  bool IsCacheable(const DriverOptions& options)
+  {
+    return !options.pchStats && !IsProfiled(options)
+        && (options.assembly
+            || (options.bytecode && !options.interpret && !options.run && !options.tiered));
+  }
+
+  // options which change output, -j and --pipeline don't
+  std::string GetCacheOptions(const DriverOptions& options)
+  {
+    std::string key = options.assembly ? "-S" : "--bytecode";
+    if (options.assembly && options.peepholeStats)
+    {
+      key += " --peephole-stats";
+    }
+    if (options.diagnosticsJson)
+    {
+      key += " -fdiagnostics-format=json";
+    }
+    return key;
+  }
+
+  // feeds `input` to `parser`, its prefix precompiled to options' pch file
+  // is restored instead of parsed, output is the same either way
+  void ParsePrefixed(const DriverOptions& options, const std::vector<char>& input,
+                     Parser& parser, std::ostream& err)
+  {
+    using namespace std;
+
+    if (options.pchFile.empty())
+    {
+      Tokenize(input, parser, options.pipeline);
+      return;
+    }
+
+    auto start = chrono::steady_clock::now();
+    PrecompiledDeclarations declarations(options.pchFile);
+    bool prefixed = declarations.IsPrefixOf(input);
+    if (prefixed)
+    {
+      Trace::Scope span("restore precompiled declarations");
+      declarations.Restore(parser);
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (options.pchStats)
+    {
+      if (prefixed)
+      {
+        err << fixed << setprecision(3)
+            << "precompiled declarations: " << declarations.GetSymbolCount() << " symbols, "
+            << declarations.GetPrefixSize() << "-byte prefix loaded in " << seconds * 1e3
+            << " ms, parsing it took " << declarations.GetParseSeconds() * 1e3 << " ms" << endl;
+      }
+      else
+      {
+        err << "precompiled declarations: not used, source doesn't start with their text" << endl;
+      }
+    }
+    // source which doesn't start with the prefix is parsed as a whole
+    Tokenize(prefixed ? declarations.GetRest(input) : input, parser, options.pipeline);
+  }
+
+  // ParsePrefixed, with -fdiagnostics-format=json errors which parser
+  // recovers from are thrown together with the one which ends it
+  void Parse(const DriverOptions& options, const std::vector<char>& input,
+             Parser& parser, std::ostream& err)
+  {
+    parser.SetErrorRecovery(options.diagnosticsJson);
+    try
+    {
+      ParsePrefixed(options, input, parser, err);
+    }
+    catch (...)
+    {
+      parser.RethrowWithRecoveredErrors();
+    }
+  }
+
+  // reads every field tools would, returns count of nodes walked
+  size_t WalkAst(const AstFile::Node& node)
+  {
+    size_t count = 1;
+    node.GetKind();
+    node.GetText();
+    if (node.HasTypeSymbol())
+    {
+      node.GetTypeSymbol().GetName();
+    }
+    for (int i = 0; i < node.GetDeclarationCount(); i++)
+    {
+      node.GetDeclaration(i).GetName();
+    }
+    for (int i = 0; i < node.GetChildCount(); i++)
+    {
+      count += WalkAst(node.GetChild(i));
+    }
+    return count;
+  }
+
+} // namespace
+
+//==============================================================================
+bool DriverOptions::IsSingleSourceMode() const
+{
+  return assembly || bytecode || interpret || run || tiered;
+}
+
+//==============================================================================
+bool ParseDriverOptions(const std::vector<std::string>& arguments, DriverOptions& options)
+{
+  size_t i = 0;
+  for (; i < arguments.size() && !arguments[i].empty() && arguments[i][0] == '-'; i++)
+  {
+    const std::string& option = arguments[i];
+    bool hasValue = i + 1 < arguments.size();
+    if (option == "-S")
+    {
+      options.assembly = true;
+    }
+    else if (option == "--peephole-stats")
+    {
+      options.peepholeStats = true;
+    }
+    else if (option == "--bytecode")
+    {
+      options.bytecode = true;
+    }
+    else if (option == "--interpret")
+    {
+      options.interpret = true;
+    }
+    else if (option == "--run")
+    {
+      options.run = true;
+    }
+    else if (option == "--jit-stats")
+    {
+      options.jitStats = true;
+    }
+    else if (option == "--tiered")
+    {
+      options.tiered = true;
+    }
+    else if (option == "--tier-stats")
+    {
+      options.tierStats = true;
+    }
+    else if (option == "-j" && hasValue && atoi(arguments[i + 1].c_str()) > 0)
+    {
+      options.threadCount = atoi(arguments[++i].c_str());
+    }
+    else if (option == "--scaling")
+    {
+      options.scaling = true;
+    }
+    else if (option == "--pipeline")
+    {
+      options.pipeline = true;
+    }
+    else if (option == "--server" && hasValue)
+    {
+      options.serverSocket = arguments[++i];
+    }
+    else if (option == "--connect" && hasValue)
+    {
+      options.connectSocket = arguments[++i];
+    }
+    else if (option == "--shutdown")
+    {
+      options.shutdown = true;
+    }
+    else if (option == "--cache" && hasValue)
+    {
+      options.cacheDirectory = arguments[++i];
+    }
+    else if (option == "--cache-size" && hasValue && atoi(arguments[i + 1].c_str()) > 0)
+    {
+      options.cacheSizeMb = atoi(arguments[++i].c_str());
+    }
+    else if (option == "--cache-stats")
+    {
+      options.cacheStats = true;
+    }
+    else if (option == "--precompile" && hasValue)
+    {
+      options.precompileFile = arguments[++i];
+    }
+    else if (option == "--pch" && hasValue)
+    {
+      options.pchFile = arguments[++i];
+    }
+    else if (option == "--pch-stats")
+    {
+      options.pchStats = true;
+    }
+    else if (option == "--ast" && hasValue)
+    {
+      options.astFile = arguments[++i];
+    }
+    else if (option == "--ast-stats")
+    {
+      options.astStats = true;
+    }
+    else if (option == "-ftime-report" || option == "-ftime-report=json")
+    {
+      options.timeReport = true;
+      options.timeReportJson = option == "-ftime-report=json";
+    }
+    else if (option == "--trace" && hasValue)
+    {
+      options.traceFile = arguments[++i];
+    }
+    else if (option.compare(0, 8, "--trace=") == 0 && option.size() > 8)
+    {
+      options.traceFile = option.substr(8);
+    }
+    else if (option == "--alloc-stats")
+    {
+      options.allocStats = true;
+    }
+    else if (option == "-fdiagnostics-format=json")
+    {
+      options.diagnosticsJson = true;
+    }
+    else
+    {
+      return false;
+    }
+  }
+  options.files.assign(arguments.begin() + i, arguments.end());
+
+  if ((options.cacheStats && options.cacheDirectory.empty())
+      || (options.pchStats && options.pchFile.empty() && options.precompileFile.empty())
+      || (options.astStats && options.astFile.empty()))
+  {
+    return false;
+  }
+
+  if (!options.astFile.empty())
+  {
+    return options.files.size() == 1 && options.precompileFile.empty() && options.pchFile.empty()
+        && !options.IsSingleSourceMode() && options.threadCount == 0 && !options.scaling
+        && options.serverSocket.empty() && options.connectSocket.empty()
+        && options.cacheDirectory.empty() && !IsProfiled(options) && !options.diagnosticsJson;
+  }
+
+  if (!options.precompileFile.empty())
+  {
+    return options.files.size() == 1 && options.pchFile.empty()
+        && !options.IsSingleSourceMode() && options.threadCount == 0 && !options.scaling
+        && options.serverSocket.empty() && options.connectSocket.empty()
+        && options.cacheDirectory.empty() && !IsProfiled(options) && !options.diagnosticsJson;
+  }
+
+  if (!options.pchFile.empty() && !options.IsSingleSourceMode())
+  {
+    return false;
+  }
+
+  if (!options.serverSocket.empty())
+  {
+    // only -j may come along, clients pass --cache themselves
+    return options.files.empty() && !options.shutdown && options.connectSocket.empty()
+        && !options.IsSingleSourceMode() && !options.peepholeStats && !options.pipeline
+        && !options.scaling && !options.jitStats && !options.tierStats
+        && options.cacheDirectory.empty() && options.pchFile.empty()
+        && options.astFile.empty() && !IsProfiled(options) && !options.diagnosticsJson;
+  }
+
+  if (options.shutdown)
+  {
+    return !options.connectSocket.empty() && options.files.empty()
+        && !options.IsSingleSourceMode();
+  }
+
+  bool multipleFiles = options.files.size() > 1 || options.scaling;
+  return !options.files.empty()
+      && (options.threadCount == 0 || options.assembly)
+      && (!multipleFiles || (options.assembly && !options.peepholeStats && !options.pchStats
+                             && !options.pipeline && options.connectSocket.empty()
+                             && !options.diagnosticsJson))
+      // profiles are one per process, server compiles for many clients
+      // at once
+      && (!IsProfiled(options) || (!multipleFiles && options.connectSocket.empty()));
+}
+
+//==============================================================================
+std::vector<char> ReadFile(const std::string& path)
+{
+  std::ifstream inputFile(path, std::ios::binary | std::ios::ate);
+  if (!inputFile)
+  {
+    throw std::runtime_error("can't open " + path);
+  }
+  std::ifstream::pos_type fileSize = inputFile.tellg();
+  inputFile.seekg(0, std::ios::beg);
+  std::vector<char> input(fileSize);
+  inputFile.read(input.data(), fileSize);
+  return input;
+}
+
+//==============================================================================
+std::string GetAssemblyPath(const std::string& path)
+{
+  size_t dot = path.find_last_of('.');
+  size_t separator = path.find_last_of("/\\");
+  if (dot == std::string::npos
+      || (separator != std::string::npos && dot < separator))
+  {
+    return path + ".asm";
+  }
+  return path.substr(0, dot) + ".asm";
+}
+
+//==============================================================================
+int WritePrecompiledDeclarations(const DriverOptions& options, std::ostream& err)
+{
+  using namespace std;
+
+  try
+  {
+    double seconds = PrecompiledDeclarations::Write(ReadFile(options.files[0]),
+                                                    options.precompileFile);
+    if (options.pchStats)
+    {
+      PrecompiledDeclarations declarations(options.precompileFile);
+      err << fixed << setprecision(3)
+          << "precompiled declarations: " << declarations.GetSymbolCount() << " symbols of "
+          << declarations.GetPrefixSize() << " bytes parsed in " << seconds * 1e3 << " ms" << endl;
+    }
+  }
+  catch (exception& e)
+  {
+    err << "ERROR: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+//==============================================================================
+int WriteAst(const DriverOptions& options, std::ostream& err)
+{
+  using namespace std;
+
+  try
+  {
+    vector<char> source = ReadFile(options.files[0]);
+    auto start = chrono::steady_clock::now();
+    double parseSeconds = AstFile::Write(source, options.astFile);
+    double writeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count()
+        - parseSeconds;
+    if (!options.astStats)
+    {
+      return EXIT_SUCCESS;
+    }
+
+    start = chrono::steady_clock::now();
+    AstFile ast(options.astFile);
+    size_t walked = 0;
+    for (size_t i = 0; i < ast.GetSymbolCount(); i++)
+    {
+      AstFile::Symbol symbol = ast.GetSymbol(i);
+      symbol.GetName();
+      if (symbol.HasBody())
+      {
+        walked += WalkAst(symbol.GetBody());
+      }
+      for (int j = 0; j < symbol.GetInitializerCount(); j++)
+      {
+        walked += WalkAst(symbol.GetInitializer(j));
+      }
+    }
+    double loadSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    auto row = [&](const char* phase, double seconds, size_t bytes, const char* of)
+    {
+      ostringstream text;
+      text << fixed << "  " << left << setw(6) << phase << right
+           << setw(10) << setprecision(3) << seconds * 1e3 << " ms"
+           << setw(10) << setprecision(1) << bytes / seconds / (1 << 20) << " MB/s of " << of;
+      err << text.str() << endl;
+    };
+    err << "AST: " << ast.GetNodeCount() << " nodes, " << ast.GetSymbolCount() << " symbols, "
+        << ast.GetSize() << "-byte file, " << source.size() << "-byte source" << endl;
+    row("parse", parseSeconds, source.size(), "source");
+    row("write", writeSeconds, ast.GetSize(), "file");
+    row("load", loadSeconds, ast.GetSize(), "file, mapped and walked");
+    if (walked != ast.GetNodeCount())
+    {
+      throw runtime_error("walked " + to_string(walked) + " nodes of AST file");
+    }
+  }
+  catch (exception& e)
+  {
+    err << "ERROR: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  return EXIT_SUCCESS;
+}
+
+//==============================================================================
+int CompileSource(const DriverOptions& options, const std::vector<char>& input,
+                  std::ostream& out, std::ostream& err)
+{
+  using namespace std;
+
+  if (options.timeReport)
+  {
+    TimeReport report;
+    DriverOptions untimed = options;
+    untimed.timeReport = false;
+    int status = CompileSource(untimed, input, out, err);
+    if (options.timeReportJson)
+    {
+      report.PrintJson(err);
+    }
+    else
+    {
+      report.PrintTable(err);
+    }
+    return status;
+  }
+
+  if (!options.traceFile.empty())
+  {
+    Trace trace;
+    DriverOptions untraced = options;
+    untraced.traceFile.clear();
+    int status = EXIT_SUCCESS;
+    {
+      Trace::Scope span("compile");
+      status = CompileSource(untraced, input, out, err);
+    }
+    try
+    {
+      trace.Write(options.traceFile);
+    }
+    catch (exception& e)
+    {
+      err << "ERROR: " << e.what() << endl;
+      return EXIT_FAILURE;
+    }
+    return status;
+  }
+
+  if (options.allocStats)
+  {
+    // allocations are put in phases of time report, so one runs unseen
+    // unless -ftime-report made it
+    unique_ptr<TimeReport> report;
+    if (!TimeReport::IsActive())
+    {
+      report.reset(new TimeReport);
+    }
+    AllocationTracker tracker;
+    DriverOptions untracked = options;
+    untracked.allocStats = false;
+    int status = CompileSource(untracked, input, out, err);
+    tracker.Print(err);
+    return status;
+  }
+
+  try
+  {
+    //        pretokenizer debug output
+    //        DebugPreTokenStream debugPreTokenStream;
+    //        PreTokenizer pretokenizer(input, debugPreTokenStream);
+
+    //        tokenizer output
+    //        DebugTokenOutputStream debugTokenOutputStream;
+    //        Tokenizer tokenizer(debugTokenOutputStream);
+    //        PreTokenizer pretokenizer(input, tokenizer);
+
+    if (options.assembly)
+    {
+      CodeGenerator codeGenerator(out, max(1u, options.threadCount));
+      Parse(options, input, codeGenerator, err);
+      if (options.peepholeStats)
+      {
+        codeGenerator.GetPeepholeOptimizer().PrintStatistics(err);
+      }
+      return EXIT_SUCCESS;
+    }
+
+    if (options.run)
+    {
+      auto start = chrono::steady_clock::now();
+      BytecodeGenerator bytecodeGenerator(false, out);
+      Parse(options, input, bytecodeGenerator, err);
+      auto parsed = chrono::steady_clock::now();
+      BytecodeJit jit(bytecodeGenerator.GetModule());
+      BytecodeInterpreter interpreter(bytecodeGenerator.GetModule(), out);
+      interpreter.SetJit(&jit);
+      auto compiled = chrono::steady_clock::now();
+      if (options.jitStats)
+      {
+        auto us = [](chrono::steady_clock::duration d)
+        {
+          return chrono::duration_cast<chrono::microseconds>(d).count();
+        };
+        err << "time to first instruction: " << us(compiled - start) << " us" << endl
+            << "  front end: " << us(parsed - start) << " us" << endl
+            << "  machine code: " << us(compiled - parsed) << " us, "
+            << jit.GetCompiledFunctionCount() << " functions, "
+            << jit.GetCodeSize() << " bytes" << endl;
+      }
+      int result = interpreter.Run("main");
+      if (options.tierStats)
+      {
+        interpreter.PrintStatistics(err);
+      }
+      return result;
+    }
+
+    if (options.bytecode || options.interpret || options.tiered)
+    {
+      BytecodeGenerator bytecodeGenerator(options.bytecode, out);
+      Parse(options, input, bytecodeGenerator, err);
+      if (options.interpret || options.tiered)
+      {
+        BytecodeInterpreter interpreter(bytecodeGenerator.GetModule(), out);
+        unique_ptr<BytecodeJit> jit;
+        if (options.tiered)
+        {
+          jit.reset(new BytecodeJit(bytecodeGenerator.GetModule(), false));
+          interpreter.SetJit(jit.get());
+        }
+        int result = interpreter.Run("main");
+        if (options.tierStats)
+        {
+          interpreter.PrintStatistics(err);
+        }
+        return result;
+      }
+      return EXIT_SUCCESS;
+    }
+
+    //        simlpe expression parser AST
+    SimpleExpressionParser simpleExpressionParser;
+    Tokenize(input, simpleExpressionParser, options.pipeline);
+  }
+  catch (exception& e)
+  {
+    if (options.diagnosticsJson)
+    {
+      PrintDiagnosticsJson(e, err);
+    }
+    else
+    {
+      err << "ERROR: " << e.what() << endl;
+    }
+    return EXIT_FAILURE;
+  }
+  catch (...)
+  {
+    err << "ERROR: unknown exception";
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+//==============================================================================
+int CompileCachedSource(const DriverOptions& options, const std::vector<char>& input,
+                        std::ostream& out, std::ostream& err)
+{
+  using namespace std;
+
+  if (options.cacheDirectory.empty() || !IsCacheable(options))
+  {
+    return CompileSource(options, input, out, err);
+  }
+
+  string key = CompileCache::GetKey(GetCacheOptions(options), input);
+  if (key.empty())
+  {
+    return CompileSource(options, input, out, err);
+  }
+
+  CompileCache cache(options.cacheDirectory, static_cast<uint64_t>(options.cacheSizeMb) << 20);
+  CompileCache::Entry entry;
+  if (!cache.Load(key, entry))
+  {
+    // errors are kept too, so failing compilation fails the same way again
+    ostringstream output;
+    ostringstream errors;
+    entry.status = CompileSource(options, input, output, errors);
+    entry.output = output.str();
+    entry.errors = errors.str();
+    cache.Store(key, entry);
+  }
+
+  out << entry.output;
+  err << entry.errors;
+  if (options.cacheStats)
+  {
+    cache.PrintStatistics(err);
+  }
+  return entry.status;
+}
+
+//==============================================================================
+bool CompileFiles(const DriverOptions& options, unsigned threadCount,
+                  bool write, std::ostream& err)
+{
+  using namespace std;
+
+  const vector<string>& files = options.files;
+  DriverOptions fileOptions = options;
+  // files are the unit of parallelism, statistics are printed once for all
+  fileOptions.threadCount = 0;
+  fileOptions.cacheStats = false;
+  vector<string> errors(files.size());
+  ThreadPool pool(threadCount);
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    pool.Submit([&files, &fileOptions, &errors, write, i]()
+    {
+      try
+      {
+        ostringstream assembly;
+        ostringstream error;
+        if (CompileCachedSource(fileOptions, ReadFile(files[i]), assembly, error) != EXIT_SUCCESS)
+        {
+          errors[i] = error.str();
+          return;
+        }
+        if (write)
+        {
+          ofstream output(GetAssemblyPath(files[i]), ios::binary);
+          output << assembly.str();
+          if (!output)
+          {
+            throw runtime_error("can't write " + GetAssemblyPath(files[i]));
+          }
+        }
+      }
+      catch (exception& e)
+      {
+        errors[i] = string("ERROR: ") + e.what() + "\n";
+      }
+      catch (...)
+      {
+        errors[i] = "ERROR: unknown exception\n";
+      }
+    });
+  }
+  pool.Wait();
+
+  bool succeeded = true;
+  for (size_t i = 0; i < files.size(); i++)
+  {
+    if (!errors[i].empty())
+    {
+      err << files[i] << ": " << errors[i] << flush;
+      succeeded = false;
+    }
+  }
+  return succeeded;
+}
+
+//==============================================================================
+void PrintScaling(const DriverOptions& options, unsigned maxThreadCount,
+                  std::ostream& err)
+{
+  using namespace std;
+
+  DriverOptions uncached = options;
+  uncached.cacheDirectory.clear();
+  uncached.cacheStats = false;
+
+  vector<unsigned> threadCounts;
+  for (unsigned count = 1; count < maxThreadCount; count *= 2)
+  {
+    threadCounts.push_back(count);
+  }
+  threadCounts.push_back(maxThreadCount);
+
+  err << "threads      time   files/s  speedup" << endl;
+  double baseline = 0.0;
+  for (unsigned count : threadCounts)
+  {
+    auto start = chrono::steady_clock::now();
+    CompileFiles(uncached, count, false, err);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (count == 1)
+    {
+      baseline = seconds;
+    }
+
+    ostringstream row;
+    row << fixed << setw(7) << count
+        << setw(9) << setprecision(3) << seconds << " s"
+        << setw(10) << setprecision(1) << options.files.size() / seconds
+        << setw(8) << setprecision(2) << baseline / seconds << "x";
+    err << row.str() << endl;
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include "ITokenStream.hpp"
+
+namespace Compiler
+{
+// command line of compiler, also what compile server gets from client
+struct DriverOptions
+{
+  bool assembly{false};
+  bool peepholeStats{false};
+  bool bytecode{false};
+  bool interpret{false};
+  bool run{false};
+  bool jitStats{false};
+  bool tiered{false};
+  bool tierStats{false};
+  bool scaling{false};
+  bool pipeline{false};
+  // 0 if not given
+  unsigned threadCount{0};
+  // --server, --connect and --shutdown
+  std::string serverSocket;
+  std::string connectSocket;
+  bool shutdown{false};
+  // --cache, -S and --bytecode listings only
+  std::string cacheDirectory;
+  unsigned cacheSizeMb{256};
+  bool cacheStats{false};
+  // --precompile PCH FILE writes declarations of FILE to PCH,
+  // --pch PCH restores them for sources which start with FILE's text
+  std::string precompileFile;
+  std::string pchFile;
+  bool pchStats{false};
+  // --ast AST FILE writes syntax tree and symbols of FILE to AST
+  std::string astFile;
+  bool astStats{false};
+  // -ftime-report prints time of each phase and counters to stderr,
+  // -ftime-report=json prints them as JSON, single file only
+  bool timeReport{false};
+  bool timeReportJson{false};
+  // --trace FILE writes timeline of phases and functions to FILE,
+  // single file only
+  std::string traceFile;
+  // --alloc-stats prints operator new calls, bytes and peak live bytes
+  // per phase and top allocation sites to stderr, single file only
+  bool allocStats{false};
+  // -fdiagnostics-format=json parses on past errors and prints all of them
+  // to stderr as JSON, single file only
+  bool diagnosticsJson{false};
+  std::vector<std::string> files;
+
+  // true for modes CompileSource can run, simple expression parser
+  // prints to standard output only and is not one of them
+  bool IsSingleSourceMode() const;
+};
+
+// arguments without program name, false on unknown option or
+// options which don't go together
+bool ParseDriverOptions(const std::vector<std::string>& arguments, DriverOptions& options);
+
+std::vector<char> ReadFile(const std::string& path);
+// FILE.c -> FILE.asm
+std::string GetAssemblyPath(const std::string& path);
+
+// parses declarations of the only file of `options` and writes them to
+// options' precompile file, returns exit status
+int WritePrecompiledDeclarations(const DriverOptions& options, std::ostream& err);
+
+// writes syntax tree of the only file of `options` to options' AST file,
+// with --ast-stats times parse, write and walk of the file mapped back,
+// returns exit status
+int WriteAst(const DriverOptions& options, std::ostream& err);
+
+// compiles one translation unit as `options` say, program output and
+// listings go to `out`, statistics and errors to `err`, returns exit status
+// everything compilation touches is owned by it,
+// so translation units may be compiled concurrently
+int CompileSource(const DriverOptions& options, const std::vector<char>& input,
+                  std::ostream& out, std::ostream& err);
+
+// CompileSource, but -S and --bytecode listings, errors and exit status
+// are replayed from options' cache directory when it has them
+int CompileCachedSource(const DriverOptions& options, const std::vector<char>& input,
+                        std::ostream& out, std::ostream& err);
+
+// compiles every file of `options` to assembly on its own pool task, errors
+// are reported per file in command line order, true if all files are compiled
+// assembly is discarded unless `write` is set
+bool CompileFiles(const DriverOptions& options, unsigned threadCount,
+                  bool write, std::ostream& err);
+
+// compiles all files on 1, 2, 4, ... up to `maxThreadCount` threads,
+// cache is not used
+void PrintScaling(const DriverOptions& options, unsigned maxThreadCount,
+                  std::ostream& err);
+
+} // namespace Compiler
@@ -0,0 +1,641 @@
+#include "IncrementalParser.hpp"
+
+#include <iostream>
+#include <algorithm>
+#include <iterator>
+#include <unordered_map>
+#include <chrono>
+#include <stdexcept>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Parser.hpp"
+#include "constants.hpp"
+#include "unicode.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const size_t npos = static_cast<size_t>(-1);
+  // literals end at newline, so a comment is the only thing reaching past it
+  const std::string unterminatedComment = "unterminated inline comment";
+
+  // both move tokens away from columns text suggests
+  bool HasTrigraphsOrSplices(const std::vector<char>& text)
+  {
+    for (size_t i = 0; i + 1 < text.size(); i++)
+    {
+      if ((text[i] == '?' && text[i + 1] == '?')
+          || (text[i] == '\\' && text[i + 1] == '\n'))
+      {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<size_t> GetLineStarts(const std::vector<char>& text)
+  {
+    std::vector<size_t> lineStarts(1, 0);
+    for (size_t i = 0; i < text.size(); i++)
+    {
+      if (text[i] == '\n')
+      {
+        lineStarts.push_back(i + 1);
+      }
+    }
+    return lineStarts;
+  }
+
+  // pretokenizer decodes whole text before it makes any token, its errors
+  // are thrown, false if decoding from `begin` doesn't stop at `end`
+  bool IsDecodedTo(const std::vector<char>& text, size_t begin, size_t end)
+  {
+    // decoded character is 4 bytes at most
+    size_t last = std::min(end + 3, text.size());
+    std::vector<int> codes;
+    for (size_t i = begin; i < last; i++)
+    {
+      codes.push_back(static_cast<unsigned char>(text[i]));
+    }
+    codes.push_back(EndOfFile);
+
+    size_t i = 0;
+    int codePoint = 0;
+    while (begin + i < end)
+    {
+      i += UTF8Decode(&codes[i], codePoint);
+    }
+    return begin + i == end;
+  }
+
+  // `b` is `a` moved by `lineShift` lines
+  bool IsSameToken(const PipelinedToken& a, const PipelinedToken& b, int lineShift)
+  {
+    return a.kind == b.kind
+        && a.type == b.type
+        && a.fundamentalType == b.fundamentalType
+        && a.line + lineShift == b.line
+        && a.column == b.column
+        && a.elementCount == b.elementCount
+        && a.source == b.source
+        && a.data == b.data;
+  }
+
+  // tokens of text[begin, end) which starts at `line` and `column`, false
+  // if tokenizer fails, tokens it has made before are kept
+  bool TokenizeRange(const std::vector<char>& text, size_t begin, size_t end, int line, int column,
+                     std::vector<PipelinedToken>& tokens, std::string& error)
+  {
+    // padded so columns of first line are right
+    std::vector<char> segment(column - 1, ' ');
+    segment.insert(segment.end(), text.begin() + begin, text.begin() + end);
+    TokenRecorder recorder;
+    bool succeeded = true;
+    error.clear();
+    try
+    {
+      Tokenizer tokenizer(recorder);
+      PreTokenizer pretokenizer(segment, tokenizer);
+    }
+    catch (std::exception& e)
+    {
+      error = e.what();
+      succeeded = false;
+    }
+    tokens = std::move(recorder.GetTokens());
+    for (auto& token : tokens)
+    {
+      token.line += line - 1;
+    }
+    return succeeded;
+  }
+
+  // everything parse of later declarations may depend on
+  std::string GetSignature(const shared_ptr<Symbol>& symbol)
+  {
+    std::string signature = symbol->GetQualifiedName();
+    if (symbol->GetType() == ESymbolType::TYPE_STRUCT)
+    {
+      shared_ptr<SymbolStruct> symStruct = static_pointer_cast<SymbolStruct>(symbol);
+      signature += symStruct->complete ? " {" : " ;";
+      if (symStruct->GetSymbolTable() != NULL)
+      {
+        for (auto& field : symStruct->GetSymbolTable()->orderedVariables)
+        {
+          signature += field->GetQualifiedName() + ";";
+        }
+      }
+    }
+    return signature;
+  }
+
+} // namespace
+
+//==============================================================================
+// records declarations as Parser finds them, starts with global symbols
+// of those already known
+class IncrementalParser::DeclarationParser : public Parser
+{
+public:
+  // symbols of first `restoredCount` of `restored` are restored,
+  // declarations parsed from `firstToken` on go to `parsed`
+  DeclarationParser(const std::vector<Declaration>& restored, size_t restoredCount,
+                    std::vector<Declaration>& parsed, size_t firstToken)
+    : Parser(std::cout)
+    , parsed_(parsed)
+    , firstIndex_(restoredCount)
+    , baseToken_(firstToken)
+  {
+    for (size_t i = 0; i < restoredCount; i++)
+    {
+      for (auto& global : restored[i].symbols)
+      {
+        AddGlobalSymbol(*GetGlobalSymbolTable(), global.name, global.symbol);
+        creators_[global.symbol.get()] = i;
+      }
+    }
+    if (restoredCount > 0)
+    {
+      anonymousGenerator_ = restored[restoredCount - 1].anonymousCount;
+    }
+    StartDeclaration_(firstToken);
+  }
+
+  // for declaration which would be parsed to the same symbols again
+  void RestoreSymbols(const Declaration& declaration)
+  {
+    for (auto& global : declaration.symbols)
+    {
+      AddGlobalSymbol(*GetGlobalSymbolTable(), global.name, global.symbol);
+    }
+  }
+
+  // first token of declaration being parsed
+  size_t GetNextToken() const
+  {
+    return current_.firstToken;
+  }
+
+  // declarations from this one on are changed by declaration being parsed
+  size_t GetPendingDefines() const
+  {
+    return current_.defines;
+  }
+
+  // prints at Print only
+  virtual void Flush() const
+  {
+
+  }
+
+  void Print() const
+  {
+    Parser::Flush();
+  }
+
+protected:
+  virtual void OnExternalDeclarationParsed_()
+  {
+    current_.anonymousCount = anonymousGenerator_;
+    parsed_.push_back(std::move(current_));
+    // consumed token count is relative to first token fed
+    StartDeclaration_(baseToken_ + GetConsumedTokenCount_());
+  }
+
+  virtual void OnGlobalSymbolAdded_(shared_ptr<Symbol> symbol, const std::string& name)
+  {
+    current_.symbols.push_back({name, symbol});
+    creators_[symbol.get()] = firstIndex_ + parsed_.size();
+  }
+
+  virtual void OnSymbolDefinition_(shared_ptr<Symbol> symbol)
+  {
+    auto creator = creators_.find(symbol.get());
+    if (creator != creators_.end())
+    {
+      current_.defines = std::min(current_.defines, creator->second);
+    }
+  }
+
+private:
+  std::vector<Declaration>& parsed_;
+  size_t firstIndex_{0};
+  size_t baseToken_{0};
+  std::unordered_map<const Symbol*, size_t> creators_;
+  Declaration current_;
+
+  void StartDeclaration_(size_t firstToken)
+  {
+    current_ = Declaration();
+    current_.firstToken = firstToken;
+    current_.defines = firstIndex_ + parsed_.size();
+  }
+};
+
+//==============================================================================
+void IncrementalParser::Parse(const std::vector<char>& input)
+{
+  using namespace std;
+
+  auto start = chrono::steady_clock::now();
+  statistics_ = Statistics();
+
+  Splice splice;
+  statistics_.incremental = Splice_(input, splice);
+
+  // symbols of restored declarations must be as they were made,
+  // not defined by declarations parsed again
+  size_t first = splice.declaration;
+  for (size_t i = declarations_.size(); i > first; i--)
+  {
+    first = min(first, declarations_[i - 1].defines);
+  }
+  size_t firstToken = first < declarations_.size() ? declarations_[first].firstToken : 0;
+
+  // new tokens are old ones with replaced range spliced
+  ptrdiff_t tokenShift = static_cast<ptrdiff_t>(splice.token + splice.tokens.size())
+      - static_cast<ptrdiff_t>(splice.endToken);
+  size_t tokenCount = tokens_.size() + tokenShift;
+  size_t endToken = splice.token + splice.tokens.size();
+
+  // old declarations from i on define nothing before i if `minDefines[i] >= i`
+  bool resyncable = statistics_.incremental && complete_ && splice.endDeclaration != npos;
+  vector<size_t> minDefines(declarations_.size() + 1, npos);
+  for (size_t i = declarations_.size(); resyncable && i > 0; i--)
+  {
+    minDefines[i - 1] = min(minDefines[i], declarations_[i - 1].defines);
+  }
+
+  vector<Declaration> parsed;
+
+  // same global symbols in the same order, so rest parses the same
+  auto isResynced = [&](size_t oldDeclaration)
+  {
+    if (minDefines[oldDeclaration] < oldDeclaration
+        || declarations_[oldDeclaration - 1].anonymousCount != parsed.back().anonymousCount)
+    {
+      return false;
+    }
+
+    vector<const GlobalSymbol*> oldSymbols;
+    vector<const GlobalSymbol*> newSymbols;
+    for (size_t i = first; i < oldDeclaration; i++)
+    {
+      for (auto& global : declarations_[i].symbols)
+      {
+        oldSymbols.push_back(&global);
+      }
+    }
+    for (auto& declaration : parsed)
+    {
+      for (auto& global : declaration.symbols)
+      {
+        newSymbols.push_back(&global);
+      }
+    }
+    if (oldSymbols.size() != newSymbols.size())
+    {
+      return false;
+    }
+    for (size_t i = 0; i < oldSymbols.size(); i++)
+    {
+      if (oldSymbols[i]->name != newSymbols[i]->name
+          || GetSignature(oldSymbols[i]->symbol) != GetSignature(newSymbols[i]->symbol))
+      {
+        return false;
+      }
+    }
+    return true;
+  };
+
+  DeclarationParser parser(declarations_, first, parsed, firstToken);
+  size_t resyncedAt = npos;
+  try
+  {
+    for (size_t i = firstToken; i < tokenCount && resyncedAt == npos; i++)
+    {
+      if (i < splice.token)
+      {
+        ReplayToken(tokens_[i], parser);
+      }
+      else if (i < endToken)
+      {
+        ReplayToken(splice.tokens[i - splice.token], parser);
+      }
+      else
+      {
+        PipelinedToken token = tokens_[i - tokenShift];
+        token.line += splice.lineShift;
+        ReplayToken(token, parser);
+      }
+
+      // checked with no lookahead taken, so nothing of next declaration is parsed
+      if (!resyncable
+          || parsed.empty()
+          || i + 1 < endToken
+          || parser.GetNextToken() != i + 1)
+      {
+        continue;
+      }
+
+      size_t oldToken = i + 1 - tokenShift;
+      auto oldDeclaration = lower_bound(declarations_.begin() + splice.endDeclaration,
+                                        declarations_.end(), oldToken,
+                                        [](const Declaration& declaration, size_t token)
+      {
+        return declaration.firstToken < token;
+      });
+      if (oldDeclaration != declarations_.end()
+          && oldDeclaration->firstToken == oldToken
+          && isResynced(oldDeclaration - declarations_.begin()))
+      {
+        resyncedAt = oldDeclaration - declarations_.begin();
+      }
+    }
+    if (!splice.error.empty())
+    {
+      throw logic_error(splice.error);
+    }
+  }
+  catch (exception& e)
+  {
+    size_t pendingDefines = parser.GetPendingDefines();
+    if (pendingDefines < first)
+    {
+      // restored struct or function was being defined, its symbol is changed
+      declarations_.resize(pendingDefines);
+      complete_ = false;
+    }
+    else if (!statistics_.incremental && splice.error.empty())
+    {
+      // nothing to reuse yet, declarations before the error are better than none
+      parsed.resize(min(parsed.size(), pendingDefines));
+      Commit_(input, splice, 0, declarations_.size(), parsed);
+      complete_ = false;
+    }
+    statistics_.parsedDeclarations = parsed.size();
+    statistics_.reusedDeclarations = min(first, pendingDefines);
+    statistics_.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    parser.Print();
+    cerr << "ERROR: " << e.what() << endl;
+    return;
+  }
+
+  size_t end = resyncedAt != npos ? resyncedAt : declarations_.size();
+  for (size_t i = end; i < declarations_.size(); i++)
+  {
+    parser.RestoreSymbols(declarations_[i]);
+  }
+  statistics_.parsedDeclarations = parsed.size();
+  statistics_.reusedDeclarations = first + declarations_.size() - end;
+  Commit_(input, splice, first, end, parsed);
+  statistics_.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  parser.Print();
+}
+
+//==============================================================================
+void IncrementalParser::Reset()
+{
+  text_.clear();
+  lineStarts_.clear();
+  tokens_.clear();
+  declarations_.clear();
+  complete_ = false;
+}
+
+//==============================================================================
+const IncrementalParser::Statistics& IncrementalParser::GetStatistics() const
+{
+  return statistics_;
+}
+
+//==============================================================================
+bool IncrementalParser::Splice_(const std::vector<char>& input, Splice& splice)
+{
+  using namespace std;
+
+  splice.endDeclaration = npos;
+  splice.endToken = tokens_.size();
+  auto tokenizeAll = [&]()
+  {
+    TokenizeRange(input, 0, input.size(), 1, 1, splice.tokens, splice.error);
+    statistics_.tokenizedBytes = input.size();
+    return false;
+  };
+  if (tokens_.empty()
+      || HasTrigraphsOrSplices(text_)
+      || HasTrigraphsOrSplices(input))
+  {
+    return tokenizeAll();
+  }
+
+  size_t common = min(text_.size(), input.size());
+  size_t prefix = mismatch(text_.begin(), text_.begin() + common, input.begin()).first - text_.begin();
+  size_t suffix = mismatch(text_.rbegin(), text_.rbegin() + (common - prefix), input.rbegin()).first
+      - text_.rbegin();
+  size_t oldEnd = text_.size() - suffix;
+
+  // from last declaration starting before the edit, or from the very start
+  size_t restart = 0;
+  size_t restartOffset = 0;
+  bool firstOnLine = false;
+  for (size_t i = 0; i < declarations_.size(); i++)
+  {
+    size_t offset = GetOffset_(tokens_[declarations_[i].firstToken], firstOnLine);
+    if (offset == npos)
+    {
+      continue;
+    }
+    if (offset > prefix)
+    {
+      break;
+    }
+    restart = i;
+    restartOffset = offset;
+  }
+  size_t restartToken = 0;
+  int line = 1;
+  int column = 1;
+  if (restartOffset > 0)
+  {
+    restartToken = declarations_[restart].firstToken;
+    line = tokens_[restartToken].line;
+    column = tokens_[restartToken].column;
+  }
+
+  // up to first line starting a declaration whose preceding newline is
+  // unchanged, after it tokens are the same as before but for their line,
+  // as it's neither in comment nor in literal
+  size_t end = npos;
+  size_t endOffset = text_.size();
+  size_t endToken = tokens_.size();
+  for (size_t i = restart + 1; i < declarations_.size(); i++)
+  {
+    size_t offset = GetOffset_(tokens_[declarations_[i].firstToken], firstOnLine);
+    if (offset == npos || !firstOnLine)
+    {
+      continue;
+    }
+    size_t lineStart = lineStarts_[tokens_[declarations_[i].firstToken].line - 1];
+    if (lineStart > oldEnd && lineStart > restartOffset)
+    {
+      end = i;
+      endOffset = lineStart;
+      endToken = declarations_[i].firstToken;
+      break;
+    }
+  }
+  size_t newEndOffset = endOffset + input.size() - text_.size();
+
+  // text before and after the range decodes as it did, if range ends
+  // where its last character does
+  try
+  {
+    if (!IsDecodedTo(input, restartOffset, newEndOffset))
+    {
+      return tokenizeAll();
+    }
+  }
+  catch (exception& e)
+  {
+    // no token is made
+    splice.error = e.what();
+    return true;
+  }
+
+  // range ends with newline, comment left open in it may be closed after it
+  if (!TokenizeRange(input, restartOffset, newEndOffset, line, column, splice.tokens, splice.error)
+      && end != npos
+      && splice.error == unterminatedComment)
+  {
+    end = npos;
+    endToken = tokens_.size();
+    newEndOffset = input.size();
+    TokenizeRange(input, restartOffset, newEndOffset, line, column, splice.tokens, splice.error);
+  }
+  if (!splice.error.empty())
+  {
+    // the same error stops tokenizing whole input, nothing after it is parsed
+    end = npos;
+    endToken = tokens_.size();
+  }
+  else if (end == npos)
+  {
+    // tokens which are the same as old ones up to the end are kept, from
+    // the first declaration among them
+    int lineShift = static_cast<int>(count(input.begin() + restartOffset, input.end(), '\n'))
+        - static_cast<int>(lineStarts_.size() - line);
+    size_t oldToken = tokens_.size();
+    size_t newToken = splice.tokens.size();
+    while (oldToken > restartToken
+           && newToken > 0
+           && IsSameToken(tokens_[oldToken - 1], splice.tokens[newToken - 1], lineShift))
+    {
+      oldToken--;
+      newToken--;
+    }
+    for (size_t i = restart + 1; i < declarations_.size(); i++)
+    {
+      if (declarations_[i].firstToken >= oldToken)
+      {
+        end = i;
+        endToken = declarations_[i].firstToken;
+        splice.tokens.resize(newToken + endToken - oldToken);
+        splice.lineShift = lineShift;
+        break;
+      }
+    }
+  }
+  else
+  {
+    if (!splice.tokens.empty() && splice.tokens.back().kind == PipelinedToken::END_OF_FILE)
+    {
+      splice.tokens.pop_back();
+    }
+    int newLine = line + count(input.begin() + restartOffset, input.begin() + newEndOffset, '\n');
+    splice.lineShift = newLine - tokens_[endToken].line;
+  }
+
+  splice.declaration = restart;
+  splice.endDeclaration = end;
+  splice.token = restartToken;
+  splice.endToken = endToken;
+  statistics_.tokenizedBytes = newEndOffset - restartOffset;
+  return true;
+}
+
+//==============================================================================
+void IncrementalParser::Commit_(const std::vector<char>& input, Splice& splice, size_t first,
+                                size_t end, std::vector<Declaration>& parsed)
+{
+  using namespace std;
+
+  ptrdiff_t tokenShift = static_cast<ptrdiff_t>(splice.token + splice.tokens.size())
+      - static_cast<ptrdiff_t>(splice.endToken);
+  for (size_t i = splice.endToken; splice.lineShift != 0 && i < tokens_.size(); i++)
+  {
+    tokens_[i].line += splice.lineShift;
+  }
+  if (tokenShift == 0)
+  {
+    // the usual edit of a name or number, later tokens stay where they are
+    move(splice.tokens.begin(), splice.tokens.end(), tokens_.begin() + splice.token);
+  }
+  else
+  {
+    tokens_.erase(tokens_.begin() + splice.token, tokens_.begin() + splice.endToken);
+    tokens_.insert(tokens_.begin() + splice.token,
+                   make_move_iterator(splice.tokens.begin()), make_move_iterator(splice.tokens.end()));
+  }
+
+  ptrdiff_t declarationShift = static_cast<ptrdiff_t>(first + parsed.size())
+      - static_cast<ptrdiff_t>(end);
+  for (size_t i = end; i < declarations_.size(); i++)
+  {
+    declarations_[i].firstToken += tokenShift;
+    declarations_[i].defines += declarationShift;
+  }
+  declarations_.erase(declarations_.begin() + first, declarations_.begin() + end);
+  declarations_.insert(declarations_.begin() + first,
+                       make_move_iterator(parsed.begin()), make_move_iterator(parsed.end()));
+
+  text_ = input;
+  lineStarts_ = GetLineStarts(text_);
+  complete_ = true;
+}
+
+//==============================================================================
+size_t IncrementalParser::GetOffset_(const PipelinedToken& token, bool& firstOnLine) const
+{
+  if (token.line < 1 || static_cast<size_t>(token.line) > lineStarts_.size())
+  {
+    return npos;
+  }
+
+  size_t lineStart = lineStarts_[token.line - 1];
+  size_t offset = lineStart + token.column - 1;
+  if (offset > text_.size())
+  {
+    return npos;
+  }
+
+  firstOnLine = true;
+  for (size_t i = lineStart; i < offset; i++)
+  {
+    unsigned char c = text_[i];
+    if (c >= 0x80 || c == '\n')
+    {
+      return npos;
+    }
+    if (c != ' ' && c != '\t' && c != '\r' && c != '\f' && c != '\v')
+    {
+      firstOnLine = false;
+    }
+  }
+  return offset;
+}
+
+} // namespace Compiler
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "TokenPipeline.hpp"
+#include "SymbolTable.hpp"
+
+namespace Compiler
+{
+// parses text being edited, every Parse prints what Parser prints for whole
+// text, but the last text parsed without error is reused where edit doesn't
+// reach: text is tokenized again from external declaration edit is in up to
+// the first unchanged line starting a declaration, global symbols of earlier
+// declarations are restored rather than parsed, and parse stops at first
+// declaration after the edit where global scope is the same as it was
+// before, later declarations keep their symbols
+class IncrementalParser
+{
+public:
+  struct Statistics
+  {
+    // tokenizing and parsing, printing excluded
+    double seconds{0.0};
+    // false if text was tokenized and parsed from scratch
+    bool incremental{false};
+    size_t tokenizedBytes{0};
+    size_t parsedDeclarations{0};
+    size_t reusedDeclarations{0};
+  };
+
+  // output and error go to standard output and error, as Parser's do
+  void Parse(const std::vector<char>& input);
+  // next Parse starts from scratch
+  void Reset();
+  const Statistics& GetStatistics() const;
+
+private:
+  class DeclarationParser;
+
+  struct Declaration
+  {
+    size_t firstToken{0};
+    // in order they are added to global scope
+    std::vector<GlobalSymbol> symbols;
+    // earliest declaration whose struct or function this one defines,
+    // own index if none
+    size_t defines{0};
+    // anonymous names generated up to its end
+    int anonymousCount{0};
+  };
+
+  // tokens of text from `declaration` up to `endDeclaration` are replaced
+  struct Splice
+  {
+    size_t declaration{0};
+    // npos if text is tokenized to the end
+    size_t endDeclaration{0};
+    // replaced tokens are [token, endToken)
+    size_t token{0};
+    size_t endToken{0};
+    std::vector<PipelinedToken> tokens;
+    // tokenizer error after `tokens`, empty if none
+    std::string error;
+    // of tokens after replaced ones
+    int lineShift{0};
+  };
+
+  // what the last text parsed without error is made of, so an edit which
+  // leaves text broken for a while isn't parsed from scratch every time
+  std::vector<char> text_;
+  std::vector<size_t> lineStarts_;
+  std::vector<PipelinedToken> tokens_;
+  std::vector<Declaration> declarations_;
+  // declarations_ go up to end of file
+  bool complete_{false};
+  Statistics statistics_;
+
+  // false if text_ can't be reused and whole input is tokenized
+  bool Splice_(const std::vector<char>& input, Splice& splice);
+  // text_ becomes `input`, [first, end) declarations become `parsed`
+  void Commit_(const std::vector<char>& input, Splice& splice, size_t first, size_t end,
+               std::vector<Declaration>& parsed);
+  // npos if token is not on pure ASCII line, where columns are bytes
+  size_t GetOffset_(const PipelinedToken& token, bool& firstOnLine) const;
+};
+
+} // namespace Compiler
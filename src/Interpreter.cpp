@@ -0,0 +1,452 @@
+#include "Interpreter.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <stdexcept>
+#include <new>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cassert>
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  int Load32(const unsigned char* memory, unsigned address)
+  {
+    int value;
+    memcpy(&value, memory + address, 4);
+    return value;
+  }
+
+  void Store32(unsigned char* memory, unsigned address, int value)
+  {
+    memcpy(memory + address, &value, 4);
+  }
+
+  // arithmetic wraps around as on target machine
+  int Wrap(unsigned value)
+  {
+    return static_cast<int>(value);
+  }
+
+  void CheckDivision(int dividend, int divisor)
+  {
+    if (divisor == 0)
+    {
+      throw std::runtime_error("division by zero");
+    }
+    if (dividend == INT_MIN && divisor == -1)
+    {
+      throw std::runtime_error("integer overflow in division");
+    }
+  }
+
+} // namespace
+
+//==============================================================================
+BytecodeInterpreter::BytecodeInterpreter(const BytecodeModule& module, std::ostream& out,
+                                         int stackSize, int registerCount)
+  : module_(module)
+  , out_(out)
+  , stackSize_(stackSize)
+  , registers_(NULL)
+  , registerCount_(registerCount)
+{
+  registers_ = static_cast<int*>(calloc(registerCount_, sizeof(int)));
+  if (registers_ == NULL)
+  {
+    throw std::bad_alloc();
+  }
+}
+
+//==============================================================================
+BytecodeInterpreter::~BytecodeInterpreter()
+{
+  free(registers_);
+}
+
+//==============================================================================
+void BytecodeInterpreter::SetJit(BytecodeJit* jit, int invocationThreshold, int backEdgeThreshold)
+{
+  jit_ = jit;
+  invocationThreshold_ = invocationThreshold;
+  backEdgeThreshold_ = backEdgeThreshold;
+}
+
+//==============================================================================
+int BytecodeInterpreter::Run(const std::string& name)
+{
+  auto it = module_.functionIndices.find(name);
+  if (it == module_.functionIndices.end())
+  {
+    throw std::runtime_error("function " + name + " is not defined");
+  }
+  GetFunction_(it->second);
+
+  memory_.assign(module_.data.begin(), module_.data.end());
+  memory_.resize(module_.data.size() + stackSize_, 0);
+  frames_.clear();
+  counters_.assign(module_.functions.size(), Counters{0, 0});
+  transitions_.clear();
+
+  context_.memory = memory_.data();
+  context_.entries = jit_ != NULL ? jit_->GetEntries() : NULL;
+  context_.registersEnd = registers_ + registerCount_;
+  context_.stackLimit = NULL;
+  context_.dataSize = module_.data.size();
+  context_.byteLimit = memory_.size() - 1;
+  context_.dwordLimit = memory_.size() - 4;
+  context_.error = 0;
+  context_.interpreter = this;
+  context_.jit = jit_;
+
+  return Call_(it->second, registers_, memory_.size());
+}
+
+//==============================================================================
+bool BytecodeInterpreter::OnCall_(int function)
+{
+  Counters& counters = counters_[function];
+  counters.invocations++;
+  if (jit_ == NULL)
+  {
+    return false;
+  }
+  if (jit_->IsCompiled(function))
+  {
+    return true;
+  }
+  if (counters.invocations < invocationThreshold_)
+  {
+    return false;
+  }
+
+  jit_->Compile(function);
+  transitions_.push_back({function, -1, counters.invocations});
+  return true;
+}
+
+//==============================================================================
+bool BytecodeInterpreter::OnBackEdge_(int function, int target)
+{
+  Counters& counters = counters_[function];
+  counters.backEdges++;
+  if (jit_ == NULL)
+  {
+    return false;
+  }
+
+  // only `for` and `while` loops have entries in native code
+  const std::vector<int>& headers = module_.functions[function].loopHeaders;
+  if (!std::binary_search(headers.begin(), headers.end(), target))
+  {
+    return false;
+  }
+  if (!jit_->IsCompiled(function))
+  {
+    if (counters.backEdges < backEdgeThreshold_)
+    {
+      return false;
+    }
+    jit_->Compile(function);
+  }
+
+  transitions_.push_back({function, target, counters.backEdges});
+  return true;
+}
+
+//==============================================================================
+int BytecodeInterpreter::Call_(int function, int* registers, int framePointer)
+{
+  if (OnCall_(function))
+  {
+    return jit_->Call(context_, function, registers, framePointer);
+  }
+  return Interpret_(function, registers, framePointer);
+}
+
+//==============================================================================
+int BytecodeInterpreter::Interpret_(int function, int* registers, int framePointer)
+{
+  // native code may call back into interpreter, frames below are not ours
+  const size_t baseFrame = frames_.size();
+  const BytecodeFunction* callee = GetFunction_(function);
+
+  const int dataSize = module_.data.size();
+  unsigned char* memory = memory_.data();
+  int* r = registers;
+  int* const registersEnd = registers_ + registerCount_;
+  int fp = framePointer - callee->frameSize;
+  const BytecodeInstruction* code = callee->code.data();
+  const BytecodeInstruction* pc = code;
+
+  if (registersEnd - r < callee->registerCount
+      || fp < dataSize)
+  {
+    throw std::runtime_error("stack overflow");
+  }
+
+  int value = 0;
+  int calleeIndex = 0;
+
+#if defined(__GNUC__)
+  // computed goto, one indirect jump per instruction, in EOpcode order
+  static void* const dispatchTable[] =
+  {
+    &&L_MOV, &&L_MOVI, &&L_ADD, &&L_SUB, &&L_MUL, &&L_DIV, &&L_MOD,
+    &&L_AND, &&L_OR, &&L_XOR, &&L_SHL, &&L_SAR,
+    &&L_ADDI, &&L_MULI, &&L_ANDI, &&L_SHLI, &&L_SARI,
+    &&L_NEG, &&L_NOT, &&L_LNOT, &&L_SEXT8,
+    &&L_EQ, &&L_NE, &&L_LT, &&L_LE, &&L_GT, &&L_GE,
+    &&L_JMP, &&L_JZ, &&L_JNZ,
+    &&L_JEQ, &&L_JNE, &&L_JLT, &&L_JLE, &&L_JGT, &&L_JGE,
+    &&L_JEQI, &&L_JNEI, &&L_JLTI, &&L_JLEI, &&L_JGTI, &&L_JGEI,
+    &&L_LEAL, &&L_LOAD8, &&L_LOAD32, &&L_STORE8, &&L_STORE32,
+    &&L_LOADL8, &&L_LOADL32, &&L_STOREL8, &&L_STOREL32,
+    &&L_LOADG8, &&L_LOADG32, &&L_STOREG8, &&L_STOREG32,
+    &&L_CALL, &&L_CALLR, &&L_TCALL, &&L_RET, &&L_RETV, &&L_PRINT,
+  };
+  static_assert(sizeof(dispatchTable) / sizeof(dispatchTable[0]) == static_cast<size_t>(EOpcode::COUNT),
+                "dispatch table does not match opcodes");
+
+#define DISPATCH() goto *dispatchTable[static_cast<int>(pc->opcode)]
+#define OPCODE(name) L_##name:
+  DISPATCH();
+#else
+#define DISPATCH() continue
+#define OPCODE(name) case EOpcode::name:
+  for (;;)
+  {
+    switch (pc->opcode)
+    {
+#endif
+
+#define NEXT() pc++; DISPATCH()
+// backward jumps are counted and may continue function in native code
+#define JUMP(target) \
+  if ((target) <= pc - code && OnBackEdge_(function, (target))) \
+  { \
+    value = jit_->Enter(context_, function, (target), r, fp); \
+    goto leave; \
+  } \
+  pc = code + (target); DISPATCH()
+#define BINARY(name, expression) OPCODE(name) r[pc->a] = (expression); NEXT();
+#define BRANCH(name, condition, target) OPCODE(name) if (condition) { JUMP(target); } NEXT();
+
+  OPCODE(MOV) r[pc->a] = r[pc->b]; NEXT();
+  OPCODE(MOVI) r[pc->a] = pc->b; NEXT();
+
+  BINARY(ADD, Wrap(static_cast<unsigned>(r[pc->b]) + static_cast<unsigned>(r[pc->c])))
+  BINARY(SUB, Wrap(static_cast<unsigned>(r[pc->b]) - static_cast<unsigned>(r[pc->c])))
+  BINARY(MUL, Wrap(static_cast<unsigned>(r[pc->b]) * static_cast<unsigned>(r[pc->c])))
+  OPCODE(DIV) CheckDivision(r[pc->b], r[pc->c]); r[pc->a] = r[pc->b] / r[pc->c]; NEXT();
+  OPCODE(MOD) CheckDivision(r[pc->b], r[pc->c]); r[pc->a] = r[pc->b] % r[pc->c]; NEXT();
+  BINARY(AND, r[pc->b] & r[pc->c])
+  BINARY(OR, r[pc->b] | r[pc->c])
+  BINARY(XOR, r[pc->b] ^ r[pc->c])
+  BINARY(SHL, Wrap(static_cast<unsigned>(r[pc->b]) << (r[pc->c] & 31)))
+  BINARY(SAR, r[pc->b] >> (r[pc->c] & 31))
+
+  BINARY(ADDI, Wrap(static_cast<unsigned>(r[pc->b]) + static_cast<unsigned>(pc->c)))
+  BINARY(MULI, Wrap(static_cast<unsigned>(r[pc->b]) * static_cast<unsigned>(pc->c)))
+  BINARY(ANDI, r[pc->b] & pc->c)
+  BINARY(SHLI, Wrap(static_cast<unsigned>(r[pc->b]) << pc->c))
+  BINARY(SARI, r[pc->b] >> pc->c)
+
+  BINARY(NEG, Wrap(0u - static_cast<unsigned>(r[pc->b])))
+  BINARY(NOT, ~r[pc->b])
+  BINARY(LNOT, r[pc->b] == 0)
+  BINARY(SEXT8, static_cast<signed char>(r[pc->b]))
+
+  BINARY(EQ, r[pc->b] == r[pc->c])
+  BINARY(NE, r[pc->b] != r[pc->c])
+  BINARY(LT, r[pc->b] < r[pc->c])
+  BINARY(LE, r[pc->b] <= r[pc->c])
+  BINARY(GT, r[pc->b] > r[pc->c])
+  BINARY(GE, r[pc->b] >= r[pc->c])
+
+  OPCODE(JMP) JUMP(pc->a);
+  BRANCH(JZ, r[pc->a] == 0, pc->b)
+  BRANCH(JNZ, r[pc->a] != 0, pc->b)
+  BRANCH(JEQ, r[pc->a] == r[pc->b], pc->c)
+  BRANCH(JNE, r[pc->a] != r[pc->b], pc->c)
+  BRANCH(JLT, r[pc->a] < r[pc->b], pc->c)
+  BRANCH(JLE, r[pc->a] <= r[pc->b], pc->c)
+  BRANCH(JGT, r[pc->a] > r[pc->b], pc->c)
+  BRANCH(JGE, r[pc->a] >= r[pc->b], pc->c)
+  BRANCH(JEQI, r[pc->a] == pc->b, pc->c)
+  BRANCH(JNEI, r[pc->a] != pc->b, pc->c)
+  BRANCH(JLTI, r[pc->a] < pc->b, pc->c)
+  BRANCH(JLEI, r[pc->a] <= pc->b, pc->c)
+  BRANCH(JGTI, r[pc->a] > pc->b, pc->c)
+  BRANCH(JGEI, r[pc->a] >= pc->b, pc->c)
+
+  // frame and global offsets come from compiler and need no checks
+  OPCODE(LEAL) r[pc->a] = fp + pc->b; NEXT();
+  OPCODE(LOAD8) r[pc->a] = static_cast<signed char>(memory[CheckMemoryAccess(memory_, r[pc->b] + pc->c, 1)]); NEXT();
+  OPCODE(LOAD32) r[pc->a] = Load32(memory, CheckMemoryAccess(memory_, r[pc->b] + pc->c, 4)); NEXT();
+  OPCODE(STORE8) memory[CheckMemoryAccess(memory_, r[pc->a] + pc->b, 1)] = static_cast<unsigned char>(r[pc->c]); NEXT();
+  OPCODE(STORE32) Store32(memory, CheckMemoryAccess(memory_, r[pc->a] + pc->b, 4), r[pc->c]); NEXT();
+  OPCODE(LOADL8) r[pc->a] = static_cast<signed char>(memory[fp + pc->b]); NEXT();
+  OPCODE(LOADL32) r[pc->a] = Load32(memory, fp + pc->b); NEXT();
+  OPCODE(STOREL8) memory[fp + pc->a] = static_cast<unsigned char>(r[pc->b]); NEXT();
+  OPCODE(STOREL32) Store32(memory, fp + pc->a, r[pc->b]); NEXT();
+  OPCODE(LOADG8) r[pc->a] = static_cast<signed char>(memory[pc->b]); NEXT();
+  OPCODE(LOADG32) r[pc->a] = Load32(memory, pc->b); NEXT();
+  OPCODE(STOREG8) memory[pc->a] = static_cast<unsigned char>(r[pc->b]); NEXT();
+  OPCODE(STOREG32) Store32(memory, pc->a, r[pc->b]); NEXT();
+
+  OPCODE(CALLR)
+  if ((r[pc->b] & ~(functionAddressTag - 1)) != functionAddressTag)
+  {
+    throw std::runtime_error("call through invalid function pointer");
+  }
+  calleeIndex = r[pc->b] & (functionAddressTag - 1);
+  goto call;
+
+  OPCODE(CALL)
+  calleeIndex = pc->b;
+
+call:
+  callee = GetFunction_(calleeIndex);
+  if (OnCall_(calleeIndex))
+  {
+    r[pc->a] = jit_->Call(context_, calleeIndex, r + pc->c, fp);
+    NEXT();
+  }
+  frames_.push_back({function, code, pc + 1, r, fp, pc->a});
+  function = calleeIndex;
+  r += pc->c;
+  fp -= callee->frameSize;
+  if (registersEnd - r < callee->registerCount
+      || fp < dataSize)
+  {
+    throw std::runtime_error("stack overflow");
+  }
+  code = callee->code.data();
+  pc = code;
+  DISPATCH();
+
+  OPCODE(TCALL)
+  // caller has no memory frame, callee frame starts at the same place
+  calleeIndex = pc->a;
+  callee = GetFunction_(calleeIndex);
+  memmove(r, r + pc->b, callee->parameterCount * sizeof(int));
+  if (OnCall_(calleeIndex))
+  {
+    value = jit_->Call(context_, calleeIndex, r, fp);
+    goto leave;
+  }
+  function = calleeIndex;
+  fp -= callee->frameSize;
+  if (registersEnd - r < callee->registerCount
+      || fp < dataSize)
+  {
+    throw std::runtime_error("stack overflow");
+  }
+  code = callee->code.data();
+  pc = code;
+  DISPATCH();
+
+  OPCODE(RET)
+  value = 0;
+  goto leave;
+
+  OPCODE(RETV)
+  value = r[pc->a];
+
+leave:
+  if (frames_.size() == baseFrame)
+  {
+    return value;
+  }
+  {
+    const Frame& frame = frames_.back();
+    function = frame.function;
+    code = frame.code;
+    pc = frame.returnAddress;
+    r = frame.registers;
+    fp = frame.framePointer;
+    r[frame.result] = value;
+  }
+  frames_.pop_back();
+  DISPATCH();
+
+  OPCODE(PRINT) PrintValues(out_, memory_, module_.printFormats[pc->a], r + pc->b, pc->c); NEXT();
+
+#if !defined(__GNUC__)
+    default:
+      assert(false);
+    }
+  }
+#endif
+
+#undef BRANCH
+#undef BINARY
+#undef JUMP
+#undef NEXT
+#undef OPCODE
+#undef DISPATCH
+
+  return 0;
+}
+
+//==============================================================================
+void BytecodeInterpreter::PrintStatistics(std::ostream& out) const
+{
+  using namespace std;
+
+  out << left << setw(24) << "function" << right << setw(12) << "calls"
+      << setw(12) << "back-edges" << "  tier" << endl;
+  for (size_t i = 0; i < counters_.size(); i++)
+  {
+    if (!module_.functions[i].defined)
+    {
+      continue;
+    }
+    out << left << setw(24) << module_.functions[i].name << right
+        << setw(12) << counters_[i].invocations
+        << setw(12) << counters_[i].backEdges << "  "
+        << (jit_ != NULL && jit_->IsCompiled(i) ? "native" : "interpreted") << endl;
+  }
+
+  // counters stop once function runs natively
+  if (!transitions_.empty())
+  {
+    out << endl << "tier transitions:" << endl;
+  }
+  for (auto& transition : transitions_)
+  {
+    out << "  " << module_.functions[transition.function].name << ": ";
+    if (transition.loopHeader < 0)
+    {
+      out << "compiled after " << transition.count << " calls" << endl;
+    }
+    else
+    {
+      out << "on-stack replacement at @" << transition.loopHeader
+          << " after " << transition.count << " back-edges" << endl;
+    }
+  }
+}
+
+//==============================================================================
+const BytecodeFunction* BytecodeInterpreter::GetFunction_(int index) const
+{
+  if (index < 0 || index >= static_cast<int>(module_.functions.size()))
+  {
+    throw std::runtime_error("call through invalid function pointer");
+  }
+  const BytecodeFunction* function = &module_.functions[index];
+  if (!function->defined)
+  {
+    throw std::runtime_error("function " + function->name + " is not defined");
+  }
+  return function;
+}
+
+} // namespace Compiler
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <iosfwd>
+
+#include "Bytecode.hpp"
+#include "Jit.hpp"
+
+namespace Compiler
+{
+// executes bytecode module, `print` writes to given stream
+// memory holds module data followed by the stack, frames grow downwards
+// with BytecodeJit attached, functions whose counters cross thresholds
+// are compiled to native code, running loops switch to it at loop headers
+class BytecodeInterpreter
+{
+public:
+  BytecodeInterpreter(const BytecodeModule& module, std::ostream& out,
+                      int stackSize = 1 << 20, int registerCount = 1 << 20);
+  ~BytecodeInterpreter();
+  BytecodeInterpreter(const BytecodeInterpreter&) = delete;
+  BytecodeInterpreter& operator=(const BytecodeInterpreter&) = delete;
+
+  // functions already compiled by `jit` run natively, others are compiled
+  // after `invocationThreshold` calls or `backEdgeThreshold` backward jumps
+  void SetJit(BytecodeJit* jit, int invocationThreshold = 100, int backEdgeThreshold = 1000);
+
+  // calls function without arguments and returns its result
+  int Run(const std::string& name);
+
+  // counters and tier transitions of the last run
+  void PrintStatistics(std::ostream& out) const;
+
+private:
+  friend class BytecodeJit;
+
+  struct Frame
+  {
+    int function;
+    const BytecodeInstruction* code;
+    const BytecodeInstruction* returnAddress;
+    int* registers;
+    int framePointer;
+    // caller register receiving result
+    int result;
+  };
+
+  struct Counters
+  {
+    long long invocations;
+    long long backEdges;
+  };
+
+  struct Transition
+  {
+    int function;
+    // instruction execution continued from, -1 if compiled on call
+    int loopHeader;
+    long long count;
+  };
+
+  const BytecodeModule& module_;
+  std::ostream& out_;
+  int stackSize_;
+  std::vector<unsigned char> memory_;
+  // calloc'ed, so untouched part of register file costs no page faults
+  int* registers_;
+  int registerCount_;
+  std::vector<Frame> frames_;
+  std::vector<Counters> counters_;
+  std::vector<Transition> transitions_;
+  BytecodeJit* jit_{NULL};
+  BytecodeJit::Context context_;
+  int invocationThreshold_{0};
+  int backEdgeThreshold_{0};
+
+  // counts call, true if function is to be run natively
+  bool OnCall_(int function);
+  // counts taken backward jump, true if running function is to be
+  // continued natively from `target`
+  bool OnBackEdge_(int function, int target);
+  // runs function with arguments at `registers`, `framePointer` is the caller's one
+  int Call_(int function, int* registers, int framePointer);
+  int Interpret_(int function, int* registers, int framePointer);
+  const BytecodeFunction* GetFunction_(int index) const;
+};
+
+} // namespace Compiler
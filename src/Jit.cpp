@@ -0,0 +1,1154 @@
+#include "Jit.hpp"
+#include "Interpreter.hpp"
+
+#include <iostream>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <cassert>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define COMPILER_JIT_X64
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  enum ERegister
+  {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+    NO_REGISTER,
+  };
+
+#if defined(_WIN32)
+  const ERegister argumentRegisters[] = {RCX, RDX, R8, R9};
+#else
+  const ERegister argumentRegisters[] = {RDI, RSI, RDX, RCX};
+#endif
+
+  // kept through whole generated function, callee-saved in both ABIs
+  const ERegister contextRegister = R12;
+  const ERegister entriesRegister = R13;
+  const ERegister windowRegister = RBX;
+  const ERegister framePointerRegister = R14;
+  const ERegister memoryRegister = R15;
+  const ERegister savedRegisters[] = {RBX, R12, R13, R14, R15};
+  // shadow space for Win64 callees, keeps stack 16-byte aligned
+  const int outgoingArea = 32;
+  // native stack one activation of generated code takes: return address,
+  // saved registers and outgoing area
+  const size_t nativeFrameSize = 8 + sizeof(savedRegisters) / sizeof(savedRegisters[0]) * 8 + outgoingArea;
+  // below the limit generated code checks, for runtime helpers it calls
+  const size_t helperStackSize = 1 << 18;
+  // for interpreter frames of functions generated code calls before they
+  // are compiled
+  const size_t interpretedStackSize = 1 << 20;
+
+  enum ECondition
+  {
+    CC_B = 0x2,
+    CC_AE = 0x3,
+    CC_E = 0x4,
+    CC_NE = 0x5,
+    CC_A = 0x7,
+    CC_L = 0xC,
+    CC_GE = 0xD,
+    CC_LE = 0xE,
+    CC_G = 0xF,
+  };
+
+  enum EError
+  {
+    ERROR_STACK_OVERFLOW,
+    ERROR_DIVISION_BY_ZERO,
+    ERROR_DIVISION_OVERFLOW,
+    ERROR_INVALID_MEMORY,
+    ERROR_INVALID_FUNCTION,
+  };
+
+  const std::map<EOpcode, ECondition> opcodeToCondition =
+  {
+    {EOpcode::EQ, CC_E}, {EOpcode::NE, CC_NE},
+    {EOpcode::LT, CC_L}, {EOpcode::LE, CC_LE},
+    {EOpcode::GT, CC_G}, {EOpcode::GE, CC_GE},
+    {EOpcode::JEQ, CC_E}, {EOpcode::JNE, CC_NE},
+    {EOpcode::JLT, CC_L}, {EOpcode::JLE, CC_LE},
+    {EOpcode::JGT, CC_G}, {EOpcode::JGE, CC_GE},
+    {EOpcode::JEQI, CC_E}, {EOpcode::JNEI, CC_NE},
+    {EOpcode::JLTI, CC_L}, {EOpcode::JLEI, CC_LE},
+    {EOpcode::JGTI, CC_G}, {EOpcode::JGEI, CC_GE},
+  };
+
+  // opcode byte and ModRM reg field of `op r/m32, r32` group and `op r/m32, imm32` group
+  struct ArithmeticEncoding
+  {
+    int opcode;
+    int extension;
+  };
+
+  const std::map<EOpcode, ArithmeticEncoding> opcodeToArithmetic =
+  {
+    {EOpcode::ADD, {0x03, 0}},
+    {EOpcode::SUB, {0x2B, 5}},
+    {EOpcode::AND, {0x23, 4}},
+    {EOpcode::OR, {0x0B, 1}},
+    {EOpcode::XOR, {0x33, 6}},
+    {EOpcode::ADDI, {0x03, 0}},
+    {EOpcode::ANDI, {0x23, 4}},
+  };
+
+  // x86-64 machine code for the handful of instruction forms generator needs
+  // 32-bit operand size unless `wide` is set
+  class X64Assembler
+  {
+  public:
+    std::vector<unsigned char> code;
+
+    void Byte(int value)
+    {
+      code.push_back(static_cast<unsigned char>(value));
+    }
+
+    void Int32(int value)
+    {
+      for (int i = 0; i < 4; i++)
+      {
+        Byte((static_cast<unsigned>(value) >> (8 * i)) & 0xFF);
+      }
+    }
+
+    void Int64(uint64_t value)
+    {
+      for (int i = 0; i < 8; i++)
+      {
+        Byte((value >> (8 * i)) & 0xFF);
+      }
+    }
+
+    // opcode with ModRM addressing [base + index * scale + displacement]
+    void Memory(std::initializer_list<int> opcode, int reg, ERegister base, int displacement,
+                bool wide = false, ERegister index = NO_REGISTER, int scale = 1)
+    {
+      int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0)
+              | ((index != NO_REGISTER && (index & 8)) ? 2 : 0) | ((base & 8) ? 1 : 0);
+      if (rex != 0x40)
+      {
+        Byte(rex);
+      }
+      for (int byte : opcode)
+      {
+        Byte(byte);
+      }
+
+      // rbp and r13 as base have no form without displacement
+      int mod = 2;
+      if (displacement == 0 && (base & 7) != RBP)
+      {
+        mod = 0;
+      }
+      else if (displacement >= -128 && displacement <= 127)
+      {
+        mod = 1;
+      }
+
+      if (index == NO_REGISTER && (base & 7) != RSP)
+      {
+        Byte((mod << 6) | ((reg & 7) << 3) | (base & 7));
+      }
+      else
+      {
+        int scaleBits = scale == 8 ? 3 : scale == 4 ? 2 : scale == 2 ? 1 : 0;
+        int indexBits = index == NO_REGISTER ? RSP : (index & 7);
+        Byte((mod << 6) | ((reg & 7) << 3) | RSP);
+        Byte((scaleBits << 6) | (indexBits << 3) | (base & 7));
+      }
+
+      if (mod == 1)
+      {
+        Byte(displacement & 0xFF);
+      }
+      else if (mod == 2)
+      {
+        Int32(displacement);
+      }
+    }
+
+    // opcode with register r/m operand
+    void Register(std::initializer_list<int> opcode, int reg, ERegister rm, bool wide = false)
+    {
+      int rex = 0x40 | (wide ? 8 : 0) | ((reg & 8) ? 4 : 0) | ((rm & 8) ? 1 : 0);
+      if (rex != 0x40)
+      {
+        Byte(rex);
+      }
+      for (int byte : opcode)
+      {
+        Byte(byte);
+      }
+      Byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+    }
+
+    void Push(ERegister reg)
+    {
+      if (reg & 8)
+      {
+        Byte(0x41);
+      }
+      Byte(0x50 + (reg & 7));
+    }
+
+    void Pop(ERegister reg)
+    {
+      if (reg & 8)
+      {
+        Byte(0x41);
+      }
+      Byte(0x58 + (reg & 7));
+    }
+
+    void MovImmediate(ERegister reg, int value)
+    {
+      if (reg & 8)
+      {
+        Byte(0x41);
+      }
+      Byte(0xB8 + (reg & 7));
+      Int32(value);
+    }
+
+    void MovImmediate64(ERegister reg, uint64_t value)
+    {
+      Byte(0x48 | ((reg & 8) ? 1 : 0));
+      Byte(0xB8 + (reg & 7));
+      Int64(value);
+    }
+
+    void MovRegister(ERegister destination, ERegister source, bool wide)
+    {
+      Register({0x89}, source, destination, wide);
+    }
+
+    // 64-bit `op reg, gs:[displacement]`, Win64 thread information block
+    void ThreadBlock(int opcode, ERegister reg, int displacement)
+    {
+      Byte(0x65);
+      Byte(0x48 | ((reg & 8) ? 4 : 0));
+      Byte(opcode);
+      Byte(0x04 | ((reg & 7) << 3));
+      Byte(0x25);
+      Int32(displacement);
+    }
+
+    // rel32 jump, returns position of displacement to patch
+    int Jump()
+    {
+      Byte(0xE9);
+      Int32(0);
+      return code.size() - 4;
+    }
+
+    int JumpIf(ECondition condition)
+    {
+      Byte(0x0F);
+      Byte(0x80 | condition);
+      Int32(0);
+      return code.size() - 4;
+    }
+
+    void Patch(int position, int target)
+    {
+      int displacement = target - (position + 4);
+      memcpy(&code[position], &displacement, 4);
+    }
+  };
+
+  // addresses of BytecodeJit runtime helpers called from generated code
+  struct RuntimeHelpers
+  {
+    uint64_t error;
+    uint64_t print;
+  };
+
+  // machine code for one bytecode function
+  // calling convention: int f(Context* context, int* registers, int framePointer)
+  // where framePointer is the caller's one
+  class FunctionMachineCodeGenerator
+  {
+  public:
+    FunctionMachineCodeGenerator(const BytecodeModule& module, const BytecodeFunction& function,
+                                 const RuntimeHelpers& helpers)
+      : module_(module)
+      , function_(function)
+      , helpers_(helpers)
+    {
+
+    }
+
+    std::vector<unsigned char> Generate();
+    // loop header -> offset of on-stack replacement entry, valid after Generate
+    const std::map<int, int>& GetLoopEntries() const
+    {
+      return loopEntries_;
+    }
+
+  private:
+    struct Fixup
+    {
+      int position;
+      int target;
+    };
+
+    const BytecodeModule& module_;
+    const BytecodeFunction& function_;
+    RuntimeHelpers helpers_;
+    X64Assembler as_;
+    // native offset of each bytecode instruction
+    std::vector<int> offsets_;
+    std::vector<Fixup> fixups_;
+    // jumps to error stubs, by EError
+    std::map<int, std::vector<int>> errorJumps_;
+    std::vector<int> exitJumps_;
+    std::map<int, int> loopEntries_;
+
+    int Slot_(int reg) const
+    {
+      return 4 * reg;
+    }
+
+    void Load_(ERegister reg, int slot)
+    {
+      as_.Memory({0x8B}, reg, windowRegister, Slot_(slot));
+    }
+
+    void Store_(int slot, ERegister reg)
+    {
+      as_.Memory({0x89}, reg, windowRegister, Slot_(slot));
+    }
+
+    void JumpTo_(int target)
+    {
+      fixups_.push_back({as_.Jump(), target});
+    }
+
+    void JumpIfTo_(ECondition condition, int target)
+    {
+      fixups_.push_back({as_.JumpIf(condition), target});
+    }
+
+    void ErrorIf_(ECondition condition, EError error)
+    {
+      errorJumps_[error].push_back(as_.JumpIf(condition));
+    }
+
+    // saves registers and loads context, arguments are not touched
+    void Prologue_();
+    void Epilogue_();
+    void CheckError_();
+    // eax holds address, generated code jumps to error stub if it is invalid
+    void CheckAddress_(int size);
+    void PrepareCall_(int argumentBase);
+    void CallHelper_(uint64_t helper);
+    void Generate_(const BytecodeInstruction& instruction);
+  };
+
+  template<typename Function>
+  uint64_t HelperAddress(Function function)
+  {
+    return reinterpret_cast<uint64_t>(function);
+  }
+
+  // int f(Context* context, int* registers, int framePointer) which calls
+  // context->target with the same arguments on context->stackTop
+  std::vector<unsigned char> GenerateStackSwitch()
+  {
+    const ERegister context = argumentRegisters[0];
+    X64Assembler as;
+    as.Push(RBX);
+#if defined(_WIN32)
+    // unwinder checks frames against stack bounds of thread information block
+    const int stackBase = 0x08;
+    const int stackLimit = 0x10;
+    as.ThreadBlock(0x8B, RAX, stackBase);
+    as.Push(RAX);
+    as.ThreadBlock(0x8B, RAX, stackLimit);
+    as.Push(RAX);
+    as.Memory({0x8B}, RAX, context, offsetof(BytecodeJit::Context, stackTop), true);
+    as.ThreadBlock(0x89, RAX, stackBase);
+    as.Memory({0x8B}, RAX, context, offsetof(BytecodeJit::Context, stackBottom), true);
+    as.ThreadBlock(0x89, RAX, stackLimit);
+#endif
+    as.MovRegister(RBX, RSP, true);
+    as.Memory({0x8B}, RSP, context, offsetof(BytecodeJit::Context, stackTop), true);
+    as.Memory({0xFF}, 2, context, offsetof(BytecodeJit::Context, target));
+    as.MovRegister(RSP, RBX, true);
+#if defined(_WIN32)
+    as.Pop(RCX);
+    as.ThreadBlock(0x89, RCX, stackLimit);
+    as.Pop(RCX);
+    as.ThreadBlock(0x89, RCX, stackBase);
+#endif
+    as.Pop(RBX);
+    as.Byte(0xC3);
+    return as.code;
+  }
+
+} // namespace
+
+//==============================================================================
+std::vector<unsigned char> FunctionMachineCodeGenerator::Generate()
+{
+  Prologue_();
+
+  // same limits as interpreter checks on call
+  if (function_.frameSize != 0)
+  {
+    as_.Register({0x81}, 5, framePointerRegister);
+    as_.Int32(function_.frameSize);
+  }
+  as_.Memory({0x3B}, framePointerRegister, contextRegister, offsetof(BytecodeJit::Context, dataSize));
+  ErrorIf_(CC_L, ERROR_STACK_OVERFLOW);
+  as_.Memory({0x8D}, RAX, windowRegister, Slot_(function_.registerCount), true);
+  as_.Memory({0x3B}, RAX, contextRegister, offsetof(BytecodeJit::Context, registersEnd), true);
+  ErrorIf_(CC_A, ERROR_STACK_OVERFLOW);
+  as_.Memory({0x3B}, RSP, contextRegister, offsetof(BytecodeJit::Context, stackLimit), true);
+  ErrorIf_(CC_B, ERROR_STACK_OVERFLOW);
+
+  for (auto& instruction : function_.code)
+  {
+    offsets_.push_back(as_.code.size());
+    Generate_(instruction);
+  }
+
+  for (auto& fixup : fixups_)
+  {
+    as_.Patch(fixup.position, offsets_[fixup.target]);
+  }
+
+  // activation already has its frame, so no limits are checked
+  for (int header : function_.loopHeaders)
+  {
+    loopEntries_[header] = as_.code.size();
+    Prologue_();
+    as_.Patch(as_.Jump(), offsets_[header]);
+  }
+
+  // error stubs, error kind in second argument, detail in third
+  std::vector<int> errorStubJumps;
+  for (auto& jumps : errorJumps_)
+  {
+    for (int position : jumps.second)
+    {
+      as_.Patch(position, as_.code.size());
+    }
+    if (jumps.first == ERROR_INVALID_MEMORY)
+    {
+      as_.MovRegister(argumentRegisters[2], RAX, false);
+    }
+    as_.MovImmediate(argumentRegisters[1], jumps.first);
+    errorStubJumps.push_back(as_.Jump());
+  }
+  if (!errorStubJumps.empty())
+  {
+    for (int position : errorStubJumps)
+    {
+      as_.Patch(position, as_.code.size());
+    }
+    as_.MovRegister(argumentRegisters[0], contextRegister, true);
+    CallHelper_(helpers_.error);
+  }
+
+  for (int position : exitJumps_)
+  {
+    as_.Patch(position, as_.code.size());
+  }
+  Epilogue_();
+
+  return as_.code;
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::Prologue_()
+{
+  for (ERegister reg : savedRegisters)
+  {
+    as_.Push(reg);
+  }
+  as_.Register({0x81}, 5, RSP, true);
+  as_.Int32(outgoingArea);
+
+  as_.MovRegister(contextRegister, argumentRegisters[0], true);
+  as_.MovRegister(windowRegister, argumentRegisters[1], true);
+  as_.MovRegister(framePointerRegister, argumentRegisters[2], false);
+  as_.Memory({0x8B}, entriesRegister, contextRegister, offsetof(BytecodeJit::Context, entries), true);
+  as_.Memory({0x8B}, memoryRegister, contextRegister, offsetof(BytecodeJit::Context, memory), true);
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::Epilogue_()
+{
+  as_.Register({0x81}, 0, RSP, true);
+  as_.Int32(outgoingArea);
+  for (int i = sizeof(savedRegisters) / sizeof(savedRegisters[0]) - 1; i >= 0; i--)
+  {
+    as_.Pop(savedRegisters[i]);
+  }
+  as_.Byte(0xC3);
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::CheckError_()
+{
+  as_.Memory({0x83}, 7, contextRegister, offsetof(BytecodeJit::Context, error));
+  as_.Byte(0);
+  exitJumps_.push_back(as_.JumpIf(CC_NE));
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::CheckAddress_(int size)
+{
+  as_.Register({0x83}, 7, RAX);
+  as_.Byte(4);
+  ErrorIf_(CC_B, ERROR_INVALID_MEMORY);
+  as_.Memory({0x3B}, RAX, contextRegister, size == 1
+             ? offsetof(BytecodeJit::Context, byteLimit)
+             : offsetof(BytecodeJit::Context, dwordLimit));
+  ErrorIf_(CC_A, ERROR_INVALID_MEMORY);
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::PrepareCall_(int argumentBase)
+{
+  as_.MovRegister(argumentRegisters[0], contextRegister, true);
+  as_.Memory({0x8D}, argumentRegisters[1], windowRegister, Slot_(argumentBase), true);
+  as_.MovRegister(argumentRegisters[2], framePointerRegister, false);
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::CallHelper_(uint64_t helper)
+{
+  as_.MovImmediate64(RAX, helper);
+  as_.Register({0xFF}, 2, RAX);
+}
+
+//==============================================================================
+void FunctionMachineCodeGenerator::Generate_(const BytecodeInstruction& instruction)
+{
+  const int a = instruction.a;
+  const int b = instruction.b;
+  const int c = instruction.c;
+
+  switch (instruction.opcode)
+  {
+  case EOpcode::MOV:
+    Load_(RAX, b);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::MOVI:
+    as_.Memory({0xC7}, 0, windowRegister, Slot_(a));
+    as_.Int32(b);
+    break;
+
+  case EOpcode::ADD:
+  case EOpcode::SUB:
+  case EOpcode::AND:
+  case EOpcode::OR:
+  case EOpcode::XOR:
+    Load_(RAX, b);
+    as_.Memory({opcodeToArithmetic.at(instruction.opcode).opcode}, RAX, windowRegister, Slot_(c));
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::MUL:
+    Load_(RAX, b);
+    as_.Memory({0x0F, 0xAF}, RAX, windowRegister, Slot_(c));
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::DIV:
+  case EOpcode::MOD:
+  {
+    Load_(RAX, b);
+    Load_(RCX, c);
+    as_.Register({0x85}, RCX, RCX);
+    ErrorIf_(CC_E, ERROR_DIVISION_BY_ZERO);
+    as_.Register({0x83}, 7, RCX);
+    as_.Byte(0xFF);
+    int notMinusOne = as_.JumpIf(CC_NE);
+    as_.Register({0x81}, 7, RAX);
+    as_.Int32(INT_MIN);
+    ErrorIf_(CC_E, ERROR_DIVISION_OVERFLOW);
+    as_.Patch(notMinusOne, as_.code.size());
+    as_.Byte(0x99);
+    as_.Register({0xF7}, 7, RCX);
+    Store_(a, instruction.opcode == EOpcode::DIV ? RAX : RDX);
+    break;
+  }
+
+  case EOpcode::SHL:
+  case EOpcode::SAR:
+    Load_(RCX, c);
+    Load_(RAX, b);
+    as_.Register({0xD3}, instruction.opcode == EOpcode::SHL ? 4 : 7, RAX);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::ADDI:
+  case EOpcode::ANDI:
+    Load_(RAX, b);
+    as_.Register({0x81}, opcodeToArithmetic.at(instruction.opcode).extension, RAX);
+    as_.Int32(c);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::MULI:
+    as_.Memory({0x69}, RAX, windowRegister, Slot_(b));
+    as_.Int32(c);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::SHLI:
+  case EOpcode::SARI:
+    Load_(RAX, b);
+    as_.Register({0xC1}, instruction.opcode == EOpcode::SHLI ? 4 : 7, RAX);
+    as_.Byte(c & 31);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::NEG:
+  case EOpcode::NOT:
+    Load_(RAX, b);
+    as_.Register({0xF7}, instruction.opcode == EOpcode::NEG ? 3 : 2, RAX);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::LNOT:
+    as_.Memory({0x83}, 7, windowRegister, Slot_(b));
+    as_.Byte(0);
+    as_.Register({0x0F, 0x90 | CC_E}, 0, RAX);
+    as_.Register({0x0F, 0xB6}, RAX, RAX);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::SEXT8:
+    as_.Memory({0x0F, 0xBE}, RAX, windowRegister, Slot_(b));
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::EQ:
+  case EOpcode::NE:
+  case EOpcode::LT:
+  case EOpcode::LE:
+  case EOpcode::GT:
+  case EOpcode::GE:
+    Load_(RAX, b);
+    as_.Memory({0x3B}, RAX, windowRegister, Slot_(c));
+    as_.Register({0x0F, 0x90 | opcodeToCondition.at(instruction.opcode)}, 0, RAX);
+    as_.Register({0x0F, 0xB6}, RAX, RAX);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::JMP:
+    JumpTo_(a);
+    break;
+
+  case EOpcode::JZ:
+  case EOpcode::JNZ:
+    as_.Memory({0x83}, 7, windowRegister, Slot_(a));
+    as_.Byte(0);
+    JumpIfTo_(instruction.opcode == EOpcode::JZ ? CC_E : CC_NE, b);
+    break;
+
+  case EOpcode::JEQ:
+  case EOpcode::JNE:
+  case EOpcode::JLT:
+  case EOpcode::JLE:
+  case EOpcode::JGT:
+  case EOpcode::JGE:
+    Load_(RAX, a);
+    as_.Memory({0x3B}, RAX, windowRegister, Slot_(b));
+    JumpIfTo_(opcodeToCondition.at(instruction.opcode), c);
+    break;
+
+  case EOpcode::JEQI:
+  case EOpcode::JNEI:
+  case EOpcode::JLTI:
+  case EOpcode::JLEI:
+  case EOpcode::JGTI:
+  case EOpcode::JGEI:
+    as_.Memory({0x81}, 7, windowRegister, Slot_(a));
+    as_.Int32(b);
+    JumpIfTo_(opcodeToCondition.at(instruction.opcode), c);
+    break;
+
+  case EOpcode::LEAL:
+    as_.Memory({0x8D}, RAX, framePointerRegister, b);
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::LOAD8:
+  case EOpcode::LOAD32:
+  {
+    bool byte = instruction.opcode == EOpcode::LOAD8;
+    Load_(RAX, b);
+    as_.Register({0x81}, 0, RAX);
+    as_.Int32(c);
+    CheckAddress_(byte ? 1 : 4);
+    if (byte)
+    {
+      as_.Memory({0x0F, 0xBE}, RAX, memoryRegister, 0, false, RAX);
+    }
+    else
+    {
+      as_.Memory({0x8B}, RAX, memoryRegister, 0, false, RAX);
+    }
+    Store_(a, RAX);
+    break;
+  }
+
+  case EOpcode::STORE8:
+  case EOpcode::STORE32:
+  {
+    bool byte = instruction.opcode == EOpcode::STORE8;
+    Load_(RAX, a);
+    as_.Register({0x81}, 0, RAX);
+    as_.Int32(b);
+    CheckAddress_(byte ? 1 : 4);
+    Load_(RCX, c);
+    as_.Memory({byte ? 0x88 : 0x89}, RCX, memoryRegister, 0, false, RAX);
+    break;
+  }
+
+  case EOpcode::LOADL8:
+  case EOpcode::LOADL32:
+    if (instruction.opcode == EOpcode::LOADL8)
+    {
+      as_.Memory({0x0F, 0xBE}, RAX, memoryRegister, b, false, framePointerRegister);
+    }
+    else
+    {
+      as_.Memory({0x8B}, RAX, memoryRegister, b, false, framePointerRegister);
+    }
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::STOREL8:
+  case EOpcode::STOREL32:
+    Load_(RAX, b);
+    as_.Memory({instruction.opcode == EOpcode::STOREL8 ? 0x88 : 0x89},
+               RAX, memoryRegister, a, false, framePointerRegister);
+    break;
+
+  case EOpcode::LOADG8:
+  case EOpcode::LOADG32:
+    if (instruction.opcode == EOpcode::LOADG8)
+    {
+      as_.Memory({0x0F, 0xBE}, RAX, memoryRegister, b);
+    }
+    else
+    {
+      as_.Memory({0x8B}, RAX, memoryRegister, b);
+    }
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::STOREG8:
+  case EOpcode::STOREG32:
+    Load_(RAX, b);
+    as_.Memory({instruction.opcode == EOpcode::STOREG8 ? 0x88 : 0x89}, RAX, memoryRegister, a);
+    break;
+
+  case EOpcode::CALL:
+    PrepareCall_(c);
+    as_.Memory({0xFF}, 2, entriesRegister, 8 * b);
+    CheckError_();
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::CALLR:
+    Load_(RAX, b);
+    as_.MovRegister(RCX, RAX, false);
+    as_.Register({0x81}, 4, RCX);
+    as_.Int32(~(functionAddressTag - 1));
+    as_.Register({0x81}, 7, RCX);
+    as_.Int32(functionAddressTag);
+    ErrorIf_(CC_NE, ERROR_INVALID_FUNCTION);
+    as_.Register({0x81}, 4, RAX);
+    as_.Int32(functionAddressTag - 1);
+    as_.Register({0x81}, 7, RAX);
+    as_.Int32(module_.functions.size());
+    ErrorIf_(CC_AE, ERROR_INVALID_FUNCTION);
+    PrepareCall_(c);
+    as_.Memory({0xFF}, 2, entriesRegister, 0, false, RAX, 8);
+    CheckError_();
+    Store_(a, RAX);
+    break;
+
+  case EOpcode::TCALL:
+  {
+    // caller has no memory frame, so callee gets the same frame pointer
+    int parameterCount = module_.functions[a].parameterCount;
+    for (int i = 0; i < parameterCount; i++)
+    {
+      Load_(RAX, b + i);
+      Store_(i, RAX);
+    }
+    PrepareCall_(0);
+    as_.Memory({0x8B}, RAX, entriesRegister, 8 * a, true);
+    as_.Register({0x81}, 0, RSP, true);
+    as_.Int32(outgoingArea);
+    for (int i = sizeof(savedRegisters) / sizeof(savedRegisters[0]) - 1; i >= 0; i--)
+    {
+      as_.Pop(savedRegisters[i]);
+    }
+    as_.Register({0xFF}, 4, RAX);
+    break;
+  }
+
+  case EOpcode::RET:
+    as_.Register({0x31}, RAX, RAX);
+    Epilogue_();
+    break;
+
+  case EOpcode::RETV:
+    Load_(RAX, a);
+    Epilogue_();
+    break;
+
+  case EOpcode::PRINT:
+    as_.MovRegister(argumentRegisters[0], contextRegister, true);
+    as_.MovImmediate(argumentRegisters[1], a);
+    as_.Memory({0x8D}, argumentRegisters[2], windowRegister, Slot_(b), true);
+    as_.MovImmediate(argumentRegisters[3], c);
+    CallHelper_(helpers_.print);
+    CheckError_();
+    break;
+
+  default:
+    throw std::logic_error("unknown opcode " + opcodeInfo.at(instruction.opcode).name);
+  }
+}
+
+//==============================================================================
+BytecodeJit::BytecodeJit(const BytecodeModule& module, bool eager)
+  : module_(module)
+  , entries_(module.functions.size(), NULL)
+  , compiled_(module.functions.size(), false)
+  , loopEntries_(module.functions.size())
+{
+  if (!IsSupported())
+  {
+    throw std::runtime_error("native code generation is not supported on this host");
+  }
+
+  // functions without code yet are jumped to with arguments in place,
+  // stubs add function index and pass the call to runtime helper
+  X64Assembler as;
+  std::vector<int> stubOffsets(module_.functions.size(), -1);
+  for (size_t i = 0; i < module_.functions.size(); i++)
+  {
+    if (module_.functions[i].defined && eager)
+    {
+      continue;
+    }
+
+    stubOffsets[i] = as.code.size();
+    if (module_.functions[i].defined)
+    {
+      as.MovImmediate(argumentRegisters[3], i);
+      as.MovImmediate64(RAX, HelperAddress(&BytecodeJit::CallInterpreter_));
+    }
+    else
+    {
+      as.MovImmediate(argumentRegisters[1], i);
+      as.MovImmediate64(RAX, HelperAddress(&BytecodeJit::UndefinedFunction_));
+    }
+    as.Register({0xFF}, 4, RAX);
+  }
+
+  if (!as.code.empty())
+  {
+    unsigned char* stubs = static_cast<unsigned char*>(Install_(as.code));
+    for (size_t i = 0; i < module_.functions.size(); i++)
+    {
+      if (stubOffsets[i] >= 0)
+      {
+        entries_[i] = stubs + stubOffsets[i];
+      }
+    }
+  }
+
+  stackSwitch_ = Install_(GenerateStackSwitch());
+
+  for (size_t i = 0; i < module_.functions.size(); i++)
+  {
+    if (module_.functions[i].defined && eager)
+    {
+      Compile(i);
+    }
+  }
+}
+
+//==============================================================================
+BytecodeJit::~BytecodeJit()
+{
+  for (auto& block : blocks_)
+  {
+#if defined(COMPILER_JIT_X64) && defined(_WIN32)
+    VirtualFree(block.first, 0, MEM_RELEASE);
+#elif defined(COMPILER_JIT_X64)
+    munmap(block.first, block.second);
+#endif
+  }
+  FreeStack_();
+}
+
+//==============================================================================
+bool BytecodeJit::IsSupported()
+{
+#if defined(COMPILER_JIT_X64)
+  return true;
+#else
+  return false;
+#endif
+}
+
+//==============================================================================
+void BytecodeJit::Compile(int function)
+{
+  if (compiled_[function])
+  {
+    return;
+  }
+
+  RuntimeHelpers helpers = {HelperAddress(&BytecodeJit::Error_), HelperAddress(&BytecodeJit::Print_)};
+  FunctionMachineCodeGenerator generator(module_, module_.functions[function], helpers);
+  std::vector<unsigned char> code = generator.Generate();
+  unsigned char* block = static_cast<unsigned char*>(Install_(code));
+
+  entries_[function] = block;
+  for (auto& entry : generator.GetLoopEntries())
+  {
+    loopEntries_[function][entry.first] = block + entry.second;
+  }
+  compiled_[function] = true;
+  compiledFunctionCount_++;
+  codeSize_ += code.size();
+}
+
+//==============================================================================
+bool BytecodeJit::IsCompiled(int function) const
+{
+  return compiled_[function];
+}
+
+//==============================================================================
+void* const* BytecodeJit::GetEntries() const
+{
+  return entries_.data();
+}
+
+//==============================================================================
+int BytecodeJit::Call(Context& context, int function, int* registers, int framePointer)
+{
+  return Run_(context, entries_[function], registers, framePointer);
+}
+
+//==============================================================================
+int BytecodeJit::Enter(Context& context, int function, int instruction, int* registers, int framePointer)
+{
+  return Run_(context, loopEntries_[function].at(instruction), registers, framePointer);
+}
+
+//==============================================================================
+int BytecodeJit::GetCompiledFunctionCount() const
+{
+  return compiledFunctionCount_;
+}
+
+//==============================================================================
+size_t BytecodeJit::GetCodeSize() const
+{
+  return codeSize_;
+}
+
+//==============================================================================
+void* BytecodeJit::Install_(const std::vector<unsigned char>& code)
+{
+  void* block = NULL;
+#if defined(COMPILER_JIT_X64) && defined(_WIN32)
+  block = VirtualAlloc(NULL, code.size(), MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+  if (block == NULL)
+  {
+    throw std::runtime_error("cannot allocate executable memory");
+  }
+  memcpy(block, code.data(), code.size());
+  DWORD oldProtection;
+  VirtualProtect(block, code.size(), PAGE_EXECUTE_READ, &oldProtection);
+  FlushInstructionCache(GetCurrentProcess(), block, code.size());
+#elif defined(COMPILER_JIT_X64)
+  // never writable and executable at the same time
+  block = mmap(NULL, code.size(), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (block == MAP_FAILED)
+  {
+    throw std::runtime_error("cannot allocate executable memory");
+  }
+  memcpy(block, code.data(), code.size());
+  if (mprotect(block, code.size(), PROT_READ | PROT_EXEC) != 0)
+  {
+    munmap(block, code.size());
+    throw std::runtime_error("cannot allocate executable memory");
+  }
+#endif
+  blocks_.push_back(std::make_pair(block, code.size()));
+  return block;
+}
+
+//==============================================================================
+int BytecodeJit::Run_(Context& context, void* entry, int* registers, int framePointer)
+{
+  typedef int (*NativeFunction)(Context*, int*, int);
+  int result = 0;
+  if (context.stackLimit != NULL)
+  {
+    // interpreter called back from generated code
+    result = reinterpret_cast<NativeFunction>(entry)(&context, registers, framePointer);
+  }
+  else
+  {
+    // every activation takes at least one register
+    ReserveStack_((context.registersEnd - registers) * nativeFrameSize
+                  + interpretedStackSize + helperStackSize);
+    context.stackBottom = stack_;
+    // callee may use outgoing area of its caller
+    context.stackTop = stack_ + stackSize_ - outgoingArea;
+    context.stackLimit = stack_ + helperStackSize;
+    context.target = entry;
+    result = reinterpret_cast<NativeFunction>(stackSwitch_)(&context, registers, framePointer);
+    context.stackLimit = NULL;
+  }
+  if (context.error != 0)
+  {
+    context.error = 0;
+    throw std::runtime_error(errorMessage_);
+  }
+  return result;
+}
+
+//==============================================================================
+void BytecodeJit::ReserveStack_(size_t size)
+{
+  if (size <= stackSize_)
+  {
+    return;
+  }
+  FreeStack_();
+
+  // pages are only backed once generated code gets to them
+  size = (size + 0xFFFF) & ~size_t(0xFFFF);
+  void* stack = NULL;
+#if defined(COMPILER_JIT_X64) && defined(_WIN32)
+  stack = VirtualAlloc(NULL, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+#elif defined(COMPILER_JIT_X64)
+  stack = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (stack == MAP_FAILED)
+  {
+    stack = NULL;
+  }
+#endif
+  if (stack == NULL)
+  {
+    throw std::runtime_error("cannot allocate native stack");
+  }
+  stack_ = static_cast<char*>(stack);
+  stackSize_ = size;
+}
+
+//==============================================================================
+void BytecodeJit::FreeStack_()
+{
+  if (stack_ == NULL)
+  {
+    return;
+  }
+#if defined(COMPILER_JIT_X64) && defined(_WIN32)
+  VirtualFree(stack_, 0, MEM_RELEASE);
+#elif defined(COMPILER_JIT_X64)
+  munmap(stack_, stackSize_);
+#endif
+  stack_ = NULL;
+  stackSize_ = 0;
+}
+
+//==============================================================================
+// runtime helpers are called from generated code and must not throw
+void BytecodeJit::Error_(Context* context, int kind, int detail)
+{
+  static const std::map<int, std::string> errorToString =
+  {
+    {ERROR_STACK_OVERFLOW, "stack overflow"},
+    {ERROR_DIVISION_BY_ZERO, "division by zero"},
+    {ERROR_DIVISION_OVERFLOW, "integer overflow in division"},
+    {ERROR_INVALID_MEMORY, "invalid memory access at address "},
+    {ERROR_INVALID_FUNCTION, "call through invalid function pointer"},
+  };
+
+  std::string& message = context->jit->errorMessage_;
+  message = errorToString.at(kind);
+  if (kind == ERROR_INVALID_MEMORY)
+  {
+    message += std::to_string(detail);
+  }
+  context->error = 1;
+}
+
+//==============================================================================
+int BytecodeJit::UndefinedFunction_(Context* context, int function)
+{
+  BytecodeJit* jit = context->jit;
+  jit->errorMessage_ = "function " + jit->module_.functions[function].name + " is not defined";
+  context->error = 1;
+  return 0;
+}
+
+//==============================================================================
+int BytecodeJit::CallInterpreter_(Context* context, int* registers, int framePointer, int function)
+{
+  try
+  {
+    return context->interpreter->Call_(function, registers, framePointer);
+  }
+  catch (std::exception& e)
+  {
+    context->jit->errorMessage_ = e.what();
+    context->error = 1;
+    return 0;
+  }
+}
+
+//==============================================================================
+void BytecodeJit::Print_(Context* context, int format, const int* arguments, int count)
+{
+  BytecodeInterpreter* interpreter = context->interpreter;
+  try
+  {
+    PrintValues(interpreter->out_, interpreter->memory_, context->jit->module_.printFormats[format],
+                arguments, count);
+  }
+  catch (std::exception& e)
+  {
+    context->jit->errorMessage_ = e.what();
+    context->error = 1;
+  }
+}
+
+} // namespace Compiler
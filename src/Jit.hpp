@@ -0,0 +1,101 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <cstddef>
+
+#include "Bytecode.hpp"
+
+namespace Compiler
+{
+class BytecodeInterpreter;
+
+// translates bytecode functions to x86-64 machine code in executable memory
+// bytecode registers stay in the register window and every instruction is
+// expanded to a fixed machine code template, so interpreted and native
+// code share registers, memory and frames and can call each other
+class BytecodeJit
+{
+public:
+  // state generated code works with, layout is known to code generator
+  struct Context
+  {
+    unsigned char* memory;
+    // entry point per module function
+    void* const* entries;
+    int* registersEnd;
+    // lowest native stack address generated code may use, NULL until
+    // Call or Enter switches to the stack of its own
+    const char* stackLimit;
+    int dataSize;
+    // highest valid address for byte and dword accesses
+    unsigned byteLimit;
+    unsigned dwordLimit;
+    // set by runtime helpers, generated code returns as soon as it is set
+    int error;
+    BytecodeInterpreter* interpreter;
+    BytecodeJit* jit;
+    // stack generated code runs on and code the switch to it calls
+    char* stackBottom;
+    char* stackTop;
+    void* target;
+  };
+
+  // `eager` compiles every function at once, otherwise functions run
+  // in interpreter until they are compiled
+  explicit BytecodeJit(const BytecodeModule& module, bool eager = true);
+  ~BytecodeJit();
+  BytecodeJit(const BytecodeJit&) = delete;
+  BytecodeJit& operator=(const BytecodeJit&) = delete;
+
+  void Compile(int function);
+  bool IsCompiled(int function) const;
+  void* const* GetEntries() const;
+
+  // runs compiled function, `framePointer` is the caller's one
+  // runtime errors are thrown as std::runtime_error
+  // generated code runs on a stack of its own, deep enough for as many
+  // activations as register file has registers, so it recurses as deep as
+  // interpreter does whatever the thread stack is
+  int Call(Context& context, int function, int* registers, int framePointer);
+  // continues compiled function from loop header `instruction`, registers
+  // and frame pointer are those of the running activation
+  int Enter(Context& context, int function, int instruction, int* registers, int framePointer);
+
+  int GetCompiledFunctionCount() const;
+  size_t GetCodeSize() const;
+
+  // true if machine code can be generated for the host
+  static bool IsSupported();
+
+private:
+  const BytecodeModule& module_;
+  std::vector<void*> entries_;
+  std::vector<bool> compiled_;
+  // function -> loop header -> on-stack replacement entry
+  std::vector<std::map<int, void*>> loopEntries_;
+  // executable blocks, freed in destructor
+  std::vector<std::pair<void*, size_t>> blocks_;
+  int compiledFunctionCount_{0};
+  size_t codeSize_{0};
+  std::string errorMessage_;
+  // switches to stack_ and calls Context::target
+  void* stackSwitch_{NULL};
+  char* stack_{NULL};
+  size_t stackSize_{0};
+
+  void* Install_(const std::vector<unsigned char>& code);
+  // runs `entry` on stack_, or on the current stack if it is stack_ already
+  int Run_(Context& context, void* entry, int* registers, int framePointer);
+  // keeps stack_ at least `size` bytes
+  void ReserveStack_(size_t size);
+  void FreeStack_();
+
+  static void Error_(Context* context, int kind, int detail);
+  static int UndefinedFunction_(Context* context, int function);
+  static int CallInterpreter_(Context* context, int* registers, int framePointer, int function);
+  static void Print_(Context* context, int format, const int* arguments, int count);
+};
+
+} // namespace Compiler
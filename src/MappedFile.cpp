@@ -0,0 +1,118 @@
+#include "MappedFile.hpp"
+
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <iterator>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Compiler
+{
+//==============================================================================
+MappedFile::MappedFile(const std::string& path)
+{
+#ifdef _WIN32
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error("can't open " + path);
+  }
+  contents_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  data_ = contents_.data();
+  size_ = contents_.size();
+#else
+  int file = open(path.c_str(), O_RDONLY);
+  if (file < 0)
+  {
+    throw std::runtime_error("can't open " + path);
+  }
+  struct stat info;
+  if (fstat(file, &info) != 0)
+  {
+    close(file);
+    throw std::runtime_error("can't read " + path);
+  }
+  size_ = info.st_size;
+  // empty file can't be mapped
+  if (size_ > 0)
+  {
+    mapping_ = mmap(NULL, size_, PROT_READ, MAP_PRIVATE, file, 0);
+  }
+  close(file);
+  if (mapping_ == MAP_FAILED)
+  {
+    mapping_ = NULL;
+    throw std::runtime_error("can't map " + path);
+  }
+  data_ = static_cast<const unsigned char*>(mapping_);
+#endif
+}
+
+//==============================================================================
+MappedFile::~MappedFile()
+{
+#ifndef _WIN32
+  if (mapping_ != NULL)
+  {
+    munmap(mapping_, size_);
+  }
+#endif
+}
+
+//==============================================================================
+const unsigned char* MappedFile::GetData() const
+{
+  return data_;
+}
+
+//==============================================================================
+size_t MappedFile::GetSize() const
+{
+  return size_;
+}
+
+//==============================================================================
+uint32_t MappedFile::Get32(size_t offset) const
+{
+  if (offset > size_ || size_ - offset < 4)
+  {
+    throw std::runtime_error("read past end of file");
+  }
+  return static_cast<uint32_t>(data_[offset])
+      | (static_cast<uint32_t>(data_[offset + 1]) << 8)
+      | (static_cast<uint32_t>(data_[offset + 2]) << 16)
+      | (static_cast<uint32_t>(data_[offset + 3]) << 24);
+}
+
+//==============================================================================
+uint64_t MappedFile::Get64(size_t offset) const
+{
+  return Get32(offset) | (static_cast<uint64_t>(Get32(offset + 4)) << 32);
+}
+
+//==============================================================================
+void Put32(std::string& out, uint32_t value)
+{
+  char bytes[4];
+  for (int i = 0; i < 4; i++)
+  {
+    bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFF);
+  }
+  out.append(bytes, 4);
+}
+
+//==============================================================================
+void Put64(std::string& out, uint64_t value)
+{
+  Put32(out, static_cast<uint32_t>(value));
+  Put32(out, static_cast<uint32_t>(value >> 32));
+}
+
+} // namespace Compiler
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace Compiler
+{
+// whole file, read-only, mapped to memory where platform allows and read
+// into it elsewhere
+class MappedFile
+{
+public:
+  // throws if file can't be read
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  const unsigned char* GetData() const;
+  size_t GetSize() const;
+
+  // little-endian words at `offset`, throw if they go past the end
+  uint32_t Get32(size_t offset) const;
+  uint64_t Get64(size_t offset) const;
+
+private:
+  const unsigned char* data_{NULL};
+  size_t size_{0};
+  // mapping or file contents where mapping isn't available
+  void* mapping_{NULL};
+  std::vector<unsigned char> contents_;
+};
+
+// appends little-endian words MappedFile reads back
+void Put32(std::string& out, uint32_t value);
+void Put64(std::string& out, uint64_t value);
+
+} // namespace Compiler
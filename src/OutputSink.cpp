@@ -0,0 +1,159 @@
+#include "OutputSink.hpp"
+
+#include <cstring>
+#include <ostream>
+#include <algorithm>
+
+namespace Compiler
+{
+//==============================================================================
+OutputSink::OutputSink(size_t capacity)
+  : buffer_(new char[std::max<size_t>(capacity, 64)])
+  , capacity_(std::max<size_t>(capacity, 64))
+{
+
+}
+
+//==============================================================================
+OutputSink::~OutputSink()
+{
+
+}
+
+//==============================================================================
+void OutputSink::Write(const char* data, size_t size)
+{
+  if (size_ + size > capacity_)
+  {
+    Flush();
+    // too large to be worth copying
+    if (size > capacity_)
+    {
+      Write_(data, size);
+      return;
+    }
+  }
+  std::memcpy(buffer_.get() + size_, data, size);
+  size_ += size;
+}
+
+//==============================================================================
+OutputSink& OutputSink::Fill(char c, size_t count)
+{
+  while (count > 0)
+  {
+    if (size_ == capacity_)
+    {
+      Flush();
+    }
+    size_t n = std::min(count, capacity_ - size_);
+    std::memset(buffer_.get() + size_, c, n);
+    size_ += n;
+    count -= n;
+  }
+  return *this;
+}
+
+//==============================================================================
+OutputSink& OutputSink::WriteHex(unsigned long long value)
+{
+  char digits[16];
+  char* p = digits + sizeof(digits);
+  do
+  {
+    *--p = "0123456789abcdef"[value & 0xF];
+    value >>= 4;
+  }
+  while (value != 0);
+  Write(p, digits + sizeof(digits) - p);
+  return *this;
+}
+
+//==============================================================================
+OutputSink& OutputSink::WriteHexDump(const void* data, size_t size)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; i++)
+  {
+    char digits[2] = {"0123456789ABCDEF"[bytes[i] >> 4], "0123456789ABCDEF"[bytes[i] & 0xF]};
+    Write(digits, 2);
+  }
+  return *this;
+}
+
+//==============================================================================
+OutputSink& OutputSink::operator<<(char c)
+{
+  if (size_ == capacity_)
+  {
+    Flush();
+  }
+  buffer_[size_++] = c;
+  return *this;
+}
+
+//==============================================================================
+OutputSink& OutputSink::operator<<(const char* text)
+{
+  Write(text, std::strlen(text));
+  return *this;
+}
+
+//==============================================================================
+OutputSink& OutputSink::operator<<(const std::string& text)
+{
+  Write(text.data(), text.size());
+  return *this;
+}
+
+//==============================================================================
+void OutputSink::Flush()
+{
+  if (size_ > 0)
+  {
+    // buffer is empty even if write throws, so destructor doesn't retry
+    size_t size = size_;
+    size_ = 0;
+    Write_(buffer_.get(), size);
+  }
+}
+
+//==============================================================================
+void OutputSink::WriteDecimal_(unsigned long long magnitude, bool negative)
+{
+  char digits[21];
+  char* p = digits + sizeof(digits);
+  do
+  {
+    *--p = static_cast<char>('0' + magnitude % 10);
+    magnitude /= 10;
+  }
+  while (magnitude != 0);
+  if (negative)
+  {
+    *--p = '-';
+  }
+  Write(p, digits + sizeof(digits) - p);
+}
+
+//==============================================================================
+StreamOutputSink::StreamOutputSink(std::ostream& out, size_t capacity)
+  : OutputSink(capacity)
+  , out_(out)
+{
+
+}
+
+//==============================================================================
+StreamOutputSink::~StreamOutputSink()
+{
+  Flush();
+}
+
+//==============================================================================
+void StreamOutputSink::Write_(const char* data, size_t size)
+{
+  out_.write(data, size);
+}
+
+} // namespace Compiler
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <memory>
+#include <iosfwd>
+#include <type_traits>
+
+namespace Compiler
+{
+// text output formatted into a large buffer, which goes to destination in
+// one write when it fills up and on Flush; derived sinks flush on
+// destruction, formatting never flushes on its own as std::endl does
+class OutputSink
+{
+public:
+  explicit OutputSink(size_t capacity = 1 << 20);
+  virtual ~OutputSink();
+
+  OutputSink(const OutputSink&) = delete;
+  OutputSink& operator=(const OutputSink&) = delete;
+
+  void Write(const char* data, size_t size);
+  // `count` copies of `c`
+  OutputSink& Fill(char c, size_t count);
+  // lowercase digits, no prefix
+  OutputSink& WriteHex(unsigned long long value);
+  // two uppercase digits per byte, as HexDump
+  OutputSink& WriteHexDump(const void* data, size_t size);
+
+  OutputSink& operator<<(char c);
+  OutputSink& operator<<(const char* text);
+  OutputSink& operator<<(const std::string& text);
+
+  // decimal, without going through locale as streams do
+  template <typename T>
+  typename std::enable_if<std::is_integral<T>::value
+                          && !std::is_same<T, char>::value
+                          && !std::is_same<T, bool>::value, OutputSink&>::type
+  operator<<(T value)
+  {
+    bool negative = std::is_signed<T>::value && value < T(0);
+    // negated as unsigned, so the most negative value works too
+    unsigned long long magnitude = static_cast<unsigned long long>(value);
+    WriteDecimal_(negative ? 0ull - magnitude : magnitude, negative);
+    return *this;
+  }
+
+  // writes buffered text to destination
+  void Flush();
+
+protected:
+  virtual void Write_(const char* data, size_t size) = 0;
+
+private:
+  // not zeroed, so small outputs don't pay for large capacity
+  std::unique_ptr<char[]> buffer_;
+  size_t capacity_;
+  size_t size_{0};
+
+  void WriteDecimal_(unsigned long long magnitude, bool negative);
+};
+
+// writes to stream, for callers which give one
+class StreamOutputSink : public OutputSink
+{
+public:
+  explicit StreamOutputSink(std::ostream& out, size_t capacity = 1 << 20);
+  virtual ~StreamOutputSink();
+
+protected:
+  virtual void Write_(const char* data, size_t size);
+
+private:
+  std::ostream& out_;
+};
+
+} // namespace Compiler
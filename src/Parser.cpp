@@ -11,15 +11,16 @@
 
 #include "utils.hpp"
 #include "prettyPrinting.hpp"
+#include "OutputSink.hpp"
+#include "TimeReport.hpp"
+#include "Trace.hpp"
 
 namespace Compiler
 {
 //==============================================================================
-Parser* theParser = NULL;
-
-Parser::Parser()
+Parser::Parser(std::ostream& out)
+  : out_(out)
 {
-  theParser = this;
   // environment
   shared_ptr<SymbolTable> internalSymbols = make_shared<SymbolTable>(EScopeType::INTERNAL);
   symTables_.push_back(internalSymbols);
@@ -493,7 +494,7 @@ shared_ptr<ASTNode> Parser::ParsePostfixExpression_(CallerType& caller)
       while (token == OP_INC
              || token == OP_DEC)
       {
-        node = make_shared<ASTNodeUnaryOperator>(token, node);
+        node = make_shared<ASTNodeUnaryOperator>(token, node, true);
         token = TakeToken_(caller);
       }
       break;
@@ -1041,6 +1042,13 @@ shared_ptr<SymbolStruct> Parser::ParseStructSpecifier_(Parser::CallerType& calle
     {
       ThrowError_("redefinition of type " + tagToken.text + ", type is alreade complete");
     }
+    // fields are set once definition starts, so it's nested in its own
+    // definition or in one which failed
+    if (symStruct->HasFields())
+    {
+      ThrowError_("redefinition of type " + tagToken.text + ", type is being defined");
+    }
+    OnSymbolDefinition_(symStruct);
 
     shared_ptr<SymbolTableWithOrder> fieldsSymTable = make_shared<SymbolTableWithOrder>(EScopeType::STRUCTURE);
     symStruct->SetFieldsSymTable(fieldsSymTable);
@@ -1087,36 +1095,68 @@ void Parser::ParseTranslationUnit_(CallerType& caller)
 {
   shared_ptr<Symbol> symbol = NULL;
   Token token = TakeTokenIf_(caller, TT_EOF);
+  size_t symTableCount = symTables_.size();
 
   while (token != TT_EOF)
   {
-    symbol = ParseDeclaration_(caller);
-    if (symbol != NULL) // ? nullptr ?
+    try
     {
-      shared_ptr<SymbolVariable> symFun = static_pointer_cast<SymbolVariable>(symbol);
-      // allowing recursive calls
-      AddFunction_(symFun);
-      symFun = LookupFunction(symFun->name);
-      shared_ptr<SymbolFunctionType> symType = static_pointer_cast<SymbolFunctionType>(symFun->GetRefSymbol());
-      symTables_.push_back(symType->GetSymbolTable());
-      // at this point symbol has ESymbolType::VARIABLE of type ESymbolType::TYPE_FUNCTION
-      // and `{` already eaten
-
-      if (symType->GetBody() != NULL)
+      symbol = ParseDeclaration_(caller);
+      if (symbol != NULL) // ? nullptr ?
       {
-        // TODO: invalid error message because token here is a return type of function beging redeclared
-        // we need to pass somehow column and line of a function declaration through symbol variable
-        ThrowInvalidTokenError(token, "redefinition of " + symFun->GetQualifiedName());
+        shared_ptr<SymbolVariable> symFun = static_pointer_cast<SymbolVariable>(symbol);
+        // allowing recursive calls
+        AddFunction_(symFun);
+        symFun = LookupFunction(symFun->name);
+        shared_ptr<SymbolFunctionType> symType = static_pointer_cast<SymbolFunctionType>(symFun->GetRefSymbol());
+        symTables_.push_back(symType->GetSymbolTable());
+        // at this point symbol has ESymbolType::VARIABLE of type ESymbolType::TYPE_FUNCTION
+        // and `{` already eaten
+
+        if (symType->GetBody() != NULL)
+        {
+          // TODO: invalid error message because token here is a return type of function beging redeclared
+          // we need to pass somehow column and line of a function declaration through symbol variable
+          ThrowInvalidTokenError(token, "redefinition of " + symFun->GetQualifiedName());
+        }
+        else
+        {
+          OnSymbolDefinition_(symFun);
+          // spans tokens body is made of as they come
+          Trace::Scope span("parse", symFun->name);
+          symType->SetBody(ParseCompoundStatement_(caller));
+        }
+        symTables_.pop_back();
+        // code of broken program is not generated
+        if (errors_.empty())
+        {
+          OnFunctionDefinition_(symFun);
+        }
       }
-      else
+      OnExternalDeclarationParsed_();
+    }
+    catch (std::logic_error&)
+    {
+      if (!recoverErrors_)
       {
-        symType->SetBody(ParseCompoundStatement_(caller));
+        OnParseError_();
+        throw;
       }
-      symTables_.pop_back();
+      RecordError_();
+      symTables_.resize(symTableCount);
+      nodeStack_.clear();
+      iterationStatementStack_.clear();
+      localDeclarations_.clear();
+      SkipToBoundary_(caller, 0);
     }
 
     token = TakeTokenIf_(caller, TT_EOF);
   }
+  if (!errors_.empty())
+  {
+    throw boost::enable_current_exception(CompileErrorList(errors_));
+  }
+  OnTranslationUnitParsed_();
   // globals
   Flush();
 }
@@ -1129,17 +1169,43 @@ shared_ptr<CompoundStatement> Parser::ParseCompoundStatement_(CallerType& caller
   shared_ptr<CompoundStatement> compoundStatement = make_shared<CompoundStatement>(symTable);
 
   Token token = TakeTokenIf_(caller, OP_RBRACE);
+  int depth = GetBraceDepth_();
+  size_t symTableCount = symTables_.size();
+  size_t nodeCount = nodeStack_.size();
+  size_t iterationCount = iterationStatementStack_.size();
 
   while (token != OP_RBRACE)
   {
-    if (IsDeclarationSpecifier_(token))
+    try
     {
-      // shall return NULL here
-      ParseDeclaration_(caller);
+      if (IsDeclarationSpecifier_(token))
+      {
+        // shall return NULL here
+        ParseDeclaration_(caller);
+        for (auto& variable : localDeclarations_)
+        {
+          compoundStatement->AddDeclaration(variable);
+        }
+        localDeclarations_.clear();
+      }
+      else
+      {
+        compoundStatement->AddStatement(ParseStatement_(caller));
+      }
     }
-    else
+    catch (std::logic_error&)
     {
-      compoundStatement->AddStatement(ParseStatement_(caller));
+      if (!recoverErrors_)
+      {
+        throw;
+      }
+      // statement is dropped
+      RecordError_();
+      symTables_.resize(symTableCount);
+      nodeStack_.resize(nodeCount);
+      iterationStatementStack_.resize(iterationCount);
+      localDeclarations_.clear();
+      SkipToBoundary_(caller, depth);
     }
 
     token = TakeTokenIf_(caller, OP_RBRACE);
@@ -1233,6 +1299,11 @@ shared_ptr<ForStatement> Parser::ParseForStatement_(Parser::CallerType& caller)
     {
       tokenStack_.push_back(token);
       ParseDeclaration_(caller);
+      for (auto& variable : localDeclarations_)
+      {
+        forStatement->AddDeclaration(variable);
+      }
+      localDeclarations_.clear();
     }
     else
     {
@@ -1458,9 +1529,141 @@ void Parser::ThrowError_(const std::string& descriptionText)
   throw std::logic_error(descriptionText);
 }
 
+//==============================================================================
+void Parser::RecordError_()
+{
+  if (errors_.empty())
+  {
+    OnParseError_();
+  }
+  try
+  {
+    throw;
+  }
+  catch (CompileError& e)
+  {
+    if (errors_.empty() || errors_.back().what() != std::string(e.what())
+        || errors_.back().GetLine() != e.GetLine() || errors_.back().GetColumn() != e.GetColumn())
+    {
+      errors_.push_back(e);
+    }
+  }
+  catch (std::logic_error& e)
+  {
+    errors_.push_back(CompileError(e.what(), lastLine_, lastColumn_, lastEndColumn_));
+  }
+}
+
+//==============================================================================
+void Parser::SkipToBoundary_(CallerType& caller, int depth)
+{
+  int current = GetBraceDepth_();
+  if (depth > 0 && current < depth)
+  {
+    // failed statement took `}` of the block
+    tokenStack_.push_back(Token(OP_RBRACE, "}"));
+    return;
+  }
+  // stray `}` outside of any block makes it negative
+  current = std::max(current, 0);
+  // error is found at the end of statement or block, nothing to skip;
+  // `;` put back is taken, `}` is left for the block it closes
+  if (current == depth && (lastType_ == OP_SEMICOLON || lastType_ == OP_RBRACE))
+  {
+    if (lastType_ == OP_SEMICOLON && !tokenStack_.empty() && tokenStack_.back() == OP_SEMICOLON)
+    {
+      tokenStack_.pop_back();
+    }
+    return;
+  }
+
+  while (true)
+  {
+    Token token = TakeToken_(caller);
+    if (token == TT_EOF || (token == OP_RBRACE && current == depth && depth > 0))
+    {
+      tokenStack_.push_back(token);
+      return;
+    }
+    if (token == OP_LBRACE)
+    {
+      current++;
+    }
+    else if (token == OP_RBRACE)
+    {
+      // stray `}` outside of any block is dropped
+      current = std::max(current - 1, 0);
+      if (current == depth)
+      {
+        return;
+      }
+    }
+    else if (token == OP_SEMICOLON && current == depth)
+    {
+      return;
+    }
+  }
+}
+
+//==============================================================================
+int Parser::GetBraceDepth_() const
+{
+  int depth = braceDepth_;
+  for (auto& token : tokenStack_)
+  {
+    depth -= token == OP_LBRACE ? 1 : (token == OP_RBRACE ? -1 : 0);
+  }
+  return depth;
+}
+
+//==============================================================================
+void Parser::SetErrorRecovery(bool recover)
+{
+  recoverErrors_ = recover;
+}
+
+//==============================================================================
+void Parser::RethrowWithRecoveredErrors() const
+{
+  if (errors_.empty())
+  {
+    throw;
+  }
+  std::vector<CompileError> errors = errors_;
+  try
+  {
+    throw;
+  }
+  catch (CompileErrorList&)
+  {
+    throw;
+  }
+  catch (CompileError& e)
+  {
+    errors.push_back(e);
+  }
+  catch (std::exception& e)
+  {
+    errors.push_back(CompileError(e.what(), 0, 0));
+  }
+  throw CompileErrorList(errors);
+}
+
 //==============================================================================
 void Parser::ResumeParse_(const Token& token)
 {
+  // parse runs in coroutine between tokens, so it is timed from here
+  TimeReport::Scope scope(TimeReport::EPhase::PARSE);
+  TimeReport::Count(TimeReport::ECounter::TOKENS);
+  receivedTokenCount_++;
+  if (token == OP_LBRACE)
+  {
+    braceDepth_++;
+  }
+  else if (token == OP_RBRACE && braceDepth_ > 0)
+  {
+    braceDepth_--;
+  }
   parseCoroutine_(token);
 }
 
@@ -1478,6 +1681,10 @@ Token Parser::TakeToken_(CallerType& caller)
     token = tokenStack_.back();
     tokenStack_.pop_back();
   }
+  lastType_ = token.type;
+  lastLine_ = token.line;
+  lastColumn_ = token.column;
+  lastEndColumn_ = token.GetEndColumn();
   return token;
 }
 
@@ -1503,10 +1710,66 @@ Token Parser::TakeTokenIf_(Parser::CallerType& caller, bool condition)
   return token;
 }
 
+//==============================================================================
+void Parser::OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun)
+{
+  UNUSED(symFun);
+}
+
+//==============================================================================
+void Parser::OnTranslationUnitParsed_()
+{
+
+}
+
+//==============================================================================
+void Parser::OnExternalDeclarationParsed_()
+{
+
+}
+
+//==============================================================================
+void Parser::OnParseError_()
+{
+
+}
+
+//==============================================================================
+void Parser::OnGlobalSymbolAdded_(shared_ptr<Symbol> symbol, const std::string& name)
+{
+  UNUSED(symbol);
+  UNUSED(name);
+}
+
+//==============================================================================
+void Parser::OnSymbolDefinition_(shared_ptr<Symbol> symbol)
+{
+  UNUSED(symbol);
+}
+
+//==============================================================================
+size_t Parser::GetConsumedTokenCount_() const
+{
+  return receivedTokenCount_ - tokenStack_.size();
+}
+
+//==============================================================================
+void Parser::RestoreGlobalSymbols(const std::vector<GlobalSymbol>& symbols, int anonymousCount)
+{
+  assert(receivedTokenCount_ == 0);
+  for (auto& global : symbols)
+  {
+    AddGlobalSymbol(*GetGlobalSymbolTable(), global.name, global.symbol);
+    OnGlobalSymbolAdded_(global.symbol, global.name);
+  }
+  anonymousGenerator_ = anonymousCount;
+}
+
 //==============================================================================
 void Parser::Flush() const
 {
-  PrintSymbolTable(symTables_[1].get());
+  StreamOutputSink out(out_);
+  PrintSymbolTable(symTables_[1].get(), out);
 }
 
 //==============================================================================
@@ -1598,6 +1861,10 @@ void Parser::AddType_(shared_ptr<SymbolType> symType, const std::string& name)
   }
 
   symbols->AddType(symType, name);
+  if (symbols == GetGlobalSymbolTable())
+  {
+    OnGlobalSymbolAdded_(symType, name);
+  }
 }
 
 //==============================================================================
@@ -1621,6 +1888,16 @@ void Parser::AddVariable_(shared_ptr<SymbolVariable> symVar)
   }
 
   symbols->AddVariable(symVar);
+  if (symbols == GetGlobalSymbolTable())
+  {
+    OnGlobalSymbolAdded_(symVar, symVar->name);
+  }
+
+  if (symbols->GetScopeType() == EScopeType::BLOCK
+      || symbols->GetScopeType() == EScopeType::LOOP)
+  {
+    localDeclarations_.push_back(symVar);
+  }
 }
 
 //==============================================================================
@@ -1644,6 +1921,7 @@ void Parser::AddFunction_(shared_ptr<SymbolVariable> symFun)
     else
     {
       symbols->AddFunction(symFun);
+      OnGlobalSymbolAdded_(symFun, symFun->name);
     }
   }
   else
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <iostream>
 #include <vector>
 #include <queue>
 #include <functional>
@@ -57,13 +58,47 @@ protected:
 
   std::vector<shared_ptr<ASTNode>> stringTable_;
 
+  // called once function body is parsed, before next external declaration
+  virtual void OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun);
+  // called once whole translation unit is parsed, right before Flush
+  virtual void OnTranslationUnitParsed_();
+  // called after each external declaration
+  virtual void OnExternalDeclarationParsed_();
+  // called on first syntax or type error, before it leaves parser or is
+  // recovered from
+  virtual void OnParseError_();
+  // called for every symbol put to global scope under `name`
+  virtual void OnGlobalSymbolAdded_(shared_ptr<Symbol> symbol, const std::string& name);
+  // called right before struct gets its fields or function its body,
+  // symbol may come from earlier external declaration
+  virtual void OnSymbolDefinition_(shared_ptr<Symbol> symbol);
+
+  // tokens taken by parse so far, lookahead excluded
+  size_t GetConsumedTokenCount_() const;
+
+  // numbers anonymous structs and parameters
+  int anonymousGenerator_{0};
+
 private:
   std::vector<Token> tokenStack_;
   std::vector<shared_ptr<ASTNode>> nodeStack_;
   std::vector<shared_ptr<IterationStatement>> iterationStatementStack_;
   Coroutine parseCoroutine_;
   std::vector<shared_ptr<SymbolTable>> symTables_;
-  int anonymousGenerator_{0};
+  // block and loop scope variables declared by last ParseDeclaration_ call
+  std::vector<shared_ptr<SymbolVariable>> localDeclarations_;
+  size_t receivedTokenCount_{0};
+  std::ostream& out_;
+  // error recovery
+  bool recoverErrors_{false};
+  std::vector<CompileError> errors_;
+  // of tokens received so far, pushed back ones included
+  int braceDepth_{0};
+  // the last token taken, position is for errors which don't name one
+  ETokenType lastType_{TT_INVALID};
+  unsigned lastLine_{0};
+  unsigned lastColumn_{0};
+  unsigned lastEndColumn_{0};
 
   // expressions
   shared_ptr<ASTNode> ParsePrimaryExpression_(CallerType& caller);
@@ -108,6 +143,15 @@ private:
   shared_ptr<ExpressionStatement> ParseExpressionStatement_(CallerType& caller);
 
   void ThrowError_(const std::string& descriptionText);
+  // keeps error being handled, the same one at the same place only once,
+  // as a block which ends at end of file reports it for each enclosing one
+  void RecordError_();
+  // panic mode: drops tokens up to `;` at brace depth `depth` or `}` which
+  // brings it back there, both taken; `}` closing the block at `depth` and
+  // end of file are left for the block to end on
+  void SkipToBoundary_(CallerType& caller, int depth);
+  // brace depth right before the next token to be taken
+  int GetBraceDepth_() const;
   void ResumeParse_(const Token& token);
   Token TakeToken_(CallerType& caller);
 
@@ -142,11 +186,21 @@ private:
   }
 
 public:
-  Parser();
+  // symbol tables are printed to `out` on Flush
+  explicit Parser(std::ostream& out);
   virtual ~Parser();
 
   virtual void Flush() const;
 
+  // on error parse skips to the end of statement or external declaration
+  // and goes on, functions are no longer defined; errors are thrown together
+  // as CompileErrorList at end of file, off by default
+  void SetErrorRecovery(bool recover);
+  // must be called from catch: rethrows exception which ended parse early,
+  // tokenizer error for one, as CompileErrorList with errors recovered from
+  // before it, or as it is if there were none
+  void RethrowWithRecoveredErrors() const;
+
   virtual void EmitInvalid(
       const string& source,
       const int line,
@@ -193,6 +247,11 @@ public:
   shared_ptr<SymbolVariable> LookupVariable(const std::string& name) const;
   shared_ptr<SymbolVariable> LookupFunction(const std::string& name) const;
 
+  // adds `symbols` to global scope in order and numbers anonymous names
+  // after `anonymousCount`, as if declarations which made them were parsed,
+  // must come before the first token
+  void RestoreGlobalSymbols(const std::vector<GlobalSymbol>& symbols, int anonymousCount);
+
 };
 
 } // namespace Compiler
@@ -0,0 +1,282 @@
+#include "PeepholeOptimizer.hpp"
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <cassert>
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  int Log2(int value)
+  {
+    if (value <= 0 || (value & (value - 1)) != 0)
+    {
+      return -1;
+    }
+    int result = 0;
+    while (value > 1)
+    {
+      value >>= 1;
+      result++;
+    }
+    return result;
+  }
+
+  bool IsMov(const AsmInstruction& instruction)
+  {
+    return instruction.Is(EAsmMnemonic::MOV)
+        && instruction.arguments.size() == 2;
+  }
+
+} // namespace
+
+//==============================================================================
+// rules are applied in table order, first match wins
+// all of them preserve register and memory state; flags are preserved too,
+// except for `add/sub x, 0` removal, code generator never branches on those
+const std::vector<PeepholeRule> peepholeRules =
+{
+  // add x, 0 / sub x, 0
+  {"add-sub-zero", 1, [](const AsmInstruction* w, AsmCode&)
+  {
+    return (w[0].Is(EAsmMnemonic::ADD) || w[0].Is(EAsmMnemonic::SUB))
+        && w[0].arguments[1].IsImmediate(0);
+  }},
+
+  // imul r, r, 2^k -> shl r, k
+  {"multiply-to-shift", 1, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    const AsmInstruction& i = w[0];
+    if (!i.Is(EAsmMnemonic::IMUL)
+        || i.arguments.size() != 3
+        || i.arguments[0] != i.arguments[1]
+        || !i.arguments[2].IsImmediate())
+    {
+      return false;
+    }
+    int shift = Log2(i.arguments[2].value);
+    if (shift < 0)
+    {
+      return false;
+    }
+    if (shift > 0)
+    {
+      replacement.push_back(AsmInstruction(EAsmMnemonic::SHL, i.arguments[0], AsmArgument(shift)));
+    }
+    return true;
+  }},
+
+  // cmp r, 0 -> test r, r
+  {"compare-zero-to-test", 1, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    const AsmInstruction& i = w[0];
+    if (!i.Is(EAsmMnemonic::CMP)
+        || !i.arguments[0].IsRegister()
+        || !i.arguments[1].IsImmediate(0))
+    {
+      return false;
+    }
+    replacement.push_back(AsmInstruction(EAsmMnemonic::TEST, i.arguments[0], i.arguments[0]));
+    return true;
+  }},
+
+  // push r / pop r
+  {"push-pop-same", 2, [](const AsmInstruction* w, AsmCode&)
+  {
+    return w[0].Is(EAsmMnemonic::PUSH)
+        && w[1].Is(EAsmMnemonic::POP)
+        && w[0].arguments[0].IsRegister()
+        && w[0].arguments[0] == w[1].arguments[0];
+  }},
+
+  // push a / mov a, x / pop b -> mov b, a / mov a, x
+  // value is passed through register instead of stack
+  {"push-load-pop", 3, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    if (!w[0].Is(EAsmMnemonic::PUSH)
+        || !IsMov(w[1])
+        || !w[2].Is(EAsmMnemonic::POP)
+        || !w[0].arguments[0].IsRegister()
+        || w[0].arguments[0] != w[1].arguments[0])
+    {
+      return false;
+    }
+    const AsmArgument& a = w[0].arguments[0];
+    const AsmArgument& b = w[2].arguments[0];
+    const AsmArgument& x = w[1].arguments[1];
+    if (!b.IsRegister()
+        || b.UsesRegister(a.reg)
+        || x.UsesRegister(b.reg)
+        || x.UsesRegister(EAsmRegister::ESP))
+    {
+      return false;
+    }
+    replacement.push_back(AsmInstruction(EAsmMnemonic::MOV, b, a));
+    replacement.push_back(w[1]);
+    return true;
+  }},
+
+  // mov a, b / mov b, a -> mov a, b
+  {"redundant-move-back", 2, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    if (!IsMov(w[0])
+        || !IsMov(w[1])
+        || w[0].arguments[0] != w[1].arguments[1]
+        || w[0].arguments[1] != w[1].arguments[0])
+    {
+      return false;
+    }
+    // memory operand must not be addressed through overwritten register
+    const AsmArgument& a = w[0].arguments[0];
+    const AsmArgument& b = w[0].arguments[1];
+    if ((a.IsRegister() && b.UsesRegister(a.reg) && b.IsMemory())
+        || (b.IsRegister() && a.UsesRegister(b.reg) && a.IsMemory()))
+    {
+      return false;
+    }
+    replacement.push_back(w[0]);
+    return true;
+  }},
+
+  // mov r, x / mov r, y -> mov r, y, if y does not read r
+  {"overwritten-move", 2, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    if (!IsMov(w[0])
+        || !IsMov(w[1])
+        || !w[0].arguments[0].IsRegister()
+        || w[0].arguments[0] != w[1].arguments[0]
+        || w[1].arguments[1].UsesRegister(w[0].arguments[0].reg))
+    {
+      return false;
+    }
+    replacement.push_back(w[1]);
+    return true;
+  }},
+
+  // jmp L / L:
+  {"jump-to-next", 2, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    if (!w[0].Is(EAsmMnemonic::JMP)
+        || !w[1].IsLabel(w[0].arguments[0].symbol))
+    {
+      return false;
+    }
+    replacement.push_back(w[1]);
+    return true;
+  }},
+
+  // jmp/ret followed by instructions unreachable until next label
+  {"unreachable-code", 2, [](const AsmInstruction* w, AsmCode& replacement)
+  {
+    if (!w[0].IsUnconditionalTransfer()
+        || w[1].IsLabel())
+    {
+      return false;
+    }
+    replacement.push_back(w[0]);
+    return true;
+  }},
+};
+
+//==============================================================================
+PeepholeOptimizer::PeepholeOptimizer(const std::vector<PeepholeRule>& rules)
+  : rules_(rules)
+  , hits_(rules.size(), 0)
+{
+  for (auto& rule : rules_)
+  {
+    maxWindowSize_ = std::max(maxWindowSize_, rule.windowSize);
+  }
+}
+
+//==============================================================================
+void PeepholeOptimizer::Optimize(AsmCode& code)
+{
+  instructionsBefore_ += code.size();
+
+  size_t i = 0;
+  while (i < code.size())
+  {
+    bool applied = false;
+    for (size_t r = 0; r < rules_.size(); r++)
+    {
+      const PeepholeRule& rule = rules_[r];
+      if (i + rule.windowSize > code.size())
+      {
+        continue;
+      }
+
+      AsmCode replacement;
+      if (rule.rewrite(&code[i], replacement))
+      {
+        code.erase(code.begin() + i, code.begin() + i + rule.windowSize);
+        code.insert(code.begin() + i, replacement.begin(), replacement.end());
+        hits_[r]++;
+        applied = true;
+        break;
+      }
+    }
+
+    if (applied)
+    {
+      // replacement may complete a pattern with preceding instructions
+      i = i >= maxWindowSize_ - 1 ? i - (maxWindowSize_ - 1) : 0;
+    }
+    else
+    {
+      i++;
+    }
+  }
+
+  instructionsAfter_ += code.size();
+}
+
+//==============================================================================
+void PeepholeOptimizer::AddStatistics(const PeepholeOptimizer& optimizer)
+{
+  assert(optimizer.hits_.size() == hits_.size());
+  for (size_t i = 0; i < hits_.size(); i++)
+  {
+    hits_[i] += optimizer.hits_[i];
+  }
+  instructionsBefore_ += optimizer.instructionsBefore_;
+  instructionsAfter_ += optimizer.instructionsAfter_;
+}
+
+//==============================================================================
+const std::vector<PeepholeRule>& PeepholeOptimizer::GetRules() const
+{
+  return rules_;
+}
+
+//==============================================================================
+const std::vector<unsigned>& PeepholeOptimizer::GetHits() const
+{
+  return hits_;
+}
+
+//==============================================================================
+void PeepholeOptimizer::PrintStatistics(std::ostream& out) const
+{
+  using namespace std;
+
+  size_t width = 0;
+  for (auto& rule : rules_)
+  {
+    width = max(width, rule.name.size());
+  }
+
+  out << "peephole rule hits:" << endl;
+  for (size_t i = 0; i < rules_.size(); i++)
+  {
+    out << "  " << left << setw(width) << rules_[i].name
+        << "  " << right << hits_[i] << endl;
+  }
+  out << "instructions: " << instructionsBefore_
+      << " -> " << instructionsAfter_ << endl;
+}
+
+} // namespace Compiler
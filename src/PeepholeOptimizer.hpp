@@ -0,0 +1,47 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <iosfwd>
+
+#include "AsmInstruction.hpp"
+
+namespace Compiler
+{
+// rewrite rule over a window of consecutive instructions
+// `rewrite` returns true and fills replacement if the window matches
+struct PeepholeRule
+{
+  std::string name;
+  unsigned windowSize;
+  std::function<bool(const AsmInstruction* window, AsmCode& replacement)> rewrite;
+};
+
+// default rules, see PeepholeOptimizer.cpp
+extern const std::vector<PeepholeRule> peepholeRules;
+
+class PeepholeOptimizer
+{
+public:
+  PeepholeOptimizer(const std::vector<PeepholeRule>& rules = peepholeRules);
+
+  // slides windows over the code and rewrites it until no rule applies
+  void Optimize(AsmCode& code);
+
+  const std::vector<PeepholeRule>& GetRules() const;
+  // hit count of each rule, indexed same as GetRules()
+  const std::vector<unsigned>& GetHits() const;
+  void PrintStatistics(std::ostream& out) const;
+  // adds hit and instruction counts of optimizer with the same rules
+  void AddStatistics(const PeepholeOptimizer& optimizer);
+
+private:
+  std::vector<PeepholeRule> rules_;
+  std::vector<unsigned> hits_;
+  unsigned maxWindowSize_{1};
+  unsigned instructionsBefore_{0};
+  unsigned instructionsAfter_{0};
+};
+
+} // namespace Compiler
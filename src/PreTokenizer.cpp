@@ -5,6 +5,8 @@
 #include "constants.hpp"
 #include "utils.hpp"
 #include "unicode.hpp"
+#include "TimeReport.hpp"
+#include "Trace.hpp"
 
 namespace Compiler
 {
@@ -36,6 +38,8 @@ PreTokenizer::PreTokenizer(const std::vector<char> &input, IPreTokenStream &outp
 //==============================================================================
 void PreTokenizer::DecodeUTF_()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::DECODE);
+  Trace::Scope span("decode");
   int codePoint = 0;
   int* i = source_;
   int* j = source_;
@@ -54,6 +58,8 @@ void PreTokenizer::DecodeUTF_()
 //==============================================================================
 void PreTokenizer::ProcessTrigraphs_()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TRIGRAPHS);
+  Trace::Scope span("trigraphs");
   int* i = source_;
   int* j = source_;
   while (i[0] != EndOfFile)
@@ -74,11 +80,14 @@ void PreTokenizer::ProcessTrigraphs_()
     j++;
   }
   j[0] = EndOfFile;
+  sourceSize_ = j - source_ + 1;
 }
 
 //==============================================================================
 void PreTokenizer::ProcessSplicing_()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::SPLICING);
+  Trace::Scope span("splicing");
   int* i = source_;
   int* j = source_;
   while (i[0] != EndOfFile)
@@ -93,11 +102,14 @@ void PreTokenizer::ProcessSplicing_()
     j++;
   }
   j[0] = EndOfFile;
+  sourceSize_ = j - source_ + 1;
 }
 
 //==============================================================================
 void PreTokenizer::Process_()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::PRETOKENIZE);
+  Trace::Scope span("pretokenize");
   while (state_ != TS_FINISHED)
   {
     int* where = source_ + pos_;
@@ -117,12 +129,14 @@ void PreTokenizer::Process_()
       //==============================================================================
       else if (MatchPrefix("//", where))
       {
+        whitespaceSequenceBegin_ = pos_;
         pos_ += 2;
         state_ = TS_COMMENT;
       }
       //==============================================================================
       else if (MatchPrefix("/*", where))
       {
+        whitespaceSequenceBegin_ = pos_;
         state_ = TS_INLINE_COMMENT;
         pos_ += 2;
       }
@@ -271,10 +285,17 @@ void PreTokenizer::Process_()
         pos_++;
       }
       //==============================================================================
-      else if (MatchPrefix("/*", where)
-               || MatchPrefix("//", where))
+      else if (MatchPrefix("//", where))
       {
-        state_ = TS_START;
+        // comment is part of whitespace sequence
+        pos_ += 2;
+        state_ = TS_COMMENT;
+      }
+      //==============================================================================
+      else if (MatchPrefix("/*", where))
+      {
+        state_ = TS_INLINE_COMMENT;
+        pos_ += 2;
       }
       //==============================================================================
       else if (c == '\n')
@@ -0,0 +1,695 @@
+#include "PrecompiledDeclarations.hpp"
+
+#include <iostream>
+#include <fstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "Parser.hpp"
+#include "CompileCache.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const char magic[] = "CPCH";
+  // bumped when records change
+  const uint32_t version = 1;
+
+  // header fields by offset, everything is little-endian
+  enum HeaderOffset
+  {
+    HO_MAGIC = 0,
+    HO_VERSION = 4,
+    HO_PREFIX_SIZE = 8,
+    HO_PREFIX_HASH = 16,
+    HO_PREFIX_LINES = 24,
+    HO_ANONYMOUS_COUNT = 28,
+    HO_PARSE_MICROSECONDS = 32,
+    HO_SYMBOL_COUNT = 36,
+    HO_TABLE_COUNT = 40,
+    HO_ENTRY_COUNT = 44,
+    HO_GLOBAL_COUNT = 48,
+    HO_STRINGS_SIZE = 52,
+    HEADER_SIZE = 56,
+  };
+
+  // records follow header in this order, sizes are in 32-bit words
+  // symbol: type, flags, name, referenced symbol, array element count or
+  // variable offset or table of fields or parameters
+  const size_t symbolWords = 5;
+  // table: scope, first entry, entry count
+  const size_t tableWords = 3;
+  // entry: section, name, symbol
+  const size_t entryWords = 3;
+  // global: name, symbol
+  const size_t globalWords = 2;
+
+  // no symbol or table
+  const uint32_t none = 0xFFFFFFFF;
+
+  enum SymbolFlag
+  {
+    // builtin, found by name in parser restoring it
+    SF_INTERNAL = 1,
+    SF_COMPLETE = 2,
+  };
+
+  enum EntrySection
+  {
+    ES_ORDERED_VARIABLE,
+    ES_VARIABLE,
+    ES_TYPE,
+    ES_FUNCTION,
+  };
+
+  bool IsBuiltin(ESymbolType type)
+  {
+    return type == ESymbolType::TYPE_VOID
+        || type == ESymbolType::TYPE_FLOAT
+        || type == ESymbolType::TYPE_INT
+        || type == ESymbolType::TYPE_CHAR;
+  }
+
+  bool IsRef(ESymbolType type)
+  {
+    return type == ESymbolType::VARIABLE
+        || type == ESymbolType::TYPE_FUNCTION
+        || type == ESymbolType::TYPE_POINTER
+        || type == ESymbolType::TYPE_ARRAY
+        || type == ESymbolType::TYPE_CONST
+        || type == ESymbolType::TYPE_TYPEDEF;
+  }
+
+  // symbol tables with these scopes are SymbolTableWithOrder
+  bool IsOrdered(EScopeType scope)
+  {
+    return scope == EScopeType::PARAMETERS || scope == EScopeType::STRUCTURE;
+  }
+
+  void ThrowMalformed()
+  {
+    throw std::runtime_error("malformed precompiled declarations");
+  }
+
+  //==============================================================================
+  // records global symbols of declarations parsed, refuses everything
+  // which would need more than symbols to be restored
+  class DeclarationRecorder : public Parser
+  {
+  public:
+    std::vector<GlobalSymbol> globals;
+
+    // prints nothing, Flush is empty
+    DeclarationRecorder()
+      : Parser(std::cout)
+    {
+
+    }
+
+    int GetAnonymousCount() const
+    {
+      return anonymousGenerator_;
+    }
+
+    bool HasStrings() const
+    {
+      return !stringTable_.empty();
+    }
+
+    const SymbolTable& GetInternalSymbols() const
+    {
+      return *GetInternalSymbolTable();
+    }
+
+    virtual void Flush() const
+    {
+
+    }
+
+  protected:
+    virtual void OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun)
+    {
+      throw std::runtime_error("function " + symFun->name
+                               + " is defined, only declarations can be precompiled");
+    }
+
+    virtual void OnGlobalSymbolAdded_(shared_ptr<Symbol> symbol, const std::string& name)
+    {
+      globals.push_back({name, symbol});
+    }
+  };
+
+  //==============================================================================
+  // numbers symbols and tables in order they are reached from globals
+  class GraphWriter
+  {
+  public:
+    explicit GraphWriter(const SymbolTable& internal)
+    {
+      for (auto& type : internal.types)
+      {
+        internal_.insert(type.second.get());
+      }
+      for (auto& variable : internal.variables)
+      {
+        internal_.insert(variable.second.get());
+      }
+    }
+
+    void AddGlobal(const GlobalSymbol& global)
+    {
+      Put32(globals_, GetString_(global.name));
+      Put32(globals_, Add_(global.symbol));
+      globalCount_++;
+      // everything global refers to is numbered and written
+      while (written_ < symbols_.size() || writtenTables_ < tables_.size())
+      {
+        while (written_ < symbols_.size())
+        {
+          WriteSymbol_(*symbols_[written_++]);
+        }
+        while (writtenTables_ < tables_.size())
+        {
+          WriteTable_(*tables_[writtenTables_++]);
+        }
+      }
+    }
+
+    size_t GetSymbolCount() const
+    {
+      return symbols_.size();
+    }
+
+    // header counts and records after them
+    void Serialize(std::string& out) const
+    {
+      Put32(out, symbols_.size());
+      Put32(out, tables_.size());
+      Put32(out, entryCount_);
+      Put32(out, globalCount_);
+      Put32(out, strings_.size());
+      out += symbolRecords_;
+      out += tableRecords_;
+      out += entries_;
+      out += globals_;
+      out += strings_;
+    }
+
+  private:
+    std::unordered_set<const Symbol*> internal_;
+    std::unordered_map<const Symbol*, uint32_t> symbolIndices_;
+    std::unordered_map<const SymbolTable*, uint32_t> tableIndices_;
+    std::unordered_map<std::string, uint32_t> stringOffsets_;
+    std::vector<const Symbol*> symbols_;
+    std::vector<const SymbolTable*> tables_;
+    size_t written_{0};
+    size_t writtenTables_{0};
+    uint32_t entryCount_{0};
+    uint32_t globalCount_{0};
+    std::string symbolRecords_;
+    std::string tableRecords_;
+    std::string entries_;
+    std::string globals_;
+    std::string strings_;
+
+    uint32_t Add_(const shared_ptr<Symbol>& symbol)
+    {
+      auto found = symbolIndices_.find(symbol.get());
+      if (found != symbolIndices_.end())
+      {
+        return found->second;
+      }
+      uint32_t index = symbols_.size();
+      symbolIndices_[symbol.get()] = index;
+      symbols_.push_back(symbol.get());
+      return index;
+    }
+
+    uint32_t AddTable_(const shared_ptr<SymbolTable>& table)
+    {
+      auto found = tableIndices_.find(table.get());
+      if (found != tableIndices_.end())
+      {
+        return found->second;
+      }
+      uint32_t index = tables_.size();
+      tableIndices_[table.get()] = index;
+      tables_.push_back(table.get());
+      return index;
+    }
+
+    uint32_t GetString_(const std::string& text)
+    {
+      auto found = stringOffsets_.find(text);
+      if (found != stringOffsets_.end())
+      {
+        return found->second;
+      }
+      uint32_t offset = strings_.size();
+      strings_ += text;
+      strings_ += '\0';
+      stringOffsets_[text] = offset;
+      return offset;
+    }
+
+    // symbols are written in order they are numbered
+    void WriteSymbol_(const Symbol& symbol)
+    {
+      ESymbolType type = symbol.GetType();
+      uint32_t flags = 0;
+      uint32_t ref = none;
+      uint32_t extra = none;
+      if (internal_.count(&symbol) > 0)
+      {
+        flags |= SF_INTERNAL;
+      }
+      else if (IsRef(type))
+      {
+        const SymbolTypeRef& symRef = static_cast<const SymbolTypeRef&>(symbol);
+        ref = Add_(symRef.GetRefSymbol());
+        if (type == ESymbolType::VARIABLE)
+        {
+          const SymbolVariable& symVar = static_cast<const SymbolVariable&>(symbol);
+          if (!symVar.GetInitializers().empty())
+          {
+            throw std::runtime_error("variable " + symVar.name
+                                     + " is initialized, only declarations can be precompiled");
+          }
+          extra = static_cast<uint32_t>(symVar.offset);
+        }
+        else if (type == ESymbolType::TYPE_FUNCTION)
+        {
+          extra = AddTable_(static_cast<const SymbolFunctionType&>(symbol).GetSymbolTable());
+        }
+        else if (type == ESymbolType::TYPE_ARRAY)
+        {
+          extra = static_cast<const SymbolArray&>(symbol).GetElementCount();
+        }
+      }
+      else if (type == ESymbolType::TYPE_STRUCT)
+      {
+        const SymbolStruct& symStruct = static_cast<const SymbolStruct&>(symbol);
+        // struct which is only declared has no fields table
+        if (symStruct.complete)
+        {
+          flags |= SF_COMPLETE;
+          extra = AddTable_(symStruct.GetSymbolTable());
+        }
+      }
+
+      Put32(symbolRecords_, static_cast<uint32_t>(type));
+      Put32(symbolRecords_, flags);
+      Put32(symbolRecords_, GetString_(symbol.name));
+      Put32(symbolRecords_, ref);
+      Put32(symbolRecords_, extra);
+    }
+
+    void WriteTable_(const SymbolTable& table)
+    {
+      Put32(tableRecords_, static_cast<uint32_t>(table.GetScopeType()));
+      Put32(tableRecords_, entryCount_);
+      uint32_t first = entryCount_;
+      if (IsOrdered(table.GetScopeType()))
+      {
+        for (auto& variable : static_cast<const SymbolTableWithOrder&>(table).orderedVariables)
+        {
+          WriteEntry_(ES_ORDERED_VARIABLE, variable->name, variable);
+        }
+      }
+      else
+      {
+        for (auto& variable : table.variables)
+        {
+          WriteEntry_(ES_VARIABLE, variable.first, variable.second);
+        }
+      }
+      for (auto& type : table.types)
+      {
+        WriteEntry_(ES_TYPE, type.first, type.second);
+      }
+      for (auto& function : table.functions)
+      {
+        WriteEntry_(ES_FUNCTION, function.first, function.second);
+      }
+      Put32(tableRecords_, entryCount_ - first);
+    }
+
+    void WriteEntry_(EntrySection section, const std::string& name, shared_ptr<Symbol> symbol)
+    {
+      Put32(entries_, section);
+      Put32(entries_, GetString_(name));
+      Put32(entries_, Add_(symbol));
+      entryCount_++;
+    }
+  };
+
+} // namespace
+
+//==============================================================================
+PrecompiledDeclarations::PrecompiledDeclarations(const std::string& path)
+  : file_(path)
+{
+  Validate_();
+}
+
+//==============================================================================
+double PrecompiledDeclarations::Write(const std::vector<char>& prefix, const std::string& path)
+{
+  using namespace std;
+
+  // rest of unit is tokenized on its own, so no token may go on past prefix
+  size_t size = prefix.size();
+  if (size > 0
+      && (prefix[size - 1] != '\n'
+          || (size > 1 && prefix[size - 2] == '\\')
+          || (size > 3 && prefix[size - 2] == '/' && prefix[size - 3] == '?' && prefix[size - 4] == '?')))
+  {
+    throw runtime_error("text to precompile must end with a line break");
+  }
+
+  auto start = chrono::steady_clock::now();
+  DeclarationRecorder recorder;
+  {
+    Tokenizer tokenizer(recorder);
+    PreTokenizer pretokenizer(prefix, tokenizer);
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  if (recorder.HasStrings())
+  {
+    throw runtime_error("string literals can't be precompiled");
+  }
+
+  GraphWriter graph(recorder.GetInternalSymbols());
+  for (auto& global : recorder.globals)
+  {
+    graph.AddGlobal(global);
+  }
+
+  uint32_t lineCount = 0;
+  for (char c : prefix)
+  {
+    lineCount += c == '\n';
+  }
+
+  string out(magic, 4);
+  Put32(out, version);
+  Put64(out, size);
+  Put64(out, CompileCache::Hash(prefix.data(), size));
+  Put32(out, lineCount);
+  Put32(out, recorder.GetAnonymousCount());
+  Put32(out, static_cast<uint32_t>(seconds * 1e6));
+  graph.Serialize(out);
+
+  ofstream file(path, ios::binary);
+  file.write(out.data(), out.size());
+  if (!file)
+  {
+    throw runtime_error("can't write " + path);
+  }
+  return seconds;
+}
+
+//==============================================================================
+bool PrecompiledDeclarations::IsPrefixOf(const std::vector<char>& input) const
+{
+  size_t prefixSize = GetPrefixSize();
+  return input.size() >= prefixSize
+      && CompileCache::Hash(input.data(), prefixSize) == file_.Get64(HO_PREFIX_HASH);
+}
+
+//==============================================================================
+std::vector<char> PrecompiledDeclarations::GetRest(const std::vector<char>& input) const
+{
+  std::vector<char> rest(file_.Get32(HO_PREFIX_LINES), '\n');
+  rest.insert(rest.end(), input.begin() + GetPrefixSize(), input.end());
+  return rest;
+}
+
+//==============================================================================
+void PrecompiledDeclarations::Restore(Parser& parser) const
+{
+  using namespace std;
+
+  size_t symbolCount = file_.Get32(HO_SYMBOL_COUNT);
+  size_t tableCount = file_.Get32(HO_TABLE_COUNT);
+  size_t entryCount = file_.Get32(HO_ENTRY_COUNT);
+  size_t globalCount = file_.Get32(HO_GLOBAL_COUNT);
+  size_t symbolsOffset = HEADER_SIZE;
+  size_t tablesOffset = symbolsOffset + symbolCount * symbolWords * 4;
+  size_t entriesOffset = tablesOffset + tableCount * tableWords * 4;
+  size_t globalsOffset = entriesOffset + entryCount * entryWords * 4;
+
+  // tables come first, function types and structs are made with theirs
+  vector<shared_ptr<SymbolTable>> tables(tableCount);
+  for (size_t i = 0; i < tableCount; i++)
+  {
+    uint32_t scope = file_.Get32(tablesOffset + i * tableWords * 4);
+    if (scope > static_cast<uint32_t>(EScopeType::LOOP) || scope == 0)
+    {
+      ThrowMalformed();
+    }
+    EScopeType scopeType = static_cast<EScopeType>(scope);
+    if (IsOrdered(scopeType))
+    {
+      tables[i] = make_shared<SymbolTableWithOrder>(scopeType);
+    }
+    else
+    {
+      tables[i] = make_shared<SymbolTable>(scopeType);
+    }
+  }
+  auto getOrderedTable = [&](uint32_t index, EScopeType scope)
+  {
+    if (index >= tableCount || tables[index]->GetScopeType() != scope)
+    {
+      ThrowMalformed();
+    }
+    return static_pointer_cast<SymbolTableWithOrder>(tables[index]);
+  };
+
+  vector<shared_ptr<Symbol>> symbols(symbolCount);
+  for (size_t i = 0; i < symbolCount; i++)
+  {
+    size_t record = symbolsOffset + i * symbolWords * 4;
+    uint32_t type = file_.Get32(record);
+    uint32_t flags = file_.Get32(record + 4);
+    string name = GetString_(file_.Get32(record + 8));
+    uint32_t extra = file_.Get32(record + 16);
+    if (type > static_cast<uint32_t>(ESymbolType::VARIABLE))
+    {
+      ThrowMalformed();
+    }
+
+    ESymbolType symbolType = static_cast<ESymbolType>(type);
+    shared_ptr<Symbol> symbol;
+    if (IsBuiltin(symbolType) || (flags & SF_INTERNAL) != 0)
+    {
+      if (symbolType == ESymbolType::VARIABLE)
+      {
+        symbol = parser.LookupVariable(name);
+      }
+      else
+      {
+        symbol = parser.LookupType(name);
+      }
+      if (symbol == NULL || symbol->GetType() != symbolType)
+      {
+        ThrowMalformed();
+      }
+      symbols[i] = symbol;
+      continue;
+    }
+
+    switch (symbolType)
+    {
+    case ESymbolType::VARIABLE:
+    {
+      shared_ptr<SymbolVariable> symVar = make_shared<SymbolVariable>(name);
+      symVar->offset = static_cast<int>(extra);
+      symbol = symVar;
+      break;
+    }
+
+    case ESymbolType::TYPE_FUNCTION:
+      symbol = make_shared<SymbolFunctionType>(getOrderedTable(extra, EScopeType::PARAMETERS));
+      break;
+
+    case ESymbolType::TYPE_STRUCT:
+    {
+      shared_ptr<SymbolStruct> symStruct = make_shared<SymbolStruct>(name);
+      if ((flags & SF_COMPLETE) != 0)
+      {
+        symStruct->SetFieldsSymTable(getOrderedTable(extra, EScopeType::STRUCTURE));
+        symStruct->complete = true;
+      }
+      symbol = symStruct;
+      break;
+    }
+
+    case ESymbolType::TYPE_POINTER:
+      symbol = make_shared<SymbolPointer>();
+      break;
+
+    case ESymbolType::TYPE_ARRAY:
+    {
+      shared_ptr<SymbolArray> symArray = make_shared<SymbolArray>();
+      if (extra != 0)
+      {
+        symArray->SetElementCount(extra);
+      }
+      symbol = symArray;
+      break;
+    }
+
+    case ESymbolType::TYPE_CONST:
+      symbol = make_shared<SymbolConst>();
+      break;
+
+    case ESymbolType::TYPE_TYPEDEF:
+      symbol = make_shared<SymbolTypedef>(name);
+      break;
+
+    default:
+      ThrowMalformed();
+      break;
+    }
+    symbols[i] = symbol;
+  }
+
+  // references may go either way, struct may point to itself
+  for (size_t i = 0; i < symbolCount; i++)
+  {
+    size_t record = symbolsOffset + i * symbolWords * 4;
+    uint32_t flags = file_.Get32(record + 4);
+    uint32_t ref = file_.Get32(record + 12);
+    if ((flags & SF_INTERNAL) != 0 || !IsRef(symbols[i]->GetType()))
+    {
+      continue;
+    }
+    if (ref >= symbolCount)
+    {
+      ThrowMalformed();
+    }
+    static_pointer_cast<SymbolTypeRef>(symbols[i])->SetRefSymbol(static_pointer_cast<SymbolType>(symbols[ref]));
+  }
+
+  for (size_t i = 0; i < tableCount; i++)
+  {
+    size_t record = tablesOffset + i * tableWords * 4;
+    size_t first = file_.Get32(record + 4);
+    size_t count = file_.Get32(record + 8);
+    if (first > entryCount || count > entryCount - first)
+    {
+      ThrowMalformed();
+    }
+    for (size_t j = first; j < first + count; j++)
+    {
+      size_t entry = entriesOffset + j * entryWords * 4;
+      uint32_t section = file_.Get32(entry);
+      uint32_t index = file_.Get32(entry + 8);
+      if (index >= symbolCount)
+      {
+        ThrowMalformed();
+      }
+      shared_ptr<Symbol> symbol = symbols[index];
+      if (section == ES_TYPE)
+      {
+        tables[i]->AddType(static_pointer_cast<SymbolType>(symbol), GetString_(file_.Get32(entry + 4)));
+        continue;
+      }
+      if (symbol->GetType() != ESymbolType::VARIABLE
+          || (section == ES_ORDERED_VARIABLE) != IsOrdered(tables[i]->GetScopeType()))
+      {
+        ThrowMalformed();
+      }
+      shared_ptr<SymbolVariable> symVar = static_pointer_cast<SymbolVariable>(symbol);
+      if (section == ES_FUNCTION)
+      {
+        tables[i]->AddFunction(symVar);
+      }
+      else
+      {
+        tables[i]->AddVariable(symVar);
+      }
+    }
+  }
+
+  vector<GlobalSymbol> globals(globalCount);
+  for (size_t i = 0; i < globalCount; i++)
+  {
+    size_t record = globalsOffset + i * globalWords * 4;
+    uint32_t index = file_.Get32(record + 4);
+    if (index >= symbolCount)
+    {
+      ThrowMalformed();
+    }
+    globals[i] = {GetString_(file_.Get32(record)), symbols[index]};
+  }
+  parser.RestoreGlobalSymbols(globals, static_cast<int>(file_.Get32(HO_ANONYMOUS_COUNT)));
+}
+
+//==============================================================================
+size_t PrecompiledDeclarations::GetSymbolCount() const
+{
+  return file_.Get32(HO_SYMBOL_COUNT);
+}
+
+//==============================================================================
+size_t PrecompiledDeclarations::GetPrefixSize() const
+{
+  return static_cast<size_t>(file_.Get64(HO_PREFIX_SIZE));
+}
+
+//==============================================================================
+double PrecompiledDeclarations::GetParseSeconds() const
+{
+  return file_.Get32(HO_PARSE_MICROSECONDS) / 1e6;
+}
+
+//==============================================================================
+std::string PrecompiledDeclarations::GetString_(uint32_t offset) const
+{
+  // strings end with zero byte, and so does their block
+  size_t strings = file_.GetSize() - file_.Get32(HO_STRINGS_SIZE);
+  if (offset >= file_.Get32(HO_STRINGS_SIZE))
+  {
+    ThrowMalformed();
+  }
+  return std::string(reinterpret_cast<const char*>(file_.GetData() + strings + offset));
+}
+
+//==============================================================================
+void PrecompiledDeclarations::Validate_() const
+{
+  const unsigned char* data = file_.GetData();
+  size_t size = file_.GetSize();
+  if (size < HEADER_SIZE
+      || std::string(reinterpret_cast<const char*>(data), 4) != std::string(magic, 4))
+  {
+    throw std::runtime_error("not a precompiled declarations file");
+  }
+  if (file_.Get32(HO_VERSION) != version)
+  {
+    throw std::runtime_error("precompiled declarations of other compiler version");
+  }
+
+  uint64_t expected = HEADER_SIZE
+      + 4 * (static_cast<uint64_t>(file_.Get32(HO_SYMBOL_COUNT)) * symbolWords
+             + static_cast<uint64_t>(file_.Get32(HO_TABLE_COUNT)) * tableWords
+             + static_cast<uint64_t>(file_.Get32(HO_ENTRY_COUNT)) * entryWords
+             + static_cast<uint64_t>(file_.Get32(HO_GLOBAL_COUNT)) * globalWords)
+      + file_.Get32(HO_STRINGS_SIZE);
+  if (expected != size
+      || (file_.Get32(HO_STRINGS_SIZE) > 0 && data[size - 1] != '\0'))
+  {
+    ThrowMalformed();
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "SymbolTable.hpp"
+#include "MappedFile.hpp"
+
+namespace Compiler
+{
+class Parser;
+
+// global symbols of a prefix of translation units, made of declarations
+// only, saved so units which start with the same prefix restore them
+// rather than parse it
+// file is symbol graph of fixed size little-endian records, where symbols
+// and symbol tables refer to each other by index, and names are offsets
+// to string block; it is mapped and read in place
+class PrecompiledDeclarations
+{
+public:
+  // maps file at `path`, throws if it can't be read or is malformed
+  explicit PrecompiledDeclarations(const std::string& path);
+
+  // parses `prefix`, which must end with a line break and may hold no
+  // function bodies or initializers, and writes its global symbols to
+  // `path`, returns time parse took
+  static double Write(const std::vector<char>& prefix, const std::string& path);
+
+  // true if `input` starts with text file is made of
+  bool IsPrefixOf(const std::vector<char>& input) const;
+  // `input` with prefix replaced by line breaks, so lines of the rest
+  // are numbered as they are in `input`
+  std::vector<char> GetRest(const std::vector<char>& input) const;
+  // new symbols of file added to global scope of `parser`, which has
+  // got no tokens yet, builtin types are parser's own
+  void Restore(Parser& parser) const;
+
+  size_t GetSymbolCount() const;
+  size_t GetPrefixSize() const;
+  // time parse of prefix took when file was written
+  double GetParseSeconds() const;
+
+private:
+  MappedFile file_;
+
+  std::string GetString_(uint32_t offset) const;
+  // throws if file doesn't hold what header says
+  void Validate_() const;
+};
+
+} // namespace Compiler
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+namespace Compiler
+{
+// lock-free bounded queue for exactly one producer thread and one consumer
+// thread, capacity is rounded up to a power of two
+template <typename T>
+class SpscQueue
+{
+public:
+  explicit SpscQueue(size_t capacity)
+  {
+    size_t size = 1;
+    while (size < capacity)
+    {
+      size *= 2;
+    }
+    slots_.resize(size);
+    mask_ = size - 1;
+  }
+
+  SpscQueue(const SpscQueue&) = delete;
+  SpscQueue& operator=(const SpscQueue&) = delete;
+
+  // producer only, `value` is moved from on success
+  bool TryPush(T& value)
+  {
+    size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size())
+    {
+      return false;
+    }
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+
+  // consumer only
+  bool TryPop(T& value)
+  {
+    size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire))
+    {
+      return false;
+    }
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+private:
+  std::vector<T> slots_;
+  size_t mask_{0};
+  // indices only grow, slot is index & mask_
+  // kept on separate cache lines so threads don't invalidate each other
+  alignas(64) std::atomic<size_t> head_{0};
+  alignas(64) std::atomic<size_t> tail_{0};
+};
+
+} // namespace Compiler
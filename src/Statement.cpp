@@ -22,12 +22,23 @@ void CompoundStatement::AddStatement(shared_ptr<Statement> statement)
   children_.push_back(statement);
 }
 
+void CompoundStatement::AddDeclaration(shared_ptr<SymbolVariable> variable)
+{
+  assert(variable != NULL);
+  declarations_.push_back({static_cast<int>(children_.size()), variable});
+}
+
 shared_ptr<SymbolTable> CompoundStatement::GetSymbolTable() const
 {
   assert(symbols_ != NULL);
   return symbols_;
 }
 
+const std::vector<DeclarationPoint>& CompoundStatement::GetDeclarations() const
+{
+  return declarations_;
+}
+
 ExpressionStatement::ExpressionStatement()
 // (expression-statement) - is too much
   : Statement(Token(OP_SEMICOLON, ";"))
@@ -76,6 +87,11 @@ void JumpStatement::SetRefLoopStatement(shared_ptr<IterationStatement> iteration
   refLoop_ = iterationStatement;
 }
 
+shared_ptr<IterationStatement> JumpStatement::GetRefLoopStatement() const
+{
+  return refLoop_;
+}
+
 SelectionStatement::SelectionStatement()
   : Statement(Token(KW_IF, "if"))
 {
@@ -161,6 +177,17 @@ void ForStatement::SetLoopStatement(shared_ptr<Statement> loopStatement)
   children_.push_back(loopStatement);
 }
 
+void ForStatement::AddDeclaration(shared_ptr<SymbolVariable> variable)
+{
+  assert(variable != NULL);
+  declarations_.push_back({0, variable});
+}
+
+const std::vector<DeclarationPoint>& ForStatement::GetDeclarations() const
+{
+  return declarations_;
+}
+
 DoStatement::DoStatement()
   : IterationStatement(Token(KW_DO, "do"))
 {
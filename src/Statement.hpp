@@ -34,6 +34,14 @@ private:
 
 //==============================================================================
 class SymbolTable;
+class SymbolVariable;
+
+// local variable declared right before statement with index `position`
+struct DeclarationPoint
+{
+  int position;
+  shared_ptr<SymbolVariable> variable;
+};
 
 class CompoundStatement
     : public Statement
@@ -45,11 +53,14 @@ class CompoundStatement
     CompoundStatement(shared_ptr<SymbolTable> symbols);
 
   void AddStatement(shared_ptr<Statement> statement);
+  void AddDeclaration(shared_ptr<SymbolVariable> variable);
   virtual EStatementType GetStatementType() const { return EStatementType::COMPOUND; }
   shared_ptr<SymbolTable> GetSymbolTable() const;
+  const std::vector<DeclarationPoint>& GetDeclarations() const;
 
 private:
   shared_ptr<SymbolTable> symbols_{NULL};
+  std::vector<DeclarationPoint> declarations_;
 
 };
 
@@ -119,9 +130,13 @@ class ForStatement
   virtual void SetControllingExpression(shared_ptr<ASTNode> controllingExpression);
   void SetIterationExpression(shared_ptr<ASTNode> iterationExpression);
   virtual void SetLoopStatement(shared_ptr<Statement> loopStatement);
+  // declarations of clause-1, if any
+  void AddDeclaration(shared_ptr<SymbolVariable> variable);
+  const std::vector<DeclarationPoint>& GetDeclarations() const;
 
 private:
   shared_ptr<SymbolTable> symbols_{NULL};
+  std::vector<DeclarationPoint> declarations_;
 
 };
 
@@ -168,6 +183,7 @@ class JumpStatement
   shared_ptr<ASTNode> GetReturnExpression() const;
   virtual EStatementType GetStatementType() const { return EStatementType::JUMP; }
   void SetRefLoopStatement(shared_ptr<IterationStatement> iterationStatement);
+  shared_ptr<IterationStatement> GetRefLoopStatement() const;
 
 private:
   shared_ptr<IterationStatement> refLoop_{NULL};
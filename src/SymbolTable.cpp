@@ -2,6 +2,7 @@
 
 #include "ASTNode.hpp"
 #include "Statement.hpp"
+#include "TimeReport.hpp"
 
 #include <iostream>
 
@@ -10,7 +11,7 @@ namespace Compiler
 Symbol::Symbol(const std::string& name)
         : name(name)
 {
-
+        TimeReport::Count(TimeReport::ECounter::SYMBOLS);
 }
 
 Symbol::~Symbol()
@@ -85,16 +86,19 @@ void SymbolTable::AddVariable(shared_ptr<SymbolVariable> symbolVariable)
 
 shared_ptr<SymbolVariable> SymbolTable::LookupVariable(const std::string& name) const
 {
+        TimeReport::Count(TimeReport::ECounter::SYMBOL_LOOKUPS);
         return LookupHelper_(variables, name);
 }
 
 shared_ptr<SymbolType> SymbolTable::LookupType(const std::string& name) const
 {
+        TimeReport::Count(TimeReport::ECounter::SYMBOL_LOOKUPS);
         return LookupHelper_(types, name);
 }
 
 shared_ptr<SymbolVariable> SymbolTable::LookupFunction(const std::string& name) const
 {
+        TimeReport::Count(TimeReport::ECounter::SYMBOL_LOOKUPS);
         return LookupHelper_(functions, name);
 }
 
@@ -156,6 +160,11 @@ void SymbolVariable::PushInitializer(shared_ptr<ASTNode> initializer)
         initializers_.push_back(initializer);
 }
 
+const std::vector<shared_ptr<ASTNode>>& SymbolVariable::GetInitializers() const
+{
+        return initializers_;
+}
+
 int SymbolVariable::GetAbsoluteElementCount()
 {
         auto typeSym = GetActualType(shared_from_this());
@@ -377,6 +386,11 @@ shared_ptr<SymbolTableWithOrder> SymbolStruct::GetSymbolTable() const
         return fields_;
 }
 
+bool SymbolStruct::HasFields() const
+{
+        return fields_ != NULL;
+}
+
 void SymbolStruct::SetFieldsSymTable(shared_ptr<SymbolTableWithOrder> fieldsSymTable)
 {
         assert(fieldsSymTable != NULL);
@@ -456,6 +470,11 @@ bool SymbolPointer::IfTypeFits(shared_ptr<Symbol> symbol) const
                && type_->IfTypeFits(static_pointer_cast<SymbolPointer>(symbol)->GetRefSymbol());
 }
 
+int SymbolPointer::GetSize()
+{
+        return 4;
+}
+
 SymbolArray::SymbolArray()
         : SymbolTypeRef("array")
 {
@@ -491,12 +510,18 @@ void SymbolArray::SetSizeInitializer(shared_ptr<ASTNode> initializerExpression)
         }
 }
 
+void SymbolArray::SetElementCount(unsigned elementCount)
+{
+        assert(elementCount > 0);
+        elementCount_ = elementCount;
+}
+
 int SymbolArray::GetSize()
 {
         assert(elementCount_ != 0);
         if (size_ == -1)
         {
-            size_ = elementCount_ * GetArrayType(this->shared_from_this())->GetSize();
+            size_ = elementCount_ * GetActualType(GetRefSymbol())->GetSize();
         }
         return size_;
 }
@@ -526,9 +551,9 @@ std::string SymbolArray::GetQualifiedName() const
 {
         assert(type_ != NULL);
         std::string size;
-        if (sizeInitializer_ != NULL)
+        if (elementCount_ != 0)
         {
-            size = " " + std::to_string(sizeInitializer_->EvalToInt());
+            size = " " + std::to_string(elementCount_);
         }
         return name + size + " of " + type_->GetQualifiedName();
 }
@@ -666,12 +691,38 @@ shared_ptr<SymbolType> SymbolTypeRef::GetRefSymbol() const
         return type_;
 }
 
+//==============================================================================
+bool SymbolTypeRef::HasRefSymbol() const
+{
+        return type_ != NULL;
+}
+
 //==============================================================================
 int SymbolTypeRef::GetSize()
 {
         return GetActualType(const_cast<SymbolTypeRef*>(this)->shared_from_this())->GetSize();
 }
 
+//==============================================================================
+void AddGlobalSymbol(SymbolTable& symbols, const std::string& name, shared_ptr<Symbol> symbol)
+{
+        if (symbol->GetType() != ESymbolType::VARIABLE)
+        {
+            symbols.AddType(static_pointer_cast<SymbolType>(symbol), name);
+            return;
+        }
+
+        shared_ptr<SymbolVariable> symVar = static_pointer_cast<SymbolVariable>(symbol);
+        if (symVar->GetRefSymbol()->GetType() == ESymbolType::TYPE_FUNCTION)
+        {
+            symbols.AddFunction(symVar);
+        }
+        else
+        {
+            symbols.AddVariable(symVar);
+        }
+}
+
 //==============================================================================
 
 bool IfSymbolIsRef(shared_ptr<Symbol> symbol)
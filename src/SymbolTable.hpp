@@ -146,6 +146,8 @@ public:
 
         void SetRefSymbol(shared_ptr<SymbolType> type);
         shared_ptr<SymbolType> GetRefSymbol() const;
+        // false for type of string literal, which is array of nothing
+        bool HasRefSymbol() const;
         int virtual GetSize();
 
 protected:
@@ -164,6 +166,7 @@ public:
         virtual std::string GetQualifiedName() const;
         virtual bool IfTypeFits(shared_ptr<Symbol> symbol) const;
         void PushInitializer(shared_ptr<ASTNode> initializer);
+        const std::vector<shared_ptr<ASTNode>>& GetInitializers() const;
         virtual int GetAbsoluteElementCount();
 
         int offset{-1};
@@ -203,6 +206,7 @@ public:
         virtual std::string GetQualifiedName() const;
         void AddField(shared_ptr<SymbolVariable> field);
         shared_ptr<SymbolTableWithOrder> GetSymbolTable() const;
+        bool HasFields() const;
         void SetFieldsSymTable(shared_ptr<SymbolTableWithOrder> fieldsSymTable);
         virtual bool IfTypeFits(shared_ptr<Symbol> symbol) const;
         int virtual GetSize();
@@ -269,6 +273,7 @@ public:
         virtual ESymbolType GetType() const;
         virtual std::string GetQualifiedName() const;
         virtual bool IfTypeFits(shared_ptr<Symbol> symbol) const;
+        virtual int GetSize();
 
 };
 
@@ -285,6 +290,8 @@ public:
         virtual std::string GetQualifiedName() const;
         virtual bool IfTypeFits(shared_ptr<Symbol> symbol) const;
         void SetSizeInitializer(shared_ptr<ASTNode> initializerExpression);
+        // for arrays restored without their size expression
+        void SetElementCount(unsigned elementCount);
         virtual int GetSize();
         int GetElementCount() const;
         virtual int GetAbsoluteElementCount();
@@ -322,6 +329,17 @@ public:
 
 };
 
+//==============================================================================
+// symbol of global scope with the name it's added under
+struct GlobalSymbol
+{
+        std::string name;
+        shared_ptr<Symbol> symbol;
+};
+
+// adds `symbol` to global scope `symbols` the way parser would
+void AddGlobalSymbol(SymbolTable& symbols, const std::string& name, shared_ptr<Symbol> symbol);
+
 //==============================================================================
 bool IfSymbolIsRef(shared_ptr<Symbol> symbol);
 bool IfInteger(shared_ptr<SymbolType> symbol);
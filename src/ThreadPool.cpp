@@ -0,0 +1,189 @@
+#include "ThreadPool.hpp"
+
+#include <algorithm>
+
+namespace Compiler
+{
+//==============================================================================
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+  if (threadCount == 0)
+  {
+    threadCount = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned i = 0; i < threadCount; i++)
+  {
+    workers_.emplace_back(new Worker);
+  }
+
+  // workers look themselves up in threads_, so it is filled under the lock
+  std::lock_guard<std::mutex> lock(mutex_);
+  threads_.reserve(threadCount);
+  for (unsigned i = 0; i < threadCount; i++)
+  {
+    threads_.emplace_back(&ThreadPool::Run_, this, i);
+  }
+}
+
+//==============================================================================
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stopping_ = true;
+  }
+  wake_.notify_all();
+
+  for (auto& thread : threads_)
+  {
+    thread.join();
+  }
+}
+
+//==============================================================================
+void ThreadPool::Submit(Task task)
+{
+  int index = GetWorkerIndex_();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queued_++;
+    pending_++;
+    if (index < 0)
+    {
+      index = nextWorker_;
+      nextWorker_ = (nextWorker_ + 1) % workers_.size();
+    }
+  }
+
+  {
+    Worker& worker = *workers_[index];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.tasks.push_back(std::move(task));
+  }
+  wake_.notify_one();
+}
+
+//==============================================================================
+void ThreadPool::Wait()
+{
+  std::unique_lock<std::mutex> lock(mutex_);
+  done_.wait(lock, [this] { return pending_ == 0; });
+
+  if (exception_)
+  {
+    std::exception_ptr exception = exception_;
+    exception_ = std::exception_ptr();
+    std::rethrow_exception(exception);
+  }
+}
+
+//==============================================================================
+unsigned ThreadPool::GetThreadCount() const
+{
+  return workers_.size();
+}
+
+//==============================================================================
+unsigned ThreadPool::GetStealCount() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  return steals_;
+}
+
+//==============================================================================
+int ThreadPool::GetWorkerIndex_() const
+{
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::thread::id id = std::this_thread::get_id();
+  for (size_t i = 0; i < threads_.size(); i++)
+  {
+    if (threads_[i].get_id() == id)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+//==============================================================================
+bool ThreadPool::Take_(unsigned index, Task& task)
+{
+  {
+    Worker& own = *workers_[index];
+    std::lock_guard<std::mutex> lock(own.mutex);
+    if (!own.tasks.empty())
+    {
+      task = std::move(own.tasks.back());
+      own.tasks.pop_back();
+    }
+  }
+
+  bool stolen = false;
+  for (size_t i = 1; !task && i < workers_.size(); i++)
+  {
+    Worker& victim = *workers_[(index + i) % workers_.size()];
+    std::lock_guard<std::mutex> lock(victim.mutex);
+    if (!victim.tasks.empty())
+    {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      stolen = true;
+    }
+  }
+
+  if (!task)
+  {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  queued_--;
+  steals_ += stolen;
+  return true;
+}
+
+//==============================================================================
+void ThreadPool::Run_(unsigned index)
+{
+  for (;;)
+  {
+    Task task;
+    if (Take_(index, task))
+    {
+      std::exception_ptr exception;
+      try
+      {
+        task();
+      }
+      catch (...)
+      {
+        exception = std::current_exception();
+      }
+      // captured state is released before Wait may return
+      task = Task();
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (exception && !exception_)
+      {
+        exception_ = exception;
+      }
+      if (--pending_ == 0)
+      {
+        done_.notify_all();
+      }
+      continue;
+    }
+
+    // task counted in queued_ may not be pushed to its deque yet,
+    // so waking up with nothing to take is fine
+    std::unique_lock<std::mutex> lock(mutex_);
+    wake_.wait(lock, [this] { return queued_ > 0 || stopping_; });
+    if (stopping_ && queued_ == 0)
+    {
+      return;
+    }
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,68 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+namespace Compiler
+{
+// work-stealing pool: every worker owns a deque, takes its own tasks
+// newest first and steals oldest tasks of other workers when it runs dry
+class ThreadPool
+{
+public:
+  typedef std::function<void()> Task;
+
+  // zero means one worker per hardware thread
+  explicit ThreadPool(unsigned threadCount = 0);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  // task submitted from a worker goes to the worker's own deque,
+  // others are spread over workers round robin
+  void Submit(Task task);
+  // blocks until every submitted task, including the ones submitted by
+  // tasks, is done, rethrows the first exception escaped from a task
+  // must not be called from a worker
+  void Wait();
+
+  unsigned GetThreadCount() const;
+  // tasks taken from deques of other workers
+  unsigned GetStealCount() const;
+
+private:
+  struct Worker
+  {
+    std::deque<Task> tasks;
+    std::mutex mutex;
+  };
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  std::vector<std::thread> threads_;
+
+  // guards everything below
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::condition_variable done_;
+  // submitted and not yet taken by a worker
+  unsigned queued_{0};
+  // submitted and not yet finished
+  unsigned pending_{0};
+  unsigned nextWorker_{0};
+  unsigned steals_{0};
+  bool stopping_{false};
+  std::exception_ptr exception_;
+
+  // -1 if the calling thread is not a worker of this pool
+  int GetWorkerIndex_() const;
+  bool Take_(unsigned index, Task& task);
+  void Run_(unsigned index);
+};
+
+} // namespace Compiler
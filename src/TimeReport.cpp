@@ -0,0 +1,191 @@
+#include "TimeReport.hpp"
+
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+#include <string>
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  const char* phaseNames[] =
+  {
+    "decode",
+    "trigraphs",
+    "splicing",
+    "pretokenize",
+    "tokenize",
+    "parse",
+    "codegen",
+    "output",
+  };
+
+  const char* counterNames[] =
+  {
+    "tokens",
+    "ast nodes",
+    "symbols",
+    "symbol lookups",
+    "allocations",
+  };
+
+  static_assert(sizeof(phaseNames) / sizeof(phaseNames[0])
+                == static_cast<size_t>(TimeReport::EPhase::COUNT), "name every phase");
+  static_assert(sizeof(counterNames) / sizeof(counterNames[0])
+                == static_cast<size_t>(TimeReport::ECounter::COUNT), "name every counter");
+
+  // phase this thread is in, COUNT outside of any, and when it was entered
+  // or its nested phase left
+  thread_local TimeReport::EPhase currentPhase = TimeReport::EPhase::COUNT;
+  thread_local std::chrono::steady_clock::time_point currentStart;
+
+  // "symbol lookups" -> "symbol_lookups"
+  std::string GetJsonKey(const char* name)
+  {
+    std::string key = name;
+    for (char& c : key)
+    {
+      if (c == ' ')
+      {
+        c = '_';
+      }
+    }
+    return key;
+  }
+
+} // namespace
+
+std::atomic<TimeReport*> TimeReport::active_{NULL};
+
+//==============================================================================
+TimeReport::TimeReport()
+  : start_(std::chrono::steady_clock::now())
+{
+  for (auto& n : nanoseconds_)
+  {
+    n = 0;
+  }
+  for (auto& c : counters_)
+  {
+    c = 0;
+  }
+  TimeReport* expected = NULL;
+  if (!active_.compare_exchange_strong(expected, this))
+  {
+    throw std::logic_error("time report is already active");
+  }
+}
+
+//==============================================================================
+TimeReport::~TimeReport()
+{
+  active_ = NULL;
+}
+
+//==============================================================================
+void TimeReport::Scope::Enter_(EPhase phase)
+{
+  auto now = std::chrono::steady_clock::now();
+  if (currentPhase != EPhase::COUNT)
+  {
+    report_->Charge_(currentPhase, now - currentStart);
+  }
+  outer_ = currentPhase;
+  currentPhase = phase;
+  currentStart = now;
+}
+
+//==============================================================================
+void TimeReport::Scope::Leave_()
+{
+  auto now = std::chrono::steady_clock::now();
+  report_->Charge_(currentPhase, now - currentStart);
+  currentPhase = outer_;
+  currentStart = now;
+}
+
+//==============================================================================
+TimeReport::EPhase TimeReport::GetPhase()
+{
+  return currentPhase;
+}
+
+//==============================================================================
+const char* TimeReport::GetPhaseName(EPhase phase)
+{
+  return phaseNames[static_cast<int>(phase)];
+}
+
+//==============================================================================
+void TimeReport::Charge_(EPhase phase, std::chrono::steady_clock::duration duration)
+{
+  nanoseconds_[static_cast<int>(phase)].fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count(),
+        std::memory_order_relaxed);
+}
+
+//==============================================================================
+double TimeReport::GetTotalSeconds_() const
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+}
+
+//==============================================================================
+void TimeReport::PrintTable(std::ostream& out) const
+{
+  using namespace std;
+
+  double total = GetTotalSeconds_();
+  double phases = 0.0;
+  ostringstream text;
+  text << fixed << setprecision(3) << "time report:" << endl;
+  auto row = [&](const char* name, double seconds)
+  {
+    text << "  " << left << setw(16) << name << right
+         << setw(12) << seconds * 1e3 << " ms"
+         << setw(8) << setprecision(1) << (total > 0.0 ? seconds / total * 100.0 : 0.0) << " %"
+         << setprecision(3) << endl;
+  };
+  for (int i = 0; i < static_cast<int>(EPhase::COUNT); i++)
+  {
+    double seconds = nanoseconds_[i] * 1e-9;
+    phases += seconds;
+    row(phaseNames[i], seconds);
+  }
+  // setting up, tearing down, waiting for other thread
+  row("other", max(0.0, total - phases));
+  row("total", total);
+  for (int i = 0; i < static_cast<int>(ECounter::COUNT); i++)
+  {
+    text << "  " << left << setw(16) << counterNames[i] << right
+         << setw(12) << counters_[i] << endl;
+  }
+  out << text.str();
+}
+
+//==============================================================================
+void TimeReport::PrintJson(std::ostream& out) const
+{
+  using namespace std;
+
+  double total = GetTotalSeconds_();
+  ostringstream text;
+  text << fixed << setprecision(3) << "{\"phases_ms\": {";
+  for (int i = 0; i < static_cast<int>(EPhase::COUNT); i++)
+  {
+    text << (i > 0 ? ", " : "") << "\"" << GetJsonKey(phaseNames[i]) << "\": "
+         << nanoseconds_[i] * 1e-6;
+  }
+  text << "}, \"total_ms\": " << total * 1e3 << ", \"counters\": {";
+  for (int i = 0; i < static_cast<int>(ECounter::COUNT); i++)
+  {
+    text << (i > 0 ? ", " : "") << "\"" << GetJsonKey(counterNames[i]) << "\": " << counters_[i];
+  }
+  text << "}}" << endl;
+  out << text.str();
+}
+
+} // namespace Compiler
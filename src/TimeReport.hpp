@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+
+namespace Compiler
+{
+// where compile time goes: time spent in each phase and counts of things
+// compilation makes, recorded from every thread while report is active
+// instrumented places check a single pointer when no report is, so they
+// are left in for good
+class TimeReport
+{
+public:
+  enum class EPhase
+  {
+    // of pretokenizer
+    DECODE,
+    TRIGRAPHS,
+    SPLICING,
+    PRETOKENIZE,
+    TOKENIZE,
+    PARSE,
+    // function code of assembly or bytecode
+    CODEGEN,
+    // Flush of generator
+    OUTPUT,
+    COUNT,
+  };
+
+  enum class ECounter
+  {
+    // passed to parser
+    TOKENS,
+    AST_NODES,
+    SYMBOLS,
+    SYMBOL_LOOKUPS,
+    // operator new calls, counted by AllocationTracker's operator new
+    ALLOCATIONS,
+    COUNT,
+  };
+
+  // time from construction to Print is total, only one report may be
+  // active at a time, throws otherwise
+  TimeReport();
+  ~TimeReport();
+
+  TimeReport(const TimeReport&) = delete;
+  TimeReport& operator=(const TimeReport&) = delete;
+
+  static bool IsActive()
+  {
+    return active_.load(std::memory_order_relaxed) != NULL;
+  }
+
+  static void Count(ECounter counter, uint64_t count = 1)
+  {
+    TimeReport* report = active_.load(std::memory_order_relaxed);
+    if (report != NULL)
+    {
+      report->counters_[static_cast<int>(counter)].fetch_add(count, std::memory_order_relaxed);
+    }
+  }
+
+  // time on this thread from construction to destruction is charged to
+  // `phase`, scopes nested in it are charged to their own phases
+  class Scope
+  {
+  public:
+    explicit Scope(EPhase phase)
+      : report_(active_.load(std::memory_order_relaxed))
+    {
+      if (report_ != NULL)
+      {
+        Enter_(phase);
+      }
+    }
+
+    ~Scope()
+    {
+      if (report_ != NULL)
+      {
+        Leave_();
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    TimeReport* report_;
+    // phase this one is nested in
+    EPhase outer_{EPhase::COUNT};
+
+    void Enter_(EPhase phase);
+    void Leave_();
+  };
+
+  // phase this thread is in, COUNT outside of any or when no report is
+  // active
+  static EPhase GetPhase();
+
+  static const char* GetPhaseName(EPhase phase);
+
+  // phases of different threads overlap, so with --pipeline they may add
+  // up to more than total
+  void PrintTable(std::ostream& out) const;
+  void PrintJson(std::ostream& out) const;
+
+private:
+  static std::atomic<TimeReport*> active_;
+
+  std::chrono::steady_clock::time_point start_;
+  std::atomic<int64_t> nanoseconds_[static_cast<int>(EPhase::COUNT)];
+  std::atomic<uint64_t> counters_[static_cast<int>(ECounter::COUNT)];
+
+  void Charge_(EPhase phase, std::chrono::steady_clock::duration duration);
+  double GetTotalSeconds_() const;
+};
+
+} // namespace Compiler
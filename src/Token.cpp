@@ -1,6 +1,9 @@
 #include "Token.hpp"
 
 #include <sstream>
+#include <ostream>
+
+#include <boost/exception/enable_current_exception.hpp>
 
 #include "utils.hpp"
 
@@ -157,6 +160,21 @@ Token::~Token()
   }
 }
 
+//==============================================================================
+unsigned Token::GetEndColumn() const
+{
+  unsigned endColumn = column;
+  if (type != TT_LITERAL_CHAR_ARRAY)
+  {
+    for (char c : text)
+    {
+      // UTF-8 continuation bytes don't start a code point
+      endColumn += (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+    }
+  }
+  return endColumn;
+}
+
 //==============================================================================
 Compiler::Token::operator const ETokenType&() const
 {
@@ -173,7 +191,44 @@ void ThrowInvalidTokenError(const Token& token, const std::string& descriptionTe
   {
     ss << ", " << descriptionText;
   }
-  throw std::logic_error(ss.str());
+  // parser coroutine rethrows a copy, which would be sliced otherwise
+  throw boost::enable_current_exception(CompileError(ss.str(), token.line, token.column,
+                                                     token.GetEndColumn()));
+}
+
+//==============================================================================
+void PrintDiagnosticsJson(const std::exception& e, std::ostream& out)
+{
+  using namespace std;
+
+  vector<CompileError> errors;
+  if (auto list = dynamic_cast<const CompileErrorList*>(&e))
+  {
+    errors = list->GetErrors();
+  }
+  else if (auto error = dynamic_cast<const CompileError*>(&e))
+  {
+    errors.push_back(*error);
+  }
+  else
+  {
+    errors.push_back(CompileError(e.what(), 0, 0));
+  }
+
+  ostringstream text;
+  text << "{\"diagnostics\": [";
+  for (size_t i = 0; i < errors.size(); i++)
+  {
+    const CompileError& error = errors[i];
+    text << (i > 0 ? "," : "") << "\n  {\"severity\": \"error\", \"message\": ";
+    WriteJsonString(text, error.what());
+    text << ", \"line\": " << error.GetLine() << ", \"column\": " << error.GetColumn()
+         << ", \"range\": {\"start\": {\"line\": " << error.GetLine()
+         << ", \"column\": " << error.GetColumn() << "}, \"end\": {\"line\": "
+         << error.GetLine() << ", \"column\": " << error.GetEndColumn() << "}}}";
+  }
+  text << "\n]}\n";
+  out << text.str();
 }
 
 } // namespace Compiler
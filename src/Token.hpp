@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <iosfwd>
 
 #include "constants.hpp"
 
@@ -26,6 +29,11 @@ struct Token
 
   ~Token();
 
+  // column after the token, counted in code points as columns are; text
+  // of string literal is its value, perhaps of several adjacent ones, not
+  // its source, so its range is empty
+  unsigned GetEndColumn() const;
+
   // !!! GCC bug: non static member initializer doesn't work for
   // union member (in this particular case at least)
   union
@@ -38,6 +46,73 @@ struct Token
   operator const ETokenType& () const;
 };
 
+// error at known position of source, message tells position as well;
+// range of source it is about ends on the same line, at `endColumn`
+class CompileError : public std::logic_error
+{
+public:
+  CompileError(const std::string& message, unsigned line, unsigned column)
+    : CompileError(message, line, column, column)
+  {
+
+  }
+
+  CompileError(const std::string& message, unsigned line, unsigned column, unsigned endColumn)
+    : std::logic_error(message)
+    , line_(line)
+    , column_(column)
+    , endColumn_(endColumn)
+  {
+
+  }
+
+  unsigned GetLine() const
+  {
+    return line_;
+  }
+
+  unsigned GetColumn() const
+  {
+    return column_;
+  }
+
+  unsigned GetEndColumn() const
+  {
+    return endColumn_;
+  }
+
+private:
+  unsigned line_;
+  unsigned column_;
+  unsigned endColumn_;
+};
+
+// every error of a parse which recovered from them, in source order,
+// message is the first one's
+class CompileErrorList : public CompileError
+{
+public:
+  explicit CompileErrorList(const std::vector<CompileError>& errors)
+    : CompileError(errors.at(0))
+    , errors_(errors)
+  {
+
+  }
+
+  const std::vector<CompileError>& GetErrors() const
+  {
+    return errors_;
+  }
+
+private:
+  std::vector<CompileError> errors_;
+};
+
+// throws CompileError at position and text of `token`
 void ThrowInvalidTokenError(const Token &token, const std::string& descriptionText = "");
 
+// {"diagnostics": [...]} of `e`, with every error of CompileErrorList,
+// position is 0 where it's unknown
+void PrintDiagnosticsJson(const std::exception& e, std::ostream& out);
+
 } // namespace Compiler
@@ -0,0 +1,273 @@
+#include "TokenPipeline.hpp"
+
+#include <thread>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+
+namespace Compiler
+{
+namespace
+{
+// thrown on producer thread to unwind it once consumer has failed
+struct PipelineCancelled
+{
+};
+
+} // namespace
+
+//==============================================================================
+void ReplayToken(const PipelinedToken& token, ITokenStream& consumer)
+{
+  switch (token.kind)
+  {
+  case PipelinedToken::INVALID:
+    consumer.EmitInvalid(token.source, token.line, token.column);
+    break;
+
+  case PipelinedToken::KEYWORD:
+    consumer.EmitKeyword(token.source, token.type, token.line, token.column);
+    break;
+
+  case PipelinedToken::PUNCTUATION:
+    consumer.EmitPunctuation(token.source, token.type, token.line, token.column);
+    break;
+
+  case PipelinedToken::IDENTIFIER:
+    consumer.EmitIdentifier(token.source, token.line, token.column);
+    break;
+
+  case PipelinedToken::LITERAL:
+    consumer.EmitLiteral(token.source, token.fundamentalType, token.data.data(),
+                         token.data.size(), token.line, token.column);
+    break;
+
+  case PipelinedToken::LITERAL_ARRAY:
+    consumer.EmitLiteralArray(token.source, token.elementCount, token.fundamentalType,
+                              token.data.data(), token.data.size(),
+                              token.line, token.column);
+    break;
+
+  case PipelinedToken::END_OF_FILE:
+    consumer.EmitEof(token.line, token.column);
+    break;
+
+  case PipelinedToken::DONE:
+  case PipelinedToken::FAILURE:
+    break;
+  }
+}
+
+//==============================================================================
+std::vector<PipelinedToken>& TokenRecorder::GetTokens()
+{
+  return tokens_;
+}
+
+//==============================================================================
+void TokenRecorder::Write_(PipelinedToken& token)
+{
+  tokens_.push_back(std::move(token));
+}
+
+//==============================================================================
+TokenPipeline::TokenPipeline(ITokenStream& consumer, size_t capacity)
+  : consumer_(consumer)
+  , queue_(capacity)
+{
+
+}
+
+//==============================================================================
+void TokenPipeline::Run(const Producer& producer)
+{
+  std::thread producerThread(&TokenPipeline::Produce_, this, std::cref(producer));
+  try
+  {
+    Consume_();
+  }
+  catch (...)
+  {
+    cancelled_ = true;
+    producerThread.join();
+    throw;
+  }
+  producerThread.join();
+}
+
+//==============================================================================
+void TokenPipeline::Produce_(const Producer& producer)
+{
+  PipelinedToken token;
+  try
+  {
+    producer(*this);
+  }
+  catch (PipelineCancelled&)
+  {
+    return;
+  }
+  catch (...)
+  {
+    producerError_ = std::current_exception();
+    token.kind = PipelinedToken::FAILURE;
+  }
+
+  try
+  {
+    Write_(token);
+  }
+  catch (PipelineCancelled&)
+  {
+
+  }
+}
+
+//==============================================================================
+void TokenPipeline::Consume_()
+{
+  PipelinedToken token;
+  for (;;)
+  {
+    while (!queue_.TryPop(token))
+    {
+      std::this_thread::yield();
+    }
+
+    if (token.kind == PipelinedToken::DONE)
+    {
+      return;
+    }
+    if (token.kind == PipelinedToken::FAILURE)
+    {
+      std::rethrow_exception(producerError_);
+    }
+    ReplayToken(token, consumer_);
+  }
+}
+
+//==============================================================================
+void TokenPipeline::Write_(PipelinedToken& token)
+{
+  for (;;)
+  {
+    if (cancelled_)
+    {
+      throw PipelineCancelled();
+    }
+    if (queue_.TryPush(token))
+    {
+      return;
+    }
+    std::this_thread::yield();
+  }
+}
+
+//==============================================================================
+void TokenWriter::EmitInvalid(const string& source, const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::INVALID;
+  token.source = source;
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitKeyword(const string& source, ETokenType token_type,
+                              const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::KEYWORD;
+  token.type = token_type;
+  token.source = source;
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitPunctuation(const string& source, ETokenType token_type,
+                                  const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::PUNCTUATION;
+  token.type = token_type;
+  token.source = source;
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitIdentifier(const string& source, const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::IDENTIFIER;
+  token.source = source;
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitLiteral(const string& source, EFundamentalType type,
+                              const void* data, size_t nbytes,
+                              const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::LITERAL;
+  token.fundamentalType = type;
+  token.source = source;
+  token.data.assign(static_cast<const char*>(data), nbytes);
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitLiteralArray(const string& source, size_t num_elements,
+                                   EFundamentalType type, const void* data,
+                                   size_t nbytes, const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::LITERAL_ARRAY;
+  token.fundamentalType = type;
+  token.elementCount = num_elements;
+  token.source = source;
+  token.data.assign(static_cast<const char*>(data), nbytes);
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void TokenWriter::EmitEof(const int line, const int column)
+{
+  PipelinedToken token;
+  token.kind = PipelinedToken::END_OF_FILE;
+  token.line = line;
+  token.column = column;
+  Write_(token);
+}
+
+//==============================================================================
+void Tokenize(const std::vector<char>& input, ITokenStream& parser, bool pipelined)
+{
+  if (pipelined)
+  {
+    TokenPipeline pipeline(parser);
+    pipeline.Run([&input](ITokenStream& tokens)
+    {
+      Tokenizer tokenizer(tokens);
+      PreTokenizer pretokenizer(input, tokenizer);
+    });
+    return;
+  }
+
+  Tokenizer tokenizer(parser);
+  PreTokenizer pretokenizer(input, tokenizer);
+}
+
+} // namespace Compiler
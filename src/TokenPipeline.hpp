@@ -0,0 +1,119 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <atomic>
+#include <exception>
+
+#include "ITokenStream.hpp"
+#include "SpscQueue.hpp"
+
+namespace Compiler
+{
+// token as it is passed between threads or kept for replaying later,
+// one per ITokenStream call
+struct PipelinedToken
+{
+  enum EKind : unsigned char
+  {
+    INVALID,
+    KEYWORD,
+    PUNCTUATION,
+    IDENTIFIER,
+    LITERAL,
+    LITERAL_ARRAY,
+    END_OF_FILE,
+    // producer has returned or thrown, nothing follows
+    DONE,
+    FAILURE,
+  };
+
+  EKind kind{DONE};
+  ETokenType type{TT_INVALID};
+  EFundamentalType fundamentalType{FT_INT};
+  int line{0};
+  int column{0};
+  size_t elementCount{0};
+  std::string source;
+  // literal value bytes
+  std::string data;
+};
+
+// makes the same call `token` was made of, DONE and FAILURE make none
+void ReplayToken(const PipelinedToken& token, ITokenStream& consumer);
+
+// turns every ITokenStream call into PipelinedToken
+class TokenWriter : public ITokenStream
+{
+public:
+  virtual void EmitInvalid(const string& source, const int line,
+                           const int column);
+  virtual void EmitKeyword(const string& source, ETokenType token_type,
+                           const int line, const int column);
+  virtual void EmitPunctuation(const string& source, ETokenType token_type,
+                               const int line, const int column);
+  virtual void EmitIdentifier(const string& source, const int line,
+                              const int column);
+  virtual void EmitLiteral(const string& source, EFundamentalType type,
+                           const void* data, size_t nbytes, const int line,
+                           const int column);
+  virtual void EmitLiteralArray(const string& source, size_t num_elements,
+                                EFundamentalType type, const void* data,
+                                size_t nbytes, const int line,
+                                const int column);
+  virtual void EmitEof(const int line, const int column);
+
+protected:
+  virtual void Write_(PipelinedToken& token) = 0;
+};
+
+// keeps every token in order
+class TokenRecorder : public TokenWriter
+{
+public:
+  std::vector<PipelinedToken>& GetTokens();
+
+protected:
+  virtual void Write_(PipelinedToken& token);
+
+private:
+  std::vector<PipelinedToken> tokens_;
+};
+
+// front end split in two threads: producer, pretokenizer and tokenizer
+// writing to this stream, runs on its own thread while tokens are replayed
+// to `consumer`, usually a parser, on the calling thread
+class TokenPipeline : public TokenWriter
+{
+public:
+  typedef std::function<void(ITokenStream&)> Producer;
+
+  explicit TokenPipeline(ITokenStream& consumer, size_t capacity = 4096);
+
+  // returns when producer is done and consumer has got every token
+  // error of either side is rethrown, same one as running both on one
+  // thread would throw: whichever comes first in token order
+  void Run(const Producer& producer);
+
+protected:
+  // producer side
+  virtual void Write_(PipelinedToken& token);
+
+private:
+  ITokenStream& consumer_;
+  SpscQueue<PipelinedToken> queue_;
+  // set by consumer on error, producer gives up on next token
+  std::atomic<bool> cancelled_{false};
+  // producer error, published by FAILURE token
+  std::exception_ptr producerError_;
+
+  void Produce_(const Producer& producer);
+  void Consume_();
+};
+
+// feeds tokens of `input` to `parser`, if `pipelined` is set pretokenizer
+// and tokenizer run on their own thread
+void Tokenize(const std::vector<char>& input, ITokenStream& parser, bool pipelined);
+
+} // namespace Compiler
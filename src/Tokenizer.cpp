@@ -6,6 +6,7 @@
 
 #include "unicode.hpp"
 #include "utils.hpp"
+#include "TimeReport.hpp"
 
 namespace Compiler
 {
@@ -46,6 +47,7 @@ void Tokenizer::EmitNewLine()
 //==============================================================================
 void Tokenizer::EmitIdentifier(const int* data, size_t size)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   string utf8Data = UTF8CodePointToString(data, size);
   if (stringToKeywordTypeMap.find(utf8Data) != stringToKeywordTypeMap.end())
@@ -66,6 +68,7 @@ void Tokenizer::EmitIdentifier(const int* data, size_t size)
 //==============================================================================
 void Tokenizer::EmitPpNumber(const string &data)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   DecodeInput_(data);
 
@@ -271,6 +274,7 @@ void Tokenizer::EmitPpNumber(const string &data)
 //==============================================================================
 void Tokenizer::EmitCharacterLiteral(const string &data)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   DecodeInput_(data);
   codePointsCount_ = ReplaceEscapeSequences(codePoints_);
@@ -312,6 +316,7 @@ void Tokenizer::EmitCharacterLiteral(const string &data)
 //==============================================================================
 void Tokenizer::EmitStringLiteral(const string &data)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   DecodeInput_(data);
   StringLiteralRecord r;
   r.data = data;
@@ -339,6 +344,7 @@ void Tokenizer::EmitStringLiteral(const string &data)
 //==============================================================================
 void Tokenizer::EmitPunctuation(const string &data)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   if (stringToPunctuationTypeMap.find(data) != stringToPunctuationTypeMap.end())
   {
@@ -354,6 +360,7 @@ void Tokenizer::EmitPunctuation(const string &data)
 //==============================================================================
 void Tokenizer::EmitNonWhitespaceChar(const string &data)
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   output_.EmitInvalid(data, line_, column_);
   column_++;
@@ -362,6 +369,7 @@ void Tokenizer::EmitNonWhitespaceChar(const string &data)
 //==============================================================================
 void Tokenizer::EmitEof()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
   output_.EmitEof(line_, column_);
 }
@@ -369,6 +377,7 @@ void Tokenizer::EmitEof()
 //==============================================================================
 void Tokenizer::Flush()
 {
+  TimeReport::Scope scope(TimeReport::EPhase::TOKENIZE);
   FlushAdjacentStringLiterals_();
 }
 
@@ -0,0 +1,120 @@
+#include "Trace.hpp"
+
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <stdexcept>
+
+#include "utils.hpp"
+
+namespace Compiler
+{
+//==============================================================================
+namespace
+{
+  // buffer of this thread and generation of trace it belongs to
+  thread_local void* threadBuffer = NULL;
+  thread_local uint64_t threadBufferGeneration = 0;
+
+} // namespace
+
+std::atomic<Trace*> Trace::active_{NULL};
+std::atomic<uint64_t> Trace::generationCounter_{0};
+
+//==============================================================================
+Trace::Trace()
+  : generation_(++generationCounter_)
+  , start_(std::chrono::steady_clock::now())
+{
+  Trace* expected = NULL;
+  if (!active_.compare_exchange_strong(expected, this))
+  {
+    throw std::logic_error("trace is already active");
+  }
+}
+
+//==============================================================================
+Trace::~Trace()
+{
+  active_ = NULL;
+}
+
+//==============================================================================
+void Trace::Scope::Begin_(const char* name, const std::string* detail)
+{
+  ThreadBuffer& buffer = trace_->GetThreadBuffer_();
+  event_ = buffer.events.size();
+  Event event;
+  event.name = name;
+  if (detail != NULL)
+  {
+    event.name += " " + *detail;
+  }
+  event.beginNs = trace_->GetNowNs_();
+  event.endNs = event.beginNs;
+  buffer.events.push_back(std::move(event));
+}
+
+//==============================================================================
+void Trace::Scope::End_()
+{
+  trace_->GetThreadBuffer_().events[event_].endNs = trace_->GetNowNs_();
+}
+
+//==============================================================================
+Trace::ThreadBuffer& Trace::GetThreadBuffer_()
+{
+  if (threadBuffer == NULL || threadBufferGeneration != generation_)
+  {
+    std::lock_guard<std::mutex> lock(buffersMutex_);
+    buffers_.emplace_back(new ThreadBuffer);
+    buffers_.back()->threadIndex = buffers_.size();
+    threadBuffer = buffers_.back().get();
+    threadBufferGeneration = generation_;
+  }
+  return *static_cast<ThreadBuffer*>(threadBuffer);
+}
+
+//==============================================================================
+int64_t Trace::GetNowNs_() const
+{
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+}
+
+//==============================================================================
+void Trace::Write(const std::string& path) const
+{
+  using namespace std;
+
+  ostringstream text;
+  text << fixed << setprecision(3) << "{\"traceEvents\": [";
+  bool first = true;
+  for (auto& buffer : buffers_)
+  {
+    text << (first ? "" : ",") << "\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+         << buffer->threadIndex << ", \"args\": {\"name\": \""
+         << (buffer->threadIndex == 1 ? "main" : "thread " + to_string(buffer->threadIndex))
+         << "\"}}";
+    first = false;
+    // complete events, times in microseconds
+    for (auto& event : buffer->events)
+    {
+      text << ",\n{\"name\": ";
+      WriteJsonString(text, event.name);
+      text << ", \"ph\": \"X\", \"pid\": 1, \"tid\": " << buffer->threadIndex
+           << ", \"ts\": " << event.beginNs * 1e-3
+           << ", \"dur\": " << (event.endNs - event.beginNs) * 1e-3 << "}";
+    }
+  }
+  text << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+  ofstream file(path, ios::binary);
+  file << text.str();
+  if (!file)
+  {
+    throw runtime_error("can't write " + path);
+  }
+}
+
+} // namespace Compiler
@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace Compiler
+{
+// timeline of compilation in trace event format chrome://tracing and
+// Perfetto open: span of each phase, function body parsed and function
+// generated, on the thread it ran on
+// every thread appends to a buffer of its own, buffers are only put
+// together by Write, when no trace is active spans check a single pointer
+class Trace
+{
+public:
+  // only one trace may be active at a time, throws otherwise
+  Trace();
+  ~Trace();
+
+  Trace(const Trace&) = delete;
+  Trace& operator=(const Trace&) = delete;
+
+  // span from construction to destruction, `name` is phase, `detail`,
+  // if given, what it works on, function name usually
+  class Scope
+  {
+  public:
+    explicit Scope(const char* name)
+      : trace_(active_.load(std::memory_order_relaxed))
+    {
+      if (trace_ != NULL)
+      {
+        Begin_(name, NULL);
+      }
+    }
+
+    Scope(const char* name, const std::string& detail)
+      : trace_(active_.load(std::memory_order_relaxed))
+    {
+      if (trace_ != NULL)
+      {
+        Begin_(name, &detail);
+      }
+    }
+
+    ~Scope()
+    {
+      if (trace_ != NULL)
+      {
+        End_();
+      }
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+  private:
+    Trace* trace_;
+    // event of this span in buffer of its thread
+    size_t event_{0};
+
+    void Begin_(const char* name, const std::string* detail);
+    void End_();
+  };
+
+  // writes spans of every thread to `path`, threads which made them have
+  // to be done by now, throws if file can't be written
+  void Write(const std::string& path) const;
+
+private:
+  struct Event
+  {
+    std::string name;
+    // since trace start
+    int64_t beginNs;
+    int64_t endNs;
+  };
+
+  struct ThreadBuffer
+  {
+    // in order threads first made span
+    unsigned threadIndex;
+    std::vector<Event> events;
+  };
+
+  static std::atomic<Trace*> active_;
+  // tells this trace from earlier one which was at the same address
+  static std::atomic<uint64_t> generationCounter_;
+
+  uint64_t generation_;
+  std::chrono::steady_clock::time_point start_;
+  std::mutex buffersMutex_;
+  std::vector<std::unique_ptr<ThreadBuffer>> buffers_;
+
+  // buffer of calling thread, made on first span
+  ThreadBuffer& GetThreadBuffer_();
+  int64_t GetNowNs_() const;
+};
+
+} // namespace Compiler
@@ -1,47 +1,1344 @@
 #include "codegen.hpp"
 
+#include <iostream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <cctype>
+
+#include "ThreadPool.hpp"
+#include "TimeReport.hpp"
+#include "Trace.hpp"
+#include "OutputSink.hpp"
+
 namespace Compiler
 {
+//==============================================================================
+namespace
+{
+  const AsmArgument eax(EAsmRegister::EAX);
+  const AsmArgument ecx(EAsmRegister::ECX);
+  const AsmArgument edx(EAsmRegister::EDX);
+  const AsmArgument esp(EAsmRegister::ESP);
+  const AsmArgument ebp(EAsmRegister::EBP);
+  const AsmArgument al(EAsmRegister::AL);
+  const AsmArgument cl(EAsmRegister::CL);
+
+  const std::unordered_map<int, EAsmMnemonic> comparisonToSet =
+  {
+    {OP_EQ, EAsmMnemonic::SETE},
+    {OP_NE, EAsmMnemonic::SETNE},
+    {OP_LT, EAsmMnemonic::SETL},
+    {OP_LE, EAsmMnemonic::SETLE},
+    {OP_GT, EAsmMnemonic::SETG},
+    {OP_GE, EAsmMnemonic::SETGE},
+  };
+
+  // labels of separately generated function are numbered from 1,
+  // `$LN3` with base 10 becomes `$LN13`
+  void RebaseLabel(std::string& name, const std::string& prefix, int base)
+  {
+    if (name.size() > prefix.size()
+        && name.compare(0, prefix.size(), prefix) == 0
+        && isdigit(name[prefix.size()]))
+    {
+      name = prefix + std::to_string(std::stoi(name.substr(prefix.size())) + base);
+    }
+  }
+
+  void RebaseLabels(AsmCode& code, int labelBase, int formatBase)
+  {
+    for (auto& instruction : code)
+    {
+      for (auto& argument : instruction.arguments)
+      {
+        RebaseLabel(argument.symbol, "$LN", labelBase);
+        RebaseLabel(argument.symbol, "$SGprint", formatBase);
+      }
+    }
+  }
+
+} // namespace
+
+//==============================================================================
+int RoundUpTo4(int size)
+{
+  return size + (4 - size % 4) * (size % 4 != 0);
+}
+
+//==============================================================================
+bool IfPointerLike(shared_ptr<SymbolType> type)
+{
+  return IfOfType(type, ESymbolType::TYPE_POINTER)
+      || IfOfType(type, ESymbolType::TYPE_ARRAY);
+}
+
+//==============================================================================
+int ElementSize(shared_ptr<SymbolType> type)
+{
+  shared_ptr<SymbolType> refType = GetActualType(GetRefSymbol(GetActualType(type)));
+  if (refType->GetType() == ESymbolType::TYPE_VOID)
+  {
+    return 1;
+  }
+  return refType->GetSize();
+}
+
+//==============================================================================
+int FieldOffset(shared_ptr<SymbolType> structType, const std::string& name)
+{
+  shared_ptr<SymbolStruct> symStruct = static_pointer_cast<SymbolStruct>(GetActualType(structType));
+  int offset = 0;
+  for (auto& field : symStruct->GetSymbolTable()->orderedVariables)
+  {
+    if (field->name == name)
+    {
+      return offset;
+    }
+    offset += RoundUpTo4(GetActualType(field)->GetSize());
+  }
+  assert(false);
+  return -1;
+}
+
+//==============================================================================
+void CollectInitializerSlots(shared_ptr<SymbolType> type, int offset,
+                             std::vector<std::pair<int, shared_ptr<SymbolType>>>& slots)
+{
+  shared_ptr<SymbolType> actualType = GetActualType(type);
+  switch (actualType->GetType())
+  {
+  case ESymbolType::TYPE_ARRAY:
+  {
+    shared_ptr<SymbolArray> symArray = static_pointer_cast<SymbolArray>(actualType);
+    shared_ptr<SymbolType> elementType = symArray->GetRefSymbol();
+    int elementSize = GetActualType(elementType)->GetSize();
+    for (int i = 0; i < symArray->GetElementCount(); i++)
+    {
+      CollectInitializerSlots(elementType, offset + i * elementSize, slots);
+    }
+    break;
+  }
+
+  case ESymbolType::TYPE_STRUCT:
+  {
+    shared_ptr<SymbolStruct> symStruct = static_pointer_cast<SymbolStruct>(actualType);
+    int fieldOffset = 0;
+    for (auto& field : symStruct->GetSymbolTable()->orderedVariables)
+    {
+      CollectInitializerSlots(field->GetRefSymbol(), offset + fieldOffset, slots);
+      fieldOffset += RoundUpTo4(GetActualType(field)->GetSize());
+    }
+    break;
+  }
+
+  default:
+    slots.push_back({offset, type});
+  }
+}
+
+//==============================================================================
+FunctionCodeGenerator::FunctionCodeGenerator(shared_ptr<SymbolVariable> symFun,
+                                             shared_ptr<SymbolTable> globalSymbols,
+                                             shared_ptr<SymbolTable> internalSymbols,
+                                             const StringLabels& stringLabels,
+                                             CodeGenContext& context)
+  : symFun_(symFun)
+  , stringLabels_(stringLabels)
+  , context_(context)
+{
+  scopes_.push_back(internalSymbols.get());
+  scopes_.push_back(globalSymbols.get());
+}
+
+//==============================================================================
+AsmCode FunctionCodeGenerator::Generate()
+{
+  shared_ptr<SymbolFunctionType> symType = static_pointer_cast<SymbolFunctionType>(symFun_->GetRefSymbol());
+  shared_ptr<SymbolTableWithOrder> parameters = symType->GetSymbolTable();
+  scopes_.push_back(parameters.get());
+
+  // cdecl: arguments are above return address and saved ebp
+  int offset = 8;
+  for (auto& parameter : parameters->orderedVariables)
+  {
+    if (IfOfType(parameter, ESymbolType::TYPE_STRUCT))
+    {
+      throw std::logic_error(parameter->GetQualifiedName() + ": structure parameters are not supported by code generator");
+    }
+    parameter->offset = offset;
+    offset += 4;
+  }
+
+  returnLabel_ = GenerateLabel_();
+
+  CollectFrameReferences_(symType->GetBody().get());
+
+  Emit_({EAsmMnemonic::PUSH, ebp});
+  Emit_({EAsmMnemonic::MOV, ebp, esp});
+  GenerateCompoundStatement_(symType->GetBody().get());
+  EmitLabel_(returnLabel_);
+  Emit_({EAsmMnemonic::MOV, esp, ebp});
+  Emit_({EAsmMnemonic::POP, ebp});
+  Emit_({EAsmMnemonic::RET, 0});
+
+  if (IsFramePointerOmittable_())
+  {
+    OmitFramePointer_();
+  }
+  else if (maxFrameSize_ > 0)
+  {
+    code_.insert(code_.begin() + 2, AsmInstruction(EAsmMnemonic::SUB, esp, maxFrameSize_));
+  }
+
+  scopes_.pop_back();
+  return code_;
+}
+
+//==============================================================================
+std::string FunctionCodeGenerator::GenerateLabel_()
+{
+  return "$LN" + std::to_string(++context_.labelCounter);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::Emit_(const AsmInstruction& instruction)
+{
+  code_.push_back(instruction);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::EmitLabel_(const std::string& name)
+{
+  code_.push_back(AsmInstruction::Label(name));
+}
+
+//==============================================================================
+SymbolTable* FunctionCodeGenerator::LookupScope_(const std::string& name) const
+{
+  for (auto it = scopes_.rbegin(); it != scopes_.rend(); ++it)
+  {
+    if ((*it)->LookupVariable(name) != NULL
+        || (*it)->LookupFunction(name) != NULL)
+    {
+      return *it;
+    }
+  }
+  return NULL;
+}
+
+//==============================================================================
+void FunctionCodeGenerator::CollectFrameReferences_(ASTNode* node)
+{
+  if (node->token == OP_AMP && node->GetChildCount() == 1)
+  {
+    frameReferenced_ = true;
+    return;
+  }
+
+  // initializers are kept aside of statement children
+  const std::vector<DeclarationPoint>* declarations = NULL;
+  if (CompoundStatement* compound = dynamic_cast<CompoundStatement*>(node))
+  {
+    declarations = &compound->GetDeclarations();
+  }
+  else if (ForStatement* forStatement = dynamic_cast<ForStatement*>(node))
+  {
+    declarations = &forStatement->GetDeclarations();
+  }
+  if (declarations != NULL)
+  {
+    for (auto& declaration : *declarations)
+    {
+      if (IfOfType(declaration.variable, ESymbolType::TYPE_ARRAY))
+      {
+        frameReferenced_ = true;
+      }
+      for (auto& initializer : declaration.variable->GetInitializers())
+      {
+        CollectFrameReferences_(initializer.get());
+      }
+    }
+  }
+
+  for (int i = 0; i < node->GetChildCount() && !frameReferenced_; i++)
+  {
+    CollectFrameReferences_(node->GetChild(i).get());
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::AllocateLocals_(const std::vector<DeclarationPoint>& declarations)
+{
+  for (auto& declaration : declarations)
+  {
+    shared_ptr<SymbolVariable> variable = declaration.variable;
+    frameSize_ += RoundUpTo4(GetActualType(variable)->GetSize());
+    variable->offset = -frameSize_;
+  }
+  maxFrameSize_ = std::max(maxFrameSize_, frameSize_);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateInitializer_(shared_ptr<SymbolVariable> variable)
+{
+  const std::vector<shared_ptr<ASTNode>>& initializers = variable->GetInitializers();
+  if (initializers.empty())
+  {
+    return;
+  }
+
+  std::vector<std::pair<int, shared_ptr<SymbolType>>> slots;
+  CollectInitializerSlots(variable->GetRefSymbol(), 0, slots);
+  assert(slots.size() >= initializers.size());
+
+  for (unsigned i = 0; i < initializers.size(); i++)
+  {
+    CheckSupportedType_(initializers[i]->token, slots[i].second);
+    GenerateValue_(initializers[i].get());
+    Emit_({EAsmMnemonic::LEA, ecx, AsmArgument::Memory(EAsmRegister::EBP, variable->offset + slots[i].first)});
+    EmitStore_(slots[i].second);
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateStatement_(Statement* statement)
+{
+  switch (statement->GetStatementType())
+  {
+  case EStatementType::COMPOUND:
+    GenerateCompoundStatement_(static_cast<CompoundStatement*>(statement));
+    break;
+
+  case EStatementType::SELECTION:
+    GenerateSelectionStatement_(static_cast<SelectionStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_FOR:
+    GenerateForStatement_(static_cast<ForStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_WHILE:
+    GenerateWhileStatement_(static_cast<WhileStatement*>(statement));
+    break;
+
+  case EStatementType::ITERATION_DO:
+    GenerateDoStatement_(static_cast<DoStatement*>(statement));
+    break;
+
+  case EStatementType::JUMP:
+    GenerateJumpStatement_(static_cast<JumpStatement*>(statement));
+    break;
+
+  case EStatementType::EXPRESSION:
+  {
+    shared_ptr<ASTNode> expression = static_cast<ExpressionStatement*>(statement)->GetExpression();
+    if (expression != NULL)
+    {
+      GenerateValue_(expression.get());
+    }
+    break;
+  }
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateCompoundStatement_(CompoundStatement* statement)
+{
+  scopes_.push_back(statement->GetSymbolTable().get());
+  // sibling blocks share stack space
+  int frameSize = frameSize_;
+
+  const std::vector<DeclarationPoint>& declarations = statement->GetDeclarations();
+  AllocateLocals_(declarations);
+
+  unsigned d = 0;
+  for (int i = 0; i < statement->GetChildCount(); i++)
+  {
+    while (d < declarations.size() && declarations[d].position == i)
+    {
+      GenerateInitializer_(declarations[d++].variable);
+    }
+    GenerateStatement_(static_cast<Statement*>(statement->GetChild(i).get()));
+  }
+  while (d < declarations.size())
+  {
+    GenerateInitializer_(declarations[d++].variable);
+  }
+
+  frameSize_ = frameSize;
+  scopes_.pop_back();
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateSelectionStatement_(SelectionStatement* statement)
+{
+  std::string elseLabel = GenerateLabel_();
+  GenerateCondition_(statement->GetChild(0).get(), elseLabel);
+  GenerateStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+
+  if (statement->GetChildCount() > 2)
+  {
+    std::string endLabel = GenerateLabel_();
+    Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(endLabel)});
+    EmitLabel_(elseLabel);
+    GenerateStatement_(static_cast<Statement*>(statement->GetChild(2).get()));
+    EmitLabel_(endLabel);
+  }
+  else
+  {
+    EmitLabel_(elseLabel);
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateForStatement_(ForStatement* statement)
+{
+  scopes_.push_back(statement->GetSymbolTable().get());
+  int frameSize = frameSize_;
+
+  AllocateLocals_(statement->GetDeclarations());
+  for (auto& declaration : statement->GetDeclarations())
+  {
+    GenerateInitializer_(declaration.variable);
+  }
+
+  // stub nodes stand for omitted expressions
+  auto present = [](shared_ptr<ASTNode> node)
+  {
+    return node->token != TT_INVALID;
+  };
+
+  shared_ptr<ASTNode> initializing = statement->GetChild(0);
+  shared_ptr<ASTNode> controlling = statement->GetChild(1);
+  shared_ptr<ASTNode> iteration = statement->GetChild(2);
+
+  if (present(initializing))
+  {
+    GenerateValue_(initializing.get());
+  }
+
+  LoopLabels labels{GenerateLabel_(), GenerateLabel_()};
+  loopLabels_[statement] = labels;
+  std::string topLabel = GenerateLabel_();
+
+  EmitLabel_(topLabel);
+  if (present(controlling))
+  {
+    GenerateCondition_(controlling.get(), labels.breakLabel);
+  }
+  GenerateStatement_(static_cast<Statement*>(statement->GetChild(3).get()));
+  EmitLabel_(labels.continueLabel);
+  if (present(iteration))
+  {
+    GenerateValue_(iteration.get());
+  }
+  Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(topLabel)});
+  EmitLabel_(labels.breakLabel);
+
+  frameSize_ = frameSize;
+  scopes_.pop_back();
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateWhileStatement_(WhileStatement* statement)
+{
+  LoopLabels labels{GenerateLabel_(), GenerateLabel_()};
+  loopLabels_[statement] = labels;
+
+  EmitLabel_(labels.continueLabel);
+  GenerateCondition_(statement->GetChild(0).get(), labels.breakLabel);
+  GenerateStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+  Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(labels.continueLabel)});
+  EmitLabel_(labels.breakLabel);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateDoStatement_(DoStatement* statement)
+{
+  LoopLabels labels{GenerateLabel_(), GenerateLabel_()};
+  loopLabels_[statement] = labels;
+  std::string topLabel = GenerateLabel_();
+
+  EmitLabel_(topLabel);
+  GenerateStatement_(static_cast<Statement*>(statement->GetChild(1).get()));
+  EmitLabel_(labels.continueLabel);
+  GenerateValue_(statement->GetChild(0).get());
+  Emit_({EAsmMnemonic::CMP, eax, 0});
+  Emit_({EAsmMnemonic::JNE, AsmArgument::Symbol(topLabel)});
+  EmitLabel_(labels.breakLabel);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateJumpStatement_(JumpStatement* statement)
+{
+  switch (statement->token.type)
+  {
+  case KW_RETURN:
+  {
+    shared_ptr<ASTNode> expression = statement->GetReturnExpression();
+    if (expression != NULL && IsTailCall_(expression.get()))
+    {
+      GenerateTailCall_(expression.get());
+      break;
+    }
+    if (expression != NULL)
+    {
+      CheckSupportedType_(expression->token, expression->GetTypeSym());
+      GenerateValue_(expression.get());
+    }
+    Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(returnLabel_)});
+    break;
+  }
+
+  case KW_BREAK:
+    Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(loopLabels_.at(statement->GetRefLoopStatement().get()).breakLabel)});
+    break;
+
+  case KW_CONTINUE:
+    Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(loopLabels_.at(statement->GetRefLoopStatement().get()).continueLabel)});
+    break;
+
+  default:
+    assert(false);
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateCondition_(ASTNode* node, const std::string& falseLabel)
+{
+  CheckSupportedType_(node->token, node->GetTypeSym());
+  GenerateValue_(node);
+  Emit_({EAsmMnemonic::CMP, eax, 0});
+  Emit_({EAsmMnemonic::JE, AsmArgument::Symbol(falseLabel)});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateValue_(ASTNode* node)
+{
+  if (dynamic_cast<ASTNodeFunctionCall*>(node) != NULL)
+  {
+    GenerateFunctionCall_(node);
+    return;
+  }
+
+  Token& token = node->token;
+  CheckSupportedType_(token, node->GetTypeSym());
+
+  switch (token.type)
+  {
+  case TT_IDENTIFIER:
+    GenerateIdentifier_(node, false);
+    break;
+
+  case TT_LITERAL_INT:
+  case TT_LITERAL_CHAR:
+    Emit_({EAsmMnemonic::MOV, eax, token.intValue});
+    break;
+
+  case TT_LITERAL_CHAR_ARRAY:
+    Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Offset(stringLabels_.at(node))});
+    break;
+
+  case OP_LAND:
+  case OP_LOR:
+    GenerateLogicalOperator_(node);
+    break;
+
+  case OP_QMARK:
+    GenerateConditional_(node);
+    break;
+
+  case OP_COMMA:
+    for (int i = 0; i < node->GetChildCount(); i++)
+    {
+      GenerateValue_(node->GetChild(i).get());
+    }
+    break;
+
+  case OP_LSQUARE:
+    GenerateSubscriptAddress_(node);
+    EmitLoad_(node->GetTypeSym());
+    break;
+
+  case OP_DOT:
+  case OP_ARROW:
+    GenerateStructureAccessAddress_(node);
+    EmitLoad_(node->GetTypeSym());
+    break;
+
+  case TT_CAST:
+  {
+    shared_ptr<SymbolType> targetType = static_cast<ASTNodeTypeName*>(node->GetChild(0).get())->GetTypeNameSymbol();
+    ASTNode* expression = node->GetChild(1).get();
+    CheckSupportedType_(token, targetType);
+    CheckSupportedType_(expression->token, expression->GetTypeSym());
+    GenerateValue_(expression);
+    if (IfOfType(targetType, ESymbolType::TYPE_CHAR))
+    {
+      Emit_({EAsmMnemonic::MOVSX, eax, al});
+    }
+    break;
+  }
+
+  default:
+    if (IsAssignmentOperator(token.type))
+    {
+      GenerateAssignment_(node);
+    }
+    else if (dynamic_cast<ASTNodeUnaryOperator*>(node) != NULL)
+    {
+      GenerateUnaryOperator_(node);
+    }
+    else if (dynamic_cast<ASTNodeBinaryOperator*>(node) != NULL)
+    {
+      GenerateBinaryOperator_(node);
+    }
+    else
+    {
+      ThrowInvalidTokenError(token, "expression is not supported by code generator");
+    }
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateAddress_(ASTNode* node)
+{
+  switch (node->token.type)
+  {
+  case TT_IDENTIFIER:
+    GenerateIdentifier_(node, true);
+    break;
+
+  case TT_LITERAL_CHAR_ARRAY:
+    Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Offset(stringLabels_.at(node))});
+    break;
+
+  case OP_LSQUARE:
+    GenerateSubscriptAddress_(node);
+    break;
+
+  case OP_DOT:
+  case OP_ARROW:
+    GenerateStructureAccessAddress_(node);
+    break;
+
+  case OP_STAR:
+    if (node->GetChildCount() == 1)
+    {
+      GenerateValue_(node->GetChild(0).get());
+      break;
+    }
+    // fallthrough
+
+  default:
+    ThrowInvalidTokenError(node->token, "lvalue expected");
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateIdentifier_(ASTNode* node, bool address)
+{
+  const std::string& name = node->token.text;
+  shared_ptr<SymbolType> type = node->GetTypeSym();
+  SymbolTable* scope = LookupScope_(name);
+  assert(scope != NULL);
+
+  if (IfOfType(type, ESymbolType::TYPE_FUNCTION))
+  {
+    Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Offset("_" + name)});
+    return;
+  }
+
+  bool global = scope->GetScopeType() == EScopeType::GLOBAL;
+  shared_ptr<SymbolType> actualType = GetActualType(type);
+  // arrays and structures are always referred by address
+  if (address
+      || actualType->GetType() == ESymbolType::TYPE_ARRAY
+      || actualType->GetType() == ESymbolType::TYPE_STRUCT)
+  {
+    if (global)
+    {
+      Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Offset("_" + name)});
+    }
+    else
+    {
+      Emit_({EAsmMnemonic::LEA, eax, AsmArgument::Memory(EAsmRegister::EBP, scope->LookupVariable(name)->offset)});
+    }
+    return;
+  }
+
+  CheckSupportedType_(node->token, type);
+  int size = actualType->GetType() == ESymbolType::TYPE_CHAR ? 1 : 4;
+  AsmArgument memory = global
+      ? AsmArgument::Memory("_" + name, size)
+      : AsmArgument::Memory(EAsmRegister::EBP, scope->LookupVariable(name)->offset, size);
+  Emit_({size == 1 ? EAsmMnemonic::MOVSX : EAsmMnemonic::MOV, eax, memory});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateBinaryOperator_(ASTNode* node)
+{
+  ASTNode* left = node->GetChild(0).get();
+  ASTNode* right = node->GetChild(1).get();
+  shared_ptr<SymbolType> leftType = left->GetTypeSym();
+  shared_ptr<SymbolType> rightType = right->GetTypeSym();
+  CheckSupportedType_(left->token, leftType);
+  CheckSupportedType_(right->token, rightType);
+
+  GenerateValue_(right);
+  Emit_({EAsmMnemonic::PUSH, eax});
+  GenerateValue_(left);
+  Emit_({EAsmMnemonic::POP, ecx});
+
+  const Token& token = node->token;
+  bool leftPointer = IfPointerLike(leftType);
+  bool rightPointer = IfPointerLike(rightType);
+  if (token == OP_PLUS && leftPointer != rightPointer)
+  {
+    if (leftPointer)
+    {
+      EmitScale_(EAsmRegister::ECX, ElementSize(leftType));
+    }
+    else
+    {
+      EmitScale_(EAsmRegister::EAX, ElementSize(rightType));
+    }
+  }
+  else if (token == OP_MINUS && leftPointer && !rightPointer)
+  {
+    EmitScale_(EAsmRegister::ECX, ElementSize(leftType));
+  }
+
+  EmitArithmetic_(token);
+
+  if (token == OP_MINUS && leftPointer && rightPointer)
+  {
+    // pointer difference is measured in elements
+    int size = ElementSize(leftType);
+    if (size != 1)
+    {
+      Emit_({EAsmMnemonic::MOV, ecx, size});
+      Emit_({EAsmMnemonic::CDQ});
+      Emit_({EAsmMnemonic::IDIV, ecx});
+    }
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateLogicalOperator_(ASTNode* node)
+{
+  std::string shortLabel = GenerateLabel_();
+  std::string endLabel = GenerateLabel_();
+  // && short-circuits to 0, || short-circuits to 1
+  EAsmMnemonic shortJump = node->token == OP_LAND ? EAsmMnemonic::JE : EAsmMnemonic::JNE;
+  int shortValue = node->token == OP_LAND ? 0 : 1;
+
+  for (int i = 0; i < 2; i++)
+  {
+    ASTNode* operand = node->GetChild(i).get();
+    CheckSupportedType_(operand->token, operand->GetTypeSym());
+    GenerateValue_(operand);
+    Emit_({EAsmMnemonic::CMP, eax, 0});
+    Emit_({shortJump, AsmArgument::Symbol(shortLabel)});
+  }
+  Emit_({EAsmMnemonic::MOV, eax, 1 - shortValue});
+  Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(endLabel)});
+  EmitLabel_(shortLabel);
+  Emit_({EAsmMnemonic::MOV, eax, shortValue});
+  EmitLabel_(endLabel);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateUnaryOperator_(ASTNode* node)
+{
+  ASTNode* operand = node->GetChild(0).get();
+
+  switch (node->token.type)
+  {
+  case OP_INC:
+  case OP_DEC:
+    GenerateIncDec_(static_cast<ASTNodeUnaryOperator*>(node));
+    break;
+
+  case OP_AMP:
+    GenerateAddress_(operand);
+    break;
+
+  case OP_STAR:
+    GenerateValue_(operand);
+    EmitLoad_(node->GetTypeSym());
+    break;
+
+  case KW_SIZEOF:
+  {
+    shared_ptr<SymbolType> type = operand->token == TT_TYPE_NAME
+        ? static_cast<ASTNodeTypeName*>(operand)->GetTypeNameSymbol()
+        : operand->GetTypeSym();
+    Emit_({EAsmMnemonic::MOV, eax, GetActualType(type)->GetSize()});
+    break;
+  }
+
+  case OP_PLUS:
+  case OP_MINUS:
+  case OP_COMPL:
+  case OP_LNOT:
+    CheckSupportedType_(operand->token, operand->GetTypeSym());
+    GenerateValue_(operand);
+    if (node->token == OP_MINUS)
+    {
+      Emit_({EAsmMnemonic::NEG, eax});
+    }
+    else if (node->token == OP_COMPL)
+    {
+      Emit_({EAsmMnemonic::NOT, eax});
+    }
+    else if (node->token == OP_LNOT)
+    {
+      Emit_({EAsmMnemonic::CMP, eax, 0});
+      Emit_({EAsmMnemonic::SETE, al});
+      Emit_({EAsmMnemonic::MOVZX, eax, al});
+    }
+    break;
+
+  default:
+    ThrowInvalidTokenError(node->token, "operator is not supported by code generator");
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateIncDec_(ASTNodeUnaryOperator* node)
+{
+  shared_ptr<SymbolType> type = node->GetTypeSym();
+  CheckSupportedType_(node->token, type);
+  int step = IfPointerLike(type) ? ElementSize(type) : 1;
+  EAsmMnemonic mnemonic = node->token == OP_INC ? EAsmMnemonic::ADD : EAsmMnemonic::SUB;
+
+  GenerateAddress_(node->GetOperand().get());
+  Emit_({EAsmMnemonic::MOV, ecx, eax});
+  EmitLoad_(type);
+  if (node->IsPostfix())
+  {
+    Emit_({EAsmMnemonic::PUSH, eax});
+    Emit_({mnemonic, eax, step});
+    EmitStore_(type);
+    Emit_({EAsmMnemonic::POP, eax});
+  }
+  else
+  {
+    Emit_({mnemonic, eax, step});
+    EmitStore_(type);
+    if (IfOfType(type, ESymbolType::TYPE_CHAR))
+    {
+      Emit_({EAsmMnemonic::MOVSX, eax, al});
+    }
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateAssignment_(ASTNode* node)
+{
+  ASTNode* left = node->GetChild(0).get();
+  ASTNode* right = node->GetChild(1).get();
+  shared_ptr<SymbolType> type = left->GetTypeSym();
+
+  if (IfOfType(type, ESymbolType::TYPE_STRUCT))
+  {
+    ThrowInvalidTokenError(node->token, "structure assignment is not supported by code generator");
+  }
+  CheckSupportedType_(left->token, type);
+  CheckSupportedType_(right->token, right->GetTypeSym());
+
+  if (node->token == OP_ASS)
+  {
+    GenerateValue_(right);
+    Emit_({EAsmMnemonic::PUSH, eax});
+    GenerateAddress_(left);
+    Emit_({EAsmMnemonic::MOV, ecx, eax});
+    Emit_({EAsmMnemonic::POP, eax});
+  }
+  else
+  {
+    // address stays on stack while right operand is computed
+    GenerateAddress_(left);
+    Emit_({EAsmMnemonic::PUSH, eax});
+    GenerateValue_(right);
+    Emit_({EAsmMnemonic::MOV, ecx, eax});
+    if (IfPointerLike(type)
+        && (node->token == OP_PLUSASS || node->token == OP_MINUSASS))
+    {
+      EmitScale_(EAsmRegister::ECX, ElementSize(type));
+    }
+    Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Memory(EAsmRegister::ESP)});
+    EmitLoad_(type);
+    EmitArithmetic_(node->token);
+    Emit_({EAsmMnemonic::POP, ecx});
+  }
+
+  EmitStore_(type);
+  if (IfOfType(type, ESymbolType::TYPE_CHAR))
+  {
+    Emit_({EAsmMnemonic::MOVSX, eax, al});
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateFunctionCall_(ASTNode* node)
+{
+  ASTNode* callee = node->GetChild(0).get();
+  if (callee->token == TT_IDENTIFIER
+      && callee->token.text == "print"
+      && LookupScope_("print") == scopes_[0])
+  {
+    GeneratePrint_(node);
+    return;
+  }
+
+  // cdecl: arguments pushed right to left, caller cleans the stack
+  int argumentCount = node->GetChildCount() - 1;
+  for (int i = argumentCount; i > 0; i--)
+  {
+    ASTNode* argument = node->GetChild(i).get();
+    if (IfOfType(argument->GetTypeSym(), ESymbolType::TYPE_STRUCT))
+    {
+      ThrowInvalidTokenError(argument->token, "structure arguments are not supported by code generator");
+    }
+    CheckSupportedType_(argument->token, argument->GetTypeSym());
+    GenerateValue_(argument);
+    Emit_({EAsmMnemonic::PUSH, eax});
+  }
+
+  shared_ptr<SymbolType> returnType = GetRefSymbol(GetActualType(callee->GetTypeSym()));
+  if (IfOfType(returnType, ESymbolType::TYPE_STRUCT))
+  {
+    ThrowInvalidTokenError(node->token, "structure return values are not supported by code generator");
+  }
+
+  if (callee->token == TT_IDENTIFIER
+      && IfOfType(callee->GetTypeSym(), ESymbolType::TYPE_FUNCTION))
+  {
+    Emit_({EAsmMnemonic::CALL, AsmArgument::Symbol("_" + callee->token.text)});
+  }
+  else
+  {
+    GenerateValue_(callee);
+    Emit_({EAsmMnemonic::CALL, eax});
+  }
+  Emit_({EAsmMnemonic::ADD, esp, 4 * argumentCount});
+}
+
+//==============================================================================
+bool FunctionCodeGenerator::IsTailCall_(ASTNode* node) const
+{
+  if (frameReferenced_
+      || dynamic_cast<ASTNodeFunctionCall*>(node) == NULL)
+  {
+    return false;
+  }
+
+  ASTNode* callee = node->GetChild(0).get();
+  if (callee->token != TT_IDENTIFIER
+      || !IfOfType(callee->GetTypeSym(), ESymbolType::TYPE_FUNCTION)
+      || LookupScope_(callee->token.text) == scopes_[0])
+  {
+    return false;
+  }
+
+  shared_ptr<SymbolFunctionType> calleeType = static_pointer_cast<SymbolFunctionType>(GetActualType(callee->GetTypeSym()));
+  shared_ptr<SymbolFunctionType> ownType = static_pointer_cast<SymbolFunctionType>(symFun_->GetRefSymbol());
+  unsigned argumentCount = node->GetChildCount() - 1;
+  // caller of this function pops only as many slots as it pushed
+  return argumentCount == calleeType->GetSymbolTable()->orderedVariables.size()
+      && argumentCount <= ownType->GetSymbolTable()->orderedVariables.size()
+      && !IfOfType(GetRefSymbol(calleeType), ESymbolType::TYPE_STRUCT);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateTailCall_(ASTNode* node)
+{
+  // all arguments are computed before any parameter slot is overwritten
+  int argumentCount = node->GetChildCount() - 1;
+  for (int i = argumentCount; i > 0; i--)
+  {
+    ASTNode* argument = node->GetChild(i).get();
+    if (IfOfType(argument->GetTypeSym(), ESymbolType::TYPE_STRUCT))
+    {
+      ThrowInvalidTokenError(argument->token, "structure arguments are not supported by code generator");
+    }
+    CheckSupportedType_(argument->token, argument->GetTypeSym());
+    GenerateValue_(argument);
+    Emit_({EAsmMnemonic::PUSH, eax});
+  }
+  for (int i = 0; i < argumentCount; i++)
+  {
+    Emit_({EAsmMnemonic::POP, eax});
+    Emit_({EAsmMnemonic::MOV, AsmArgument::Memory(EAsmRegister::EBP, 8 + 4 * i), eax});
+  }
+
+  Emit_({EAsmMnemonic::MOV, esp, ebp});
+  Emit_({EAsmMnemonic::POP, ebp});
+  Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol("_" + node->GetChild(0)->token.text)});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GeneratePrint_(ASTNode* node)
+{
+  std::string format;
+  int argumentCount = node->GetChildCount() - 1;
+  for (int i = 1; i <= argumentCount; i++)
+  {
+    ASTNode* argument = node->GetChild(i).get();
+    shared_ptr<SymbolType> type = argument->GetTypeSym();
+    CheckSupportedType_(argument->token, type);
+
+    std::string specifier = "%d";
+    if (IfOfType(type, ESymbolType::TYPE_CHAR))
+    {
+      specifier = "%c";
+    }
+    else if (IfPointerLike(type)
+             && IfOfType(GetRefSymbol(GetActualType(type)), ESymbolType::TYPE_CHAR))
+    {
+      specifier = "%s";
+    }
+    else if (!IfInteger(type) && !IfPointerLike(type))
+    {
+      ThrowInvalidTokenError(argument->token, "print argument of type "
+                             + type->GetQualifiedName() + " is not supported by code generator");
+    }
+    format += (i == 1 ? "" : " ") + specifier;
+  }
+
+  for (int i = argumentCount; i > 0; i--)
+  {
+    GenerateValue_(node->GetChild(i).get());
+    Emit_({EAsmMnemonic::PUSH, eax});
+  }
+
+  std::string label = "$SGprint" + std::to_string(context_.formatStrings.size() + 1);
+  context_.formatStrings.push_back({label, format});
+  if (std::find(context_.externals.begin(), context_.externals.end(), "_printf") == context_.externals.end())
+  {
+    context_.externals.push_back("_printf");
+  }
+
+  Emit_({EAsmMnemonic::PUSH, AsmArgument::Offset(label)});
+  Emit_({EAsmMnemonic::CALL, AsmArgument::Symbol("_printf")});
+  Emit_({EAsmMnemonic::ADD, esp, 4 * (argumentCount + 1)});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateConditional_(ASTNode* node)
+{
+  std::string elseLabel = GenerateLabel_();
+  std::string endLabel = GenerateLabel_();
+
+  GenerateCondition_(node->GetChild(0).get(), elseLabel);
+  GenerateValue_(node->GetChild(1).get());
+  Emit_({EAsmMnemonic::JMP, AsmArgument::Symbol(endLabel)});
+  EmitLabel_(elseLabel);
+  GenerateValue_(node->GetChild(2).get());
+  EmitLabel_(endLabel);
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateStructureAccessAddress_(ASTNode* node)
+{
+  ASTNode* lhs = node->GetChild(0).get();
+  shared_ptr<SymbolType> structType;
+  if (node->token == OP_DOT)
+  {
+    GenerateAddress_(lhs);
+    structType = lhs->GetTypeSym();
+  }
+  else
+  {
+    GenerateValue_(lhs);
+    structType = GetRefSymbol(GetActualType(lhs->GetTypeSym()));
+  }
+
+  Emit_({EAsmMnemonic::ADD, eax, FieldOffset(structType, node->GetChild(1)->token.text)});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::GenerateSubscriptAddress_(ASTNode* node)
+{
+  ASTNode* base = node->GetChild(0).get();
+  ASTNode* index = node->GetChild(1).get();
+
+  GenerateValue_(index);
+  Emit_({EAsmMnemonic::PUSH, eax});
+  GenerateValue_(base);
+  Emit_({EAsmMnemonic::POP, ecx});
+  EmitScale_(EAsmRegister::ECX, GetActualType(node->GetTypeSym())->GetSize());
+  Emit_({EAsmMnemonic::ADD, eax, ecx});
+}
+
+//==============================================================================
+void FunctionCodeGenerator::EmitArithmetic_(const Token& token)
+{
+  switch (token.type)
+  {
+  case OP_PLUS:
+  case OP_PLUSASS:
+    Emit_({EAsmMnemonic::ADD, eax, ecx});
+    break;
+
+  case OP_MINUS:
+  case OP_MINUSASS:
+    Emit_({EAsmMnemonic::SUB, eax, ecx});
+    break;
+
+  case OP_STAR:
+  case OP_STARASS:
+    Emit_({EAsmMnemonic::IMUL, eax, ecx});
+    break;
+
+  case OP_DIV:
+  case OP_DIVASS:
+    Emit_({EAsmMnemonic::CDQ});
+    Emit_({EAsmMnemonic::IDIV, ecx});
+    break;
+
+  case OP_MOD:
+  case OP_MODASS:
+    Emit_({EAsmMnemonic::CDQ});
+    Emit_({EAsmMnemonic::IDIV, ecx});
+    Emit_({EAsmMnemonic::MOV, eax, edx});
+    break;
+
+  case OP_AMP:
+  case OP_BANDASS:
+    Emit_({EAsmMnemonic::AND, eax, ecx});
+    break;
+
+  case OP_BOR:
+  case OP_BORASS:
+    Emit_({EAsmMnemonic::OR, eax, ecx});
+    break;
+
+  case OP_XOR:
+  case OP_XORASS:
+    Emit_({EAsmMnemonic::XOR, eax, ecx});
+    break;
+
+  case OP_LSHIFT:
+  case OP_LSHIFTASS:
+    Emit_({EAsmMnemonic::SHL, eax, cl});
+    break;
+
+  case OP_RSHIFT:
+  case OP_RSHIFTASS:
+    Emit_({EAsmMnemonic::SAR, eax, cl});
+    break;
+
+  case OP_EQ:
+  case OP_NE:
+  case OP_LT:
+  case OP_LE:
+  case OP_GT:
+  case OP_GE:
+    Emit_({EAsmMnemonic::CMP, eax, ecx});
+    Emit_({comparisonToSet.at(token.type), al});
+    Emit_({EAsmMnemonic::MOVZX, eax, al});
+    break;
+
+  default:
+    ThrowInvalidTokenError(token, "operator is not supported by code generator");
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::EmitLoad_(shared_ptr<SymbolType> type)
+{
+  shared_ptr<SymbolType> actualType = GetActualType(type);
+  switch (actualType->GetType())
+  {
+  case ESymbolType::TYPE_ARRAY:
+  case ESymbolType::TYPE_STRUCT:
+  case ESymbolType::TYPE_FUNCTION:
+    // value is the address itself
+    break;
+
+  case ESymbolType::TYPE_CHAR:
+    Emit_({EAsmMnemonic::MOVSX, eax, AsmArgument::Memory(EAsmRegister::EAX, 0, 1)});
+    break;
+
+  default:
+    // floats are rejected by CheckSupportedType_ beforehand
+    assert(actualType->GetType() != ESymbolType::TYPE_FLOAT);
+    Emit_({EAsmMnemonic::MOV, eax, AsmArgument::Memory(EAsmRegister::EAX)});
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::EmitStore_(shared_ptr<SymbolType> type)
+{
+  if (IfOfType(type, ESymbolType::TYPE_CHAR))
+  {
+    Emit_({EAsmMnemonic::MOV, AsmArgument::Memory(EAsmRegister::ECX, 0, 1), al});
+  }
+  else
+  {
+    Emit_({EAsmMnemonic::MOV, AsmArgument::Memory(EAsmRegister::ECX), eax});
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::EmitScale_(EAsmRegister reg, int size)
+{
+  if (size != 1)
+  {
+    Emit_({EAsmMnemonic::IMUL, reg, reg, size});
+  }
+}
+
+//==============================================================================
+void FunctionCodeGenerator::CheckSupportedType_(const Token& token, shared_ptr<SymbolType> type) const
+{
+  if (type != NULL
+      && IfOfType(type, ESymbolType::TYPE_FLOAT))
+  {
+    ThrowInvalidTokenError(token, "floating point values are not supported by code generator");
+  }
+}
+
+//==============================================================================
+bool FunctionCodeGenerator::IsFramePointerOmittable_() const
+{
+  if (maxFrameSize_ > 0)
+  {
+    return false;
+  }
+  for (auto& instruction : code_)
+  {
+    if (instruction.Is(EAsmMnemonic::CALL))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//==============================================================================
+void FunctionCodeGenerator::OmitFramePointer_()
+{
+  AsmCode code;
+  // bytes pushed since function entry, same at every label
+  // since pushes and pops are balanced within expressions
+  int depth = 0;
+  // prologue is `push ebp` / `mov ebp, esp`
+  for (unsigned i = 2; i < code_.size(); i++)
+  {
+    AsmInstruction instruction = code_[i];
+    if (instruction.Is(EAsmMnemonic::MOV)
+        && instruction.arguments[0].IsRegister(EAsmRegister::ESP)
+        && instruction.arguments[1].IsRegister(EAsmRegister::EBP))
+    {
+      // epilogue `mov esp, ebp` / `pop ebp`
+      assert(code_[i + 1].Is(EAsmMnemonic::POP));
+      i++;
+      continue;
+    }
+
+    for (auto& argument : instruction.arguments)
+    {
+      if (argument.IsMemory() && argument.symbol.empty()
+          && argument.reg == EAsmRegister::EBP)
+      {
+        // [ebp+8] was the first parameter, it is [esp+4] at entry
+        argument.reg = EAsmRegister::ESP;
+        argument.value += depth - 4;
+      }
+    }
+
+    if (instruction.Is(EAsmMnemonic::PUSH))
+    {
+      depth += 4;
+    }
+    else if (instruction.Is(EAsmMnemonic::POP))
+    {
+      depth -= 4;
+    }
+    else if ((instruction.Is(EAsmMnemonic::ADD) || instruction.Is(EAsmMnemonic::SUB))
+             && instruction.arguments[0].IsRegister(EAsmRegister::ESP))
+    {
+      depth += instruction.Is(EAsmMnemonic::ADD) ? -instruction.arguments[1].value
+                                                 : instruction.arguments[1].value;
+    }
+    code.push_back(instruction);
+  }
+  code_ = code;
+}
 
-CodeGenerator::CodeGenerator()
-  : Parser()
+//==============================================================================
+CodeGenerator::CodeGenerator(std::ostream& out, unsigned threadCount)
+  : Parser(out)
+  , out_(out)
+  , threadCount_(threadCount)
 {
 
 }
 
+//==============================================================================
 CodeGenerator::~CodeGenerator()
 {
 
 }
 
+//==============================================================================
 void CodeGenerator::Flush() const
 {
   using namespace std;
 
-  cout << asmHeader;
+  TimeReport::Scope scope(TimeReport::EPhase::OUTPUT);
+  Trace::Scope span("output");
+
+  // formatted into one buffer, written to out_ at once
+  StreamOutputSink out(out_);
+  out << asmHeader;
 
   shared_ptr<SymbolTable> internalSymbols = GetInternalSymbolTable();
   shared_ptr<SymbolTable> globalSymbols = GetGlobalSymbolTable();
 
+  for (auto& f : functions_)
+  {
+    out << "PUBLIC _" << f.symbol->name << '\n';
+  }
+
+  // declared only functions, sorted for stable output
+  vector<string> externals = context_.externals;
   for (auto& f : globalSymbols->functions)
   {
-    cout << "PUBLIC _" << f.second->name << endl;
+    auto symType = static_pointer_cast<SymbolFunctionType>(f.second->GetRefSymbol());
+    if (symType->GetBody() == NULL)
+    {
+      externals.push_back("_" + f.second->name);
+    }
+  }
+  sort(externals.begin(), externals.end());
+  for (auto& e : externals)
+  {
+    out << "EXTRN " << e << ":PROC" << '\n';
   }
-  if (globalSymbols->functions.size() > 0)
+
+  if (functions_.size() + externals.size() > 0)
   {
-    cout << endl;
+    out << '\n';
   }
 
   if (globalSymbols->variables.size() > 0)
   {
     // TODO: take order into account
-    cout << "_DATA SEGMENT" << endl;
+    out << "_DATA SEGMENT" << '\n';
     for (auto& f : globalSymbols->variables)
     {
       // TODO: initializer present case
       auto& v = f.second;
       auto t = GetActualType(v);
       string sizeName;
+      // count of sizeName units
+      int size = 1;
       if (t->GetType() == ESymbolType::TYPE_CHAR)
       {
         sizeName = "BYTE";
@@ -54,7 +1351,7 @@ void CodeGenerator::Flush() const
       }
       else
       {
-        int size = t->GetSize();
+        size = t->GetSize();
         if (t->GetType() == ESymbolType::TYPE_ARRAY)
         {
           shared_ptr<SymbolType> arrayTypeSymbol = GetArrayType(t);
@@ -74,48 +1371,230 @@ void CodeGenerator::Flush() const
         {
           sizeName = "BYTE";
         }
-        if (size != 1)
-        {
-          stringstream ss;
-          ss << hex << size;
-          sizeName += ":0" + ss.str() + "H";
-        }
       }
 
-      cout << "COMM _" << v->name << ":" << sizeName << endl;
+      out << "COMM _" << v->name << ":" << sizeName;
+      if (size != 1)
+      {
+        out << ":0";
+        out.WriteHex(size) << "H";
+      }
+      out << '\n';
     }
-    cout << "_DATA ENDS" << endl;
+    out << "_DATA ENDS" << '\n';
   }
 
   if (stringTable_.size() > 0)
   {
-    cout << "_DATA SEGMENT" << endl;
+    out << "_DATA SEGMENT" << '\n';
 
     int size = 1000;
     for (auto& s : stringTable_)
     {
       Token& token = s->token;
-      cout << "$SG" << size << " ";
+      out << "$SG" << size << " ";
       for (int i = 0; i < token.size; i++)
       {
-        stringstream ss;
-        unsigned value = static_cast<unsigned char>(token.charValue[i]);
-        ss << hex << value;
-        cout << "DB 0" << ss.str() << "H" << endl;
+        out << "DB 0";
+        out.WriteHex(static_cast<unsigned char>(token.charValue[i])) << "H\n";
       }
       size += token.size;
       int pad = (4 - size % 4) * (size % 4 != 0);
       size += pad;
       if (pad != 0)
       {
-        cout << "ORG $+" << pad << endl;
+        out << "ORG $+" << pad << '\n';
+      }
+    }
+
+    out << "_DATA ENDS" << '\n';
+  }
+
+  if (context_.formatStrings.size() > 0)
+  {
+    out << "CONST SEGMENT" << '\n';
+    for (auto& f : context_.formatStrings)
+    {
+      out << f.first << " DB '" << f.second << "', 0aH, 00H" << '\n';
+    }
+    out << "CONST ENDS" << '\n';
+  }
+
+  if (functions_.size() > 0)
+  {
+    out << "_TEXT SEGMENT" << '\n';
+    for (auto& f : functions_)
+    {
+      out << "_" << f.symbol->name << " PROC" << '\n';
+      for (auto& instruction : f.code)
+      {
+        out << instruction.ToString() << '\n';
+      }
+      out << "_" << f.symbol->name << " ENDP" << '\n';
+    }
+    out << "_TEXT ENDS" << '\n';
+  }
+
+  out << asmFooter;
+}
+
+//==============================================================================
+const PeepholeOptimizer& CodeGenerator::GetPeepholeOptimizer() const
+{
+  return peepholeOptimizer_;
+}
+
+//==============================================================================
+void CodeGenerator::OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun)
+{
+  TimeReport::Scope scope(TimeReport::EPhase::CODEGEN);
+  if (threadCount_ != 1)
+  {
+    functions_.push_back({symFun, AsmCode()});
+    return;
+  }
+
+  // functions after failed one are not generated
+  if (error_)
+  {
+    return;
+  }
+
+  UpdateStringLabels_();
+
+  try
+  {
+    Trace::Scope span("codegen", symFun->name);
+    FunctionCodeGenerator generator(symFun, GetGlobalSymbolTable(), GetInternalSymbolTable(),
+                                    stringLabels_, context_);
+    FunctionCode functionCode{symFun, generator.Generate()};
+    peepholeOptimizer_.Optimize(functionCode.code);
+    functions_.push_back(functionCode);
+  }
+  catch (std::exception&)
+  {
+    error_ = std::current_exception();
+  }
+}
+
+//==============================================================================
+void CodeGenerator::OnTranslationUnitParsed_()
+{
+  TimeReport::Scope scope(TimeReport::EPhase::CODEGEN);
+  if (threadCount_ != 1)
+  {
+    Trace::Scope span("codegen in parallel");
+    GenerateFunctionsInParallel_();
+  }
+  if (error_)
+  {
+    std::rethrow_exception(error_);
+  }
+}
+
+//==============================================================================
+void CodeGenerator::OnParseError_()
+{
+  // parse error is reported, output still has code of functions before it
+  if (threadCount_ != 1)
+  {
+    TimeReport::Scope scope(TimeReport::EPhase::CODEGEN);
+    Trace::Scope span("codegen in parallel");
+    GenerateFunctionsInParallel_();
+  }
+}
+
+//==============================================================================
+void CodeGenerator::GenerateFunctionsInParallel_()
+{
+  // globals, types and string labels are only read from now on,
+  // everything generator writes is per function
+  UpdateStringLabels_();
+  shared_ptr<SymbolTable> globalSymbols = GetGlobalSymbolTable();
+  shared_ptr<SymbolTable> internalSymbols = GetInternalSymbolTable();
+
+  std::vector<CodeGenContext> contexts(functions_.size());
+  std::vector<std::exception_ptr> errors(functions_.size());
+  // contiguous ranges of functions, several per thread for stealing to even out
+  size_t chunkCount = 0;
+  std::vector<PeepholeOptimizer> optimizers;
+  {
+    ThreadPool pool(threadCount_);
+    chunkCount = std::min<size_t>(functions_.size(), pool.GetThreadCount() * 4);
+    optimizers.resize(chunkCount);
+    for (size_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+      pool.Submit([&, chunk]()
+      {
+        size_t begin = functions_.size() * chunk / chunkCount;
+        size_t end = functions_.size() * (chunk + 1) / chunkCount;
+        for (size_t i = begin; i < end; i++)
+        {
+          try
+          {
+            Trace::Scope span("codegen", functions_[i].symbol->name);
+            FunctionCodeGenerator generator(functions_[i].symbol, globalSymbols, internalSymbols,
+                                            stringLabels_, contexts[i]);
+            functions_[i].code = generator.Generate();
+            optimizers[chunk].Optimize(functions_[i].code);
+          }
+          catch (...)
+          {
+            errors[i] = std::current_exception();
+            return;
+          }
+        }
+      });
+    }
+    pool.Wait();
+  }
+
+  // same numbering serial generation gives, first error in definition order
+  // wins; what failed function added to its context is kept, as serial
+  // generation adds it to context_ before failing
+  for (size_t i = 0; i < functions_.size(); i++)
+  {
+    int formatBase = context_.formatStrings.size();
+    RebaseLabels(functions_[i].code, context_.labelCounter, formatBase);
+    context_.labelCounter += contexts[i].labelCounter;
+    for (auto& format : contexts[i].formatStrings)
+    {
+      context_.formatStrings.push_back(format);
+      RebaseLabel(context_.formatStrings.back().first, "$SGprint", formatBase);
+    }
+    for (auto& external : contexts[i].externals)
+    {
+      if (std::find(context_.externals.begin(), context_.externals.end(), external) == context_.externals.end())
+      {
+        context_.externals.push_back(external);
       }
     }
 
-    cout << "_DATA ENDS" << endl;
+    if (errors[i])
+    {
+      error_ = errors[i];
+      functions_.resize(i);
+      return;
+    }
+  }
+
+  for (auto& optimizer : optimizers)
+  {
+    peepholeOptimizer_.AddStatistics(optimizer);
   }
+}
 
-  cout << asmFooter;
+//==============================================================================
+void CodeGenerator::UpdateStringLabels_()
+{
+  // same numbering as string table output in Flush
+  for (; labeledStrings_ < stringTable_.size(); labeledStrings_++)
+  {
+    shared_ptr<ASTNode> node = stringTable_[labeledStrings_];
+    stringLabels_[node.get()] = "$SG" + std::to_string(stringTableSize_);
+    stringTableSize_ += node->token.size;
+    stringTableSize_ += (4 - stringTableSize_ % 4) * (stringTableSize_ % 4 != 0);
+  }
 }
 
 } // namespace Compiler
@@ -1,9 +1,17 @@
 #pragma once
 
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <exception>
+#include <iostream>
+
 #include "Visitor.hpp"
 #include "ASTNode.hpp"
 #include "Statement.hpp"
 #include "Parser.hpp"
+#include "AsmInstruction.hpp"
+#include "PeepholeOptimizer.hpp"
 
 namespace Compiler
 {
@@ -23,70 +31,179 @@ static const char* asmFooter = R"(
 
     )";
 
-enum class EAsmMnemonic
-{
-  MOV,
-  PUSH,
-  POP,
-  RET,
-  CALL,
-  NOP,
-};
-
-enum class EAsmRegister
-{
-  EAX,
-  EBX,
-  ECX,
-  EDX,
-  ESI,
-  EDI,
-  ESP,
-  EBP,
-};
-
-class AsmArgument
+class CodeGenVisitor
+    : virtual public IVisitorBase
+    , virtual public IVisitor<ASTNodeAssignment>
 {
 public:
-private:
+  void VisitOnEnter(ASTNodeAssignment &)
+  {
 
-};
+  }
 
-class AsmInstruction
-{
-public:
-  AsmInstruction()
+  void VisitOnLeave(ASTNodeAssignment &)
   {
 
   }
+};
 
-private:
-
+// type layout helpers, shared with bytecode compiler
+int RoundUpTo4(int size);
+bool IfPointerLike(shared_ptr<SymbolType> type);
+// size of object pointed to, `void*` arithmetic is done by byte
+int ElementSize(shared_ptr<SymbolType> type);
+// same layout as SymbolStruct::GetSize
+int FieldOffset(shared_ptr<SymbolType> structType, const std::string& name);
+// flattens aggregate into scalar slots matching initializer list order
+void CollectInitializerSlots(shared_ptr<SymbolType> type, int offset,
+                             std::vector<std::pair<int, shared_ptr<SymbolType>>>& slots);
+
+// string literal node -> `$SG` data label
+typedef std::unordered_map<const ASTNode*, std::string> StringLabels;
+
+// shared between generated functions of one translation unit
+struct CodeGenContext
+{
+  // `print` format strings: label -> contents
+  std::vector<std::pair<std::string, std::string>> formatStrings;
+  // external procedures referenced from generated code
+  std::vector<std::string> externals;
+  int labelCounter{0};
 };
 
-class CodeGenVisitor
-    : virtual public IVisitorBase
-    , virtual public IVisitor<ASTNodeAssignment>
+// lowers single function definition to x86 instructions
+// values are computed into eax, ecx and edx are scratch registers
+class FunctionCodeGenerator
 {
 public:
-  void VisitOnEnter(ASTNodeAssignment &)
-  {
+  FunctionCodeGenerator(shared_ptr<SymbolVariable> symFun,
+                        shared_ptr<SymbolTable> globalSymbols,
+                        shared_ptr<SymbolTable> internalSymbols,
+                        const StringLabels& stringLabels,
+                        CodeGenContext& context);
 
-  }
+  AsmCode Generate();
 
-  void VisitOnLeave(ASTNodeAssignment &)
+private:
+  struct LoopLabels
   {
-
-  }
+    std::string continueLabel;
+    std::string breakLabel;
+  };
+
+  shared_ptr<SymbolVariable> symFun_;
+  const StringLabels& stringLabels_;
+  CodeGenContext& context_;
+  AsmCode code_;
+  std::vector<SymbolTable*> scopes_;
+  std::unordered_map<const Statement*, LoopLabels> loopLabels_;
+  std::string returnLabel_;
+  int frameSize_{0};
+  int maxFrameSize_{0};
+  // pointer into own frame may exist: `&` is used or local array decays,
+  // tail calls would free the frame while callee still refers to it
+  bool frameReferenced_{false};
+
+  std::string GenerateLabel_();
+  void Emit_(const AsmInstruction& instruction);
+  void EmitLabel_(const std::string& name);
+
+  // table containing variable or function visible by `name` from current scope
+  SymbolTable* LookupScope_(const std::string& name) const;
+  void CollectFrameReferences_(ASTNode* node);
+  void AllocateLocals_(const std::vector<DeclarationPoint>& declarations);
+  void GenerateInitializer_(shared_ptr<SymbolVariable> variable);
+
+  void GenerateStatement_(Statement* statement);
+  void GenerateCompoundStatement_(CompoundStatement* statement);
+  void GenerateSelectionStatement_(SelectionStatement* statement);
+  void GenerateForStatement_(ForStatement* statement);
+  void GenerateWhileStatement_(WhileStatement* statement);
+  void GenerateDoStatement_(DoStatement* statement);
+  void GenerateJumpStatement_(JumpStatement* statement);
+  void GenerateCondition_(ASTNode* node, const std::string& falseLabel);
+
+  // value of expression into eax
+  void GenerateValue_(ASTNode* node);
+  // address of lvalue into eax
+  void GenerateAddress_(ASTNode* node);
+  void GenerateIdentifier_(ASTNode* node, bool address);
+  void GenerateBinaryOperator_(ASTNode* node);
+  void GenerateLogicalOperator_(ASTNode* node);
+  void GenerateUnaryOperator_(ASTNode* node);
+  void GenerateIncDec_(ASTNodeUnaryOperator* node);
+  void GenerateAssignment_(ASTNode* node);
+  void GenerateFunctionCall_(ASTNode* node);
+  // `return f(...)` where f takes no more arguments than this function:
+  // arguments overwrite own parameter slots and f is jumped to
+  bool IsTailCall_(ASTNode* node) const;
+  void GenerateTailCall_(ASTNode* node);
+  void GeneratePrint_(ASTNode* node);
+  void GenerateConditional_(ASTNode* node);
+  void GenerateStructureAccessAddress_(ASTNode* node);
+  void GenerateSubscriptAddress_(ASTNode* node);
+
+  // eax = eax `operation` ecx, operation is binary or compound assignment
+  void EmitArithmetic_(const Token& token);
+  // eax = value stored at address eax
+  void EmitLoad_(shared_ptr<SymbolType> type);
+  // value eax stored at address ecx
+  void EmitStore_(shared_ptr<SymbolType> type);
+  // reg *= size, pointer arithmetic
+  void EmitScale_(EAsmRegister reg, int size);
+
+  void CheckSupportedType_(const Token& token, shared_ptr<SymbolType> type) const;
+
+  // function calls nothing and has no locals, parameters are addressed
+  // relative to esp and ebp is neither saved nor set up
+  bool IsFramePointerOmittable_() const;
+  void OmitFramePointer_();
 };
 
 class CodeGenerator : public Parser
 {
 public:
-  CodeGenerator();
+  // assembly is written to `out` by Flush
+  // with `threadCount` other than 1 functions are generated on that many
+  // threads once whole translation unit is parsed or a parse error is
+  // found, output and reported error stay the same
+  CodeGenerator(std::ostream& out, unsigned threadCount = 1);
   ~CodeGenerator();
 
   virtual void Flush() const;
+
+  const PeepholeOptimizer& GetPeepholeOptimizer() const;
+
+protected:
+  virtual void OnFunctionDefinition_(shared_ptr<SymbolVariable> symFun);
+  virtual void OnTranslationUnitParsed_();
+  virtual void OnParseError_();
+
+private:
+  struct FunctionCode
+  {
+    shared_ptr<SymbolVariable> symbol;
+    AsmCode code;
+  };
+
+  CodeGenContext context_;
+  StringLabels stringLabels_;
+  std::vector<FunctionCode> functions_;
+  PeepholeOptimizer peepholeOptimizer_;
+  std::ostream& out_;
+  unsigned threadCount_;
+  // of the first function which failed, thrown once translation unit is
+  // parsed, so a parse error anywhere is reported instead in either mode
+  std::exception_ptr error_;
+
+  int stringTableSize_{1000};
+  unsigned labeledStrings_{0};
+
+  void UpdateStringLabels_();
+  // generates every function of functions_, each with own context,
+  // then appends contexts to context_ in definition order; on error
+  // functions_ and context_ are left as serial generation leaves them
+  void GenerateFunctionsInParallel_();
 };
 
 } // namespace Compiler
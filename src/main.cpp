@@ -1,8 +1,9 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
-#include <fstream>
 #include <vector>
+#include <string>
+#include <algorithm>
 
 // this_thread::sleep_for example
 #include <iostream>       // std::cout
@@ -11,11 +12,9 @@
 
 
 #include "constants.hpp"
-#include "PreTokenizer.hpp"
-#include "Tokenizer.hpp"
-#include "DebugPreTokenStream.hpp"
-#include "DebugTokenOutputStream.hpp"
-#include "SimpleExpressionParser.hpp"
+#include "Driver.hpp"
+#include "CompileServer.hpp"
+#include "CompileCache.hpp"
 
 void ShowHelp()
 {
@@ -23,8 +22,110 @@ void ShowHelp()
                R"(C language subset compiler study project.
                Usage: compiler FILE
                or:    compiler [OPTION]
+               or:    compiler -S [-j N] [--peephole-stats] FILE
+               or:    compiler -S [-j N] [--scaling] FILE...
+               or:    compiler --pipeline OPTION... FILE
+               or:    compiler --bytecode FILE
+               or:    compiler --interpret FILE
+               or:    compiler --run [--jit-stats] [--tier-stats] FILE
+               or:    compiler --tiered [--tier-stats] FILE
+               or:    compiler --server SOCKET [-j N]
+               or:    compiler --connect SOCKET OPTION... FILE
+               or:    compiler --connect SOCKET --shutdown
+               or:    compiler --cache DIR [--cache-size MB] [--cache-stats]
+                               OPTION... FILE...
+               or:    compiler --precompile PCH [--pch-stats] FILE
+               or:    compiler --pch PCH [--pch-stats] OPTION... FILE
+               or:    compiler --ast AST [--ast-stats] FILE
+               or:    compiler -ftime-report[=json] OPTION... FILE
+               or:    compiler --trace TRACE OPTION... FILE
+               or:    compiler --alloc-stats OPTION... FILE
+               or:    compiler -fdiagnostics-format=json OPTION... FILE
 
                -h, --help, no options    display this help and exit
+               -S                        print generated assembly
+               --peephole-stats          print peephole rule hit counts
+                                         to stderr, with -S only
+               -j N                      compile on N threads, with -S
+                                         only; several files are compiled
+                                         concurrently, one per hardware
+                                         thread by default, and assembly
+                                         of FILE.c is written to FILE.asm;
+                                         functions of single file are
+                                         generated concurrently once it
+                                         is parsed, output and errors are
+                                         the same
+               --scaling                 compile files on 1 to N threads
+                                         and print throughput to stderr,
+                                         nothing is written
+               --pipeline                tokenize on a separate thread
+                                         while parsing, single file only
+               --bytecode                print interpreter bytecode listing
+               --interpret               run main in bytecode interpreter,
+                                         exit status is its return value
+               --run                     compile to native code in memory
+                                         and run main, exit status is its
+                                         return value
+               --jit-stats               print time to first instruction
+                                         to stderr, with --run only
+               --tiered                  run main in bytecode interpreter,
+                                         hot functions and loops continue
+                                         in native code
+               --tier-stats              print call and back-edge counters
+                                         and tier transitions to stderr,
+                                         with --interpret, --run or --tiered
+               --server SOCKET           serve compile requests on unix
+                                         domain socket until shutdown,
+                                         -j N requests at once, to the
+                                         user who started it only
+               --connect SOCKET          let server compile FILE with -S or
+                                         --bytecode, output and exit status
+                                         are the server's
+               --shutdown                stop server, with --connect only
+               --cache DIR               reuse -S and --bytecode output,
+                                         errors and exit status of earlier
+                                         compilations of the same source
+                                         with the same options, kept in DIR
+               --cache-size MB           least recently used entries are
+                                         dropped beyond this, 256 default
+               --cache-stats             print cache hit rate and size
+                                         to stderr
+               --precompile PCH          write global symbols of FILE to
+                                         PCH; FILE holds declarations
+                                         only and ends with a line break
+               --pch PCH                 restore symbols of PCH instead of
+                                         parsing sources which start with
+                                         the text it was made of, others
+                                         are parsed as usual
+               --pch-stats               print symbol count and time PCH
+                                         saves to stderr
+               --ast AST                 write syntax tree and symbol
+                                         tables of FILE to AST, tools map
+                                         it and walk it in place
+               --ast-stats               print time parse, write and walk
+                                         of AST mapped back take to stderr
+               -ftime-report             print time each compilation phase
+                                         takes and counts of tokens, nodes,
+                                         symbols, lookups and allocations
+                                         to stderr, single file only
+               -ftime-report=json        the same as JSON
+               --trace TRACE             write timeline of phases, function
+                                         bodies parsed and functions
+                                         generated to TRACE, it opens in
+                                         chrome://tracing and Perfetto;
+                                         single file only
+               --alloc-stats             print operator new calls and bytes
+                                         of each phase, peak live bytes
+                                         and sites which allocate the most
+                                         to stderr, single file only
+               -fdiagnostics-format=json parse on past syntax and type
+                                         errors, skipping to the next
+                                         statement or declaration, and
+                                         print all of them to stderr as
+                                         JSON with line, column and range;
+                                         a lexical error, such as a bad
+                                         literal, ends parsing and has no
+                                         position; single file only
 
       Author: Denis Rotanov, B8303A, FEFU
               )";
@@ -43,39 +144,94 @@ void ShowHelp()
       return EXIT_SUCCESS;
     }
 
-    try
+    DriverOptions options;
+    vector<string> arguments(argv + 1, argv + argc);
+    if (!ParseDriverOptions(arguments, options))
     {
-      ifstream inputFile;
-      inputFile.open(argv[1], ios::binary | ios::ate);
-      ifstream::pos_type fileSize = inputFile.tellg();
-      inputFile.seekg(0, ios::beg);
-      vector<char> input(fileSize);
-      inputFile.read(&input[0], fileSize);
+      ShowHelp();
+      return EXIT_FAILURE;
+    }
 
-      //        pretokenizer debug output
-      //        DebugPreTokenStream debugPreTokenStream;
-      //        PreTokenizer pretokenizer(input, debugPreTokenStream);
+    if (!options.precompileFile.empty())
+    {
+      return WritePrecompiledDeclarations(options, cerr);
+    }
 
-      //        tokenizer output
-      //        DebugTokenOutputStream debugTokenOutputStream;
-      //        Tokenizer tokenizer(debugTokenOutputStream);
-      //        PreTokenizer pretokenizer(input, tokenizer);
+    if (!options.astFile.empty())
+    {
+      return WriteAst(options, cerr);
+    }
 
-      //        simlpe expression parser AST
-      SimpleExpressionParser simpleExpressionParser;
-      Tokenizer tokenizer(simpleExpressionParser);
-      PreTokenizer pretokenizer(input, tokenizer);
+    if (options.files.size() > 1 || options.scaling)
+    {
+      unsigned threadCount = options.threadCount;
+      if (threadCount == 0)
+      {
+        threadCount = max(1u, thread::hardware_concurrency());
+      }
+      if (options.scaling)
+      {
+        PrintScaling(options, threadCount, cerr);
+        return EXIT_SUCCESS;
+      }
+      bool succeeded = CompileFiles(options, threadCount, true, cerr);
+      if (options.cacheStats)
+      {
+        CompileCache(options.cacheDirectory, static_cast<uint64_t>(options.cacheSizeMb) << 20)
+            .PrintStatistics(cerr);
+      }
+      return succeeded ? EXIT_SUCCESS : EXIT_FAILURE;
     }
-    catch (exception& e)
+
+    if (!options.serverSocket.empty() || !options.connectSocket.empty())
     {
-      cerr << "ERROR: " << e.what() << endl;
-      return EXIT_FAILURE;
+      try
+      {
+        if (!options.serverSocket.empty())
+        {
+          CompileServer server(options.serverSocket, options.threadCount);
+          server.Run(cerr);
+          return EXIT_SUCCESS;
+        }
+
+        // everything but --connect goes to server
+        vector<string> request;
+        for (size_t i = 0; i < arguments.size(); i++)
+        {
+          if (arguments[i] == "--connect")
+          {
+            i++;
+            continue;
+          }
+          request.push_back(arguments[i]);
+          if ((arguments[i] == "--pch" || arguments[i] == "--cache") && i + 1 < arguments.size())
+          {
+            request.push_back(GetAbsolutePath(arguments[++i]));
+          }
+        }
+        vector<char> source;
+        if (!options.shutdown)
+        {
+          source = ReadFile(options.files[0]);
+        }
+        return RunCompileClient(options.connectSocket, request, source, cout, cerr);
+      }
+      catch (exception& e)
+      {
+        cerr << "ERROR: " << e.what() << endl;
+        return EXIT_FAILURE;
+      }
+    }
+
+    vector<char> input;
+    try
+    {
+      input = ReadFile(options.files[0]);
     }
-    catch (...)
+    catch (exception& e)
     {
-      cerr << "ERROR: unknown exception";
+      cerr << "ERROR: " << e.what() << endl;
       return EXIT_FAILURE;
     }
-
-    return EXIT_SUCCESS;
+    return CompileCachedSource(options, input, cout, cerr);
   }
@@ -5,20 +5,20 @@
 #include <string>
 #include <queue>
 #include <algorithm>
-#include <iostream>
 
 #include "ASTNode.hpp"
 #include "SymbolTable.hpp"
 #include "Statement.hpp"
 #include "utils.hpp"
+#include "OutputSink.hpp"
 
 namespace Compiler
 {
-void PrintAST(ASTNode* root, int indentLevel)
+void PrintAST(ASTNode* root, OutputSink& out, int indentLevel)
 {
-  auto print = [&]() -> decltype(std::operator <<(std::cout, std::string()))
+  auto print = [&]() -> OutputSink&
   {
-      return std::cout << std::string(indentLevel * 2, ' ');
+      return out.Fill(' ', indentLevel * 2);
 };
 
   struct PrintTreeNode
@@ -113,12 +113,12 @@ void PrintAST(ASTNode* root, int indentLevel)
       queue.push(next->children[i]);
     }
 
-    std::cout << next->text;
+    out << next->text;
     line.push_back(next);
 
     if (!queue.empty() && depth != queue.front()->depth)
     {
-      std::cout << std::endl;
+      out << '\n';
       depth = queue.front()->depth;
       print();
       for (auto node : line)
@@ -127,19 +127,19 @@ void PrintAST(ASTNode* root, int indentLevel)
         {
           std::string& text = node->children[i]->text;
           auto leadingSpaceCount = text.find_first_not_of(' ');
-          std::cout << std::string(leadingSpaceCount, ' ');
-          std::cout << "|";
-          std::cout << std::string(text.size() - leadingSpaceCount - 1, ' ');
+          out << std::string(leadingSpaceCount, ' ');
+          out << "|";
+          out << std::string(text.size() - leadingSpaceCount - 1, ' ');
         }
       }
-      std::cout << std::endl;
+      out << '\n';
       print();
       line.clear();
     }
   }
 }
 
-void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
+void PrintSymbolTable(SymbolTable* symTable, OutputSink& out, int indentLevel)
 {
   assert(symTable != NULL);
   SymbolTableWithOrder* symTableOrdered = NULL;
@@ -149,42 +149,42 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
     symTableOrdered = static_cast<SymbolTableWithOrder*>(symTable);
   }
   // utility -------------------------------------------------------------
-  auto print = [&]() -> decltype(std::operator <<(std::cout, std::string()))
+  auto print = [&]() -> OutputSink&
   {
-      return std::cout << std::string(indentLevel * 2, ' ');
+      return out.Fill(' ', indentLevel * 2);
 };
 
-  auto printn = [&](int n) -> decltype(std::operator <<(std::cout, std::string()))
+  auto printn = [&](int n) -> OutputSink&
   {
-    return std::cout << std::string(n * 2, ' ');
+    return out.Fill(' ', n * 2);
   };
 
   auto splitter = [&]()
   {
-    print() << std::string(48 - indentLevel * 2, '-') << std::endl;
+    print() << std::string(48 - indentLevel * 2, '-') << '\n';
   };
 
   auto prolog = [&](const std::string text, int n)
   {
-    printn(n) << ">" << std::string(48 - n * 2 - 1 - text.size(), '-') << text << std::endl;
+    printn(n) << ">" << std::string(48 - n * 2 - 1 - text.size(), '-') << text << '\n';
   };
 
   auto epilog = [&](const std::string text, int n)
   {
-    printn(n) << "<" << std::string(48 - n * 2 - 1 - text.size(), '-') << text << std::endl;
+    printn(n) << "<" << std::string(48 - n * 2 - 1 - text.size(), '-') << text << '\n';
   };
 
   // types ---------------------------------------------------------------
   if (symTable->types.size() > 0)
   {
-    print() << "types:" << std::endl;
+    print() << "types:" << '\n';
     splitter();
   }
   for (auto type : symTable->types)
   {
     std::string typeName = type.first;
     SymbolType* typeSym = type.second.get();
-    print() << typeSym->GetQualifiedName() << std::endl;
+    print() << typeSym->GetQualifiedName() << '\n';
 
     switch (typeSym->GetType())
     {
@@ -193,7 +193,7 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
       SymbolStruct* symStruct = static_cast<SymbolStruct*>(typeSym);
       if (symStruct->complete)
       {
-        PrintSymbolTable(symStruct->GetSymbolTable().get(), indentLevel + 1);
+        PrintSymbolTable(symStruct->GetSymbolTable().get(), out, indentLevel + 1);
       }
       break;
     }
@@ -203,20 +203,20 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
       break;
     }
     }
-    print() << std::endl;
+    print() << '\n';
   }
 
   // variables -----------------------------------------------------------
   if (symTable->variables.size() > 0)
   {
-    print() << "variables:" << std::endl;
+    print() << "variables:" << '\n';
     splitter();
   }
   if (symTableOrdered != NULL)
   {
     for (auto var : symTableOrdered->orderedVariables)
     {
-      print() << var->GetQualifiedName() << std::endl;
+      print() << var->GetQualifiedName() << '\n';
     }
   }
   else
@@ -225,14 +225,14 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
     {
       std::string varName = var.first;
       SymbolVariable* varSym = var.second.get();
-      print() << varSym->GetQualifiedName() << std::endl;
+      print() << varSym->GetQualifiedName() << '\n';
     }
   }
 
   // functions -----------------------------------------------------------
   if (symTable->functions.size() > 0)
   {
-    print() << "functions:" << std::endl;
+    print() << "functions:" << '\n';
     splitter();
   }
 
@@ -241,12 +241,12 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
     if (statement->GetStatementType() == EStatementType::COMPOUND)
     {
       CompoundStatement* compoundStatement = static_cast<CompoundStatement*>(statement);
-      PrintSymbolTable(compoundStatement->GetSymbolTable().get(), indentLevel + 1);
+      PrintSymbolTable(compoundStatement->GetSymbolTable().get(), out, indentLevel + 1);
     }
     else if (statement->GetStatementType() == EStatementType::ITERATION_FOR)
     {
       ForStatement* forStatement = static_cast<ForStatement*>(statement);
-      PrintSymbolTable(forStatement->GetSymbolTable().get(), indentLevel + 1);
+      PrintSymbolTable(forStatement->GetSymbolTable().get(), out, indentLevel + 1);
     }
 
     for (int i = 0; i < statement->GetChildCount(); i++)
@@ -255,18 +255,18 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
       if (IsStatement(node->token))
       {
         Statement* statement = static_cast<Statement*>(node);
-        // printn(depth) << statement->token.text << std::endl;
+        // printn(depth) << statement->token.text << '\n';
         // splittern(depth);
         prolog(statement->token.text, depth);
         f(statement, depth + 1);
         epilog(statement->token.text, depth);
         // splittern(depth);
-        // printn(depth) << "end of " << statement->token.text << std::endl;
+        // printn(depth) << "end of " << statement->token.text << '\n';
       }
       else
       {
-        PrintAST(node, depth);
-        std::cout << std::endl << std::endl;
+        PrintAST(node, out, depth);
+        out << "\n\n";
       }
     }
 
@@ -276,11 +276,11 @@ void PrintSymbolTable(SymbolTable* symTable, int indentLevel)
   {
     std::string functionName = function.first;
     SymbolVariable* functionSym = function.second.get();
-    print() << functionSym->GetQualifiedName() << std::endl;
+    print() << functionSym->GetQualifiedName() << '\n';
     SymbolFunctionType* symFunType = static_cast<SymbolFunctionType*>(functionSym->GetRefSymbol().get());
     if (symFunType->GetSymbolTable() != NULL)
     {
-      PrintSymbolTable(symFunType->GetSymbolTable().get(), indentLevel + 1);
+      PrintSymbolTable(symFunType->GetSymbolTable().get(), out, indentLevel + 1);
     }
     CompoundStatement* body = symFunType->GetBody().get();
     if (body != NULL)
@@ -4,8 +4,9 @@ namespace Compiler
 {
 class ASTNode;
 class SymbolTable;
+class OutputSink;
 
-void PrintAST(ASTNode *root, int indentLevel = 0);
-void PrintSymbolTable(SymbolTable* symTable, int indentLevel = 0);
+void PrintAST(ASTNode *root, OutputSink& out, int indentLevel = 0);
+void PrintSymbolTable(SymbolTable* symTable, OutputSink& out, int indentLevel = 0);
 
 } // namespace Compiler
@@ -37,7 +37,7 @@ int UTF8Decode(int* in, int& out)
 
   // FSA
   // TODO: handle invalid UTF-8 sequences e.g. overlongs, surrogates
-  static unsigned char table[] =
+  static const unsigned char table[] =
   {
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 000-015
     0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, // 016-031
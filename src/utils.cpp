@@ -1,6 +1,7 @@
 #include "utils.hpp"
 
 #include <sstream>
+#include <iomanip>
 #include <exception>
 #include <cassert>
 
@@ -524,4 +525,69 @@ bool IsStatement(const ETokenType& tokenType)
   }
 }
 
+//==============================================================================
+namespace
+{
+// length of well-formed UTF-8 sequence at `p`, 0 if it isn't one: stray
+// continuation bytes, overlong forms, surrogates and code points past
+// U+10FFFF, and sequences cut short by `end`
+size_t GetUTF8SequenceLength(const unsigned char* p, const unsigned char* end)
+{
+  size_t length = p[0] < 0x80 ? 1 : p[0] < 0xC2 ? 0 : p[0] < 0xE0 ? 2 : p[0] < 0xF0 ? 3 : p[0] < 0xF5 ? 4 : 0;
+  if (length == 0 || static_cast<size_t>(end - p) < length)
+  {
+    return 0;
+  }
+  // second byte has narrower range after these leads
+  unsigned char low = p[0] == 0xE0 ? 0xA0 : p[0] == 0xF0 ? 0x90 : 0x80;
+  unsigned char high = p[0] == 0xED ? 0x9F : p[0] == 0xF4 ? 0x8F : 0xBF;
+  if (length > 1 && (p[1] < low || p[1] > high))
+  {
+    return 0;
+  }
+  for (size_t i = 2; i < length; i++)
+  {
+    if ((p[i] & 0xC0) != 0x80)
+    {
+      return 0;
+    }
+  }
+  return length;
+}
+
+} // namespace
+
+//==============================================================================
+void WriteJsonString(std::ostream& out, const std::string& text)
+{
+  out << '"';
+  const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+  const unsigned char* end = p + text.size();
+  while (p < end)
+  {
+    size_t length = GetUTF8SequenceLength(p, end);
+    if (length == 0)
+    {
+      // JSON text must be UTF-8, source text in messages needn't be
+      out << "\\ufffd";
+      p++;
+    }
+    else if (*p == '"' || *p == '\\')
+    {
+      out << '\\' << static_cast<char>(*p++);
+    }
+    else if (*p < 0x20)
+    {
+      out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+          << static_cast<int>(*p++) << std::dec << std::setfill(' ');
+    }
+    else
+    {
+      out.write(reinterpret_cast<const char*>(p), length);
+      p += length;
+    }
+  }
+  out << '"';
+}
+
 } // namespace Compiler
@@ -2,6 +2,7 @@
 
 #include <string>
 #include <vector>
+#include <iosfwd>
 
 #include "constants.hpp"
 
@@ -64,4 +65,7 @@ bool IsBinaryOperator(const ETokenType& tokenType);
 bool IsLiteral(const ETokenType& tokenType);
 bool IsStatement(const ETokenType& tokenType);
 
+// quoted and escaped as JSON string, bytes which aren't UTF-8 become U+FFFD
+void WriteJsonString(std::ostream& out, const std::string& text);
+
 } // namespace Compiler
@@ -0,0 +1,343 @@
+#include "CompileWorker.hpp"
+
+#include <iostream>
+#include <streambuf>
+#include <functional>
+#include <chrono>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "DebugTokenOutputStream.hpp"
+#include "SimpleExpressionParser.hpp"
+#include "ExpressionParser.hpp"
+#include "Parser.hpp"
+#include "codegen.hpp"
+#include "BytecodeCompiler.hpp"
+#include "TokenPipeline.hpp"
+
+#include "MainWindow.hpp"
+
+namespace
+{
+    // output is passed on once this much of it is gathered
+    const size_t chunkSize = 64 * 1024;
+
+    // gathers everything written to streams it's set for, in order, and
+    // passes it on in chunks of whole lines, so UTF-8 isn't split
+    class ChunkStream : public std::basic_streambuf<char>
+    {
+    public:
+        typedef std::function<void(const std::string&)> Writer;
+
+        explicit ChunkStream(const Writer& writer)
+            : writer_(writer)
+        {
+
+        }
+
+        // passes on what is left
+        void Flush()
+        {
+            if (!chunk_.empty())
+            {
+                writer_(chunk_);
+                chunk_.clear();
+            }
+        }
+
+    protected:
+        virtual int_type overflow(int_type v)
+        {
+            if (v != traits_type::eof())
+            {
+                chunk_ += static_cast<char>(v);
+                PassChunk_();
+            }
+            return v;
+        }
+
+        virtual std::streamsize xsputn(const char* p, std::streamsize n)
+        {
+            chunk_.append(p, n);
+            PassChunk_();
+            return n;
+        }
+
+    private:
+        Writer writer_;
+        std::string chunk_;
+
+        void PassChunk_()
+        {
+            if (chunk_.size() < chunkSize)
+            {
+                return;
+            }
+            size_t end = chunk_.rfind('\n');
+            if (end != std::string::npos)
+            {
+                writer_(chunk_.substr(0, end + 1));
+                chunk_.erase(0, end + 1);
+            }
+        }
+    };
+
+    // sets stream buffer for its lifetime
+    class StreamRedirect
+    {
+    public:
+        StreamRedirect(std::ostream& stream, std::streambuf* buffer)
+            : stream_(stream)
+            , oldBuffer_(stream.rdbuf(buffer))
+        {
+
+        }
+
+        ~StreamRedirect()
+        {
+            stream_.rdbuf(oldBuffer_);
+        }
+
+    private:
+        std::ostream& stream_;
+        std::streambuf* oldBuffer_;
+    };
+
+    // passes tokens to `consumer` until `cancelled` is set
+    class CancellableTokenStream : public Compiler::TokenWriter
+    {
+    public:
+        CancellableTokenStream(Compiler::ITokenStream& consumer, const std::atomic<bool>& cancelled)
+            : consumer_(consumer)
+            , cancelled_(cancelled)
+        {
+
+        }
+
+    protected:
+        virtual void Write_(Compiler::PipelinedToken& token)
+        {
+            if (cancelled_)
+            {
+                throw CompileCancelled();
+            }
+            Compiler::ReplayToken(token, consumer_);
+        }
+
+    private:
+        Compiler::ITokenStream& consumer_;
+        const std::atomic<bool>& cancelled_;
+    };
+
+} // namespace
+
+void RunCompiler(const std::vector<char>& input, CompilerMode mode,
+                 const std::atomic<bool>* cancelled)
+{
+    using namespace Compiler;
+
+    ITokenStream* output = NULL;
+    try
+    {
+        switch (mode)
+        {
+            case CompilerMode::TOKENIZER:
+            {
+                output = new DebugTokenOutputStream(std::cout);
+                break;
+            }
+
+            case CompilerMode::SIMPLE_EXPRESSION:
+            {
+                output = new SimpleExpressionParser;
+                break;
+            }
+
+            case CompilerMode::EXPRESSION_PARSER:
+            {
+                output = new ExpressionParser;
+                break;
+            }
+
+            case CompilerMode::PARSER:
+            {
+                output = new Parser(std::cout);
+                break;
+            }
+
+            case CompilerMode::TYPE_CHECK:
+            {
+                output = new Parser(std::cout);
+                break;
+            }
+
+            case CompilerMode::GENERATOR:
+            {
+                output = new CodeGenerator(std::cout);
+                break;
+            }
+
+            case CompilerMode::BYTECODE:
+            {
+                output = new BytecodeGenerator(true, std::cout);
+                break;
+            }
+
+            default:
+            {
+                throw std::runtime_error("unknown compiler mode");
+                break;
+            }
+        }
+
+        if (cancelled != NULL)
+        {
+            CancellableTokenStream stream(*output, *cancelled);
+            Tokenizer tokenizer(stream);
+            PreTokenizer preTokenizer(input, tokenizer);
+        }
+        else
+        {
+            Tokenizer tokenizer(*output);
+            PreTokenizer preTokenizer(input, tokenizer);
+        }
+    }
+    catch (CompileCancelled&)
+    {
+        delete output;
+        throw;
+    }
+    catch (std::exception& e)
+    {
+        output->Flush();
+        std::cerr << "ERROR: " << e.what() << std::endl;
+    }
+    catch (boost::coroutines::detail::forced_unwind&)
+    {
+        throw;
+    }
+    catch (...)
+    {
+        std::cerr << "ERROR: unknown exception";
+    }
+
+    delete output;
+}
+
+CompileWorker::CompileWorker(QObject* parent)
+    : QObject(parent)
+{
+    thread_ = std::thread(&CompileWorker::Run_, this);
+}
+
+CompileWorker::~CompileWorker()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        quit_ = true;
+        cancelled_ = true;
+        changed_.notify_all();
+    }
+    thread_.join();
+}
+
+unsigned CompileWorker::Compile(const std::vector<char>& input, CompilerMode mode, bool incremental)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_.input = input;
+    pending_.mode = mode;
+    pending_.incremental = incremental;
+    pending_.id = ++lastId_;
+    hasPending_ = true;
+    // request in progress, if any, is stale now
+    cancelled_ = true;
+    changed_.notify_all();
+    return lastId_;
+}
+
+void CompileWorker::Reset()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    reset_ = true;
+}
+
+void CompileWorker::Cancel()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    hasPending_ = false;
+    cancelled_ = true;
+    changed_.wait(lock, [this] { return !busy_; });
+}
+
+void CompileWorker::Run_()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true)
+    {
+        changed_.wait(lock, [this] { return quit_ || hasPending_; });
+        if (quit_)
+        {
+            return;
+        }
+
+        Request request = std::move(pending_);
+        hasPending_ = false;
+        busy_ = true;
+        cancelled_ = false;
+        if (reset_)
+        {
+            incrementalParser_.Reset();
+            reset_ = false;
+        }
+
+        lock.unlock();
+        Process_(request);
+        lock.lock();
+
+        busy_ = false;
+        changed_.notify_all();
+    }
+}
+
+void CompileWorker::Process_(Request& request)
+{
+    using namespace std;
+
+    ChunkStream chunks([&](const string& chunk)
+    {
+        emit OutputReady(request.id, QString::fromUtf8(chunk.data(), chunk.size()));
+    });
+
+    QString status;
+    try
+    {
+        StreamRedirect coutRedirect(cout, &chunks);
+        StreamRedirect cerrRedirect(cerr, &chunks);
+        if (request.incremental
+            && (request.mode == CompilerMode::PARSER || request.mode == CompilerMode::TYPE_CHECK))
+        {
+            incrementalParser_.Parse(request.input);
+            const Compiler::IncrementalParser::Statistics& statistics = incrementalParser_.GetStatistics();
+            status = QString("%1 %2 ms, %3 declarations parsed, %4 reused, %5 bytes tokenized")
+                    .arg(statistics.incremental ? "reparse" : "parse")
+                    .arg(statistics.seconds * 1000.0, 0, 'f', 2)
+                    .arg(statistics.parsedDeclarations)
+                    .arg(statistics.reusedDeclarations)
+                    .arg(statistics.tokenizedBytes);
+        }
+        else
+        {
+            auto start = chrono::steady_clock::now();
+            RunCompiler(request.input, request.mode, &cancelled_);
+            double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            status = QString("compile %1 ms").arg(seconds * 1000.0, 0, 'f', 2);
+        }
+    }
+    catch (CompileCancelled&)
+    {
+        return;
+    }
+
+    chunks.Flush();
+    emit Finished(request.id, status);
+}
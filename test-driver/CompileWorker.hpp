@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+#include <QObject>
+#include <QString>
+
+#include "IncrementalParser.hpp"
+
+enum class CompilerMode;
+
+// thrown out of RunCompiler once it's cancelled, nothing is printed then
+struct CompileCancelled
+{
+
+};
+
+// compiles `input` as `mode` says, output and errors go to std::cout and
+// std::cerr, stops at next token once `cancelled` is set
+void RunCompiler(const std::vector<char>& input, CompilerMode mode,
+                 const std::atomic<bool>* cancelled = NULL);
+
+// compiles on its own thread, so the editor isn't blocked by big input,
+// newer request cancels one in progress, output comes in chunks
+class CompileWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit CompileWorker(QObject* parent = 0);
+    virtual ~CompileWorker();
+
+    // returns at once with id of request, previous request is dropped or
+    // cancelled, parser modes are parsed incrementally if `incremental`
+    unsigned Compile(const std::vector<char>& input, CompilerMode mode, bool incremental);
+    // next incremental parse starts from scratch
+    void Reset();
+    // returns once request in progress is cancelled and worker is idle,
+    // std::cout and std::cerr are left alone then
+    void Cancel();
+
+signals:
+    // output of request so far, in order
+    void OutputReady(unsigned request, QString output);
+    void Finished(unsigned request, QString status);
+
+private:
+    struct Request
+    {
+        std::vector<char> input;
+        CompilerMode mode;
+        bool incremental = false;
+        unsigned id = 0;
+    };
+
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    Request pending_;
+    bool hasPending_ = false;
+    bool busy_ = false;
+    bool reset_ = false;
+    bool quit_ = false;
+    unsigned lastId_ = 0;
+    std::atomic<bool> cancelled_{false};
+    // used on worker thread only
+    Compiler::IncrementalParser incrementalParser_;
+    std::thread thread_;
+
+    void Run_();
+    void Process_(Request& request);
+};
@@ -1,91 +1,433 @@
 #include "CxxHighlighter.hpp"
 
+#include <string>
+#include <stdexcept>
+#include <algorithm>
+
+#include <QTextDocument>
+#include <QTextBlock>
+
 #include "constants.hpp"
+#include "utils.hpp"
+#include "unicode.hpp"
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
 
-CxxHighlighter::CxxHighlighter(QTextDocument *parent)
-    : QSyntaxHighlighter(parent)
+namespace
 {
-    HighlightingRule rule;
+    // what a piece of line is, as compiler's tokenizer sees it
+    enum SpanKind
+    {
+        SK_KEYWORD,
+        SK_IDENTIFIER,
+        SK_FUNCTION,
+        SK_CONSTANT,
+        SK_LITERAL,
+        SK_PUNCTUATION,
+        SK_COMMENT,
+        SK_INVALID,
+        SK_COUNT,
+    };
+
+    struct Span
+    {
+        int begin;
+        int end;
+        SpanKind kind;
+    };
+
+    // block states, -1 is for blocks not highlighted yet
+    enum BlockState
+    {
+        BS_NORMAL = 0,
+        BS_INLINE_COMMENT = 1,
+        // block ends with a splice, the rest of state value is hash of line
+        // up to block end, so the next block is highlighted again once
+        // anything it's spliced to changes
+        BS_SPLICED = 2,
+    };
+
+    // lets pretokenizer start inside inline comment, "/*" alone would be
+    // closed by "/" at line start
+    const char commentPrefix[] = "/* ";
+
+    // kind of the last token tokenizer emitted
+    class TokenKindStream : public Compiler::ITokenStream
+    {
+    public:
+        SpanKind kind = SK_INVALID;
+
+        virtual void EmitInvalid(const std::string&, const int, const int)
+        {
+            kind = SK_INVALID;
+        }
+
+        virtual void EmitKeyword(const std::string&, Compiler::ETokenType, const int, const int)
+        {
+            kind = SK_KEYWORD;
+        }
+
+        virtual void EmitPunctuation(const std::string&, Compiler::ETokenType, const int, const int)
+        {
+            kind = SK_PUNCTUATION;
+        }
+
+        virtual void EmitIdentifier(const std::string&, const int, const int)
+        {
+            kind = SK_IDENTIFIER;
+        }
+
+        virtual void EmitLiteral(const std::string&, Compiler::EFundamentalType,
+                                 const void*, size_t, const int, const int)
+        {
+            kind = SK_CONSTANT;
+        }
+
+        virtual void EmitLiteralArray(const std::string&, size_t, Compiler::EFundamentalType,
+                                      const void*, size_t, const int, const int)
+        {
+            kind = SK_LITERAL;
+        }
+
+        virtual void EmitEof(const int, const int)
+        {
 
-    keywordFormat.setForeground(Qt::darkBlue);
-    keywordFormat.setFontWeight(QFont::Bold);
-    QStringList keywordPatterns;
-    for (const auto& keyword : Compiler::stringToKeywordTypeMap)
+        }
+    };
+
+    // turns pretokens into spans of code points, each pretoken is passed to
+    // tokenizer alone, so it tells what the pretoken is
+    class SpanStream : public Compiler::IPreTokenStream
     {
-        keywordPatterns << (QString("\\b") + QString().fromStdString(keyword.first) + QString("\\b"));
+    public:
+        SpanStream(const std::vector<int>& codePoints, std::vector<Span>& spans)
+            : codePoints_(codePoints)
+            , spans_(spans)
+            , tokenizer_(kinds_)
+        {
+
+        }
+
+        // code points up to here are in spans
+        int GetPosition() const
+        {
+            return position_;
+        }
+
+        virtual void EmitWhitespaceSequence(const int rowOffset)
+        {
+            // the only thing in whitespace sequence besides whitespace is comment
+            for (int i = position_; i < position_ + rowOffset; i++)
+            {
+                if (!Compiler::IsWhiteSpace(codePoints_[i]))
+                {
+                    spans_.push_back({position_, position_ + rowOffset, SK_COMMENT});
+                    break;
+                }
+            }
+            position_ += rowOffset;
+        }
+
+        virtual void EmitNewLine()
+        {
+
+        }
+
+        virtual void EmitIdentifier(const int* data, size_t size)
+        {
+            Tokenize_([&] { tokenizer_.EmitIdentifier(data, size); });
+            Push_(size + 1, kinds_.kind);
+        }
+
+        virtual void EmitPpNumber(const std::string& data)
+        {
+            Tokenize_([&] { tokenizer_.EmitPpNumber(data); });
+            Push_(CodePointCount_(data), kinds_.kind);
+        }
+
+        virtual void EmitCharacterLiteral(const std::string& data)
+        {
+            Tokenize_([&] { tokenizer_.EmitCharacterLiteral(data); });
+            Push_(CodePointCount_(data), kinds_.kind == SK_INVALID ? SK_INVALID : SK_LITERAL);
+        }
+
+        virtual void EmitStringLiteral(const std::string& data)
+        {
+            // adjacent literals are not joined, so this one is emitted now
+            Tokenize_([&] { tokenizer_.EmitStringLiteral(data); tokenizer_.Flush(); });
+            Push_(CodePointCount_(data), kinds_.kind);
+        }
+
+        virtual void EmitPunctuation(const std::string& data)
+        {
+            Tokenize_([&] { tokenizer_.EmitPunctuation(data); });
+            if (data == "(" && !spans_.empty() && spans_.back().kind == SK_IDENTIFIER)
+            {
+                spans_.back().kind = SK_FUNCTION;
+            }
+            Push_(data.size(), kinds_.kind);
+        }
+
+        virtual void EmitNonWhitespaceChar(const std::string& data)
+        {
+            Push_(CodePointCount_(data), SK_INVALID);
+        }
+
+        virtual void EmitEof()
+        {
+
+        }
+
+        virtual void Flush()
+        {
+
+        }
+
+    private:
+        const std::vector<int>& codePoints_;
+        std::vector<Span>& spans_;
+        TokenKindStream kinds_;
+        Compiler::Tokenizer tokenizer_;
+        int position_ = 0;
+
+        template<typename F>
+        void Tokenize_(F tokenize)
+        {
+            kinds_.kind = SK_INVALID;
+            try
+            {
+                tokenize();
+            }
+            catch (std::exception&)
+            {
+                kinds_.kind = SK_INVALID;
+            }
+        }
+
+        void Push_(size_t size, SpanKind kind)
+        {
+            spans_.push_back({position_, position_ + static_cast<int>(size), kind});
+            position_ += size;
+        }
+
+        static size_t CodePointCount_(const std::string& data)
+        {
+            return std::count_if(data.begin(), data.end(), [](char c)
+            {
+                return (static_cast<unsigned char>(c) & 0xC0) != 0x80;
+            });
+        }
+    };
+
+    bool EndsWithSplice(const QString& text)
+    {
+        return text.endsWith('\\') || text.endsWith("?\?/");
     }
 
-    foreach (const QString& pattern, keywordPatterns)
+    // splits logical line of `size` UTF-16 units into spans of UTF-16 units,
+    // returns true if line ends inside inline comment
+    bool LexLine(const ushort* units, int size, bool inComment, std::vector<Span>& spans)
     {
-        rule.pattern = QRegExp(pattern);
-        rule.format = keywordFormat;
-        highlightingRules.append(rule);
+        using namespace std;
+
+        // code points as pretokenizer sees them, with range of units each
+        // of them comes from
+        vector<int> codePoints;
+        vector<int> begins;
+        vector<int> ends;
+        string input;
+        if (inComment)
+        {
+            input = commentPrefix;
+            for (char c : input)
+            {
+                codePoints.push_back(c);
+                begins.push_back(0);
+                ends.push_back(0);
+            }
+        }
+        for (int i = 0; i < size;)
+        {
+            int c = units[i];
+            int width = 1;
+            if (0xD800 <= c && c < 0xDC00
+                && i + 1 < size && 0xDC00 <= units[i + 1] && units[i + 1] < 0xE000)
+            {
+                c = 0x10000 + ((c - 0xD800) << 10) + (units[i + 1] - 0xDC00);
+                width = 2;
+            }
+            char utf8[4];
+            input.append(utf8, UTF8Encode(c, utf8));
+            codePoints.push_back(c);
+            begins.push_back(i);
+            ends.push_back(i + width);
+            i += width;
+        }
+
+        // trigraphs and splices are replaced the way pretokenizer does
+        size_t j = 0;
+        for (size_t i = 0; i < codePoints.size(); i++, j++)
+        {
+            if (i + 2 < codePoints.size()
+                && codePoints[i] == '?' && codePoints[i + 1] == '?'
+                && Compiler::trigraphReplacement.count(codePoints[i + 2]) > 0)
+            {
+                codePoints[j] = Compiler::trigraphReplacement.at(codePoints[i + 2]);
+                begins[j] = begins[i];
+                ends[j] = ends[i + 2];
+                i += 2;
+                continue;
+            }
+            codePoints[j] = codePoints[i];
+            begins[j] = begins[i];
+            ends[j] = ends[i];
+        }
+        codePoints.resize(j);
+        j = 0;
+        for (size_t i = 0; i < codePoints.size(); i++)
+        {
+            if (i + 1 < codePoints.size() && codePoints[i] == '\\' && codePoints[i + 1] == '\n')
+            {
+                i++;
+                continue;
+            }
+            codePoints[j] = codePoints[i];
+            begins[j] = begins[i];
+            ends[j] = ends[i];
+            j++;
+        }
+        codePoints.resize(j);
+
+        bool endsInComment = false;
+        SpanStream stream(codePoints, spans);
+        try
+        {
+            Compiler::PreTokenizer preTokenizer(vector<char>(input.begin(), input.end()), stream);
+        }
+        catch (std::exception& e)
+        {
+            // rest of line is what pretokenizer stopped at
+            endsInComment = string(e.what()) == "unterminated inline comment";
+            spans.push_back({stream.GetPosition(), static_cast<int>(codePoints.size()),
+                             endsInComment ? SK_COMMENT : SK_INVALID});
+        }
+
+        j = 0;
+        for (size_t i = 0; i < spans.size(); i++)
+        {
+            Span span = spans[i];
+            if (span.begin >= span.end)
+            {
+                continue;
+            }
+            span.begin = begins[span.begin];
+            span.end = ends[span.end - 1];
+            if (span.begin < span.end)
+            {
+                spans[j++] = span;
+            }
+        }
+        spans.resize(j);
+        return endsInComment;
     }
 
-    classFormat.setFontWeight(QFont::Bold);
-    classFormat.setForeground(Qt::darkMagenta);
-    rule.pattern = QRegExp("\\bQ[A-Za-z]+\\b");
-    rule.format = classFormat;
-    highlightingRules.append(rule);
+} // namespace
+
+CxxHighlighter::CxxHighlighter(QTextDocument *parent)
+    : QSyntaxHighlighter(parent)
+    , formats_(SK_COUNT)
+{
+    formats_[SK_KEYWORD].setForeground(Qt::darkBlue);
+    formats_[SK_KEYWORD].setFontWeight(QFont::Bold);
 
-    singleLineCommentFormat.setForeground(Qt::red);
-    rule.pattern = QRegExp("//[^\n]*");
-    rule.format = singleLineCommentFormat;
-    highlightingRules.append(rule);
+    formats_[SK_FUNCTION].setFontItalic(true);
+    formats_[SK_FUNCTION].setForeground(Qt::blue);
 
-    multiLineCommentFormat.setForeground(Qt::red);
+    formats_[SK_CONSTANT].setForeground(Qt::darkMagenta);
 
-    quotationFormat.setForeground(Qt::darkGreen);
-    rule.pattern = QRegExp("\".*\"");
-    rule.format = quotationFormat;
-    highlightingRules.append(rule);
+    formats_[SK_LITERAL].setForeground(Qt::darkGreen);
 
-    functionFormat.setFontItalic(true);
-    functionFormat.setForeground(Qt::blue);
-    rule.pattern = QRegExp("\\b[A-Za-z0-9_]+(?=\\()");
-    rule.format = functionFormat;
-    highlightingRules.append(rule);
+    formats_[SK_COMMENT].setForeground(Qt::red);
 
-    commentStartExpression = QRegExp("/\\*");
-    commentEndExpression = QRegExp("\\*/");
+    formats_[SK_INVALID].setUnderlineStyle(QTextCharFormat::WaveUnderline);
+    formats_[SK_INVALID].setUnderlineColor(Qt::red);
 }
 
 void CxxHighlighter::highlightBlock(const QString& text)
 {
-    foreach (const HighlightingRule &rule, highlightingRules)
+    QTextBlock block = currentBlock();
+
+    // logical line starts after the last block not ending with a splice
+    QTextBlock first = block;
+    while (first.previous().isValid() && first.previous().userState() >= BS_SPLICED)
     {
-        QRegExp expression(rule.pattern);
-        int index = expression.indexIn(text);
-        while (index >= 0)
-        {
-            int length = expression.matchedLength();
-            setFormat(index, length, rule.format);
-            index = expression.indexIn(text, index + length);
-        }
+        first = first.previous();
+    }
+    int startState = BS_NORMAL;
+    if (first.previous().isValid() && first.previous().userState() == BS_INLINE_COMMENT)
+    {
+        startState = BS_INLINE_COMMENT;
     }
-    setCurrentBlockState(0);
 
-    int startIndex = 0;
-    if (previousBlockState() != 1)
+    QString line;
+    for (QTextBlock b = first; b != block; b = b.next())
     {
-        startIndex = commentStartExpression.indexIn(text);
+        line += b.text();
+        line += '\n';
+    }
+    int blockStart = line.size();
+    line += text;
+    uint hash = qHash(line) ^ static_cast<uint>(startState);
+    // tokens this block ends with may go on in the next blocks
+    QString rest = text;
+    for (QTextBlock b = block.next(); b.isValid() && EndsWithSplice(rest); b = b.next())
+    {
+        rest = b.text();
+        line += '\n';
+        line += rest;
+    }
+
+    std::vector<Span> spans;
+    bool endsInComment = LexLine(line.utf16(), line.size(), startState == BS_INLINE_COMMENT, spans);
+    if (EndsWithSplice(text))
+    {
+        setCurrentBlockState(BS_SPLICED + static_cast<int>(hash & 0x3FFFFFFF));
+    }
+    else
+    {
+        setCurrentBlockState(endsInComment ? BS_INLINE_COMMENT : BS_NORMAL);
     }
 
-    while (startIndex >= 0)
+    int blockEnd = blockStart + text.size();
+    bool continuesPrevious = false;
+    for (const Span& span : spans)
     {
-        int endIndex = commentEndExpression.indexIn(text, startIndex);
-        int commentLength;
-        if (endIndex == -1)
+        int begin = std::max(span.begin, blockStart);
+        int end = std::min(span.end, blockEnd);
+        if (begin < end && span.kind != SK_IDENTIFIER && span.kind != SK_PUNCTUATION)
         {
-            setCurrentBlockState(1);
-            commentLength = text.length() - startIndex;
+            setFormat(begin - blockStart, end - begin, formats_[span.kind]);
         }
-        else
+        if (span.begin < blockStart && span.end > blockStart && span.kind != SK_COMMENT)
         {
-            commentLength = endIndex - startIndex
-                            + commentEndExpression.matchedLength();
+            continuesPrevious = true;
         }
-        setFormat(startIndex, commentLength, multiLineCommentFormat);
-        startIndex = commentStartExpression.indexIn(text, startIndex + commentLength);
+    }
+
+    // highlighting of token's beginning in previous block depends on this
+    // one, but previous blocks are not highlighted again by themselves
+    if (continuesPrevious)
+    {
+        QMetaObject::invokeMethod(this, "RehighlightBlock_", Qt::QueuedConnection,
+                                  Q_ARG(int, block.blockNumber() - 1));
+    }
+}
+
+void CxxHighlighter::RehighlightBlock_(int number)
+{
+    QTextBlock block = document()->findBlockByNumber(number);
+    if (block.isValid())
+    {
+        rehighlightBlock(block);
     }
 }
@@ -1,7 +1,13 @@
 #pragma once
 
+#include <vector>
+
 #include <QSyntaxHighlighter>
+#include <QTextCharFormat>
 
+// highlights text as compiler's tokenizer sees it, line by line: block state
+// tells whether line ends inside inline comment or continues in the next
+// block through a splice, so an edit re-lexes only blocks it reaches
 class CxxHighlighter : public QSyntaxHighlighter
 {
     Q_OBJECT
@@ -16,21 +22,10 @@ public:
 protected:
     void highlightBlock(const QString &text);
 
+private slots:
+    void RehighlightBlock_(int number);
+
 private:
-    struct HighlightingRule
-    {
-        QRegExp pattern;
-        QTextCharFormat format;
-    };
-    QVector<HighlightingRule> highlightingRules;
-
-    QRegExp commentStartExpression;
-    QRegExp commentEndExpression;
-
-    QTextCharFormat keywordFormat;
-    QTextCharFormat classFormat;
-    QTextCharFormat singleLineCommentFormat;
-    QTextCharFormat multiLineCommentFormat;
-    QTextCharFormat quotationFormat;
-    QTextCharFormat functionFormat;
+    // by kind of piece of line
+    std::vector<QTextCharFormat> formats_;
 };
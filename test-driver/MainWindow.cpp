@@ -2,6 +2,7 @@
 #include "ui_mainwindow.h"
 
 #include <cassert>
+#include <algorithm>
 
 #include <QTimer>
 #include <QTextCodec>
@@ -22,33 +23,63 @@
 #include <QSettings>
 
 #include "constants.hpp"
-#include "PreTokenizer.hpp"
-#include "Tokenizer.hpp"
 #include "DebugPreTokenStream.hpp"
-#include "DebugTokenOutputStream.hpp"
-#include "SimpleExpressionParser.hpp"
-#include "ExpressionParser.hpp"
-#include "Parser.hpp"
-#include "codegen.hpp"
 
 #include "CxxHighlighter.hpp"
 #include "DebugStream.hpp"
 #include "CodeEditor.hpp"
+#include "CompileWorker.hpp"
 
 class QTextDocument;
 
 void MainWindow::OnInputTextChanged()
+{
+    // incremental parse of a keystroke is quick, no reason to wait
+    compileTimer_->start(IsIncremental_() ? 0 : 200);
+}
+
+void MainWindow::OnCompileTimeout()
 {
     QString text = ui->qpteInput->toPlainText();
-    ui->qpteOutput->clear();
     QByteArray utf8 = text.toUtf8();
     std::vector<char> input(utf8.size());
     for (int i = 0; i < utf8.size(); i++)
     {
         input[i] = utf8[i];
     }
-    RunCompiler_(input);
-    ui->qpteOutput->appendPlainText("");
+    compileRequest_ = compileWorker_->Compile(input, mode_, ui->actionIncremental_Reparse->isChecked());
+}
+
+void MainWindow::OnCompileOutputReady(unsigned request, QString output)
+{
+    if (request != compileRequest_)
+    {
+        return;
+    }
+    // previous output stays until there is something to replace it
+    if (shownRequest_ != request)
+    {
+        ui->qpteOutput->clear();
+        shownRequest_ = request;
+    }
+    ui->qpteOutput->moveCursor(QTextCursor::End);
+    ui->qpteOutput->insertPlainText(output);
+}
+
+void MainWindow::OnCompileFinished(unsigned request, QString status)
+{
+    if (request != compileRequest_)
+    {
+        return;
+    }
+    if (shownRequest_ != request)
+    {
+        ui->qpteOutput->clear();
+        shownRequest_ = request;
+    }
+    qlCompileStatus_->setText(status);
+    ui->qpteOutput->moveCursor(QTextCursor::Start);
+    ui->qpteOutput->ensureCursorVisible();
 }
 
 void MainWindow::OnOutputTextChanged()
@@ -69,6 +100,7 @@ std::map<CompilerMode, std::string> CompilerModeToString =
     {CompilerMode::PARSER, "Parser"},
     {CompilerMode::TYPE_CHECK, "Type Check"},
     {CompilerMode::GENERATOR, "Generator"},
+    {CompilerMode::BYTECODE, "Bytecode"},
 };
 
 std::map<CompilerMode, std::string> CompilerModeToTestDir =
@@ -79,6 +111,7 @@ std::map<CompilerMode, std::string> CompilerModeToTestDir =
     {CompilerMode::PARSER, "../tests/parser/"},
     {CompilerMode::TYPE_CHECK, "../tests/type-check/"},
     {CompilerMode::GENERATOR, "../tests/codegen/"},
+    {CompilerMode::BYTECODE, "../tests/bytecode/"},
 };
 
 MainWindow::MainWindow(QWidget *parent)
@@ -92,8 +125,20 @@ MainWindow::MainWindow(QWidget *parent)
     ui->setupUi(this);
     qlStatus_ = new QLabel;
     qlLineColumn_ = new QLabel;
+    qlCompileStatus_ = new QLabel;
     ui->statusBar->addWidget(qlStatus_);
     ui->statusBar->addWidget(qlLineColumn_);
+    ui->statusBar->addWidget(qlCompileStatus_);
+
+    compileWorker_ = new CompileWorker;
+    compileTimer_ = new QTimer(this);
+    compileTimer_->setSingleShot(true);
+    connect(compileTimer_, &QTimer::timeout,
+            this, &MainWindow::OnCompileTimeout);
+    connect(compileWorker_, &CompileWorker::OutputReady,
+            this, &MainWindow::OnCompileOutputReady);
+    connect(compileWorker_, &CompileWorker::Finished,
+            this, &MainWindow::OnCompileFinished);
 
     int modeCount = static_cast<int>(CompilerMode::COUNT);
     tests_.resize(modeCount);
@@ -173,6 +218,7 @@ MainWindow::MainWindow(QWidget *parent)
 
 MainWindow::~MainWindow()
 {
+    delete compileWorker_;
     delete cxxHighlighter_;
     delete debugStreamCout_;
     delete debugStreamCerr_;
@@ -203,6 +249,7 @@ void MainWindow::CompareOutputWithReference_()
 void MainWindow::SetMode_(const CompilerMode &mode)
 {
     mode_ = mode;
+    compileWorker_->Reset();
 }
 
 TestInfo &MainWindow::GetCurrentTest_()
@@ -233,80 +280,20 @@ void MainWindow::UpdateTest_()
 
 void MainWindow::RunCompiler_(std::vector<char> &input)
 {
-    using namespace Compiler;
     //        pretokenizer debug output
     //        DebugPreTokenStream debugPreTokenStream;
     //        PreTokenizer pretokenizer(input, debugPreTokenStream);
 
-    ITokenStream* output = NULL;
-    try
-    {
-        switch (mode_)
-        {
-            case CompilerMode::TOKENIZER:
-            {
-                output = new DebugTokenOutputStream;
-                break;
-            }
-
-            case CompilerMode::SIMPLE_EXPRESSION:
-            {
-                output = new SimpleExpressionParser;
-                break;
-            }
-
-            case CompilerMode::EXPRESSION_PARSER:
-            {
-                output = new ExpressionParser;
-                break;
-            }
-
-            case CompilerMode::PARSER:
-            {
-                output = new Parser;
-                break;
-            }
-
-            case CompilerMode::TYPE_CHECK:
-            {
-                output = new Parser;
-                break;
-            }
-
-            case CompilerMode::GENERATOR:
-            {
-                output = new CodeGenerator;
-                break;
-            }
-
-            default:
-            {
-                throw std::runtime_error("unknown compiler mode");
-                break;
-            }
-        }
-
-        Tokenizer tokenizer(*output);
-        PreTokenizer preTokenizer(input, tokenizer);
-    }
-    catch (std::exception& e)
-    {
-        output->Flush();
-        std::cerr << "ERROR: " << e.what() << std::endl;
-    }
-    catch (boost::coroutines::detail::forced_unwind&)
-    {
-        throw;
-    }
-    catch (...)
-    {
-        std::cerr << "ERROR: unknown exception";
-    }
+    RunCompiler(input, mode_);
 
     ui->qpteOutput->moveCursor(QTextCursor::Start);
     ui->qpteOutput->ensureCursorVisible();
+}
 
-    delete output;
+bool MainWindow::IsIncremental_() const
+{
+    return (mode_ == CompilerMode::PARSER || mode_ == CompilerMode::TYPE_CHECK)
+            && ui->actionIncremental_Reparse->isChecked();
 }
 
 void MainWindow::on_action_New_triggered()
@@ -363,6 +350,11 @@ void MainWindow::on_action_Run_Tests_for_Current_Mode_triggered()
         ui->menu_View->actions().at(2)->trigger();
     }
 
+    // tests redirect std::cout themselves
+    compileTimer_->stop();
+    compileWorker_->Cancel();
+    compileRequest_ = 0;
+
     int modeIndex = static_cast<int>(mode_);
 
     QDir dir(QString().fromStdString(CompilerModeToTestDir[mode_]),
@@ -440,6 +432,8 @@ void MainWindow::on_action_Run_Tests_for_Current_Mode_triggered()
         ui->qpteLog->appendPlainText("FAIL. FAILED TESTS ARE: " + failedTestsString);
     }
 
+    OnInputTextChanged();
+
 }
 
 void MainWindow::on_action_Tokenizer_triggered()
@@ -541,3 +535,15 @@ void MainWindow::on_actionCode_Generation_triggered()
     SetMode_(CompilerMode::GENERATOR);
     UpdateTest_();
 }
+
+void MainWindow::on_actionBytecode_triggered()
+{
+    SetMode_(CompilerMode::BYTECODE);
+    UpdateTest_();
+}
+
+void MainWindow::on_actionIncremental_Reparse_triggered()
+{
+    compileWorker_->Reset();
+    OnInputTextChanged();
+}
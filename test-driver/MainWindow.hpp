@@ -5,7 +5,9 @@
 #include <QMainWindow>
 
 class QLabel;
+class QTimer;
 class CxxHighlighter;
+class CompileWorker;
 
 namespace Ui
 {
@@ -20,6 +22,7 @@ enum class CompilerMode
     PARSER,
     TYPE_CHECK,
     GENERATOR,
+    BYTECODE,
     COUNT,
 };
 
@@ -38,6 +41,9 @@ public slots:
     void OnInputTextChanged();
     void OnOutputTextChanged();
     void OnReferenceTextChanged();
+    void OnCompileTimeout();
+    void OnCompileOutputReady(unsigned request, QString output);
+    void OnCompileFinished(unsigned request, QString status);
 
 private slots:
     void on_action_New_triggered();
@@ -64,6 +70,10 @@ private slots:
 
     void on_actionCode_Generation_triggered();
 
+    void on_actionBytecode_triggered();
+
+    void on_actionIncremental_Reparse_triggered();
+
 public:
     explicit MainWindow(QWidget *parent = 0);
     ~MainWindow();
@@ -75,9 +85,19 @@ private:
     std::vector<std::vector<TestInfo>> tests_;
     QLabel* qlStatus_ = NULL;
     QLabel* qlLineColumn_ = NULL;
+    QLabel* qlCompileStatus_ = NULL;
     DebugStream* debugStreamCout_ = NULL; // YES WE CAN WHAT A RELIEF
     DebugStream* debugStreamCerr_ = NULL;
     CxxHighlighter* cxxHighlighter_;
+    // compiles off UI thread, keeps previous input of parser modes,
+    // so a keystroke is parsed in time proportional to what it changes
+    CompileWorker* compileWorker_ = NULL;
+    // input is compiled once typing pauses
+    QTimer* compileTimer_ = NULL;
+    // output of other requests is stale
+    unsigned compileRequest_ = 0;
+    // request whose output is shown
+    unsigned shownRequest_ = 0;
 
     void CompareOutputWithReference_();
     void SetMode_(const CompilerMode& mode);
@@ -85,4 +105,5 @@ private:
     // reloads current mode_ current test
     void UpdateTest_();
     void RunCompiler_(std::vector<char>& input);
+    bool IsIncremental_() const;
 };
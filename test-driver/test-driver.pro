@@ -65,14 +65,27 @@ SOURCES += main.cpp\
     CodeEditor.cpp \
     DebugStream.cpp \
     CxxHighlighter.cpp \
+    CompileWorker.cpp \
     ../src/ExpressionParser.cpp \
     ../src/Token.cpp \
     ../src/Parser.cpp \
     ../src/ASTNode.cpp \
     ../src/SymbolTable.cpp \
     ../src/prettyPrinting.cpp \
+    ../src/OutputSink.cpp \
     ../src/Statement.cpp \
-    ../src/codegen.cpp
+    ../src/codegen.cpp \
+    ../src/ThreadPool.cpp \
+    ../src/AsmInstruction.cpp \
+    ../src/PeepholeOptimizer.cpp \
+    ../src/Bytecode.cpp \
+    ../src/BytecodeCompiler.cpp \
+    ../src/Interpreter.cpp \
+    ../src/Jit.cpp \
+    ../src/TokenPipeline.cpp \
+    ../src/IncrementalParser.cpp \
+    ../src/TimeReport.cpp \
+    ../src/Trace.cpp
 
 HEADERS += MainWindow.hpp \
     ../src/utils.hpp \
@@ -88,14 +101,28 @@ HEADERS += MainWindow.hpp \
     CodeEditor.hpp \
     DebugStream.hpp \
     CxxHighlighter.hpp \
+    CompileWorker.hpp \
     ../src/ExpressionParser.hpp \
     ../src/Token.hpp \
     ../src/Parser.hpp \
     ../src/ASTNode.hpp \
     ../src/SymbolTable.hpp \
     ../src/prettyPrinting.hpp \
+    ../src/OutputSink.hpp \
     ../src/Statement.hpp \
     ../src/Visitor.hpp \
-    ../src/codegen.hpp
+    ../src/codegen.hpp \
+    ../src/ThreadPool.hpp \
+    ../src/AsmInstruction.hpp \
+    ../src/PeepholeOptimizer.hpp \
+    ../src/Bytecode.hpp \
+    ../src/BytecodeCompiler.hpp \
+    ../src/Interpreter.hpp \
+    ../src/Jit.hpp \
+    ../src/SpscQueue.hpp \
+    ../src/TokenPipeline.hpp \
+    ../src/IncrementalParser.hpp \
+    ../src/TimeReport.hpp \
+    ../src/Trace.hpp
 
 FORMS += mainwindow.ui
@@ -49,6 +49,8 @@ public:
     QAction *actionAll_equal;
     QAction *actionType_Check;
     QAction *actionCode_Generation;
+    QAction *actionBytecode;
+    QAction *actionIncremental_Reparse;
     QWidget *centralWidget;
     QVBoxLayout *verticalLayout;
     QSplitter *splitter;
@@ -110,6 +112,12 @@ public:
         actionType_Check->setObjectName(QStringLiteral("actionType_Check"));
         actionCode_Generation = new QAction(MainWindow);
         actionCode_Generation->setObjectName(QStringLiteral("actionCode_Generation"));
+        actionBytecode = new QAction(MainWindow);
+        actionBytecode->setObjectName(QStringLiteral("actionBytecode"));
+        actionIncremental_Reparse = new QAction(MainWindow);
+        actionIncremental_Reparse->setObjectName(QStringLiteral("actionIncremental_Reparse"));
+        actionIncremental_Reparse->setCheckable(true);
+        actionIncremental_Reparse->setChecked(true);
         centralWidget = new QWidget(MainWindow);
         centralWidget->setObjectName(QStringLiteral("centralWidget"));
         verticalLayout = new QVBoxLayout(centralWidget);
@@ -182,6 +190,7 @@ public:
         menu_Select_Mode->addAction(action_Parser);
         menu_Select_Mode->addAction(actionType_Check);
         menu_Select_Mode->addAction(actionCode_Generation);
+        menu_Select_Mode->addAction(actionBytecode);
         menu_View->addAction(action_Prev);
         menu_View->addAction(action_Next);
         menu_View->addAction(action_Log);
@@ -193,6 +202,7 @@ public:
         menuExpand_panel->addSeparator();
         menuExpand_panel->addAction(actionAll_equal);
         menu_Run->addAction(action_Run_Tests_for_Current_Mode);
+        menu_Run->addAction(actionIncremental_Reparse);
 
         retranslateUi(MainWindow);
 
@@ -238,6 +248,8 @@ public:
         actionAll_equal->setShortcut(QApplication::translate("MainWindow", "Ctrl+Alt+5", 0));
         actionType_Check->setText(QApplication::translate("MainWindow", "Type Check", 0));
         actionCode_Generation->setText(QApplication::translate("MainWindow", "Code Generation", 0));
+        actionBytecode->setText(QApplication::translate("MainWindow", "Bytecode", 0));
+        actionIncremental_Reparse->setText(QApplication::translate("MainWindow", "&Incremental Reparse", 0));
         qpteOutput->setDocumentTitle(QApplication::translate("MainWindow", "Output", 0));
         menu_File->setTitle(QApplication::translate("MainWindow", "&File", 0));
         menu_Edit->setTitle(QApplication::translate("MainWindow", "&Edit", 0));
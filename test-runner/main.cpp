@@ -0,0 +1,618 @@
+#include <cstdlib>
+#include <cstdio>
+#include <csignal>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <iterator>
+
+#include <dirent.h>
+
+#include "PreTokenizer.hpp"
+#include "Tokenizer.hpp"
+#include "DebugTokenOutputStream.hpp"
+#include "SimpleExpressionParser.hpp"
+#include "ExpressionParser.hpp"
+#include "Parser.hpp"
+#include "codegen.hpp"
+#include "BytecodeCompiler.hpp"
+#include "Interpreter.hpp"
+#include "Jit.hpp"
+#include "ThreadPool.hpp"
+#include "OutputSink.hpp"
+
+namespace
+{
+using namespace Compiler;
+
+// output and path of the test this thread runs, NULL on threads which
+// run none
+thread_local std::string* threadOutput = NULL;
+thread_local const char* threadTest = NULL;
+
+// failed assertion or crash of one test takes the whole run down, so the
+// test is named before it goes
+void OnCrash(int signal)
+{
+  if (threadTest != NULL)
+  {
+    std::fputs("CRASH in ", stderr);
+    std::fputs(threadTest, stderr);
+    std::fputs(".t\n", stderr);
+    std::fflush(stderr);
+  }
+  std::signal(signal, SIG_DFL);
+  std::raise(signal);
+}
+
+// compiler prints to std::cout and std::cerr, so both are routed to the
+// test of the writing thread, what other threads write is passed on
+class RoutingBuffer : public std::streambuf
+{
+public:
+  explicit RoutingBuffer(std::streambuf* fallback)
+    : fallback_(fallback)
+  {
+
+  }
+
+protected:
+  virtual int_type overflow(int_type c)
+  {
+    if (c == traits_type::eof())
+    {
+      return traits_type::not_eof(c);
+    }
+    if (threadOutput == NULL)
+    {
+      return fallback_->sputc(traits_type::to_char_type(c));
+    }
+    *threadOutput += traits_type::to_char_type(c);
+    return c;
+  }
+
+  virtual std::streamsize xsputn(const char* p, std::streamsize n)
+  {
+    if (threadOutput == NULL)
+    {
+      return fallback_->sputn(p, n);
+    }
+    threadOutput->append(p, n);
+    return n;
+  }
+
+  virtual int sync()
+  {
+    return threadOutput == NULL ? fallback_->pubsync() : 0;
+  }
+
+private:
+  std::streambuf* fallback_;
+};
+
+// sets stream buffer for its lifetime
+class StreamRedirect
+{
+public:
+  StreamRedirect(std::ostream& stream, std::streambuf* buffer)
+    : stream_(stream)
+    , oldBuffer_(stream.rdbuf(buffer))
+  {
+
+  }
+
+  ~StreamRedirect()
+  {
+    stream_.rdbuf(oldBuffer_);
+  }
+
+private:
+  std::ostream& stream_;
+  std::streambuf* oldBuffer_;
+};
+
+// tests of each mode are in directory of its name
+const char* modes[] =
+{
+  "tokenizer", "simple-expression-parser", "expression-parser", "parser", "type-check",
+  "codegen", "bytecode", "output-sink", "diagnostics", "run",
+};
+
+// codegen tests run serially and again on this many threads, as output
+// and errors of both must be the same
+const unsigned parallelCodegenThreadCount = 4;
+
+// run tests run in each tier, which must not change what program does;
+// the ones needing native code only where it can be generated
+const char* runTiers[] = {"--interpret", "--tiered", "--run"};
+
+ITokenStream* CreateOutput(const std::string& mode, unsigned threadCount)
+{
+  if (mode == "tokenizer")
+  {
+    return new DebugTokenOutputStream(std::cout);
+  }
+  else if (mode == "simple-expression-parser")
+  {
+    return new SimpleExpressionParser;
+  }
+  else if (mode == "expression-parser")
+  {
+    return new ExpressionParser;
+  }
+  else if (mode == "parser" || mode == "type-check")
+  {
+    return new Parser(std::cout);
+  }
+  else if (mode == "codegen")
+  {
+    return new CodeGenerator(std::cout, threadCount);
+  }
+  else if (mode == "bytecode")
+  {
+    return new BytecodeGenerator(true, std::cout);
+  }
+  return NULL;
+}
+
+// the same as test driver's RunCompiler, output of references is made by it
+void RunCompiler(const std::vector<char>& input, const std::string& mode, unsigned threadCount)
+{
+  std::unique_ptr<ITokenStream> output(CreateOutput(mode, threadCount));
+  try
+  {
+    Tokenizer tokenizer(*output);
+    PreTokenizer preTokenizer(input, tokenizer);
+  }
+  catch (std::exception& e)
+  {
+    output->Flush();
+    std::cerr << "ERROR: " << e.what() << std::endl;
+  }
+  catch (boost::coroutines::detail::forced_unwind&)
+  {
+    throw;
+  }
+  catch (...)
+  {
+    std::cerr << "ERROR: unknown exception";
+  }
+}
+
+// compiles to bytecode and runs main as the driver does with `tier`
+void RunProgram(const std::vector<char>& input, const std::string& tier)
+{
+  try
+  {
+    BytecodeGenerator bytecodeGenerator(false, std::cout);
+    {
+      Tokenizer tokenizer(bytecodeGenerator);
+      PreTokenizer preTokenizer(input, tokenizer);
+    }
+    BytecodeInterpreter interpreter(bytecodeGenerator.GetModule(), std::cout);
+    std::unique_ptr<BytecodeJit> jit;
+    if (tier != "--interpret")
+    {
+      jit.reset(new BytecodeJit(bytecodeGenerator.GetModule(), tier == "--run"));
+      interpreter.SetJit(jit.get());
+    }
+    interpreter.Run("main");
+  }
+  catch (std::exception& e)
+  {
+    std::cerr << "ERROR: " << e.what() << std::endl;
+  }
+  catch (boost::coroutines::detail::forced_unwind&)
+  {
+    throw;
+  }
+  catch (...)
+  {
+    std::cerr << "ERROR: unknown exception";
+  }
+}
+
+// parses on past errors as -fdiagnostics-format=json does and prints all of
+// them as it does, to stdout; nothing if there are none
+void RunDiagnostics(const std::vector<char>& input)
+{
+  std::ostringstream ast;
+  Parser parser(ast);
+  parser.SetErrorRecovery(true);
+  try
+  {
+    try
+    {
+      Tokenizer tokenizer(parser);
+      PreTokenizer preTokenizer(input, tokenizer);
+    }
+    catch (boost::coroutines::detail::forced_unwind&)
+    {
+      throw;
+    }
+    catch (...)
+    {
+      parser.RethrowWithRecoveredErrors();
+    }
+  }
+  catch (std::exception& e)
+  {
+    PrintDiagnosticsJson(e, std::cout);
+  }
+}
+
+// each line of input is `int N`, `long N`, `unsigned N`, `hex N`,
+// `fill N C` or `text T`, written on a line of its own through a sink of
+// the smallest capacity, so long lines go past its buffer
+void RunOutputSink(const std::vector<char>& input)
+{
+  std::istringstream lines(std::string(input.begin(), input.end()));
+  StreamOutputSink out(std::cout, 0);
+  try
+  {
+    std::string line;
+    while (std::getline(lines, line))
+    {
+      std::istringstream fields(line);
+      std::string kind;
+      fields >> kind;
+      if (kind == "int")
+      {
+        int value = 0;
+        fields >> value;
+        out << value;
+      }
+      else if (kind == "long")
+      {
+        long long value = 0;
+        fields >> value;
+        out << value;
+      }
+      else if (kind == "unsigned")
+      {
+        unsigned long long value = 0;
+        fields >> value;
+        out << value;
+      }
+      else if (kind == "hex")
+      {
+        unsigned long long value = 0;
+        fields >> value;
+        out.WriteHex(value);
+      }
+      else if (kind == "fill")
+      {
+        size_t count = 0;
+        char c = ' ';
+        fields >> count >> c;
+        out.Fill(c, count);
+      }
+      else if (kind == "text")
+      {
+        fields.get();
+        std::string text;
+        std::getline(fields, text);
+        out << text;
+      }
+      else
+      {
+        throw std::runtime_error("unknown line: " + line);
+      }
+      if (fields.fail())
+      {
+        throw std::runtime_error("malformed line: " + line);
+      }
+      out << '\n';
+    }
+    out.Flush();
+  }
+  catch (std::exception& e)
+  {
+    out.Flush();
+    std::cerr << "ERROR: " << e.what() << std::endl;
+  }
+}
+
+std::string ReadText(const std::string& path)
+{
+  std::ifstream file(path, std::ios::binary);
+  if (!file)
+  {
+    throw std::runtime_error("can't open " + path);
+  }
+  std::ostringstream text;
+  text << file.rdbuf();
+  return text.str();
+}
+
+struct Test
+{
+  std::string mode;
+  // tests/MODE/NNN without extension
+  std::string path;
+  std::string output;
+  std::string reference;
+  unsigned threadCount{1};
+  // execution tier option of run tests
+  std::string tier;
+  double seconds{0.0};
+  bool passed{false};
+};
+
+// MODE/NNN.t of every mode directory of `root` which has a .ref
+std::vector<Test> FindTests(const std::string& root)
+{
+  std::vector<Test> tests;
+  auto list = [](const std::string& directory)
+  {
+    std::vector<std::string> names;
+    DIR* handle = opendir(directory.c_str());
+    while (handle != NULL)
+    {
+      dirent* item = readdir(handle);
+      if (item == NULL)
+      {
+        closedir(handle);
+        break;
+      }
+      if (item->d_name[0] != '.')
+      {
+        names.push_back(item->d_name);
+      }
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+  };
+
+  for (auto& mode : list(root))
+  {
+    if (std::find(std::begin(modes), std::end(modes), mode) == std::end(modes))
+    {
+      continue;
+    }
+    for (auto& name : list(root + "/" + mode))
+    {
+      if (name.size() > 2 && name.compare(name.size() - 2, 2, ".t") == 0)
+      {
+        Test test;
+        test.mode = mode;
+        test.path = root + "/" + mode + "/" + name.substr(0, name.size() - 2);
+        if (mode == "run")
+        {
+          for (auto& tier : runTiers)
+          {
+            test.tier = tier;
+            if (test.tier == "--interpret" || BytecodeJit::IsSupported())
+            {
+              tests.push_back(test);
+            }
+          }
+          continue;
+        }
+        tests.push_back(test);
+        if (mode == "codegen")
+        {
+          test.threadCount = parallelCodegenThreadCount;
+          tests.push_back(test);
+        }
+      }
+    }
+  }
+  return tests;
+}
+
+// line number and both lines where output first differs from reference
+std::string GetFirstDifference(const Test& test)
+{
+  std::istringstream output(test.output);
+  std::istringstream reference(test.reference);
+  std::string outputLine;
+  std::string referenceLine;
+  for (int line = 1; ; line++)
+  {
+    bool hasOutput = static_cast<bool>(std::getline(output, outputLine));
+    bool hasReference = static_cast<bool>(std::getline(reference, referenceLine));
+    if (!hasOutput && !hasReference)
+    {
+      // differ in line break at the end only
+      return "    line breaks at the end differ";
+    }
+    if (!hasOutput || !hasReference || outputLine != referenceLine)
+    {
+      auto shorten = [](const std::string& text)
+      {
+        return text.size() > 120 ? text.substr(0, 120) + "..." : text;
+      };
+      return "    line " + std::to_string(line) + "\n"
+             "    expected: " + (hasReference ? shorten(referenceLine) : "<end of file>") + "\n"
+             "    got:      " + (hasOutput ? shorten(outputLine) : "<end of file>");
+    }
+  }
+}
+
+double GetMedian(std::vector<double> values)
+{
+  std::sort(values.begin(), values.end());
+  size_t middle = values.size() / 2;
+  return values.empty() ? 0.0
+       : values.size() % 2 == 1 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+}
+
+void ShowHelp()
+{
+  std::cout <<
+               R"(Runs golden tests of every mode in process, on a thread pool.
+               Usage: test-runner [OPTION]... [DIR]
+
+               DIR                       holds a directory of tests for
+                                         each mode, MODE/NNN.t is compiled
+                                         as the test driver does and its
+                                         output compared with MODE/NNN.ref,
+                                         codegen tests once more with -j 4,
+                                         output-sink tests are written
+                                         through a sink of least capacity,
+                                         diagnostics tests print errors
+                                         as -fdiagnostics-format=json,
+                                         run tests run with --interpret,
+                                         --tiered and --run;
+                                         tests by default
+               -j N                      run tests on N threads, one per
+                                         hardware thread by default
+               --filter TEXT             run only tests which path contains
+                                         TEXT
+               --slow FACTOR             mark tests which take more than
+                                         FACTOR times the median and more
+                                         than 10 ms as slow, 10 by default
+               -q, --quiet               print failed and slow tests only
+               -h, --help                display this help and exit
+              )";
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+  using namespace std;
+
+  unsigned threadCount = 0;
+  string filter;
+  double slowFactor = 10.0;
+  bool quiet = false;
+  string root = "tests";
+  for (int i = 1; i < argc; i++)
+  {
+    string option = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (option == "-j" && hasValue && atoi(argv[i + 1]) > 0)
+    {
+      threadCount = atoi(argv[++i]);
+    }
+    else if (option == "--filter" && hasValue)
+    {
+      filter = argv[++i];
+    }
+    else if (option == "--slow" && hasValue && atof(argv[i + 1]) > 0.0)
+    {
+      slowFactor = atof(argv[++i]);
+    }
+    else if (option == "-q" || option == "--quiet")
+    {
+      quiet = true;
+    }
+    else if (i + 1 == argc && !option.empty() && option[0] != '-')
+    {
+      root = option;
+    }
+    else
+    {
+      ShowHelp();
+      return option == "-h" || option == "--help" ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+  }
+
+  vector<Test> tests = FindTests(root);
+  tests.erase(remove_if(tests.begin(), tests.end(), [&](const Test& test)
+  {
+    return test.path.find(filter) == string::npos;
+  }), tests.end());
+  if (tests.empty())
+  {
+    cerr << "ERROR: no tests in " << root << endl;
+    return EXIT_FAILURE;
+  }
+
+  signal(SIGABRT, OnCrash);
+  signal(SIGSEGV, OnCrash);
+  auto start = chrono::steady_clock::now();
+  unsigned usedThreadCount = 0;
+  try
+  {
+    RoutingBuffer routing(cout.rdbuf());
+    StreamRedirect coutRedirect(cout, &routing);
+    StreamRedirect cerrRedirect(cerr, &routing);
+    ThreadPool pool(threadCount);
+    usedThreadCount = pool.GetThreadCount();
+    for (auto& test : tests)
+    {
+      pool.Submit([&test]
+      {
+        test.reference = ReadText(test.path + ".ref");
+        string text = ReadText(test.path + ".t");
+        vector<char> input(text.begin(), text.end());
+
+        threadOutput = &test.output;
+        threadTest = test.path.c_str();
+        auto testStart = chrono::steady_clock::now();
+        if (test.mode == "output-sink")
+        {
+          RunOutputSink(input);
+        }
+        else if (test.mode == "diagnostics")
+        {
+          RunDiagnostics(input);
+        }
+        else if (test.mode == "run")
+        {
+          RunProgram(input, test.tier);
+        }
+        else
+        {
+          RunCompiler(input, test.mode, test.threadCount);
+        }
+        test.seconds = chrono::duration<double>(chrono::steady_clock::now() - testStart).count();
+        threadOutput = NULL;
+        threadTest = NULL;
+        test.passed = test.output == test.reference;
+      });
+    }
+    pool.Wait();
+  }
+  catch (exception& e)
+  {
+    cerr << "ERROR: " << e.what() << endl;
+    return EXIT_FAILURE;
+  }
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  vector<double> times;
+  for (auto& test : tests)
+  {
+    times.push_back(test.seconds);
+  }
+  double median = GetMedian(times);
+
+  size_t passedCount = 0;
+  size_t slowCount = 0;
+  for (auto& test : tests)
+  {
+    bool slow = test.seconds > median * slowFactor && test.seconds > 0.010;
+    passedCount += test.passed ? 1 : 0;
+    slowCount += slow ? 1 : 0;
+    if (quiet && test.passed && !slow)
+    {
+      continue;
+    }
+    cout << (test.passed ? "PASS " : "FAIL ") << fixed << setprecision(2)
+         << setw(10) << test.seconds * 1e3 << " ms  " << test.path << ".t"
+         << (test.threadCount != 1 ? " -j " + to_string(test.threadCount) : "")
+         << (test.tier.empty() ? "" : " " + test.tier)
+         << (slow ? "  SLOW" : "") << endl;
+    if (!test.passed)
+    {
+      cout << GetFirstDifference(test) << endl;
+    }
+  }
+
+  cout << endl << "Passed " << passedCount << " of " << tests.size() << " in " << fixed
+       << setprecision(2) << seconds * 1e3 << " ms on " << usedThreadCount << " threads, median "
+       << median * 1e3 << " ms, " << slowCount << " slow" << endl;
+  cout << (passedCount == tests.size() ? "SUCCESS. ALL TESTS PASSED." : "FAIL.") << endl;
+  return passedCount == tests.size() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
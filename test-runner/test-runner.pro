@@ -0,0 +1,83 @@
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+CONFIG -= qt
+CONFIG += thread
+
+QMAKE_CXXFLAGS += -std=c++11
+
+DESTDIR = ../bin
+
+INCLUDEPATH += ../src
+
+CONFIG(debug, debug|release) {
+    DEFINES += \
+        _DEBUG
+    OBJECTS_DIR = temp/debug/obj
+    TARGET = test-runner-debug
+} else {
+    OBJECTS_DIR = temp/release/obj
+    TARGET = test-runner-release
+}
+
+DEFINES += BOOST_ALL_NO_LIB
+
+LIBS += \
+    -lboost_system-mgw48-mt-1_55 \
+    -lboost_coroutine-mgw48-mt-1_55 \
+    -lboost_context-mgw48-mt-1_55 \
+
+SOURCES += main.cpp \
+    ../src/utils.cpp \
+    ../src/unicode.cpp \
+    ../src/PreTokenizer.cpp \
+    ../src/Tokenizer.cpp \
+    ../src/SimpleExpressionParser.cpp \
+    ../src/ExpressionParser.cpp \
+    ../src/Token.cpp \
+    ../src/Parser.cpp \
+    ../src/ASTNode.cpp \
+    ../src/SymbolTable.cpp \
+    ../src/prettyPrinting.cpp \
+    ../src/OutputSink.cpp \
+    ../src/Statement.cpp \
+    ../src/codegen.cpp \
+    ../src/AsmInstruction.cpp \
+    ../src/PeepholeOptimizer.cpp \
+    ../src/Bytecode.cpp \
+    ../src/BytecodeCompiler.cpp \
+    ../src/Interpreter.cpp \
+    ../src/Jit.cpp \
+    ../src/ThreadPool.cpp \
+    ../src/TimeReport.cpp \
+    ../src/Trace.cpp
+
+HEADERS += \
+    ../src/utils.hpp \
+    ../src/unicode.hpp \
+    ../src/PreTokenizer.hpp \
+    ../src/Tokenizer.hpp \
+    ../src/SimpleExpressionParser.hpp \
+    ../src/ExpressionParser.hpp \
+    ../src/IPreTokenStream.hpp \
+    ../src/ITokenStream.hpp \
+    ../src/DebugTokenOutputStream.hpp \
+    ../src/constants.hpp \
+    ../src/Token.hpp \
+    ../src/Parser.hpp \
+    ../src/ASTNode.hpp \
+    ../src/SymbolTable.hpp \
+    ../src/prettyPrinting.hpp \
+    ../src/OutputSink.hpp \
+    ../src/Statement.hpp \
+    ../src/Visitor.hpp \
+    ../src/codegen.hpp \
+    ../src/AsmInstruction.hpp \
+    ../src/PeepholeOptimizer.hpp \
+    ../src/Bytecode.hpp \
+    ../src/BytecodeCompiler.hpp \
+    ../src/Interpreter.hpp \
+    ../src/Jit.hpp \
+    ../src/ThreadPool.hpp \
+    ../src/TimeReport.hpp \
+    ../src/Trace.hpp
@@ -0,0 +1,32 @@
+int count;
+char* name = "bytecode";
+
+int sum(int* a, int n)
+{
+  int i;
+  int s = 0;
+  for (i = 0; i < n; i++)
+    s += a[i];
+  return s;
+}
+
+int gcd(int a, int b)
+{
+  if (b == 0)
+    return a;
+  return gcd(b, a % b);
+}
+
+int main()
+{
+  int a[4];
+  int i = 0;
+  while (i < 4)
+  {
+    a[i] = i * i;
+    i++;
+  }
+  count = sum(&a[0], 4);
+  print(gcd(count, 21), name);
+  return count > 10 && name[0] == 'b';
+}
@@ -0,0 +1,20 @@
+int square(int a)
+{
+  return a * a;
+}
+
+int main()
+{
+  int i;
+  int sum = 0;
+  int squares[8];
+  for (i = 0; i < 8; i++)
+  {
+    squares[i] = square(i);
+    if (i % 2 == 1)
+      continue;
+    sum += squares[i];
+  }
+  print(sum, squares[7]);
+  return 0;
+}
@@ -0,0 +1,8 @@
+int main()
+{
+  int* p;
+  int m[2][3];
+  // pointer is 4 bytes, array size is element count times size of element
+  print(sizeof(p), sizeof(m), sizeof(m[1]));
+  return 0;
+}
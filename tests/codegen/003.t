@@ -0,0 +1,13 @@
+struct pair { int first; int second; };
+
+int main()
+{
+  struct pair p;
+  // address of field at offset 0 is address of structure, `add eax, 0` goes;
+  // branch on its value still compares it, not flags of the removed add
+  p.first = 0;
+  p.second = 1;
+  if (p.first)
+    return 1;
+  return p.second;
+}
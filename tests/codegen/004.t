@@ -0,0 +1,11 @@
+int main()
+{
+  int a[4];
+  int m[2][3];
+  int i;
+  i = 1;
+  // element size 4 is a shift, row size 12 stays a multiplication
+  a[i] = 2;
+  m[i][i] = a[i];
+  return m[1][1];
+}
@@ -0,0 +1,16 @@
+int main()
+{
+  int n;
+  int sum;
+  n = 3;
+  sum = 0;
+  // comparisons of conditions with 0 are tests
+  while (n)
+  {
+    sum += n;
+    n--;
+  }
+  if (!sum)
+    return 1;
+  return 0;
+}
@@ -0,0 +1,12 @@
+int count(int n)
+{
+  if (n < 1)
+    return 0;
+  // single argument of tail call is pushed and popped right back
+  return count(n - 1);
+}
+
+int main()
+{
+  return count(3);
+}
@@ -0,0 +1,12 @@
+int g;
+
+int main()
+{
+  int a;
+  int b;
+  a = 1;
+  b = 2;
+  // right operand is passed to ecx through register instead of stack
+  g = a + b;
+  return a - g;
+}
@@ -0,0 +1,15 @@
+int identity(int x)
+{
+  return x;
+}
+
+int forward(int x)
+{
+  // argument loaded from parameter slot is not stored back to it
+  return identity(x);
+}
+
+int main()
+{
+  return forward(1);
+}
@@ -0,0 +1,9 @@
+int main()
+{
+  int a;
+  a = 1;
+  // value of expression statement is dropped when next one loads eax
+  a;
+  a = 2;
+  return a;
+}
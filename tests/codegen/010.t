@@ -0,0 +1,9 @@
+int main()
+{
+  int a;
+  a = 1;
+  if (a)
+    a = 2;
+  // last return jumps to epilogue right after it
+  return a;
+}
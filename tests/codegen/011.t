@@ -0,0 +1,20 @@
+int sign(int a)
+{
+  // jump over else branch follows return, and nothing comes after
+  // the loop's break before its end label
+  if (a < 0)
+    return -1;
+  else
+    return 1;
+}
+
+int main()
+{
+  int i;
+  for (i = 0; i < 10; i++)
+  {
+    break;
+    i = 5;
+  }
+  return sign(i);
+}
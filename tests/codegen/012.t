@@ -0,0 +1,14 @@
+int gcd(int a, int b)
+{
+  if (b == 0)
+    return a;
+  // both arguments are computed before either parameter slot is
+  // overwritten, so the swap reads old values
+  return gcd(b, a % b);
+}
+
+int main()
+{
+  print(gcd(12, 18));
+  return 0;
+}
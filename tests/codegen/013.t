@@ -0,0 +1,23 @@
+int load(int* p)
+{
+  return *p;
+}
+
+int local(int a)
+{
+  int x;
+  x = a;
+  // callee reads caller's frame, which a jump would free before
+  return load(&x);
+}
+
+int parameter(int a)
+{
+  // parameter slot would be overwritten by the pointer to itself
+  return load(&a);
+}
+
+int main()
+{
+  return local(1) + parameter(2);
+}
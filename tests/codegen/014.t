@@ -0,0 +1,17 @@
+int twice(int a)
+{
+  return a + a;
+}
+
+float half(float a)
+{
+  // code generator rejects this, but error in main is reported, as code
+  // is generated only for translation unit which parses, whether functions
+  // are generated one by one or in parallel
+  return a / 2;
+}
+
+int main()
+{
+  return twice(1) +;
+}
@@ -0,0 +1,17 @@
+int twice(int a)
+{
+  return a + a;
+}
+
+float half(float a)
+{
+  // first function code generator rejects is reported, output stops
+  // before it whether functions are generated one by one or in parallel
+  return a / 2;
+}
+
+int main()
+{
+  print(twice(1));
+  return 0;
+}
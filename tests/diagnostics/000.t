@@ -0,0 +1,19 @@
+int a;
+int b c;
+float f;
+
+int main()
+{
+  a = 1 +;
+  f = a;
+  b = (a;
+  return a;
+}
+
+int g(int x)
+{
+  return x x;
+}
+
+struct s { int i; } t;
+int h;
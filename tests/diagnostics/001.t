@@ -0,0 +1,11 @@
+struct s { int i; } t;
+int a;
+
+int main()
+{
+  t = a;
+  a = t.j;
+  a = b;
+  a = a + 1;
+  return t;
+}
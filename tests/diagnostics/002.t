@@ -0,0 +1,6 @@
+int a;
+int b c;
+
+int main()
+{
+  a = '
@@ -0,0 +1,8 @@
+int a;
+
+int main()
+{
+  a = 1 "café";
+  a = 2 "\xff\t\"";
+  a = 3 'é';
+}
@@ -0,0 +1,4 @@
+int x;
+int x 'é';
+int y;
+int y "été";
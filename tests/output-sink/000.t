@@ -0,0 +1,15 @@
+int 0
+int -2147483648
+int 2147483647
+long -9223372036854775808
+long 9223372036854775807
+unsigned 0
+unsigned 18446744073709551615
+hex 0
+hex 255
+hex 18446744073709551615
+fill 0 x
+fill 3 -
+fill 150 =
+text short
+text abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuv
@@ -0,0 +1,7 @@
+struct s
+{
+  struct s
+  {
+    int x;
+  } a;
+};
@@ -0,0 +1,32 @@
+int deep(int n)
+{
+  if (n == 0)
+    return 0;
+  return deep(n - 1) + 1;
+}
+
+int odd(int n);
+
+int even(int n)
+{
+  int a[4];
+  a[n % 4] = n;
+  if (n == 0)
+    return 1;
+  return odd(n - 1) + a[n % 4] - n;
+}
+
+int odd(int n)
+{
+  if (n == 0)
+    return 0;
+  return even(n - 1);
+}
+
+int main()
+{
+  print(deep(100000));
+  print(even(70000));
+  print(odd(70001));
+  return 0;
+}
@@ -0,0 +1,13 @@
+int deep(int n)
+{
+  if (n == 0)
+    return 0;
+  return deep(n - 1) + 1;
+}
+
+int main()
+{
+  print(deep(1000));
+  print(deep(1000000));
+  return 0;
+}
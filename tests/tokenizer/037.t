@@ -0,0 +1,3 @@
+a      b/**/c;
+d/**/e //x
+f;
\ No newline at end of file
@@ -0,0 +1,11 @@
+int a;
+int b;
+int* p;
+
+int main()
+{
+  // relational and equality operators have type int
+  a = a < b;
+  a = a != b;
+  p = a >= b;
+}
@@ -0,0 +1,12 @@
+int a;
+float f;
+int* p;
+
+int main()
+{
+  // common arithmetic type of both operands
+  f = a ? a : f;
+  // type of operands when they are not arithmetic
+  p = a ? p : p;
+  a = a ? p : p;
+}
@@ -0,0 +1,12 @@
+struct s { int x; };
+
+int main()
+{
+  int a;
+  char c;
+  struct s v;
+  a = (int)c + 1;
+  c = (char)a;
+  // cast has type it names
+  v = (int)c;
+}